@@ -23,6 +23,12 @@
 #include "../base/Exception.h"
 #include "../player/Player.h"
 #include "../player/Node.h"
+#include "../player/AreaNode.h"
+#include "../player/FilledVectorNode.h"
+#include "../player/RectNode.h"
+#include "../player/CircleNode.h"
+
+#include <boost/bind.hpp>
 
 using namespace boost;
 using namespace boost::python;
@@ -54,7 +60,8 @@ AttrAnim::AttrAnim(const object& node, const string& sAttrName,
         const object& startCallback, const object& stopCallback)
     : Anim(startCallback, stopCallback),
       m_Node(node),
-      m_sAttrName(sAttrName)
+      m_sAttrName(sAttrName),
+      m_AttrID(node, sAttrName)
 {
     object obj = getValue();
 }
@@ -68,6 +75,7 @@ void AttrAnim::start(bool bKeepAttr)
     stopActiveAttrAnim();
     Anim::start();
     addToMap();
+    resolveNativeSetter();
 }
 
 object AttrAnim::getValue() const
@@ -80,24 +88,115 @@ void AttrAnim::setValue(const object& val)
     m_Node.attr(m_sAttrName.c_str()) = val;
 }
 
+void AttrAnim::setValue(float val)
+{
+    if (m_FloatSetter) {
+        m_FloatSetter(val);
+    } else {
+        setValue(object(val));
+    }
+}
+
+void AttrAnim::setValue(const glm::vec2& val)
+{
+    if (m_Vec2Setter) {
+        m_Vec2Setter(val);
+    } else {
+        setValue(object(val));
+    }
+}
+
+void AttrAnim::setValue(const Color& val)
+{
+    if (m_ColorSetter) {
+        m_ColorSetter(val);
+    } else {
+        setValue(object(val));
+    }
+}
+
+bool AttrAnim::hasNativeSetter() const
+{
+    return m_FloatSetter || m_Vec2Setter || m_ColorSetter;
+}
+
 void AttrAnim::addToMap()
 {
-    s_ActiveAnimations[ObjAttrID(m_Node, m_sAttrName)] = 
+    s_ActiveAnimations[m_AttrID] = 
             dynamic_pointer_cast<AttrAnim>(shared_from_this());
 }
 
 void AttrAnim::removeFromMap()
 {
-    s_ActiveAnimations.erase(ObjAttrID(m_Node, m_sAttrName));
+    s_ActiveAnimations.erase(m_AttrID);
 }
 
 void AttrAnim::stopActiveAttrAnim()
 {
-    ObjAttrID id(m_Node, m_sAttrName);
-    AttrAnimationMap::iterator it = s_ActiveAnimations.find(id);
+    AttrAnimationMap::iterator it = s_ActiveAnimations.find(m_AttrID);
     if (it != s_ActiveAnimations.end()) {
         it->second->abort();
     }
 }
 
+// Returns true if setting sAttrName on obj calls the property NODE registers under 
+// that name. Derived classes - C++ or Python - may have replaced it with their own.
+template<class NODE>
+bool isNodeProperty(const object& obj, const string& sAttrName)
+{
+    if (!isPythonType<NODE*>(obj)) {
+        return false;
+    }
+    PyObject* pNodeClass = (PyObject*)
+            converter::registered<NODE>::converters.get_class_object();
+    PyObject* pObjClass = (PyObject*)Py_TYPE(obj.ptr());
+    const char* pszAttrName = sAttrName.c_str();
+    if (!PyObject_HasAttrString(pNodeClass, pszAttrName)) {
+        return false;
+    }
+    object nodeProperty = object(handle<>(borrowed(pNodeClass))).attr(pszAttrName);
+    object objProperty = object(handle<>(borrowed(pObjClass))).attr(pszAttrName);
+    return nodeProperty.ptr() == objProperty.ptr();
+}
+
+template<class NODE, class ARG, class SETTER>
+void resolveSetter(const object& obj, const string& sAttrName, const char* pszName, 
+        void (NODE::*pSetterFunc)(ARG), SETTER& setter)
+{
+    if (sAttrName == pszName && isNodeProperty<NODE>(obj, sAttrName)) {
+        NODE* pNode = extract<NODE*>(obj);
+        setter = boost::bind(pSetterFunc, pNode, _1);
+    }
+}
+
+void AttrAnim::resolveNativeSetter()
+{
+    // The node pointers stay valid because m_Node holds a reference to the node.
+    m_FloatSetter.clear();
+    m_Vec2Setter.clear();
+    m_ColorSetter.clear();
+    const string& sName = m_sAttrName;
+    resolveSetter(m_Node, sName, "opacity", &Node::setOpacity, m_FloatSetter);
+    resolveSetter(m_Node, sName, "x", &AreaNode::setX, m_FloatSetter);
+    resolveSetter(m_Node, sName, "y", &AreaNode::setY, m_FloatSetter);
+    resolveSetter(m_Node, sName, "width", &AreaNode::setWidth, m_FloatSetter);
+    resolveSetter(m_Node, sName, "height", &AreaNode::setHeight, m_FloatSetter);
+    resolveSetter(m_Node, sName, "angle", &AreaNode::setAngle, m_FloatSetter);
+    resolveSetter(m_Node, sName, "pos", &AreaNode::setPos, m_Vec2Setter);
+    resolveSetter(m_Node, sName, "size", &AreaNode::setSize, m_Vec2Setter);
+    resolveSetter(m_Node, sName, "pivot", &AreaNode::setPivot, m_Vec2Setter);
+    resolveSetter(m_Node, sName, "strokewidth", &VectorNode::setStrokeWidth, 
+            m_FloatSetter);
+    resolveSetter(m_Node, sName, "color", &VectorNode::setColor, m_ColorSetter);
+    resolveSetter(m_Node, sName, "fillopacity", &FilledVectorNode::setFillOpacity, 
+            m_FloatSetter);
+    resolveSetter(m_Node, sName, "fillcolor", &FilledVectorNode::setFillColor, 
+            m_ColorSetter);
+    resolveSetter(m_Node, sName, "pos", &RectNode::setPos, m_Vec2Setter);
+    resolveSetter(m_Node, sName, "size", &RectNode::setSize, m_Vec2Setter);
+    resolveSetter(m_Node, sName, "angle", &RectNode::setAngle, m_FloatSetter);
+    resolveSetter(m_Node, sName, "pos", &CircleNode::setPos, m_Vec2Setter);
+    resolveSetter(m_Node, sName, "r", &CircleNode::setR, m_FloatSetter);
+}
+
 }
@@ -28,9 +28,13 @@
 // Python docs say python.h should be included before any standard headers (!)
 #include "../player/WrapPython.h" 
 
+#include "../base/GLMHelper.h"
+#include "../graphics/Color.h"
+
 #include <boost/python.hpp>
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
+#include <boost/function.hpp>
 
 #include <string>
 #include <map>
@@ -68,6 +72,12 @@ public:
 protected:
     boost::python::object getValue() const;
     void setValue(const boost::python::object& val);
+    // The typed versions call the C++ setter directly if the attribute is a node
+    // attribute known to libavg and go through Python otherwise.
+    void setValue(float val);
+    void setValue(const glm::vec2& val);
+    void setValue(const Color& val);
+    bool hasNativeSetter() const;
 
     void addToMap();
     void removeFromMap();
@@ -76,9 +86,15 @@ private:
     AttrAnim();
     AttrAnim(const AttrAnim&);
     void stopActiveAttrAnim();
+    void resolveNativeSetter();
 
     boost::python::object m_Node;
     std::string m_sAttrName;
+    ObjAttrID m_AttrID;
+
+    boost::function<void (float)> m_FloatSetter;
+    boost::function<void (const glm::vec2&)> m_Vec2Setter;
+    boost::function<void (const Color&)> m_ColorSetter;
 
     typedef std::map<ObjAttrID, AttrAnimPtr> AttrAnimationMap;
     static AttrAnimationMap s_ActiveAnimations;
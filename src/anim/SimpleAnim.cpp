@@ -40,6 +40,23 @@ SimpleAnim::SimpleAnim(const object& node, const string& sAttrName, long long du
       m_EndValue(endValue),
       m_bUseInt(bUseInt)
 {
+    if (isPythonType<float>(m_StartValue) && isPythonType<float>(m_EndValue)) {
+        m_ValueType = FLOAT_VALUE;
+        m_StartVec = glm::vec2(extract<float>(m_StartValue), 0);
+        m_EndVec = glm::vec2(extract<float>(m_EndValue), 0);
+    } else if (isPythonType<glm::vec2>(m_StartValue) && 
+            isPythonType<glm::vec2>(m_EndValue))
+    {
+        m_ValueType = VEC2_VALUE;
+        m_StartVec = extract<glm::vec2>(m_StartValue);
+        m_EndVec = extract<glm::vec2>(m_EndValue);
+    } else if (isPythonType<Color>(m_StartValue) && isPythonType<Color>(m_EndValue)) {
+        m_ValueType = COLOR_VALUE;
+        m_StartColor = extract<Color>(m_StartValue);
+        m_EndColor = extract<Color>(m_EndValue);
+    } else {
+        m_ValueType = OTHER_VALUE;
+    }
 }
 
 SimpleAnim::~SimpleAnim()
@@ -58,7 +75,7 @@ void SimpleAnim::start(bool bKeepAttr)
         m_StartTime = Player::get()->getFrameTime();
     }
     if (m_Duration == 0) {
-        setValue(m_EndValue);
+        setEndValue();
         remove();
     } else {
         step();
@@ -72,49 +89,35 @@ void SimpleAnim::abort()
     }
 }
 
-template<class T>
-object typedLERP(const object& startValue, const object& endValue, float part)
-{
-    T start = extract<T>(startValue);
-    T end = extract<T>(endValue);
-    T cur = start+(end-start)*part;
-    return object(cur);
-}
-
 bool SimpleAnim::step()
 {
     AVG_ASSERT(isRunning());
     float t = ((float(Player::get()->getFrameTime())-m_StartTime)
             /m_Duration);
     if (t >= 1.0) {
-        setValue(m_EndValue);
+        setEndValue();
         remove();
         return true;
     } else {
-        object curValue;
         float part = interpolate(t);
-        if (isPythonType<float>(m_StartValue)) {
-            curValue = typedLERP<float>(m_StartValue, m_EndValue, part);
+        if (m_ValueType == FLOAT_VALUE) {
+            float cur = m_StartVec.x+(m_EndVec.x-m_StartVec.x)*part;
             if (m_bUseInt) {
-                float d = extract<float>(curValue);
-                curValue = object(round(d));
+                cur = round(cur);
             }
-        } else if (isPythonType<glm::vec2>(m_StartValue)) {
-            curValue = typedLERP<glm::vec2>(m_StartValue, m_EndValue, part);
+            setValue(cur);
+        } else if (m_ValueType == VEC2_VALUE) {
+            glm::vec2 cur = m_StartVec+(m_EndVec-m_StartVec)*part;
             if (m_bUseInt) {
-                glm::vec2 pt = extract<glm::vec2>(curValue);
-                curValue = object(glm::vec2(round(pt.x), round(pt.y)));
+                cur = glm::vec2(round(cur.x), round(cur.y));
             }
-        } else if (isPythonType<Color>(m_StartValue)) {
-            Color start = extract<Color>(m_StartValue);
-            Color end = extract<Color>(m_EndValue);
-            Color curColor = Color::mix(start, end, 1-part);
-            curValue = object(curColor);
+            setValue(cur);
+        } else if (m_ValueType == COLOR_VALUE) {
+            setValue(Color::mix(m_StartColor, m_EndColor, 1-part));
         } else {
             throw (Exception(AVG_ERR_TYPE, 
                     "Animated attributes must be numbers, Point2D or Colors."));
         }
-        setValue(curValue);
         return false;
     }
 }
@@ -178,6 +181,22 @@ float SimpleAnim::getStartPart(float start, float end, float cur)
     return (tend+tstart)/2;
 }
 
+void SimpleAnim::setEndValue()
+{
+    // Through Python, the end value is set as passed so it keeps its type.
+    if (!hasNativeSetter()) {
+        setValue(m_EndValue);
+    } else if (m_ValueType == FLOAT_VALUE) {
+        setValue(m_EndVec.x);
+    } else if (m_ValueType == VEC2_VALUE) {
+        setValue(m_EndVec);
+    } else if (m_ValueType == COLOR_VALUE) {
+        setValue(m_EndColor);
+    } else {
+        setValue(m_EndValue);
+    }
+}
+
 void SimpleAnim::remove() 
 {
     AnimPtr tempThis = shared_from_this();
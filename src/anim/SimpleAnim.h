@@ -63,10 +63,20 @@ private:
     long long getDuration() const;
     long long calcStartTime();
     virtual float getStartPart(float start, float end, float cur);
+    void setEndValue();
 
     long long m_Duration;
     boost::python::object m_StartValue;
     boost::python::object m_EndValue;
+
+    // Typed copies of the start and end values, so step() doesn't need to 
+    // evaluate Python objects. Numbers are stored in the x component of the vectors.
+    enum ValueType {FLOAT_VALUE, VEC2_VALUE, COLOR_VALUE, OTHER_VALUE};
+    ValueType m_ValueType;
+    glm::vec2 m_StartVec;
+    glm::vec2 m_EndVec;
+    Color m_StartColor;
+    Color m_EndColor;
     bool m_bUseInt;
     long long m_StartTime;
 };
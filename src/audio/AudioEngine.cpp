@@ -24,12 +24,15 @@
 #include "AudioEngine.h"
 
 #include "Dynamics.h"
+#include "MixHelper.h"
 
 #include "../base/Exception.h"
 #include "../base/Logger.h"
+#include "../base/StringHelper.h"
 #include "../base/TimeSource.h"
 
 #include <iostream>
+#include <string.h>
 
 using namespace std;
 using namespace boost;
@@ -38,6 +41,42 @@ namespace avg {
 
 AudioEngine* AudioEngine::s_pInstance = 0;
 
+// Each add/remove retires one list, and the main thread frees them before it 
+// publishes the next one, so this only needs to cover a few lists.
+static const int RETIRED_SOURCES_RING_SIZE = 16;
+
+template<int CHANNELS>
+static IProcessor<float>* createLimiter(float sampleRate)
+{
+    Dynamics<float, CHANNELS>* pLimiter = new Dynamics<float, CHANNELS>(sampleRate);
+    pLimiter->setThreshold(0.f); // in dB
+    pLimiter->setAttackTime(0.f); // in seconds
+    pLimiter->setReleaseTime(0.05f); // in seconds
+    pLimiter->setRmsTime(0.f); // in seconds
+    pLimiter->setRatio(std::numeric_limits<float>::infinity());
+    pLimiter->setMakeupGain(0.f); // in dB
+    return pLimiter;
+}
+
+static IProcessor<float>* createLimiter(int numChannels, float sampleRate)
+{
+    switch (numChannels) {
+        case 1:
+            return createLimiter<1>(sampleRate);
+        case 2:
+            return createLimiter<2>(sampleRate);
+        case 4:
+            return createLimiter<4>(sampleRate);
+        case 6:
+            return createLimiter<6>(sampleRate);
+        case 8:
+            return createLimiter<8>(sampleRate);
+        default:
+            throw Exception(AVG_ERR_UNSUPPORTED, 
+                    "Unsupported number of audio channels: "+toString(numChannels));
+    }
+}
+
 AudioEngine* AudioEngine::get()
 {
     return s_pInstance;
@@ -48,9 +87,18 @@ AudioEngine::AudioEngine()
       m_pMixBuffer(0),
       m_pLimiter(0),
       m_pGobblerThread(0),
+      m_bStopGobbler(false),
       m_bEnabled(true),
+      m_pCurSources(new AudioSourceList),
+      m_pNextSources(0),
+      m_RetiredSources(RETIRED_SOURCES_RING_SIZE, false),
       m_Volume(1),
-      m_bInitialized(false)
+      m_LastVolume(1),
+      m_bInitialized(false),
+      m_NumUnderruns(0),
+      m_NumLateCallbacks(0),
+      m_bRestartTiming(true),
+      m_LastCallbackTime(0)
 {
     AVG_ASSERT(s_pInstance == 0);
     if (SDL_InitSubSystem(SDL_INIT_AUDIO) == -1) {
@@ -70,7 +118,8 @@ AudioEngine::~AudioEngine()
         m_pLimiter = 0;
     }
     SDL_QuitSubSystem(SDL_INIT_AUDIO);
-    m_AudioSources.clear();
+    resetSourceLists();
+    delete m_pCurSources;
 }
 
 int AudioEngine::getChannels()
@@ -95,17 +144,14 @@ const AudioParams * AudioEngine::getParams()
 void AudioEngine::init(const AudioParams& ap, float volume) 
 {
     m_Volume = volume;
+    m_LastVolume = volume;
+    m_NumUnderruns = 0;
+    m_NumLateCallbacks = 0;
+    m_bRestartTiming = true;
     if (!m_bInitialized) {
+        m_pLimiter = createLimiter(ap.m_Channels, float(ap.m_SampleRate));
         m_bInitialized = true;
         m_AP = ap;
-        Dynamics<float, 2>* pLimiter = new Dynamics<float, 2>(float(m_AP.m_SampleRate));
-        pLimiter->setThreshold(0.f); // in dB
-        pLimiter->setAttackTime(0.f); // in seconds
-        pLimiter->setReleaseTime(0.05f); // in seconds
-        pLimiter->setRmsTime(0.f); // in seconds
-        pLimiter->setRatio(std::numeric_limits<float>::infinity());
-        pLimiter->setMakeupGain(0.f); // in dB
-        m_pLimiter = pLimiter;
 
         SDL_AudioSpec desired;
         desired.freq = m_AP.m_SampleRate;
@@ -155,13 +201,12 @@ void AudioEngine::teardown()
 #endif
     }
 
-    m_AudioSources.clear();
+    // The audio thread isn't running anymore, so we can touch its source list.
+    resetSourceLists();
 }
 
 void AudioEngine::setAudioEnabled(bool bEnabled)
 {
-    SDL_LockAudio();
-    lock_guard lock(m_Mutex);
     AVG_ASSERT(m_AudioSources.empty());
     m_bEnabled = bEnabled;
     if (m_bEnabled) {
@@ -169,11 +214,11 @@ void AudioEngine::setAudioEnabled(bool bEnabled)
     } else {
         pause();
     }
-    SDL_UnlockAudio();
 }
 
 void AudioEngine::play()
 {
+    m_bRestartTiming = true;
     SDL_PauseAudio(0);
 }
 
@@ -182,69 +227,50 @@ void AudioEngine::pause()
     SDL_PauseAudio(1);
 }
 
-int AudioEngine::addSource(AudioMsgQueue& dataQ, AudioMsgQueue& statusQ)
+int AudioEngine::addSource(AudioMsgQueuePtr pDataQ, AudioMsgQueuePtr pStatusQ,
+        AudioTimeStatusPtr pTimeStatus)
 {
-    SDL_LockAudio();
-    lock_guard lock(m_Mutex);
     static int nextID = -1;
     nextID++;
-    AudioSourcePtr pSrc(new AudioSource(dataQ, statusQ, m_AP.m_SampleRate));
+    AudioSourcePtr pSrc(new AudioSource(pDataQ, pStatusQ, pTimeStatus, 
+            m_AP.m_SampleRate));
     m_AudioSources[nextID] = pSrc;
-    SDL_UnlockAudio();
+    publishSources();
     return nextID;
 }
 
 void AudioEngine::removeSource(int id)
 {
-    SDL_LockAudio();
-    lock_guard lock(m_Mutex);
     int numErased = m_AudioSources.erase(id);
     AVG_ASSERT(numErased == 1);
-    SDL_UnlockAudio();
+    // The audio thread may still be mixing the source. It's deleted when the last 
+    // list containing it is freed.
+    publishSources();
 }
 
 void AudioEngine::pauseSource(int id)
 {
-    lock_guard lock(m_Mutex);
-    AudioSourceMap::iterator itSource = m_AudioSources.find(id);
-    AVG_ASSERT(itSource != m_AudioSources.end());
-    AudioSourcePtr pSource = itSource->second;
-    pSource->pause();
+    getSource(id)->pause();
 }
 
 void AudioEngine::playSource(int id)
 {
-    lock_guard lock(m_Mutex);
-    AudioSourceMap::iterator itSource = m_AudioSources.find(id);
-    AVG_ASSERT(itSource != m_AudioSources.end());
-    AudioSourcePtr pSource = itSource->second;
-    pSource->play();
+    getSource(id)->play();
 }
 
 void AudioEngine::notifySeek(int id)
 {
-    lock_guard lock(m_Mutex);
-    AudioSourceMap::iterator itSource = m_AudioSources.find(id);
-    AVG_ASSERT(itSource != m_AudioSources.end());
-    AudioSourcePtr pSource = itSource->second;
-    pSource->notifySeek();
+    getSource(id)->notifySeek();
 }
 
 void AudioEngine::setSourceVolume(int id, float volume)
 {
-    lock_guard lock(m_Mutex);
-    AudioSourceMap::iterator itSource = m_AudioSources.find(id);
-    AVG_ASSERT(itSource != m_AudioSources.end());
-    AudioSourcePtr pSource = itSource->second;
-    pSource->setVolume(volume);
+    getSource(id)->setVolume(volume);
 }
 
 void AudioEngine::setVolume(float volume)
 {
-    SDL_LockAudio();
-    lock_guard lock(m_Mutex);
     m_Volume = volume;
-    SDL_UnlockAudio();
 }
 
 float AudioEngine::getVolume() const
@@ -256,38 +282,112 @@ bool AudioEngine::isEnabled() const
 {
     return m_bEnabled;
 }
+
+int AudioEngine::getNumUnderruns() const
+{
+    return m_NumUnderruns;
+}
+
+int AudioEngine::getNumLateCallbacks() const
+{
+    return m_NumLateCallbacks;
+}
+
+AudioSourcePtr AudioEngine::getSource(int id)
+{
+    AudioSourceMap::iterator itSource = m_AudioSources.find(id);
+    AVG_ASSERT(itSource != m_AudioSources.end());
+    return itSource->second;
+}
+
+void AudioEngine::publishSources()
+{
+    freeRetiredSources();
+    AudioSourceList* pNewSources = new AudioSourceList;
+    pNewSources->reserve(m_AudioSources.size());
+    AudioSourceMap::iterator it;
+    for (it = m_AudioSources.begin(); it != m_AudioSources.end(); it++) {
+        pNewSources->push_back(it->second);
+    }
+    // If the audio thread hasn't picked up the previous list yet, it never will.
+    delete m_pNextSources.exchange(pNewSources);
+}
+
+void AudioEngine::freeRetiredSources()
+{
+    AudioSourceList* pSources;
+    while (m_RetiredSources.tryPop(pSources)) {
+        delete pSources;
+    }
+}
+
+void AudioEngine::updateSources()
+{
+    AudioSourceList* pNewSources = m_pNextSources.exchange(0);
+    if (pNewSources) {
+        if (!m_RetiredSources.tryPush(m_pCurSources)) {
+            // The main thread hasn't freed the old lists yet. Deleting this one 
+            // ourselves is slower, but correct.
+            delete m_pCurSources;
+        }
+        m_pCurSources = pNewSources;
+    }
+}
+
+void AudioEngine::resetSourceLists()
+{
+    freeRetiredSources();
+    delete m_pNextSources.exchange(0);
+    m_pCurSources->clear();
+    m_AudioSources.clear();
+}
         
 void AudioEngine::mixAudio(Uint8 *pDestBuffer, int destBufferLen)
 {
-    int numFrames = destBufferLen/(2*getChannels()); // 16 bit samples.
+    updateSources();
+    int numChannels = getChannels();
+    int numFrames = destBufferLen/(2*numChannels); // 16 bit samples.
+    checkCallbackTiming(numFrames);
 
-    if (!m_pTempBuffer || m_pTempBuffer->getNumFrames() < numFrames) {
+    if (!m_pTempBuffer || m_pTempBuffer->getNumFrames() != numFrames) {
         if (m_pTempBuffer) {
             delete[] m_pMixBuffer;
         }
         m_pTempBuffer = AudioBufferPtr(new AudioBuffer(numFrames, m_AP));
-        m_pMixBuffer = new float[getChannels()*numFrames];
+        m_pMixBuffer = new float[numChannels*numFrames];
     }
 
-    for (int i = 0; i < getChannels()*numFrames; ++i) {
-        m_pMixBuffer[i]=0;
+    memset(m_pMixBuffer, 0, numChannels*numFrames*sizeof(float));
+    bool bUnderrun = false;
+    for (unsigned i = 0; i < m_pCurSources->size(); ++i) {
+        bool bOK = (*m_pCurSources)[i]->mixAudio(m_pMixBuffer, m_pTempBuffer);
+        bUnderrun |= !bOK;
     }
-    {
-        lock_guard lock(m_Mutex);
-        AudioSourceMap::iterator it;
-        for (it = m_AudioSources.begin(); it != m_AudioSources.end(); it++) {
-            m_pTempBuffer->clear();
-            it->second->fillAudioBuffer(m_pTempBuffer);
-            addBuffers(m_pMixBuffer, m_pTempBuffer);
-        }
+    if (bUnderrun) {
+        m_NumUnderruns++;
     }
-    calcVolume(m_pMixBuffer, numFrames*getChannels(), getVolume());
+    float volume = getVolume();
+    applyGain(m_pMixBuffer, numFrames, numChannels, m_LastVolume, volume, 
+            VOLUME_FADE_FRAMES);
+    m_LastVolume = volume;
     for (int i = 0; i < numFrames; ++i) {
-        m_pLimiter->process(m_pMixBuffer+i*getChannels());
-        for (int j = 0; j < getChannels(); ++j) {
-            ((short*)pDestBuffer)[i*2+j]=short(m_pMixBuffer[i*2+j]*32768);
-        }
+        m_pLimiter->process(m_pMixBuffer+i*numChannels);
+    }
+    floatToShort((short*)pDestBuffer, m_pMixBuffer, numFrames*numChannels);
+}
+
+void AudioEngine::checkCallbackTiming(int numFrames)
+{
+    long long now = TimeSource::get()->getCurrentMicrosecs();
+    if (m_bRestartTiming.exchange(false)) {
+        m_LastCallbackTime = now;
+        return;
     }
+    long long bufferDuration = (long long)(numFrames)*1000000/m_AP.m_SampleRate;
+    if ((now-m_LastCallbackTime)*2 > bufferDuration*3) {
+        m_NumLateCallbacks++;
+    }
+    m_LastCallbackTime = now;
 }
 
 void AudioEngine::consumeBuffers()
@@ -295,10 +395,9 @@ void AudioEngine::consumeBuffers()
     // Separate thread that's active only if we don't have a running sound subsystem.
     while (!m_bStopGobbler) {
         msleep(3);
-        AudioSourceMap::iterator it;
-        lock_guard lock(m_Mutex);
-        for (it = m_AudioSources.begin(); it != m_AudioSources.end(); it++) {
-            it->second->clearQueue();
+        updateSources();
+        for (unsigned i = 0; i < m_pCurSources->size(); ++i) {
+            (*m_pCurSources)[i]->clearQueue();
         }
     }
 }
@@ -309,21 +408,4 @@ void AudioEngine::audioCallback(void *userData, Uint8 *audioBuffer, int audioBuf
     pThis->mixAudio(audioBuffer, audioBufferLen);
 }
 
-void AudioEngine::addBuffers(float *pDest, AudioBufferPtr pSrc)
-{
-    int numFrames = pSrc->getNumFrames();
-    short * pData = pSrc->getData();
-    for(int i = 0; i < numFrames*getChannels(); ++i) {
-        pDest[i] += pData[i]/32768.0f;
-    }
-}
-
-void AudioEngine::calcVolume(float *pBuffer, int numSamples, float volume)
-{
-    // TODO: We need a VolumeFader class that keeps state.
-    for(int i = 0; i < numSamples; ++i) {
-        pBuffer[i] *= volume;
-    }
-}
-
 }
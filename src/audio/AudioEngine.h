@@ -30,16 +30,25 @@
 #include "AudioBuffer.h"
 #include "IProcessor.h"
 
+#include "../base/LockFreeRing.h"
+
 #include <SDL2/SDL.h>
 
-#include <boost/thread/mutex.hpp>
 #include <boost/thread.hpp>
 
+#include <atomic>
 #include <map>
+#include <vector>
 
 namespace avg {
 
 typedef std::map<int, AudioSourcePtr> AudioSourceMap;
+typedef std::vector<AudioSourcePtr> AudioSourceList;
+
+// The audio callback never blocks. The main thread owns the map of sources and 
+// publishes an immutable copy of it whenever a source is added or removed. The audio 
+// thread picks up the newest copy at the start of each callback and hands the one 
+// it replaced back to the main thread for deletion. Per-source parameters are atomic.
 
 class AVG_API AudioEngine
 {
@@ -60,7 +69,8 @@ class AVG_API AudioEngine
         void play();
         void pause();
         
-        int addSource(AudioMsgQueue& dataQ, AudioMsgQueue& statusQ);
+        int addSource(AudioMsgQueuePtr pDataQ, AudioMsgQueuePtr pStatusQ,
+                AudioTimeStatusPtr pTimeStatus);
         void removeSource(int id);
         void pauseSource(int id);
         void playSource(int id);
@@ -70,30 +80,55 @@ class AVG_API AudioEngine
         void setVolume(float volume);
         float getVolume() const;
         bool isEnabled() const;
+
+        // Number of callbacks in which a playing source ran out of data.
+        int getNumUnderruns() const;
+        // Number of callbacks that started more than 1.5 buffer durations after the 
+        // previous one.
+        int getNumLateCallbacks() const;
         
     private:
+        AudioSourcePtr getSource(int id);
+        void publishSources();
+        void freeRetiredSources();
+        void updateSources();
+        void resetSourceLists();
+
         void mixAudio(Uint8 *pDestBuffer, int destBufferLen);
+        void checkCallbackTiming(int numFrames);
         void consumeBuffers();
         static void audioCallback(void *userData, Uint8 *audioBuffer, int audioBufferLen);
-        void addBuffers(float *pDest, AudioBufferPtr pSrc);
-        void calcVolume(float *pBuffer, int numSamples, float volume);
         
         AudioParams m_AP;
         AudioBufferPtr m_pTempBuffer;
         float * m_pMixBuffer;
         IProcessor<float>* m_pLimiter;
-        boost::mutex m_Mutex;
 
         // Reads all audio packets when we can't initialize audio so the
         // queues get flushed.
         bool m_bFakeAudio;
         boost::thread* m_pGobblerThread;
-        bool m_bStopGobbler;
+        std::atomic<bool> m_bStopGobbler;
 
         bool m_bEnabled;
+        // Main thread only.
         AudioSourceMap m_AudioSources;
-        float m_Volume;
+        // Audio thread only, except while the audio thread is stopped.
+        AudioSourceList* m_pCurSources;
+        // Published by the main thread, picked up by the audio thread.
+        std::atomic<AudioSourceList*> m_pNextSources;
+        // Lists the audio thread doesn't need anymore, deleted by the main thread.
+        LockFreeRing<AudioSourceList*> m_RetiredSources;
+
+        std::atomic<float> m_Volume;
+        // Volume used in the last audio callback. Accessed only by the audio thread.
+        float m_LastVolume;
         bool m_bInitialized;
+
+        std::atomic<int> m_NumUnderruns;
+        std::atomic<int> m_NumLateCallbacks;
+        std::atomic<bool> m_bRestartTiming;
+        long long m_LastCallbackTime;
         
         static AudioEngine* s_pInstance;
 };
@@ -49,12 +49,6 @@ void AudioMsg::setAudio(AudioBufferPtr pAudioBuffer, float audioTime)
     m_AudioTime = audioTime;
 }
 
-void AudioMsg::setAudioTime(float audioTime)
-{
-    setType(AUDIO_TIME);
-    m_AudioTime = audioTime;
-}
-
 void AudioMsg::setEOF()
 {
     setType(END_OF_FILE);
@@ -92,7 +86,7 @@ AudioBufferPtr AudioMsg::getAudioBuffer() const
 
 float AudioMsg::getAudioTime() const
 {
-    AVG_ASSERT(m_MsgType == AUDIO_TIME || m_MsgType == AUDIO);
+    AVG_ASSERT(m_MsgType == AUDIO);
     return m_AudioTime;
 }
 
@@ -123,9 +117,6 @@ void AudioMsg::dump()
         case AUDIO:
             cerr << "AUDIO" << endl;
             break;
-        case AUDIO_TIME:
-            cerr << "AUDIO_TIME" << endl;
-            break;
         case END_OF_FILE:
             cerr << "END_OF_FILE" << endl;
             break;
@@ -156,6 +147,11 @@ void AudioMsg::setType(MsgType msgType)
     m_MsgType = msgType;
 }
 
+void AudioMsg::resetType()
+{
+    m_MsgType = NONE;
+}
+
 
 
 }
@@ -30,15 +30,15 @@
 
 #include <boost/shared_ptr.hpp>
 
+#include <atomic>
+
 namespace avg {
 
 class AVG_API AudioMsg {
 public:
-    enum MsgType {NONE, AUDIO, AUDIO_TIME, END_OF_FILE, ERROR, FRAME, SEEK_DONE, PACKET,
-            CLOSED};
+    enum MsgType {NONE, AUDIO, END_OF_FILE, ERROR, FRAME, SEEK_DONE, PACKET, CLOSED};
     AudioMsg();
     void setAudio(AudioBufferPtr pAudioBuffer, float audioTime);
-    void setAudioTime(float audioTime);
     void setEOF();
     void setError(const Exception& ex);
     void setSeekDone(int seqNum, float seekTime);
@@ -60,6 +60,7 @@ public:
 
 protected:
     void setType(MsgType msgType);
+    void resetType();
 
 private:
     MsgType m_MsgType;
@@ -81,6 +82,11 @@ typedef boost::shared_ptr<AudioMsg> AudioMsgPtr;
 typedef Queue<AudioMsg> AudioMsgQueue;
 typedef boost::shared_ptr<AudioMsgQueue> AudioMsgQueuePtr;
 
+// Playback time the audio thread reports after every buffer. Shared like the queues,
+// but updated without locking or allocating memory. Negative until the first report.
+typedef std::atomic<float> AudioTimeStatus;
+typedef boost::shared_ptr<AudioTimeStatus> AudioTimeStatusPtr;
+
 }
 #endif 
 
@@ -21,6 +21,7 @@
 
 #include "AudioSource.h"
 #include "AudioEngine.h"
+#include "MixHelper.h"
 
 #include <string>
 #include <algorithm>
@@ -29,14 +30,19 @@ using namespace std;
 
 namespace avg {
 
-AudioSource::AudioSource(AudioMsgQueue& msgQ, AudioMsgQueue& statusQ, int sampleRate)
-    : m_MsgQ(msgQ),
-      m_StatusQ(statusQ),
+AudioSource::AudioSource(AudioMsgQueuePtr pMsgQ, AudioMsgQueuePtr pStatusQ, 
+        AudioTimeStatusPtr pTimeStatus, int sampleRate)
+    : m_pMsgQ(pMsgQ),
+      m_pStatusQ(pStatusQ),
+      m_pTimeStatus(pTimeStatus),
       m_SampleRate(sampleRate),
+      m_bEOF(false),
+      m_bUnderrun(false),
+      m_LastVolume(1.0),
       m_bPaused(false),
-      m_bSeeking(false),
       m_Volume(1.0),
-      m_LastVolume(1.0)
+      m_NumSeeksRequested(0),
+      m_NumSeeksDone(0)
 {
 }
 
@@ -56,10 +62,9 @@ void AudioSource::play()
 
 void AudioSource::notifySeek()
 {
-    while (m_bSeeking) {
-        processNextMsg(true);
-    }
-    m_bSeeking = true;
+    // The audio thread discards data until it has seen the SEEK_DONE of the last seek
+    // requested. Seeks are numbered starting with 1, like in the decoder.
+    m_NumSeeksRequested++;
 }
     
 void AudioSource::setVolume(float volume)
@@ -67,13 +72,29 @@ void AudioSource::setVolume(float volume)
     m_Volume = volume;
 }
 
-void AudioSource::fillAudioBuffer(AudioBufferPtr pBuffer)
+bool AudioSource::mixAudio(float* pMixBuffer, AudioBufferPtr pTempBuffer)
+{
+    if (fillAudioBuffer(pTempBuffer)) {
+        float volume = m_Volume;
+        mixSamples(pMixBuffer, pTempBuffer->getData(), pTempBuffer->getNumFrames(),
+                pTempBuffer->getNumChannels(), m_LastVolume, volume, 
+                VOLUME_FADE_FRAMES);
+        m_LastVolume = volume;
+    }
+    return !m_bUnderrun;
+}
+
+bool AudioSource::fillAudioBuffer(AudioBufferPtr pBuffer)
 {
+    m_bUnderrun = false;
     bool bContinue = true;
-    while (bContinue && m_bSeeking) {
+    while (bContinue && isSeeking()) {
         bContinue = processNextMsg(false);
     }
-    if (!m_bPaused) {
+    if (m_bPaused) {
+        return false;
+    } else {
+        pBuffer->clear();
         unsigned char* pDest = (unsigned char *)(pBuffer->getData());
         int framesLeftToFill = pBuffer->getNumFrames();
         AudioMsgPtr pMsg;
@@ -101,16 +122,15 @@ void AudioSource::fillAudioBuffer(AudioBufferPtr pBuffer)
             if (framesLeftToFill != 0) {
                 bool bContinue = processNextMsg(false);
                 if (!bContinue) {
+                    // The decoder didn't keep up unless the stream has ended.
+                    m_bUnderrun = !m_bEOF && !isSeeking();
                     framesLeftToFill = 0;
                 }
             }
         }
-        pBuffer->volumize(m_LastVolume, m_Volume);
-        m_LastVolume = m_Volume;
-
-        AudioMsgPtr pStatusMsg(new AudioMsg);
-        pStatusMsg->setAudioTime(m_LastTime);
-        m_StatusQ.push(pStatusMsg);
+        // Reported once per buffer, so this must not lock or allocate.
+        *m_pTimeStatus = m_LastTime;
+        return true;
     }
 }
 
@@ -122,31 +142,40 @@ void AudioSource::clearQueue()
 
 bool AudioSource::processNextMsg(bool bWait)
 {
-    AudioMsgPtr pMsg = m_MsgQ.pop(bWait);
+    AudioMsgPtr pMsg = m_pMsgQ->pop(bWait);
     if (pMsg) {
         switch (pMsg->getType()) {
             case AudioMsg::AUDIO:
                 m_pInputAudioBuffer = pMsg->getAudioBuffer();
                 m_CurInputAudioPos = 0;
+                m_bEOF = false;
                 m_LastTime = pMsg->getAudioTime();
 //                cerr << "  New buffer: " << m_LastTime << endl;
                 return true;
             case AudioMsg::END_OF_FILE: {
 //                cerr << "        AudioSource: EOF" << endl;
-                m_bSeeking = false;
+                m_bEOF = true;
                 AudioMsgPtr pStatusMsg(new AudioMsg);
                 pStatusMsg->setEOF();
-                m_StatusQ.push(pStatusMsg);
+                m_pStatusQ->push(pStatusMsg);
                 return false;
             }
             case AudioMsg::SEEK_DONE: {
 //                cerr << "        AudioSource: SEEK_DONE" << endl;
-                m_bSeeking = false;
+                // The decoder only reports the latest of several pending seeks, so
+                // completion is tracked by sequence number and never runs ahead of
+                // the seeks requested.
+                m_NumSeeksDone = max(m_NumSeeksDone, 
+                        min(pMsg->getSeekSeqNum(), int(m_NumSeeksRequested)));
+                m_bEOF = false;
                 m_pInputAudioBuffer = AudioBufferPtr();
                 m_LastTime = pMsg->getSeekTime();
+                // Before the SEEK_DONE, so the decoder never sees a time from before 
+                // the seek after it.
+                *m_pTimeStatus = m_LastTime;
                 AudioMsgPtr pStatusMsg(new AudioMsg);
                 pStatusMsg->setSeekDone(pMsg->getSeekSeqNum(), m_LastTime);
-                m_StatusQ.push(pStatusMsg);
+                m_pStatusQ->push(pStatusMsg);
                 return true;
             }
             default:
@@ -159,4 +188,9 @@ bool AudioSource::processNextMsg(bool bWait)
     }
 }
 
+bool AudioSource::isSeeking() const
+{
+    return m_NumSeeksRequested > m_NumSeeksDone;
+}
+
 }
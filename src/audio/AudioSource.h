@@ -28,13 +28,18 @@
 
 #include <boost/shared_ptr.hpp>
 
+#include <atomic>
+
 namespace avg
 {
 
+// pause(), play(), notifySeek() and setVolume() are called from the main thread and
+// never block. All other methods are only called from the audio thread.
 class AVG_API AudioSource
 {
 public:
-    AudioSource(AudioMsgQueue& msgQ, AudioMsgQueue& statusQ, int sampleRate);
+    AudioSource(AudioMsgQueuePtr pMsgQ, AudioMsgQueuePtr pStatusQ, 
+            AudioTimeStatusPtr pTimeStatus, int sampleRate);
     virtual ~AudioSource();
 
     void pause();
@@ -42,22 +47,35 @@ public:
     void notifySeek();
     void setVolume(float volume);
 
-    void fillAudioBuffer(AudioBufferPtr pBuffer);
+    // Fills pTempBuffer with the next frames and adds them to pMixBuffer. Returns 
+    // false if the source is playing but not enough data was available.
+    bool mixAudio(float* pMixBuffer, AudioBufferPtr pTempBuffer);
     void clearQueue();
 
 private:
+    bool fillAudioBuffer(AudioBufferPtr pBuffer);
     bool processNextMsg(bool bWait);
+    bool isSeeking() const;
 
-    AudioMsgQueue& m_MsgQ;    
-    AudioMsgQueue& m_StatusQ;
+    // The queues are shared with the decoder so they stay valid until the audio
+    // thread has dropped the source, even if the decoder is gone by then.
+    AudioMsgQueuePtr m_pMsgQ;    
+    AudioMsgQueuePtr m_pStatusQ;
+    AudioTimeStatusPtr m_pTimeStatus;
     int m_SampleRate;
     AudioBufferPtr m_pInputAudioBuffer;
     float m_LastTime;
     int m_CurInputAudioPos;
-    bool m_bPaused;
-    bool m_bSeeking;
-    float m_Volume;
+    bool m_bEOF;
+    bool m_bUnderrun;
     float m_LastVolume;
+
+    std::atomic<bool> m_bPaused;
+    std::atomic<float> m_Volume;
+    // A seek is pending until the SEEK_DONE with the sequence number of the last seek
+    // requested has arrived.
+    std::atomic<int> m_NumSeeksRequested;
+    int m_NumSeeksDone;
 };
 
 typedef boost::shared_ptr<AudioSource> AudioSourcePtr;
@@ -0,0 +1,293 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "MixHelper.h"
+
+#include "../base/SIMDHelper.h"
+
+#include <algorithm>
+
+using namespace std;
+
+namespace avg {
+
+static const float SHORT_TO_FLOAT = 1.f/32768;
+
+namespace {
+
+// ------------------------------------------------------------------------
+// Vectorized versions of the constant-gain loops. Each processes whole vectors
+// starting at sample i and returns the index of the first sample it didn't handle.
+// The callers finish the buffer with the scalar loop.
+
+#ifdef AVG_SIMD_X86
+
+int mixSamplesSSE2(float* pDest, const short* pSrc, int i, int numSamples, 
+        float scale)
+{
+    __m128 scale4 = _mm_set1_ps(scale);
+    for (; i+8 <= numSamples; i += 8) {
+        __m128i src = _mm_loadu_si128((const __m128i*)(pSrc+i));
+        // Sign-extend to 32 bit by unpacking into the upper half and shifting back.
+        __m128i lo = _mm_srai_epi32(_mm_unpacklo_epi16(src, src), 16);
+        __m128i hi = _mm_srai_epi32(_mm_unpackhi_epi16(src, src), 16);
+        __m128 loVal = _mm_mul_ps(_mm_cvtepi32_ps(lo), scale4);
+        __m128 hiVal = _mm_mul_ps(_mm_cvtepi32_ps(hi), scale4);
+        _mm_storeu_ps(pDest+i, _mm_add_ps(_mm_loadu_ps(pDest+i), loVal));
+        _mm_storeu_ps(pDest+i+4, _mm_add_ps(_mm_loadu_ps(pDest+i+4), hiVal));
+    }
+    return i;
+}
+
+int applyGainSSE2(float* pBuffer, int i, int numSamples, float gain)
+{
+    __m128 gain4 = _mm_set1_ps(gain);
+    for (; i+4 <= numSamples; i += 4) {
+        _mm_storeu_ps(pBuffer+i, _mm_mul_ps(_mm_loadu_ps(pBuffer+i), gain4));
+    }
+    return i;
+}
+
+int floatToShortSSE2(short* pDest, const float* pSrc, int numSamples)
+{
+    __m128 scale4 = _mm_set1_ps(32768.f);
+    __m128 min4 = _mm_set1_ps(-32768.f);
+    __m128 max4 = _mm_set1_ps(32767.f);
+    int i = 0;
+    for (; i+8 <= numSamples; i += 8) {
+        __m128 lo = _mm_mul_ps(_mm_loadu_ps(pSrc+i), scale4);
+        __m128 hi = _mm_mul_ps(_mm_loadu_ps(pSrc+i+4), scale4);
+        lo = _mm_min_ps(_mm_max_ps(lo, min4), max4);
+        hi = _mm_min_ps(_mm_max_ps(hi, min4), max4);
+        __m128i packed = _mm_packs_epi32(_mm_cvttps_epi32(lo), _mm_cvttps_epi32(hi));
+        _mm_storeu_si128((__m128i*)(pDest+i), packed);
+    }
+    return i;
+}
+
+AVG_TARGET_AVX2 int mixSamplesAVX2(float* pDest, const short* pSrc, int i, 
+        int numSamples, float scale)
+{
+    __m256 scale8 = _mm256_set1_ps(scale);
+    for (; i+8 <= numSamples; i += 8) {
+        __m256i src = _mm256_cvtepi16_epi32(_mm_loadu_si128((const __m128i*)(pSrc+i)));
+        __m256 val = _mm256_mul_ps(_mm256_cvtepi32_ps(src), scale8);
+        _mm256_storeu_ps(pDest+i, _mm256_add_ps(_mm256_loadu_ps(pDest+i), val));
+    }
+    return i;
+}
+
+AVG_TARGET_AVX2 int applyGainAVX2(float* pBuffer, int i, int numSamples, float gain)
+{
+    __m256 gain8 = _mm256_set1_ps(gain);
+    for (; i+8 <= numSamples; i += 8) {
+        _mm256_storeu_ps(pBuffer+i, _mm256_mul_ps(_mm256_loadu_ps(pBuffer+i), gain8));
+    }
+    return i;
+}
+
+AVG_TARGET_AVX2 int floatToShortAVX2(short* pDest, const float* pSrc, int numSamples)
+{
+    __m256 scale8 = _mm256_set1_ps(32768.f);
+    __m256 min8 = _mm256_set1_ps(-32768.f);
+    __m256 max8 = _mm256_set1_ps(32767.f);
+    int i = 0;
+    for (; i+16 <= numSamples; i += 16) {
+        __m256 lo = _mm256_mul_ps(_mm256_loadu_ps(pSrc+i), scale8);
+        __m256 hi = _mm256_mul_ps(_mm256_loadu_ps(pSrc+i+8), scale8);
+        lo = _mm256_min_ps(_mm256_max_ps(lo, min8), max8);
+        hi = _mm256_min_ps(_mm256_max_ps(hi, min8), max8);
+        __m256i packed = _mm256_packs_epi32(_mm256_cvttps_epi32(lo), 
+                _mm256_cvttps_epi32(hi));
+        // packs works on 128 bit lanes, so the middle quadwords need to be swapped.
+        packed = _mm256_permute4x64_epi64(packed, 0xD8);
+        _mm256_storeu_si256((__m256i*)(pDest+i), packed);
+    }
+    return i;
+}
+
+#endif
+
+#ifdef AVG_SIMD_NEON
+
+int mixSamplesNEON(float* pDest, const short* pSrc, int i, int numSamples, 
+        float scale)
+{
+    float32x4_t scale4 = vdupq_n_f32(scale);
+    for (; i+8 <= numSamples; i += 8) {
+        int16x8_t src = vld1q_s16(pSrc+i);
+        float32x4_t loVal = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_low_s16(src))), 
+                scale4);
+        float32x4_t hiVal = vmulq_f32(vcvtq_f32_s32(vmovl_s16(vget_high_s16(src))),
+                scale4);
+        vst1q_f32(pDest+i, vaddq_f32(vld1q_f32(pDest+i), loVal));
+        vst1q_f32(pDest+i+4, vaddq_f32(vld1q_f32(pDest+i+4), hiVal));
+    }
+    return i;
+}
+
+int applyGainNEON(float* pBuffer, int i, int numSamples, float gain)
+{
+    float32x4_t gain4 = vdupq_n_f32(gain);
+    for (; i+4 <= numSamples; i += 4) {
+        vst1q_f32(pBuffer+i, vmulq_f32(vld1q_f32(pBuffer+i), gain4));
+    }
+    return i;
+}
+
+int floatToShortNEON(short* pDest, const float* pSrc, int numSamples)
+{
+    float32x4_t scale4 = vdupq_n_f32(32768.f);
+    float32x4_t min4 = vdupq_n_f32(-32768.f);
+    float32x4_t max4 = vdupq_n_f32(32767.f);
+    int i = 0;
+    for (; i+8 <= numSamples; i += 8) {
+        float32x4_t lo = vmulq_f32(vld1q_f32(pSrc+i), scale4);
+        float32x4_t hi = vmulq_f32(vld1q_f32(pSrc+i+4), scale4);
+        lo = vminq_f32(vmaxq_f32(lo, min4), max4);
+        hi = vminq_f32(vmaxq_f32(hi, min4), max4);
+        int16x8_t packed = vcombine_s16(vqmovn_s32(vcvtq_s32_f32(lo)),
+                vqmovn_s32(vcvtq_s32_f32(hi)));
+        vst1q_s16(pDest+i, packed);
+    }
+    return i;
+}
+
+#endif
+
+}
+
+void mixSamples(float* pDest, const short* pSrc, int numFrames, int numChannels,
+        float startGain, float endGain, int rampFrames)
+{
+    int i = 0;
+    if (startGain != endGain) {
+        int numRampFrames = min(numFrames, rampFrames);
+        float scale = startGain*SHORT_TO_FLOAT;
+        float scaleStep = (endGain-startGain)*SHORT_TO_FLOAT/rampFrames;
+        for (int frame = 0; frame < numRampFrames; ++frame) {
+            for (int j = 0; j < numChannels; ++j, ++i) {
+                pDest[i] += pSrc[i]*scale;
+            }
+            scale += scaleStep;
+        }
+    }
+
+    int numSamples = numFrames*numChannels;
+    float scale = endGain*SHORT_TO_FLOAT;
+    switch (getSIMDLevel()) {
+#ifdef AVG_SIMD_X86
+        case SIMD_AVX2:
+            i = mixSamplesAVX2(pDest, pSrc, i, numSamples, scale);
+            break;
+        case SIMD_SSE2:
+            i = mixSamplesSSE2(pDest, pSrc, i, numSamples, scale);
+            break;
+#endif
+#ifdef AVG_SIMD_NEON
+        case SIMD_NEON:
+            i = mixSamplesNEON(pDest, pSrc, i, numSamples, scale);
+            break;
+#endif
+        default:
+            break;
+    }
+    for (; i < numSamples; ++i) {
+        pDest[i] += pSrc[i]*scale;
+    }
+}
+
+void applyGain(float* pBuffer, int numFrames, int numChannels,
+        float startGain, float endGain, int rampFrames)
+{
+    int i = 0;
+    if (startGain != endGain) {
+        int numRampFrames = min(numFrames, rampFrames);
+        float gain = startGain;
+        float gainStep = (endGain-startGain)/rampFrames;
+        for (int frame = 0; frame < numRampFrames; ++frame) {
+            for (int j = 0; j < numChannels; ++j, ++i) {
+                pBuffer[i] *= gain;
+            }
+            gain += gainStep;
+        }
+    } else if (endGain == 1.f) {
+        return;
+    }
+
+    int numSamples = numFrames*numChannels;
+    switch (getSIMDLevel()) {
+#ifdef AVG_SIMD_X86
+        case SIMD_AVX2:
+            i = applyGainAVX2(pBuffer, i, numSamples, endGain);
+            break;
+        case SIMD_SSE2:
+            i = applyGainSSE2(pBuffer, i, numSamples, endGain);
+            break;
+#endif
+#ifdef AVG_SIMD_NEON
+        case SIMD_NEON:
+            i = applyGainNEON(pBuffer, i, numSamples, endGain);
+            break;
+#endif
+        default:
+            break;
+    }
+    for (; i < numSamples; ++i) {
+        pBuffer[i] *= endGain;
+    }
+}
+
+void floatToShort(short* pDest, const float* pSrc, int numSamples)
+{
+    // Values are clamped in float before the truncating conversion, so all code paths
+    // produce identical results.
+    int i = 0;
+    switch (getSIMDLevel()) {
+#ifdef AVG_SIMD_X86
+        case SIMD_AVX2:
+            i = floatToShortAVX2(pDest, pSrc, numSamples);
+            break;
+        case SIMD_SSE2:
+            i = floatToShortSSE2(pDest, pSrc, numSamples);
+            break;
+#endif
+#ifdef AVG_SIMD_NEON
+        case SIMD_NEON:
+            i = floatToShortNEON(pDest, pSrc, numSamples);
+            break;
+#endif
+        default:
+            break;
+    }
+    for (; i < numSamples; ++i) {
+        float val = pSrc[i]*32768.f;
+        if (val < -32768.f) {
+            val = -32768.f;
+        } else if (val > 32767.f) {
+            val = 32767.f;
+        }
+        pDest[i] = short(val);
+    }
+}
+
+}
@@ -0,0 +1,50 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _MixHelper_H_
+#define _MixHelper_H_
+
+#include "../api.h"
+
+namespace avg {
+
+// Length of the gain ramp applied when a volume changes.
+static const int VOLUME_FADE_FRAMES = 100;
+
+// Sample processing primitives used by the software mixer. Buffers contain
+// interleaved samples. The gain ramps linearly from startGain to endGain over the
+// first rampFrames frames and stays at endGain for the rest of the buffer. The
+// constant-gain part runs on the instruction set selected by getSIMDLevel().
+
+// Converts pSrc to float in [-1, 1), scales it and adds it to pDest.
+AVG_API void mixSamples(float* pDest, const short* pSrc, int numFrames, int numChannels,
+        float startGain, float endGain, int rampFrames);
+
+AVG_API void applyGain(float* pBuffer, int numFrames, int numChannels,
+        float startGain, float endGain, int rampFrames);
+
+// Converts to 16 bit, saturating values outside of [-1, 1).
+AVG_API void floatToShort(short* pDest, const float* pSrc, int numSamples);
+
+}
+
+#endif
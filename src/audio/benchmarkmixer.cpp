@@ -0,0 +1,147 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "MixHelper.h"
+
+#include "../base/SIMDHelper.h"
+#include "../base/TimeSource.h"
+
+#include <iostream>
+#include <string>
+#include <string.h>
+#include <vector>
+
+using namespace avg;
+using namespace std;
+
+static const int NUM_CHANNELS = 2;
+static const int NUM_FRAMES = 1024;
+static const int NUM_SAMPLES = NUM_FRAMES*NUM_CHANNELS;
+static const int NUM_SOURCES = 16;
+
+static const float SOURCE_VOLUME = 0.8f;
+static const float MASTER_VOLUME = 0.9f;
+static const int VOLUME_FADE_SAMPLES = 100;
+
+// The per-sample loops the mixer used before it was vectorised: Each source was
+// volume-adjusted in 16 bit, then converted and added.
+static void volumizeReference(short* pData, float lastVol, float curVol)
+{
+    float volDiff = lastVol - curVol;
+    for (int i = 0; i < NUM_SAMPLES; i++) {
+        float fadeVol = 0;
+        if (volDiff != 0 && i < VOLUME_FADE_SAMPLES) {
+            fadeVol = volDiff * (VOLUME_FADE_SAMPLES - i) / VOLUME_FADE_SAMPLES;
+        }
+        int s = int(pData[i] * (curVol + fadeVol));
+        if (s < -32768)
+            s = -32768;
+        if (s >  32767)
+            s = 32767;
+        pData[i] = s;
+    }
+}
+
+static void mixReference(float* pMix, const vector<short*>& pSources, short* pTemp,
+        short* pDest)
+{
+    for (int i = 0; i < NUM_SAMPLES; ++i) {
+        pMix[i] = 0;
+    }
+    for (unsigned j = 0; j < pSources.size(); ++j) {
+        memcpy(pTemp, pSources[j], NUM_SAMPLES*sizeof(short));
+        volumizeReference(pTemp, SOURCE_VOLUME, SOURCE_VOLUME);
+        for (int i = 0; i < NUM_SAMPLES; ++i) {
+            pMix[i] += pTemp[i]/32768.0f;
+        }
+    }
+    for (int i = 0; i < NUM_SAMPLES; ++i) {
+        pMix[i] *= MASTER_VOLUME;
+    }
+    for (int i = 0; i < NUM_SAMPLES; ++i) {
+        pDest[i] = short(pMix[i]*32768);
+    }
+}
+
+static void mixVectorised(float* pMix, const vector<short*>& pSources, short* pTemp,
+        short* pDest)
+{
+    for (int i = 0; i < NUM_SAMPLES; ++i) {
+        pMix[i] = 0;
+    }
+    for (unsigned j = 0; j < pSources.size(); ++j) {
+        memcpy(pTemp, pSources[j], NUM_SAMPLES*sizeof(short));
+        mixSamples(pMix, pTemp, NUM_FRAMES, NUM_CHANNELS, SOURCE_VOLUME, SOURCE_VOLUME,
+                0);
+    }
+    applyGain(pMix, NUM_FRAMES, NUM_CHANNELS, MASTER_VOLUME, MASTER_VOLUME, 0);
+    floatToShort(pDest, pMix, NUM_SAMPLES);
+}
+
+typedef void (*MixFunc)(float*, const vector<short*>&, short*, short*);
+
+void runMixBenchmark(const string& sName, MixFunc mixFunc, int numRuns=20000)
+{
+    vector<short*> pSources;
+    for (int j = 0; j < NUM_SOURCES; ++j) {
+        short* pSrc = new short[NUM_SAMPLES];
+        for (int i = 0; i < NUM_SAMPLES; ++i) {
+            pSrc[i] = short((i*(j+1)*31)%4096 - 2048);
+        }
+        pSources.push_back(pSrc);
+    }
+    float* pMix = new float[NUM_SAMPLES];
+    short* pTemp = new short[NUM_SAMPLES];
+    short* pDest = new short[NUM_SAMPLES];
+
+    long long startTime = TimeSource::get()->getCurrentMicrosecs();
+    for (int i = 0; i < numRuns; ++i) {
+        mixFunc(pMix, pSources, pTemp, pDest);
+    }
+    float activeTime = (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000.f;
+    cerr << sName << ": " << activeTime/numRuns*1000 << " us per buffer, "
+            << (float(NUM_SAMPLES)*NUM_SOURCES*numRuns)/(activeTime*1000) 
+            << " M source samples/s" << endl;
+
+    for (unsigned j = 0; j < pSources.size(); ++j) {
+        delete[] pSources[j];
+    }
+    delete[] pMix;
+    delete[] pTemp;
+    delete[] pDest;
+}
+
+int main(int nargs, char** args)
+{
+    cerr << NUM_SOURCES << " sources, " << NUM_FRAMES << " frames, " << NUM_CHANNELS 
+            << " channels" << endl;
+    runMixBenchmark("  Per-sample", &mixReference);
+    SIMDLevel origLevel = getSIMDLevel();
+    for (int i = SIMD_NONE; i <= SIMD_NEON; ++i) {
+        SIMDLevel level = SIMDLevel(i);
+        if (isSIMDLevelSupported(level)) {
+            setSIMDLevel(level);
+            runMixBenchmark(string("  ")+getSIMDLevelName(level), &mixVectorised);
+        }
+    }
+    setSIMDLevel(origLevel);
+}
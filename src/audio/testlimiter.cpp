@@ -20,7 +20,12 @@
 //
 
 #include "Dynamics.h"
+#include "MixHelper.h"
+#include "AudioSource.h"
+#include "AudioBuffer.h"
+#include "AudioMsg.h"
 
+#include "../base/SIMDHelper.h"
 #include "../base/TestSuite.h"
 #include "../base/MathHelper.h"
 
@@ -98,11 +103,225 @@ public:
     }
 };
 
+class MixHelperTest: public Test {
+public:
+    MixHelperTest()
+        : Test("MixHelperTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        SIMDLevel origLevel = getSIMDLevel();
+        for (int i = SIMD_NONE; i <= SIMD_NEON; ++i) {
+            SIMDLevel level = SIMDLevel(i);
+            if (isSIMDLevelSupported(level)) {
+                cerr << "    Testing " << getSIMDLevelName(level) << " kernels." << endl;
+                setSIMDLevel(level);
+                runLevelTests();
+            }
+        }
+        setSIMDLevel(origLevel);
+    }
+
+private:
+    void runLevelTests()
+    {
+        const int CHANNELS = 2;
+        // Odd frame count so the scalar tail of the vectorised loops is exercised.
+        const int NUM_FRAMES = 1001;
+        const int RAMP_FRAMES = 100;
+        const int NUM_SAMPLES = NUM_FRAMES*CHANNELS;
+
+        short* pSrc = new short[NUM_SAMPLES];
+        for (int i = 0; i < NUM_SAMPLES; ++i) {
+            pSrc[i] = short((i*7919)%65536 - 32768);
+        }
+        pSrc[0] = -32768;
+        pSrc[1] = 32767;
+
+        // Accumulate with gain ramp.
+        float* pMix = new float[NUM_SAMPLES];
+        float* pExpected = new float[NUM_SAMPLES];
+        for (int i = 0; i < NUM_SAMPLES; ++i) {
+            pMix[i] = 0.25f;
+            pExpected[i] = 0.25f;
+        }
+        mixSamples(pMix, pSrc, NUM_FRAMES, CHANNELS, 0.f, 0.5f, RAMP_FRAMES);
+        for (int frame = 0; frame < NUM_FRAMES; ++frame) {
+            float gain = 0.5f;
+            if (frame < RAMP_FRAMES) {
+                gain = 0.5f - 0.5f*(RAMP_FRAMES-frame)/RAMP_FRAMES;
+            }
+            for (int j = 0; j < CHANNELS; ++j) {
+                int i = frame*CHANNELS+j;
+                pExpected[i] += pSrc[i]*gain/32768;
+            }
+        }
+        TEST(isEqual(pMix, pExpected, NUM_SAMPLES));
+        // Both channels of a frame get the same gain.
+        TEST(pMix[0] == 0.25f && pMix[1] == 0.25f);
+
+        // Constant gain.
+        applyGain(pMix, NUM_FRAMES, CHANNELS, 2.f, 2.f, RAMP_FRAMES);
+        for (int i = 0; i < NUM_SAMPLES; ++i) {
+            pExpected[i] *= 2.f;
+        }
+        TEST(isEqual(pMix, pExpected, NUM_SAMPLES));
+
+        // Saturating conversion.
+        float values[] = {-2.f, -1.f, -0.5f, 0.f, 0.5f, 0.99999f, 1.f, 2.f, 
+                0.25f, -0.25f, 1e10f, -1e10f, 0.000015f, -0.000015f, 0.75f, -0.75f, 
+                0.1f};
+        short expected[] = {-32768, -32768, -16384, 0, 16384, 32767, 32767, 32767,
+                8192, -8192, 32767, -32768, 0, 0, 24576, -24576, 3276};
+        const int NUM_VALUES = sizeof(values)/sizeof(float);
+        short dest[NUM_VALUES];
+        floatToShort(dest, values, NUM_VALUES);
+        bool bOK = true;
+        for (int i = 0; i < NUM_VALUES; ++i) {
+            if (dest[i] != expected[i]) {
+                cerr << "floatToShort(" << values[i] << "): " << dest[i] << ", expected "
+                        << expected[i] << endl;
+                bOK = false;
+            }
+        }
+        TEST(bOK);
+
+        delete[] pSrc;
+        delete[] pMix;
+        delete[] pExpected;
+    }
+
+    bool isEqual(const float* pBuffer1, const float* pBuffer2, int numSamples)
+    {
+        for (int i = 0; i < numSamples; ++i) {
+            if (fabs(pBuffer1[i]-pBuffer2[i]) > 0.000001f) {
+                cerr << "Sample " << i << ": " << pBuffer1[i] << ", expected " 
+                        << pBuffer2[i] << endl;
+                return false;
+            }
+        }
+        return true;
+    }
+};
+
+class AudioSourceTest: public Test {
+public:
+    AudioSourceTest()
+        : Test("AudioSourceTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        m_pMsgQ = AudioMsgQueuePtr(new AudioMsgQueue);
+        m_pStatusQ = AudioMsgQueuePtr(new AudioMsgQueue);
+        AudioTimeStatusPtr pTimeStatus(new AudioTimeStatus(-1));
+        AudioSource source(m_pMsgQ, m_pStatusQ, pTimeStatus, SAMPLE_RATE);
+        AudioParams ap(SAMPLE_RATE, 2, NUM_FRAMES);
+        m_pTempBuffer = AudioBufferPtr(new AudioBuffer(NUM_FRAMES, ap));
+        m_pMixBuffer = new float[NUM_FRAMES*2];
+
+        // Running out of data is an underrun. The playback time is reported without 
+        // status messages.
+        pushAudio(ap);
+        TEST(mix(source));
+        TEST(*pTimeStatus == 0);
+        TEST(m_pStatusQ->empty());
+        TEST(!mix(source));
+
+        // No underruns while seeks are pending. An EOF doesn't end a seek, only the
+        // SEEK_DONE of the last seek does.
+        source.notifySeek();
+        source.notifySeek();
+        TEST(mix(source));
+        pushSeekDone(1);
+        TEST(mix(source));
+        pushEOF();
+        TEST(mix(source));
+        pushSeekDone(2);
+        pushAudio(ap);
+        TEST(mix(source));
+        TEST(!mix(source));
+
+        // A stray SEEK_DONE can't complete seeks that haven't been requested yet.
+        pushSeekDone(3);
+        TEST(!mix(source));
+        source.notifySeek();
+        TEST(mix(source));
+        pushSeekDone(3);
+        TEST(!mix(source));
+
+        // Looping: The decoder seeks to the start after the end of the stream.
+        pushAudio(ap);
+        pushEOF();
+        TEST(mix(source));
+        TEST(mix(source));
+        source.notifySeek();
+        pushSeekDone(4);
+        pushAudio(ap);
+        TEST(mix(source));
+        TEST(!mix(source));
+
+        delete[] m_pMixBuffer;
+    }
+
+private:
+    bool mix(AudioSource& source)
+    {
+        return source.mixAudio(m_pMixBuffer, m_pTempBuffer);
+    }
+
+    void pushAudio(const AudioParams& ap)
+    {
+        AudioBufferPtr pBuffer(new AudioBuffer(NUM_FRAMES, ap));
+        pBuffer->clear();
+        AudioMsgPtr pMsg(new AudioMsg);
+        pMsg->setAudio(pBuffer, 0);
+        m_pMsgQ->push(pMsg);
+    }
+
+    void pushSeekDone(int seqNum)
+    {
+        AudioMsgPtr pMsg(new AudioMsg);
+        pMsg->setSeekDone(seqNum, 0);
+        m_pMsgQ->push(pMsg);
+    }
+
+    void pushEOF()
+    {
+        AudioMsgPtr pMsg(new AudioMsg);
+        pMsg->setEOF();
+        m_pMsgQ->push(pMsg);
+    }
+
+    static const int SAMPLE_RATE = 44100;
+    static const int NUM_FRAMES = 256;
+
+    AudioMsgQueuePtr m_pMsgQ;
+    AudioMsgQueuePtr m_pStatusQ;
+    AudioBufferPtr m_pTempBuffer;
+    float* m_pMixBuffer;
+};
+
+class AudioTestSuite: public TestSuite
+{
+public:
+    AudioTestSuite() 
+        : TestSuite("AudioTestSuite")
+    {
+        addTest(TestPtr(new LimiterTest));
+        addTest(TestPtr(new MixHelperTest));
+        addTest(TestPtr(new AudioSourceTest));
+    }
+};
+
 int main(int nargs, char** args)
 {
-    LimiterTest test;
-    test.runTests();
-    bool bOK = test.isOk();
+    AudioTestSuite suite;
+    suite.runTests();
+    bool bOK = suite.isOk();
 
     if (bOK) {
         return 0;
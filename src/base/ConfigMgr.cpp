@@ -80,7 +80,16 @@ ConfigMgr::ConfigMgr()
     addOption("scr", "gamma", "-1,-1,-1");
     addOption("scr", "vsyncmode", "auto");
     addOption("scr", "videoaccel", "true");
+    addOption("scr", "videodecodingthreads", "0");
+    addOption("scr", "videoworkerthreads", "0");
+    addOption("scr", "keyframeindexdir", "");
+    addOption("scr", "filterthreads", "0");
+    addOption("scr", "filterminpixels", "65536");
     addOption("scr", "imgcachesize", "-1,-1");
+    addOption("scr", "imgdiskcachedir", "");
+    addOption("scr", "imgdiskcachesize", "1024");
+    addOption("scr", "imgatlaspagesize", "0");
+    addOption("scr", "imgatlasmaximagesize", "128");
     
     addSubsys("aud");
     addOption("aud", "channels", "2");
@@ -102,6 +111,7 @@ ConfigMgr::ConfigMgr()
     addSubsys("touch");
     addOption("touch", "area", "0, 0");
     addOption("touch", "offset", "0, 0");
+    addOption("touch", "contacthistorylength", "256");
 
     m_sFName = "avgrc";
     loadFile(getGlobalConfigDir()+m_sFName);
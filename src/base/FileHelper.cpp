@@ -120,6 +120,45 @@ bool fileExists(const string& sFilename)
     return stat(sFilename.c_str(), &myStat) != -1;
 }
 
+bool statFile(const string& sFilename, long long& size, long long& modTime)
+{
+    struct stat fileStat;
+    if (stat(sFilename.c_str(), &fileStat) != 0) {
+        return false;
+    }
+    size = fileStat.st_size;
+    modTime = fileStat.st_mtime;
+    return true;
+}
+
+void makeDir(const string& sDir)
+{
+#ifdef _WIN32
+    _mkdir(sDir.c_str());
+#else
+    mkdir(sDir.c_str(), 0755);
+#endif
+}
+
+void removeDir(const string& sDir)
+{
+#ifdef _WIN32
+    _rmdir(sDir.c_str());
+#else
+    rmdir(sDir.c_str());
+#endif
+}
+
+unsigned long long hashString(const string& s)
+{
+    unsigned long long hash = 14695981039346656037ULL;
+    for (unsigned i = 0; i < s.size(); ++i) {
+        hash ^= (unsigned char)(s[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
 void readWholeFile(const string& sFilename, string& sContent)
 {
     ifstream file(sFilename.c_str());
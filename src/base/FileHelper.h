@@ -36,6 +36,16 @@ bool AVG_API isAbsPath(const std::string& path);
 
 bool AVG_API fileExists(const std::string& sFilename);
 
+// Returns false if the file doesn't exist.
+bool AVG_API statFile(const std::string& sFilename, long long& size, long long& modTime);
+
+void AVG_API makeDir(const std::string& sDir);
+// The directory must be empty.
+void AVG_API removeDir(const std::string& sDir);
+
+// 64-bit FNV-1a. Stable across platforms and runs, unlike std::hash.
+unsigned long long AVG_API hashString(const std::string& s);
+
 void AVG_API readWholeFile(const std::string& sFilename, std::string& sContents);
 
 void AVG_API writeWholeFile(const std::string& sFilename, const std::string& sContent);
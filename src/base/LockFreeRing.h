@@ -0,0 +1,199 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _LockFreeRing_H_
+#define _LockFreeRing_H_
+
+#include "../api.h"
+
+#include <atomic>
+#include <assert.h>
+#include <stddef.h>
+
+#define AVG_CACHE_LINE_SIZE 64
+
+namespace avg {
+
+// Bounded, non-blocking ring buffer. tryPush() fails if the ring is full, tryPop()
+// fails if it's empty. Every cell carries a sequence number (D. Vyukov's bounded
+// queue), so producers and consumers never touch each other's index.
+//
+// In single-producer mode, exactly one thread may push and one thread may pop at
+// any time. In multi-producer mode, any number of threads may push and pop
+// concurrently. In both modes, tryPeek() must not race with a pop from a
+// different thread.
+template<class ELEMENT>
+class AVG_TEMPLATE_API LockFreeRing
+{
+public:
+    LockFreeRing(int capacity, bool bMultiProducer);
+    ~LockFreeRing();
+
+    bool tryPush(const ELEMENT& elem);
+    bool tryPop(ELEMENT& elem);
+    bool tryPeek(ELEMENT& elem) const;
+    int size() const;
+    int getCapacity() const;
+    bool isMultiProducer() const;
+
+private:
+    LockFreeRing(const LockFreeRing&);
+    LockFreeRing& operator=(const LockFreeRing&);
+
+    struct Cell {
+        std::atomic<size_t> m_Seq;
+        ELEMENT m_Elem;
+    };
+
+    Cell* m_pCells;
+    const size_t m_Capacity;
+    const bool m_bMultiProducer;
+
+    // Head and tail live on separate cache lines so producers and consumers don't
+    // invalidate each other's cache line on every operation.
+    char m_Pad0[AVG_CACHE_LINE_SIZE];
+    std::atomic<size_t> m_Head;
+    char m_Pad1[AVG_CACHE_LINE_SIZE-sizeof(std::atomic<size_t>)];
+    std::atomic<size_t> m_Tail;
+    char m_Pad2[AVG_CACHE_LINE_SIZE-sizeof(std::atomic<size_t>)];
+};
+
+template<class ELEMENT>
+LockFreeRing<ELEMENT>::LockFreeRing(int capacity, bool bMultiProducer)
+    : m_Capacity(capacity),
+      m_bMultiProducer(bMultiProducer),
+      m_Head(0),
+      m_Tail(0)
+{
+    assert(capacity > 0);
+    m_pCells = new Cell[m_Capacity];
+    for (size_t i = 0; i < m_Capacity; ++i) {
+        m_pCells[i].m_Seq.store(i, std::memory_order_relaxed);
+    }
+}
+
+template<class ELEMENT>
+LockFreeRing<ELEMENT>::~LockFreeRing()
+{
+    delete[] m_pCells;
+}
+
+template<class ELEMENT>
+bool LockFreeRing<ELEMENT>::tryPush(const ELEMENT& elem)
+{
+    size_t pos = m_Tail.load(std::memory_order_relaxed);
+    Cell* pCell;
+    while (true) {
+        pCell = &m_pCells[pos % m_Capacity];
+        size_t seq = pCell->m_Seq.load(std::memory_order_acquire);
+        if (seq == pos) {
+            if (!m_bMultiProducer) {
+                m_Tail.store(pos+1, std::memory_order_relaxed);
+                break;
+            }
+            if (m_Tail.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) {
+                break;
+            }
+            // pos has been reloaded by compare_exchange_weak.
+        } else if (seq < pos) {
+            // Cell still holds the element from the previous lap: full.
+            return false;
+        } else {
+            pos = m_Tail.load(std::memory_order_relaxed);
+        }
+    }
+    pCell->m_Elem = elem;
+    pCell->m_Seq.store(pos+1, std::memory_order_release);
+    return true;
+}
+
+template<class ELEMENT>
+bool LockFreeRing<ELEMENT>::tryPop(ELEMENT& elem)
+{
+    size_t pos = m_Head.load(std::memory_order_relaxed);
+    Cell* pCell;
+    while (true) {
+        pCell = &m_pCells[pos % m_Capacity];
+        size_t seq = pCell->m_Seq.load(std::memory_order_acquire);
+        if (seq == pos+1) {
+            if (!m_bMultiProducer) {
+                m_Head.store(pos+1, std::memory_order_relaxed);
+                break;
+            }
+            if (m_Head.compare_exchange_weak(pos, pos+1, std::memory_order_relaxed)) {
+                break;
+            }
+        } else if (seq < pos+1) {
+            return false;
+        } else {
+            pos = m_Head.load(std::memory_order_relaxed);
+        }
+    }
+    elem = pCell->m_Elem;
+    // Don't keep a reference to the element alive in the ring.
+    pCell->m_Elem = ELEMENT();
+    pCell->m_Seq.store(pos+m_Capacity, std::memory_order_release);
+    return true;
+}
+
+template<class ELEMENT>
+bool LockFreeRing<ELEMENT>::tryPeek(ELEMENT& elem) const
+{
+    size_t pos = m_Head.load(std::memory_order_relaxed);
+    const Cell& cell = m_pCells[pos % m_Capacity];
+    if (cell.m_Seq.load(std::memory_order_acquire) == pos+1) {
+        elem = cell.m_Elem;
+        return true;
+    } else {
+        return false;
+    }
+}
+
+template<class ELEMENT>
+int LockFreeRing<ELEMENT>::size() const
+{
+    // Approximate if other threads are active.
+    size_t head = m_Head.load(std::memory_order_acquire);
+    size_t tail = m_Tail.load(std::memory_order_acquire);
+    if (tail <= head) {
+        return 0;
+    } else if (tail-head > m_Capacity) {
+        return int(m_Capacity);
+    } else {
+        return int(tail-head);
+    }
+}
+
+template<class ELEMENT>
+int LockFreeRing<ELEMENT>::getCapacity() const
+{
+    return int(m_Capacity);
+}
+
+template<class ELEMENT>
+bool LockFreeRing<ELEMENT>::isMultiProducer() const
+{
+    return m_bMultiProducer;
+}
+
+}
+
+#endif
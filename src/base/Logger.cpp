@@ -23,8 +23,12 @@
 #include "Exception.h"
 #include "StandardLogSink.h"
 #include "OSHelper.h"
+#include "TimeSource.h"
+#include "LockFreeRing.h"
 
 #include <boost/algorithm/string.hpp>
+#include <boost/bind.hpp>
+#include <boost/thread/tss.hpp>
 
 #ifdef _WIN32
 #include <Winsock2.h>
@@ -37,6 +41,7 @@
 #endif
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 
 using namespace std;
 namespace ba = boost::algorithm;
@@ -62,12 +67,79 @@ namespace avg {
     const category_t Logger::category::DEPRECATION = UTF8String("DEPREC");
     const category_t Logger::category::VIDEO = UTF8String("VIDEO");
 
+struct LogMessage {
+#ifdef _WIN32
+    __int64 m_Time;
+#else
+    time_t m_Time;
+#endif
+    unsigned m_Millis;
+    category_t m_Category;
+    severity_t m_Severity;
+    UTF8String m_sMsg;
+};
+
+const int THREAD_BUFFER_SIZE = 1024;
+const int LOG_THREAD_SLEEP_TIME = 5;
+// Maximum time in milliseconds a producer waits for room with BLOCK_PRODUCER.
+const int MAX_PRODUCER_WAIT_TIME = 100;
+
+class ThreadLogBuffer {
+public:
+    ThreadLogBuffer()
+        : m_Messages(THREAD_BUFFER_SIZE, false),
+          m_bThreadExited(false),
+          m_bWaitTimedOut(false)
+    {
+    }
+
+    LockFreeRing<LogMessage> m_Messages;
+    std::atomic<bool> m_bThreadExited;
+    // Only accessed by the producer thread.
+    bool m_bWaitTimedOut;
+};
+
 namespace {
     Logger* s_pLogger = 0;
     boost::mutex s_logMutex;
     boost::mutex s_traceMutex;
     boost::mutex s_sinkMutex;
     boost::mutex s_removeStdSinkMutex;
+    boost::mutex s_asyncMutex;
+    boost::mutex s_bufferMutex;
+    boost::mutex s_dispatchMutex;
+
+    // Owned by the thread that logs into the buffer and deleted when it exits. The
+    // logger keeps the buffer until the logging thread has emptied it.
+    class ThreadLogBufferRef {
+    public:
+        ThreadLogBufferRef(const ThreadLogBufferPtr& pBuffer)
+            : m_pBuffer(pBuffer)
+        {
+        }
+
+        ~ThreadLogBufferRef()
+        {
+            m_pBuffer->m_bThreadExited = true;
+        }
+
+        ThreadLogBufferPtr m_pBuffer;
+    };
+    boost::thread_specific_ptr<ThreadLogBufferRef> s_pThreadBufferRef;
+
+    void setCurrentTime(LogMessage& msg)
+    {
+        #ifdef _WIN32
+        _time64(&msg.m_Time);
+        DWORD tms = timeGetTime();
+        msg.m_Millis = unsigned(tms % 1000);
+        #else
+        struct timeval time;
+        gettimeofday(&time, NULL);
+        msg.m_Time = time.tv_sec;
+        msg.m_Millis = time.tv_usec/1000;
+        #endif
+    }
 }
 
 boost::mutex Logger::m_CategoryMutex;
@@ -82,7 +154,17 @@ Logger * Logger::get()
 }
 
 Logger::Logger()
+    : m_bAsync(false),
+      m_OverflowPolicy(DROP_MESSAGES),
+      m_NumDroppedMessages(0),
+      m_NumReportedDroppedMessages(0),
+      m_pLogThread(0),
+      m_bStopLogThread(false)
 {
+    for (int i = 0; i < MAX_CATEGORIES; ++i) {
+        m_CategorySlots[i].m_pCategory = 0;
+        m_CategorySlots[i].m_Severity = severity::NONE;
+    }
     m_Severity = severity::WARNING;
     string sEnvSeverity;
     bool bEnvSeveritySet = getEnv("AVG_LOG_SEVERITY", sEnvSeverity);
@@ -120,10 +202,18 @@ Logger::Logger()
         m_pStdSink = LogSinkPtr(new StandardLogSink);
         addLogSink(m_pStdSink);
     }
+
+    if (getEnv("AVG_LOG_ASYNC", sDummy)) {
+        setAsync(true);
+    }
 }
 
 Logger::~Logger()
 {
+    setAsync(false);
+    for (int i = 0; i < MAX_CATEGORIES; ++i) {
+        delete m_CategorySlots[i].m_pCategory.load();
+    }
 }
 
 void Logger::addLogSink(const LogSinkPtr& logSink)
@@ -163,35 +253,28 @@ category_t Logger::configureCategory(category_t category, severity_t severity)
     }
     pair<const category_t, const severity_t> element(sCategory, severity);
     m_CategorySeverities.insert(element);
+    setCategorySeverity(sCategory, severity);
     return sCategory;
 }
 
 CatToSeverityMap Logger::getCategories()
 {
+    lock_guard lock(m_CategoryMutex);
     return m_CategorySeverities;
 }
 
 void Logger::trace(const UTF8String& sMsg, const category_t& category,
         severity_t severity) const
 {
-    lock_guard lock(s_traceMutex);
-    struct tm* pTime;
-    #ifdef _WIN32
-    __int64 now;
-    _time64(&now);
-    pTime = _localtime64(&now);
-    DWORD tms = timeGetTime();
-    unsigned millis = unsigned(tms % 1000);
-    #else
-    struct timeval time;
-    gettimeofday(&time, NULL);
-    pTime = localtime(&time.tv_sec);
-    unsigned millis = time.tv_usec/1000;
-    #endif
-    lock_guard lockHandler(s_sinkMutex);
-    std::vector<LogSinkPtr>::const_iterator it;
-    for(it=m_pSinks.begin(); it!=m_pSinks.end(); ++it){
-        (*it)->logMessage(pTime, millis, category, severity, sMsg);
+    LogMessage msg;
+    setCurrentTime(msg);
+    msg.m_Category = category;
+    msg.m_Severity = severity;
+    msg.m_sMsg = sMsg;
+    if (m_bAsync) {
+        queue(msg);
+    } else {
+        dispatch(msg);
     }
 }
 
@@ -228,6 +311,214 @@ void Logger::log(const UTF8String& msg, const category_t& category,
     }
 }
 
+void Logger::setAsync(bool bAsync, OverflowPolicy policy)
+{
+    lock_guard lock(s_asyncMutex);
+    m_OverflowPolicy = policy;
+    if (bAsync && !m_pLogThread) {
+        m_bStopLogThread = false;
+        m_bAsync = true;
+        m_pLogThread = new boost::thread(boost::bind(&Logger::logThreadFunc, this));
+    } else if (!bAsync && m_pLogThread) {
+        m_bAsync = false;
+        stopLogThread();
+    }
+}
+
+bool Logger::isAsync() const
+{
+    return m_bAsync;
+}
+
+Logger::OverflowPolicy Logger::getOverflowPolicy() const
+{
+    return OverflowPolicy(m_OverflowPolicy.load());
+}
+
+void Logger::flush()
+{
+    dispatchQueuedMessages();
+}
+
+long long Logger::getNumDroppedMessages() const
+{
+    return m_NumDroppedMessages;
+}
+
+void Logger::dispatch(const LogMessage& msg) const
+{
+    lock_guard lock(s_traceMutex);
+    struct tm* pTime;
+    #ifdef _WIN32
+    pTime = _localtime64(&msg.m_Time);
+    #else
+    pTime = localtime(&msg.m_Time);
+    #endif
+    lock_guard lockHandler(s_sinkMutex);
+    std::vector<LogSinkPtr>::const_iterator it;
+    for(it=m_pSinks.begin(); it!=m_pSinks.end(); ++it){
+        (*it)->logMessage(pTime, msg.m_Millis, msg.m_Category, msg.m_Severity, 
+                msg.m_sMsg);
+    }
+}
+
+void Logger::queue(const LogMessage& msg) const
+{
+    ThreadLogBuffer* pBuffer = getThreadBuffer();
+    int waitTime = 0;
+    while (!pBuffer->m_Messages.tryPush(msg)) {
+        if (!m_bAsync) {
+            dispatchThreadBuffer(pBuffer);
+            dispatch(msg);
+            return;
+        }
+        if (m_OverflowPolicy == DROP_MESSAGES || pBuffer->m_bWaitTimedOut) {
+            m_NumDroppedMessages++;
+            return;
+        }
+        // Wait for the logging thread to make room. The calling thread may hold a
+        // resource a sink needs (e.g. the python GIL), so give up after a while 
+        // instead of deadlocking. Further messages are dropped without waiting until
+        // there is room again.
+        if (waitTime >= MAX_PRODUCER_WAIT_TIME) {
+            pBuffer->m_bWaitTimedOut = true;
+            m_NumDroppedMessages++;
+            return;
+        }
+        msleep(1);
+        waitTime++;
+    }
+    pBuffer->m_bWaitTimedOut = false;
+    if (!m_bAsync) {
+        // Async mode was switched off after trace() checked it, so the logging thread
+        // may already have dispatched its last messages.
+        dispatchThreadBuffer(pBuffer);
+    }
+}
+
+void Logger::dispatchThreadBuffer(ThreadLogBuffer* pBuffer) const
+{
+    lock_guard dispatchLock(s_dispatchMutex);
+    LogMessage msg;
+    while (pBuffer->m_Messages.tryPop(msg)) {
+        dispatch(msg);
+    }
+}
+
+ThreadLogBuffer* Logger::getThreadBuffer() const
+{
+    ThreadLogBufferRef* pRef = s_pThreadBufferRef.get();
+    if (!pRef) {
+        ThreadLogBufferPtr pBuffer(new ThreadLogBuffer);
+        {
+            lock_guard lock(s_bufferMutex);
+            m_pThreadBuffers.push_back(pBuffer);
+        }
+        pRef = new ThreadLogBufferRef(pBuffer);
+        s_pThreadBufferRef.reset(pRef);
+    }
+    return pRef->m_pBuffer.get();
+}
+
+bool Logger::dispatchQueuedMessages()
+{
+    lock_guard dispatchLock(s_dispatchMutex);
+    vector<ThreadLogBufferPtr> pBuffers;
+    {
+        lock_guard lock(s_bufferMutex);
+        pBuffers = m_pThreadBuffers;
+    }
+    bool bDispatched = false;
+    LogMessage msg;
+    for (unsigned i = 0; i < pBuffers.size(); ++i) {
+        ThreadLogBuffer* pBuffer = pBuffers[i].get();
+        // Read before emptying the buffer: Exited threads don't push any more.
+        bool bThreadExited = pBuffer->m_bThreadExited;
+        // Bounded so a thread that logs continuously can't starve the others.
+        for (int j = 0; j < THREAD_BUFFER_SIZE && pBuffer->m_Messages.tryPop(msg); ++j)
+        {
+            dispatch(msg);
+            bDispatched = true;
+        }
+        if (bThreadExited && pBuffer->m_Messages.size() == 0) {
+            lock_guard lock(s_bufferMutex);
+            m_pThreadBuffers.erase(find(m_pThreadBuffers.begin(), m_pThreadBuffers.end(),
+                    pBuffers[i]));
+        }
+    }
+
+    long long numDroppedMessages = m_NumDroppedMessages;
+    if (numDroppedMessages != m_NumReportedDroppedMessages) {
+        stringstream ss;
+        ss << "Logger: Buffer overflow, " 
+                << numDroppedMessages-m_NumReportedDroppedMessages 
+                << " messages dropped.";
+        setCurrentTime(msg);
+        msg.m_Category = category::NONE;
+        msg.m_Severity = severity::WARNING;
+        msg.m_sMsg = ss.str();
+        dispatch(msg);
+        m_NumReportedDroppedMessages = numDroppedMessages;
+    }
+    return bDispatched;
+}
+
+void Logger::logThreadFunc()
+{
+    while (!m_bStopLogThread) {
+        if (!dispatchQueuedMessages()) {
+            msleep(LOG_THREAD_SLEEP_TIME);
+        }
+    }
+}
+
+void Logger::stopLogThread()
+{
+    m_bStopLogThread = true;
+    m_pLogThread->join();
+    delete m_pLogThread;
+    m_pLogThread = 0;
+    // Messages queued while the thread was shutting down.
+    dispatchQueuedMessages();
+}
+
+severity_t Logger::getCategorySeverity(const category_t& category) const
+{
+    size_t hash = hash_value(category);
+    for (int i = 0; i < MAX_CATEGORIES; ++i) {
+        const CategorySlot& slot = m_CategorySlots[(hash+i) % MAX_CATEGORIES];
+        const category_t* pCategory = slot.m_pCategory.load(memory_order_acquire);
+        if (!pCategory) {
+            break;
+        }
+        if (*pCategory == category) {
+            return slot.m_Severity.load(memory_order_relaxed);
+        }
+    }
+    string msg("Unknown category: " + category);
+    throw Exception(AVG_ERR_INVALID_ARGS, msg);
+}
+
+void Logger::setCategorySeverity(const category_t& category, severity_t severity)
+{
+    // Called with m_CategoryMutex held, so there is only one writer.
+    size_t hash = hash_value(category);
+    for (int i = 0; i < MAX_CATEGORIES; ++i) {
+        CategorySlot& slot = m_CategorySlots[(hash+i) % MAX_CATEGORIES];
+        const category_t* pCategory = slot.m_pCategory.load(memory_order_relaxed);
+        if (!pCategory) {
+            slot.m_Severity.store(severity, memory_order_relaxed);
+            slot.m_pCategory.store(new category_t(category), memory_order_release);
+            return;
+        }
+        if (*pCategory == category) {
+            slot.m_Severity.store(severity, memory_order_relaxed);
+            return;
+        }
+    }
+    throw Exception(AVG_ERR_UNSUPPORTED, "Too many log categories.");
+}
+
 void Logger::setupCategory()
 {
     configureCategory(category::NONE);
@@ -31,10 +31,12 @@
 #include <boost/noncopyable.hpp>
 #include <boost/functional/hash.hpp>
 #include <boost/unordered_map.hpp>
+#include <boost/shared_ptr.hpp>
 
 #include <string>
 #include <vector>
 #include <sstream>
+#include <atomic>
 
 #ifdef ERROR
 #undef ERROR
@@ -44,6 +46,10 @@ namespace avg {
 
 typedef boost::unordered_map< const category_t, const severity_t > CatToSeverityMap;
 
+struct LogMessage;
+class ThreadLogBuffer;
+typedef boost::shared_ptr<ThreadLogBuffer> ThreadLogBufferPtr;
+
 #ifdef _WIN32
 // non dll-interface class used as base for dll-interface class
 #pragma warning(disable:4275)
@@ -76,6 +82,12 @@ public:
         static const category_t VIDEO;
     };
 
+    // What trace() does in async mode if the buffer of the calling thread is full.
+    enum OverflowPolicy {
+        DROP_MESSAGES,
+        BLOCK_PRODUCER
+    };
+
     static Logger* get();
     virtual ~Logger();
 
@@ -105,26 +117,56 @@ public:
     void log(const UTF8String& msg, const category_t& category=category::APP,
             severity_t severity=severity::INFO) const;
 
+    // In async mode, trace() just queues the message in a lock-free buffer owned by 
+    // the calling thread. A logging thread formats the queued messages and passes 
+    // them to the sinks.
+    void setAsync(bool bAsync, OverflowPolicy policy=DROP_MESSAGES);
+    bool isAsync() const;
+    OverflowPolicy getOverflowPolicy() const;
+    // Blocks until all messages queued so far have been passed to the sinks.
+    void flush();
+    long long getNumDroppedMessages() const;
+
     inline bool shouldLog(const category_t& category, severity_t severity) const {
-        lock_guard lock(m_CategoryMutex);
-        try {
-            severity_t targetSeverity = m_CategorySeverities.at(category);
-            return (targetSeverity <= severity);
-        } catch (const out_of_range& e){
-            string msg("Unknown category: " + category);
-            throw Exception(AVG_ERR_INVALID_ARGS, msg);
-        }
+        return getCategorySeverity(category) <= severity;
     }
 
 private:
     Logger();
     void setupCategory();
+    severity_t getCategorySeverity(const category_t& category) const;
+    void setCategorySeverity(const category_t& category, severity_t severity);
+
+    void dispatch(const LogMessage& msg) const;
+    void queue(const LogMessage& msg) const;
+    void dispatchThreadBuffer(ThreadLogBuffer* pBuffer) const;
+    ThreadLogBuffer* getThreadBuffer() const;
+    bool dispatchQueuedMessages();
+    void logThreadFunc();
+    void stopLogThread();
 
     std::vector<LogSinkPtr> m_pSinks;
     LogSinkPtr m_pStdSink;
     CatToSeverityMap m_CategorySeverities;
     severity_t m_Severity;
     static boost::mutex m_CategoryMutex;
+
+    // Lock-free lookup table for shouldLog(). Slots are filled under 
+    // m_CategoryMutex and never removed, so readers only need the atomics.
+    struct CategorySlot {
+        std::atomic<const category_t*> m_pCategory;
+        std::atomic<severity_t> m_Severity;
+    };
+    static const int MAX_CATEGORIES = 256;
+    CategorySlot m_CategorySlots[MAX_CATEGORIES];
+
+    std::atomic<bool> m_bAsync;
+    std::atomic<int> m_OverflowPolicy;
+    mutable std::atomic<long long> m_NumDroppedMessages;
+    long long m_NumReportedDroppedMessages;
+    mutable std::vector<ThreadLogBufferPtr> m_pThreadBuffers;
+    boost::thread* m_pLogThread;
+    std::atomic<bool> m_bStopLogThread;
 };
 
 #define AVG_TRACE(category, severity, sMsg) { \
@@ -29,6 +29,8 @@ namespace avg {
 ProfilingZone::ProfilingZone(const ProfilingZoneID& zoneID)
     : m_TimeSum(0),
       m_AvgTime(0),
+      m_StartTime(0),
+      m_StopTime(0),
       m_NumFrames(0),
       m_Indent(0),
       m_ZoneID(zoneID)
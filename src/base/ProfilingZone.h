@@ -41,7 +41,16 @@ public:
     };
     void stop()
     {
-        m_TimeSum += TimeSource::get()->getCurrentMicrosecs()-m_StartTime;
+        m_StopTime = TimeSource::get()->getCurrentMicrosecs();
+        m_TimeSum += m_StopTime-m_StartTime;
+    };
+    long long getStartTime() const
+    {
+        return m_StartTime;
+    };
+    long long getStopTime() const
+    {
+        return m_StopTime;
     };
     void reset();
     long long getUSecs() const;
@@ -55,6 +64,7 @@ private:
     long long m_TimeSum;
     long long m_AvgTime;
     long long m_StartTime;
+    long long m_StopTime;
     int m_NumFrames;
     int m_Indent;
     const ProfilingZoneID& m_ZoneID;
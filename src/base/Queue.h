@@ -23,6 +23,7 @@
 #define _Queue_H_
 
 #include "../api.h"
+#include "LockFreeRing.h"
 
 #include <boost/thread/mutex.hpp>
 #include <boost/thread/condition.hpp>
@@ -34,13 +35,20 @@ namespace avg {
 
 typedef boost::unique_lock<boost::mutex> unique_lock;
 
+// QT_LOCKING: std::deque protected by a mutex. Any number of producers and consumers.
+// QT_LOCKFREE_SP: Lock-free ring, one pushing and one popping thread.
+// QT_LOCKFREE_MP: Lock-free ring, any number of pushing and popping threads.
+// The lock-free variants need a bounded queue. They only touch the mutex if a
+// thread actually needs to block.
+enum QueueType {QT_LOCKING, QT_LOCKFREE_SP, QT_LOCKFREE_MP};
+
 template<class QElement>
 class AVG_TEMPLATE_API Queue 
 {
 public:
     typedef boost::shared_ptr<QElement> QElementPtr;
 
-    Queue(int maxSize=-1);
+    Queue(int maxSize=-1, QueueType type=QT_LOCKING);
     virtual ~Queue();
 
     bool empty() const;
@@ -50,30 +58,49 @@ public:
     QElementPtr peek(bool bBlock = true) const;
     int size() const;
     int getMaxSize() const;
+    QueueType getType() const;
 
 private:
     QElementPtr getFrontElement(bool bBlock, unique_lock& Lock) const;
+    void waitForRingSpace(const QElementPtr& pElem);
+    void waitForRingElement(QElementPtr& pElem, bool bRemove) const;
+    void wakeRingWaiters() const;
 
     std::deque<QElementPtr> m_pElements;
     mutable boost::mutex m_Mutex;
     mutable boost::condition m_Cond;
     int m_MaxSize;
+
+    QueueType m_Type;
+    LockFreeRing<QElementPtr>* m_pRing;
+    mutable std::atomic<int> m_NumRingWaiters;
 };
 
 template<class QElement>
-Queue<QElement>::Queue(int maxSize)
-    : m_MaxSize(maxSize)
+Queue<QElement>::Queue(int maxSize, QueueType type)
+    : m_MaxSize(maxSize),
+      m_Type(type),
+      m_pRing(0),
+      m_NumRingWaiters(0)
 {
+    if (m_Type != QT_LOCKING) {
+        assert(maxSize > 0);
+        m_pRing = new LockFreeRing<QElementPtr>(maxSize, m_Type == QT_LOCKFREE_MP);
+    }
 }
 
 template<class QElement>
 Queue<QElement>::~Queue()
 {
+    delete m_pRing;
 }
 
 template<class QElement>
 bool Queue<QElement>::empty() const
 {
+    if (m_pRing) {
+        return m_pRing->size() == 0;
+    }
     unique_lock Lock(m_Mutex);
     return m_pElements.empty();
 }
@@ -81,6 +108,16 @@ bool Queue<QElement>::empty() const
 template<class QElement>
 typename Queue<QElement>::QElementPtr Queue<QElement>::pop(bool bBlock)
 {
+    if (m_pRing) {
+        QElementPtr pElem;
+        if (m_pRing->tryPop(pElem)) {
+            wakeRingWaiters();
+        } else if (bBlock) {
+            waitForRingElement(pElem, true);
+            wakeRingWaiters();
+        }
+        return pElem;
+    }
     unique_lock lock(m_Mutex);
     QElementPtr pElem = getFrontElement(bBlock, lock); 
     if (pElem) {
@@ -102,6 +139,13 @@ void Queue<QElement>::clear()
 template<class QElement>
 typename Queue<QElement>::QElementPtr Queue<QElement>::peek(bool bBlock) const
 {
+    if (m_pRing) {
+        QElementPtr pElem;
+        if (!m_pRing->tryPeek(pElem) && bBlock) {
+            waitForRingElement(pElem, false);
+        }
+        return pElem;
+    }
     unique_lock lock(m_Mutex);
     QElementPtr pElem = getFrontElement(bBlock, lock); 
     if (pElem) {
@@ -114,6 +158,13 @@ template<class QElement>
 void Queue<QElement>::push(const QElementPtr& pElem)
 {
     assert(pElem);
+    if (m_pRing) {
+        if (!m_pRing->tryPush(pElem)) {
+            waitForRingSpace(pElem);
+        }
+        wakeRingWaiters();
+        return;
+    }
     unique_lock lock(m_Mutex);
     if (m_pElements.size() == (unsigned)m_MaxSize) {
         while (m_pElements.size() == (unsigned)m_MaxSize) {
@@ -127,6 +178,9 @@ void Queue<QElement>::push(const QElementPtr& pElem)
 template<class QElement>
 int Queue<QElement>::size() const
 {
+    if (m_pRing) {
+        return m_pRing->size();
+    }
     unique_lock lock(m_Mutex);
     return int(m_pElements.size());
 }
@@ -134,10 +188,19 @@ int Queue<QElement>::size() const
 template<class QElement>
 int Queue<QElement>::getMaxSize() const
 {
+    if (m_pRing) {
+        return m_MaxSize;
+    }
     unique_lock lock(m_Mutex);
     return m_MaxSize;
 }
 
+template<class QElement>
+QueueType Queue<QElement>::getType() const
+{
+    return m_Type;
+}
+
 template<class QElement>
 typename Queue<QElement>::QElementPtr 
         Queue<QElement>::getFrontElement(bool bBlock, unique_lock& lock) const
@@ -154,5 +217,44 @@ typename Queue<QElement>::QElementPtr
     return m_pElements.front();
 }
 
+template<class QElement>
+void Queue<QElement>::waitForRingSpace(const QElementPtr& pElem)
+{
+    // Slow path: Register as waiter and sleep until a consumer calls 
+    // wakeRingWaiters(). The waiter count is incremented before the ring is checked
+    // again under the mutex, so a concurrent wakeRingWaiters() either sees the waiter
+    // or we see its update to the ring.
+    unique_lock lock(m_Mutex);
+    m_NumRingWaiters.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!m_pRing->tryPush(pElem)) {
+        m_Cond.wait(lock);
+    }
+    m_NumRingWaiters.fetch_sub(1);
+}
+
+template<class QElement>
+void Queue<QElement>::waitForRingElement(QElementPtr& pElem, bool bRemove) const
+{
+    unique_lock lock(m_Mutex);
+    m_NumRingWaiters.fetch_add(1);
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    while (!(bRemove ? m_pRing->tryPop(pElem) : m_pRing->tryPeek(pElem))) {
+        m_Cond.wait(lock);
+    }
+    m_NumRingWaiters.fetch_sub(1);
+}
+
+template<class QElement>
+void Queue<QElement>::wakeRingWaiters() const
+{
+    // Fast path: No syscall unless somebody is actually blocked.
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (m_NumRingWaiters.load() > 0) {
+        unique_lock lock(m_Mutex);
+        m_Cond.notify_all();
+    }
+}
+
 }
 #endif
@@ -0,0 +1,170 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _RingBuffer_H_
+#define _RingBuffer_H_
+
+#include "../api.h"
+
+#include <vector>
+#include <algorithm>
+#include <assert.h>
+
+namespace avg {
+
+// Bounded history of the most recent elements. When the buffer is full, push() 
+// overwrites the oldest element. Not thread-safe; see LockFreeRing for a queue that is.
+// Index 0 is the oldest element.
+template<class ELEMENT>
+class AVG_TEMPLATE_API RingBuffer
+{
+public:
+    RingBuffer(int capacity);
+
+    void push(const ELEMENT& elem);
+    void clear();
+
+    int size() const;
+    bool empty() const;
+    int getCapacity() const;
+    // Keeps the newest elements that fit.
+    void setCapacity(int capacity);
+
+    const ELEMENT& operator[](int i) const;
+    const ELEMENT& front() const;
+    const ELEMENT& back() const;
+
+    // Copies all elements, oldest first, to contiguous memory. pDest must have room
+    // for size() elements.
+    void copyTo(ELEMENT* pDest) const;
+
+private:
+    int getIndex(int i) const;
+
+    std::vector<ELEMENT> m_Elems;
+    int m_Start;
+    int m_Size;
+};
+
+template<class ELEMENT>
+RingBuffer<ELEMENT>::RingBuffer(int capacity)
+    : m_Elems(capacity),
+      m_Start(0),
+      m_Size(0)
+{
+    assert(capacity > 0);
+}
+
+template<class ELEMENT>
+void RingBuffer<ELEMENT>::push(const ELEMENT& elem)
+{
+    if (m_Size < int(m_Elems.size())) {
+        m_Elems[getIndex(m_Size)] = elem;
+        m_Size++;
+    } else {
+        m_Elems[m_Start] = elem;
+        m_Start = getIndex(1);
+    }
+}
+
+template<class ELEMENT>
+void RingBuffer<ELEMENT>::clear()
+{
+    // Release the elements, not just the indices.
+    std::fill(m_Elems.begin(), m_Elems.end(), ELEMENT());
+    m_Start = 0;
+    m_Size = 0;
+}
+
+template<class ELEMENT>
+int RingBuffer<ELEMENT>::size() const
+{
+    return m_Size;
+}
+
+template<class ELEMENT>
+bool RingBuffer<ELEMENT>::empty() const
+{
+    return m_Size == 0;
+}
+
+template<class ELEMENT>
+int RingBuffer<ELEMENT>::getCapacity() const
+{
+    return int(m_Elems.size());
+}
+
+template<class ELEMENT>
+void RingBuffer<ELEMENT>::setCapacity(int capacity)
+{
+    assert(capacity > 0);
+    int newSize = std::min(m_Size, capacity);
+    std::vector<ELEMENT> elems(capacity);
+    for (int i = 0; i < newSize; ++i) {
+        elems[i] = (*this)[m_Size-newSize+i];
+    }
+    m_Elems.swap(elems);
+    m_Start = 0;
+    m_Size = newSize;
+}
+
+template<class ELEMENT>
+const ELEMENT& RingBuffer<ELEMENT>::operator[](int i) const
+{
+    assert(i >= 0 && i < m_Size);
+    return m_Elems[getIndex(i)];
+}
+
+template<class ELEMENT>
+const ELEMENT& RingBuffer<ELEMENT>::front() const
+{
+    return (*this)[0];
+}
+
+template<class ELEMENT>
+const ELEMENT& RingBuffer<ELEMENT>::back() const
+{
+    return (*this)[m_Size-1];
+}
+
+template<class ELEMENT>
+void RingBuffer<ELEMENT>::copyTo(ELEMENT* pDest) const
+{
+    // At most two contiguous segments.
+    int firstSegSize = std::min(m_Size, int(m_Elems.size())-m_Start);
+    std::copy(m_Elems.begin()+m_Start, m_Elems.begin()+m_Start+firstSegSize, pDest);
+    std::copy(m_Elems.begin(), m_Elems.begin()+(m_Size-firstSegSize), 
+            pDest+firstSegSize);
+}
+
+template<class ELEMENT>
+int RingBuffer<ELEMENT>::getIndex(int i) const
+{
+    int index = m_Start+i;
+    if (index >= int(m_Elems.size())) {
+        index -= int(m_Elems.size());
+    }
+    return index;
+}
+
+}
+
+#endif
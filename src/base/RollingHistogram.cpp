@@ -0,0 +1,157 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "RollingHistogram.h"
+
+#include "Exception.h"
+
+#include <algorithm>
+#include <math.h>
+
+using namespace std;
+
+namespace avg {
+
+RollingHistogram::RollingHistogram(int windowSize, int bucketWidth, int numBuckets)
+    : m_BucketWidth(bucketWidth),
+      m_Buckets(numBuckets+1)
+{
+    AVG_ASSERT(bucketWidth > 0 && numBuckets > 0);
+    setWindowSize(windowSize);
+}
+
+RollingHistogram::~RollingHistogram()
+{
+}
+
+void RollingHistogram::setWindowSize(int windowSize)
+{
+    if (windowSize < 1) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE, 
+                "RollingHistogram: window size must be at least 1.");
+    }
+    m_Samples = vector<atomic<int> >(windowSize);
+    reset();
+}
+
+int RollingHistogram::getWindowSize() const
+{
+    return int(m_Samples.size());
+}
+
+void RollingHistogram::reset()
+{
+    for (unsigned i = 0; i < m_Buckets.size(); ++i) {
+        m_Buckets[i] = 0;
+    }
+    for (unsigned i = 0; i < m_Samples.size(); ++i) {
+        m_Samples[i] = 0;
+    }
+    m_WritePos = 0;
+    m_NumSamples = 0;
+    m_Sum = 0;
+}
+
+void RollingHistogram::addSample(int value)
+{
+    value = max(value, 0);
+    if (m_NumSamples == int(m_Samples.size())) {
+        int oldValue = m_Samples[m_WritePos];
+        m_Buckets[getBucket(oldValue)]--;
+        m_Sum -= oldValue;
+    } else {
+        m_NumSamples++;
+    }
+    m_Samples[m_WritePos] = value;
+    m_Buckets[getBucket(value)]++;
+    m_Sum += value;
+    m_WritePos = (m_WritePos+1) % m_Samples.size();
+}
+
+int RollingHistogram::getNumSamples() const
+{
+    return m_NumSamples;
+}
+
+int RollingHistogram::getPercentile(float percent) const
+{
+    if (percent < 0 || percent > 100) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE, 
+                "RollingHistogram: percentile must be between 0 and 100.");
+    }
+    int total = 0;
+    for (unsigned i = 0; i < m_Buckets.size(); ++i) {
+        total += m_Buckets[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+    int rank = max(int(ceil(total*percent/100)), 1);
+    int count = 0;
+    int maxValue = getMax();
+    for (unsigned i = 0; i < m_Buckets.size()-1; ++i) {
+        count += m_Buckets[i];
+        if (count >= rank) {
+            return min(int(i+1)*m_BucketWidth, maxValue);
+        }
+    }
+    return maxValue;
+}
+
+int RollingHistogram::getMax() const
+{
+    int maxValue = 0;
+    int numSamples = m_NumSamples;
+    for (int i = 0; i < numSamples; ++i) {
+        maxValue = max(maxValue, int(m_Samples[i]));
+    }
+    return maxValue;
+}
+
+float RollingHistogram::getAverage() const
+{
+    int numSamples = m_NumSamples;
+    if (numSamples == 0) {
+        return 0;
+    }
+    return float(m_Sum)/numSamples;
+}
+
+int RollingHistogram::getBucketWidth() const
+{
+    return m_BucketWidth;
+}
+
+vector<int> RollingHistogram::getBucketCounts() const
+{
+    vector<int> counts(m_Buckets.size());
+    for (unsigned i = 0; i < m_Buckets.size(); ++i) {
+        counts[i] = m_Buckets[i];
+    }
+    return counts;
+}
+
+int RollingHistogram::getBucket(int value) const
+{
+    return min(value/m_BucketWidth, int(m_Buckets.size())-1);
+}
+
+}
@@ -0,0 +1,77 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#ifndef _RollingHistogram_H_
+#define _RollingHistogram_H_
+
+#include "../api.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <atomic>
+#include <vector>
+
+namespace avg {
+
+// Histogram of the last windowSize samples (e.g. frame times in microseconds). 
+// Samples are sorted into buckets of bucketWidth; values beyond the last bucket go 
+// into an overflow bucket. Adding a sample is O(1).
+//
+// One thread adds samples. Other threads may query concurrently without locking; 
+// they see a consistent state up to the sample currently being added. 
+// setWindowSize() and reset() must not run concurrently with anything else.
+class AVG_API RollingHistogram
+{
+public:
+    RollingHistogram(int windowSize, int bucketWidth=50, int numBuckets=2000);
+    virtual ~RollingHistogram();
+
+    void setWindowSize(int windowSize);
+    int getWindowSize() const;
+    void reset();
+
+    void addSample(int value);
+
+    int getNumSamples() const;
+    // Upper bound of the bucket containing the percentile, but never more than the 
+    // maximum. Percentiles in the overflow bucket return the maximum.
+    int getPercentile(float percent) const;
+    int getMax() const;
+    float getAverage() const;
+    int getBucketWidth() const;
+    std::vector<int> getBucketCounts() const;
+
+private:
+    int getBucket(int value) const;
+
+    int m_BucketWidth;
+    std::vector<std::atomic<int> > m_Buckets;
+    std::vector<std::atomic<int> > m_Samples;
+    int m_WritePos;
+    std::atomic<int> m_NumSamples;
+    std::atomic<long long> m_Sum;
+};
+
+typedef boost::shared_ptr<RollingHistogram> RollingHistogramPtr;
+
+}
+
+#endif
@@ -0,0 +1,124 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "SIMDHelper.h"
+
+#include "Exception.h"
+
+#if defined(AVG_SIMD_X86) && defined(_MSC_VER)
+#include <intrin.h>
+#endif
+
+namespace avg {
+
+#ifdef AVG_SIMD_X86
+static bool cpuHasAVX2()
+{
+#if defined(_MSC_VER)
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    bool bOSXSave = (info[2] & (1 << 27)) != 0;
+    bool bAVX = (info[2] & (1 << 28)) != 0;
+    if (!bOSXSave || !bAVX) {
+        return false;
+    }
+    // The OS must save the ymm registers on context switches.
+    if ((_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2") != 0;
+#endif
+}
+#endif
+
+SIMDLevel getCPUSIMDLevel()
+{
+#if defined(AVG_SIMD_X86)
+    static SIMDLevel cpuLevel = cpuHasAVX2() ? SIMD_AVX2 : SIMD_SSE2;
+    return cpuLevel;
+#elif defined(AVG_SIMD_NEON)
+    return SIMD_NEON;
+#else
+    return SIMD_NONE;
+#endif
+}
+
+bool isSIMDLevelSupported(SIMDLevel level)
+{
+    switch (level) {
+        case SIMD_NONE:
+            return true;
+        case SIMD_SSE2:
+        case SIMD_AVX2:
+#ifdef AVG_SIMD_X86
+            return level <= getCPUSIMDLevel();
+#else
+            return false;
+#endif
+        case SIMD_NEON:
+            return getCPUSIMDLevel() == SIMD_NEON;
+        default:
+            return false;
+    }
+}
+
+static SIMDLevel s_SIMDLevel = getCPUSIMDLevel();
+
+SIMDLevel getSIMDLevel()
+{
+    return s_SIMDLevel;
+}
+
+void setSIMDLevel(SIMDLevel level)
+{
+    if (!isSIMDLevelSupported(level)) {
+        throw Exception(AVG_ERR_UNSUPPORTED, std::string("SIMD level ")+
+                getSIMDLevelName(level)+" not supported on this machine.");
+    }
+    s_SIMDLevel = level;
+}
+
+const char* getSIMDLevelName(SIMDLevel level)
+{
+    switch (level) {
+        case SIMD_NONE:
+            return "scalar";
+        case SIMD_SSE2:
+            return "SSE2";
+        case SIMD_AVX2:
+            return "AVX2";
+        case SIMD_NEON:
+            return "NEON";
+        default:
+            return "unknown";
+    }
+}
+
+}
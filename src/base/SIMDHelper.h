@@ -0,0 +1,68 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _SIMDHelper_H_
+#define _SIMDHelper_H_
+
+#include "../api.h"
+
+#if defined(__x86_64__) || defined(__i386__) || defined(_M_X64) || defined(_M_IX86)
+    #define AVG_SIMD_X86
+    #include <emmintrin.h>
+    #include <immintrin.h>
+    // Functions that use AVX2 intrinsics must be marked so gcc and clang generate
+    // AVX2 code for them without compiling the whole library with -mavx2. They may
+    // only be called after getSIMDLevel() has returned SIMD_AVX2.
+    #if defined(__GNUC__) || defined(__clang__)
+        #define AVG_TARGET_AVX2 __attribute__((target("avx2")))
+    #else
+        #define AVG_TARGET_AVX2
+    #endif
+#elif defined(__ARM_NEON) || defined(__ARM_NEON__)
+    #define AVG_SIMD_NEON
+    #include <arm_neon.h>
+#endif
+
+namespace avg {
+
+enum SIMDLevel {
+    SIMD_NONE,
+    SIMD_SSE2,
+    SIMD_AVX2,
+    SIMD_NEON
+};
+
+// Best instruction set supported by both the build and the cpu we're running on.
+AVG_API SIMDLevel getCPUSIMDLevel();
+AVG_API bool isSIMDLevelSupported(SIMDLevel level);
+
+// Instruction set the vectorized kernels currently use. Defaults to
+// getCPUSIMDLevel(). setSIMDLevel() is meant for tests and benchmarks that compare
+// kernels; it isn't synchronized with kernels running in other threads.
+AVG_API SIMDLevel getSIMDLevel();
+AVG_API void setSIMDLevel(SIMDLevel level);
+
+AVG_API const char* getSIMDLevelName(SIMDLevel level);
+
+}
+
+#endif
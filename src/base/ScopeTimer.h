@@ -48,11 +48,17 @@ public:
     };
 
     static void enableTimers(bool bEnable);
+    // Timers are also needed while a trace is recorded, even if profiling output is 
+    // off.
+    static void enableTracing(bool bEnable);
+    static bool timersEnabled();
 
 private:
     ProfilingZoneID* m_pZoneID;
 
     static bool s_bTimersEnabled;
+    static bool s_bProfilingEnabled;
+    static bool s_bTracingEnabled;
 };
 
 }
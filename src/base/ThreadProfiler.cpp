@@ -25,7 +25,11 @@
 #include "Exception.h"
 #include "ProfilingZone.h"
 #include "ScopeTimer.h"
+#include "FileHelper.h"
+#include "ThreadHelper.h"
+#include "StringHelper.h"
 
+#include <algorithm>
 #include <sstream>
 #include <iomanip>
 #include <iostream>
@@ -34,8 +38,66 @@ using namespace std;
 using namespace boost;
 
 namespace avg {
-    
+
+// Preallocated so recording an event never allocates. Events that don't fit are 
+// dropped and counted.
+const int TRACE_BUFFER_SIZE = 65536;
+
+struct TraceEvent {
+    const ProfilingZoneID* m_pID;
+    char m_Type;            // 'X': zone, 'C': counter, 'i': frame end.
+    long long m_Time;
+    long long m_Value;      // Zone end time or counter value.
+};
+
+// Written only by the thread that owns it. Kept alive by the trace registry after 
+// the thread has exited so its events can still be exported.
+struct TraceBuffer {
+    TraceBuffer(int threadID)
+        : m_ThreadID(threadID),
+          m_Events(TRACE_BUFFER_SIZE),
+          m_NumEvents(0),
+          m_Generation(-1),
+          m_NumDropped(0),
+          m_bThreadExited(false)
+    {}
+
+    int m_ThreadID;
+    std::string m_sThreadName;
+    std::vector<TraceEvent> m_Events;
+    std::atomic<int> m_NumEvents;
+    std::atomic<int> m_Generation;
+    std::atomic<long long> m_NumDropped;
+    std::atomic<bool> m_bThreadExited;
+};
+
+namespace {
+    boost::mutex s_TraceMutex;
+    vector<TraceBufferPtr> s_pTraceBuffers;
+    int s_NextTraceThreadID = 1;
+    long long s_TraceStartTime = 0;
+
+    void writeJSONString(ostream& os, const string& s)
+    {
+        os << '"';
+        for (unsigned i = 0; i < s.size(); ++i) {
+            char c = s[i];
+            if (c == '"' || c == '\\') {
+                os << '\\' << c;
+            } else if ((unsigned char)c < 0x20) {
+                os << ' ';
+            } else {
+                os << c;
+            }
+        }
+        os << '"';
+    }
+}
+
 thread_specific_ptr<ThreadProfiler*> ThreadProfiler::s_pInstance;
+std::atomic<bool> ThreadProfiler::s_bTracing(false);
+std::atomic<int> ThreadProfiler::s_TraceGeneration(0);
+std::atomic<int> ThreadProfiler::s_NumTraceFramesLeft(0);
 
 ThreadProfiler* ThreadProfiler::get() 
 {
@@ -63,6 +125,9 @@ ThreadProfiler::ThreadProfiler()
 
 ThreadProfiler::~ThreadProfiler() 
 {
+    if (m_pTraceBuffer) {
+        m_pTraceBuffer->m_bThreadExited = true;
+    }
 }
 
 void ThreadProfiler::setLogCategory(category_t category)
@@ -81,6 +146,7 @@ void ThreadProfiler::restart()
     for (auto it = m_Zones.begin(); it != m_Zones.end(); ++it) {
         (*it)->restart();
     }
+    m_Counters.clear();
 }
 
 void ThreadProfiler::startZone(const ProfilingZoneID& zoneID)
@@ -105,6 +171,34 @@ void ThreadProfiler::stopZone(const ProfilingZoneID& zoneID)
     ProfilingZonePtr& pZone = it->second;
     pZone->stop();
     m_ActiveZones.pop_back();
+    if (isTracing()) {
+        addTraceEvent(&zoneID, 'X', pZone->getStartTime(), pZone->getStopTime());
+    }
+}
+
+void ThreadProfiler::addCounterValue(const ProfilingZoneID& counterID, long long value)
+{
+    if (!ScopeTimer::timersEnabled()) {
+        return;
+    }
+    if (isTracing()) {
+        addTraceEvent(&counterID, 'C', TimeSource::get()->getCurrentMicrosecs(), 
+                value);
+    }
+    for (auto it = m_Counters.begin(); it != m_Counters.end(); ++it) {
+        if (it->m_pID == &counterID) {
+            it->m_NumValues++;
+            it->m_Sum += value;
+            it->m_Max = std::max(it->m_Max, value);
+            return;
+        }
+    }
+    Counter counter;
+    counter.m_pID = &counterID;
+    counter.m_NumValues = 1;
+    counter.m_Sum = value;
+    counter.m_Max = value;
+    m_Counters.push_back(counter);
 }
 
 void ThreadProfiler::dumpStatistics()
@@ -124,6 +218,21 @@ void ThreadProfiler::dumpStatistics()
         }
         AVG_TRACE(m_LogCategory, Logger::severity::INFO, "");
     }
+    if (!m_Counters.empty()) {
+        AVG_TRACE(m_LogCategory, Logger::severity::INFO, "Thread " << m_sName);
+        AVG_TRACE(m_LogCategory, Logger::severity::INFO,
+                "Counter name                         Samples   Average       Max");
+        AVG_TRACE(m_LogCategory, Logger::severity::INFO,
+                "------------                         -------   -------       ---");
+        for (auto it = m_Counters.begin(); it != m_Counters.end(); ++it) {
+            AVG_TRACE(m_LogCategory, Logger::severity::INFO,
+                    std::setw(35) << std::left << it->m_pID->getName()
+                    << std::setw(9) << std::right << it->m_NumValues
+                    << std::setw(10) << std::right << it->m_Sum/it->m_NumValues
+                    << std::setw(10) << std::right << it->m_Max);
+        }
+        AVG_TRACE(m_LogCategory, Logger::severity::INFO, "");
+    }
 }
 
 void ThreadProfiler::reset()
@@ -146,6 +255,113 @@ const std::string& ThreadProfiler::getName() const
 void ThreadProfiler::setName(const std::string& sName)
 {
     m_sName = sName;
+    if (m_pTraceBuffer) {
+        lock_guard lock(s_TraceMutex);
+        m_pTraceBuffer->m_sThreadName = sName;
+    }
+}
+
+void ThreadProfiler::startTracing(int numFrames)
+{
+    lock_guard lock(s_TraceMutex);
+    // Buffers of threads that have exited only hold events of earlier traces.
+    for (auto it = s_pTraceBuffers.begin(); it != s_pTraceBuffers.end(); ) {
+        if ((*it)->m_bThreadExited) {
+            it = s_pTraceBuffers.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    s_TraceStartTime = TimeSource::get()->getCurrentMicrosecs();
+    s_NumTraceFramesLeft = numFrames;
+    s_TraceGeneration++;
+    ScopeTimer::enableTracing(true);
+    s_bTracing = true;
+}
+
+void ThreadProfiler::stopTracing()
+{
+    s_bTracing = false;
+    ScopeTimer::enableTracing(false);
+}
+
+void ThreadProfiler::endTraceFrame()
+{
+    static ProfilingZoneID FrameID("Frame");
+    if (!isTracing()) {
+        return;
+    }
+    get()->addTraceEvent(&FrameID, 'i', TimeSource::get()->getCurrentMicrosecs(), 0);
+    if (s_NumTraceFramesLeft > 0 && --s_NumTraceFramesLeft == 0) {
+        stopTracing();
+    }
+}
+
+string ThreadProfiler::getTraceJSON()
+{
+    lock_guard lock(s_TraceMutex);
+    stringstream ss;
+    ss << "{\"traceEvents\":[";
+    bool bFirst = true;
+    int generation = s_TraceGeneration;
+    for (auto it = s_pTraceBuffers.begin(); it != s_pTraceBuffers.end(); ++it) {
+        TraceBuffer& buffer = **it;
+        if (buffer.m_Generation.load(std::memory_order_acquire) != generation) {
+            continue;
+        }
+        int tid = buffer.m_ThreadID;
+        if (!bFirst) {
+            ss << ",";
+        }
+        bFirst = false;
+        ss << "\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << tid
+                << ",\"args\":{\"name\":";
+        if (buffer.m_sThreadName.empty()) {
+            writeJSONString(ss, "Thread "+toString(tid));
+        } else {
+            writeJSONString(ss, buffer.m_sThreadName);
+        }
+        ss << "}}";
+        int numEvents = buffer.m_NumEvents.load(std::memory_order_acquire);
+        for (int i = 0; i < numEvents; ++i) {
+            const TraceEvent& event = buffer.m_Events[i];
+            ss << ",\n{\"name\":";
+            writeJSONString(ss, event.m_pID->getName());
+            ss << ",\"ph\":\"" << event.m_Type << "\",\"pid\":1,\"tid\":" << tid
+                    << ",\"ts\":" << event.m_Time-s_TraceStartTime;
+            switch (event.m_Type) {
+                case 'X':
+                    ss << ",\"dur\":" << event.m_Value-event.m_Time;
+                    break;
+                case 'C':
+                    ss << ",\"args\":{\"value\":" << event.m_Value << "}";
+                    break;
+                default:
+                    ss << ",\"s\":\"p\"";
+            }
+            ss << "}";
+        }
+    }
+    ss << "\n],\"displayTimeUnit\":\"ms\"}\n";
+    return ss.str();
+}
+
+void ThreadProfiler::writeTrace(const string& sFilename)
+{
+    writeWholeFile(sFilename, getTraceJSON());
+}
+
+long long ThreadProfiler::getNumDroppedTraceEvents()
+{
+    lock_guard lock(s_TraceMutex);
+    long long numDropped = 0;
+    int generation = s_TraceGeneration;
+    for (auto it = s_pTraceBuffers.begin(); it != s_pTraceBuffers.end(); ++it) {
+        if ((*it)->m_Generation.load(std::memory_order_acquire) == generation) {
+            numDropped += (*it)->m_NumDropped;
+        }
+    }
+    return numDropped;
 }
 
 
@@ -177,5 +393,41 @@ ProfilingZonePtr ThreadProfiler::addZone(const ProfilingZoneID& zoneID)
     return pZone;
 }
 
+TraceBuffer* ThreadProfiler::getTraceBuffer()
+{
+    if (!m_pTraceBuffer) {
+        lock_guard lock(s_TraceMutex);
+        m_pTraceBuffer = TraceBufferPtr(new TraceBuffer(s_NextTraceThreadID++));
+        m_pTraceBuffer->m_sThreadName = m_sName;
+        s_pTraceBuffers.push_back(m_pTraceBuffer);
+    }
+    int generation = s_TraceGeneration;
+    if (m_pTraceBuffer->m_Generation.load(std::memory_order_relaxed) != generation) {
+        // First event of a new trace. Readers only look at buffers of the current
+        // generation, so the count must be reset before the generation is published.
+        m_pTraceBuffer->m_NumEvents.store(0, std::memory_order_relaxed);
+        m_pTraceBuffer->m_NumDropped = 0;
+        m_pTraceBuffer->m_Generation.store(generation, std::memory_order_release);
+    }
+    return m_pTraceBuffer.get();
+}
+
+void ThreadProfiler::addTraceEvent(const ProfilingZoneID* pID, char type, long long time,
+        long long value)
+{
+    TraceBuffer* pBuffer = getTraceBuffer();
+    int i = pBuffer->m_NumEvents.load(std::memory_order_relaxed);
+    if (i == TRACE_BUFFER_SIZE) {
+        pBuffer->m_NumDropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    TraceEvent& event = pBuffer->m_Events[i];
+    event.m_pID = pID;
+    event.m_Type = type;
+    event.m_Time = time;
+    event.m_Value = value;
+    pBuffer->m_NumEvents.store(i+1, std::memory_order_release);
+}
+
 }
 
@@ -30,6 +30,8 @@
 #include <boost/thread/tss.hpp>
 
 #include <vector>
+#include <string>
+#include <atomic>
 #if defined(_WIN32) || defined(_LIBCPP_VERSION)
 #include <unordered_map>
 #else
@@ -43,6 +45,8 @@ typedef boost::shared_ptr<ThreadProfiler> ThreadProfilerPtr;
 class ProfilingZone;
 typedef boost::shared_ptr<ProfilingZone> ProfilingZonePtr;
 class ProfilingZoneID;
+struct TraceBuffer;
+typedef boost::shared_ptr<TraceBuffer> TraceBufferPtr;
 
 class AVG_API ThreadProfiler
 {
@@ -57,6 +61,9 @@ public:
     void restart();
     void startZone(const ProfilingZoneID& zoneID);
     void stopZone(const ProfilingZoneID& zoneID);
+    // Records a sample of a value that isn't a time (e.g. a queue length).
+    // dumpStatistics() reports number of samples, average and maximum.
+    void addCounterValue(const ProfilingZoneID& counterID, long long value);
     void dumpStatistics();
     void reset();
     int getNumZones();
@@ -64,10 +71,37 @@ public:
     const std::string& getName() const;
     void setName(const std::string& sName);
 
+    // Tracing: While a trace is recorded, every zone and counter value of every 
+    // thread is stored with timestamps. The trace can be exported in the Chrome 
+    // trace event format (chrome://tracing, ui.perfetto.dev).
+    // If numFrames > 0, recording stops after numFrames calls to endTraceFrame().
+    static void startTracing(int numFrames=0);
+    static void stopTracing();
+    static bool isTracing()
+    {
+        return s_bTracing.load(std::memory_order_relaxed);
+    };
+    // Called by the main thread at the end of each frame.
+    static void endTraceFrame();
+    static std::string getTraceJSON();
+    static void writeTrace(const std::string& sFilename);
+    static long long getNumDroppedTraceEvents();
+
 private:
     ProfilingZonePtr addZone(const ProfilingZoneID& zoneID);
+    TraceBuffer* getTraceBuffer();
+    void addTraceEvent(const ProfilingZoneID* pID, char type, long long time, 
+            long long value);
     std::string m_sName;
 
+    struct Counter {
+        const ProfilingZoneID* m_pID;
+        long long m_NumValues;
+        long long m_Sum;
+        long long m_Max;
+    };
+    std::vector<Counter> m_Counters;
+
 #if defined(_WIN32) || defined(_LIBCPP_VERSION)
     typedef std::unordered_map<const ProfilingZoneID*, ProfilingZonePtr> ZoneMap;
 #else
@@ -79,8 +113,12 @@ private:
     ZoneVector m_Zones;
     bool m_bRunning;
     category_t m_LogCategory;
+    TraceBufferPtr m_pTraceBuffer;
 
     static boost::thread_specific_ptr<ThreadProfiler*> s_pInstance;
+    static std::atomic<bool> s_bTracing;
+    static std::atomic<int> s_TraceGeneration;
+    static std::atomic<int> s_NumTraceFramesLeft;
 };
 
 }
@@ -68,6 +68,11 @@ TimeSource::TimeSource()
 #ifdef __APPLE__
     mach_timebase_info(&m_TimebaseInfo);
 #endif
+#ifdef _WIN32
+    LARGE_INTEGER frequency;
+    QueryPerformanceFrequency(&frequency);
+    m_PerfCounterFrequency = frequency.QuadPart;
+#endif
 }
 
 TimeSource::~TimeSource()
@@ -82,7 +87,12 @@ long long TimeSource::getCurrentMillisecs()
 long long TimeSource::getCurrentMicrosecs()
 {
 #ifdef _WIN32
-    return (long long)(timeGetTime())*1000;
+    // timeGetTime() only has millisecond resolution.
+    LARGE_INTEGER counter;
+    QueryPerformanceCounter(&counter);
+    long long ticks = counter.QuadPart;
+    return (ticks/m_PerfCounterFrequency)*1000000
+            + ((ticks%m_PerfCounterFrequency)*1000000)/m_PerfCounterFrequency;
 #else
 #ifdef __APPLE__
     long long systemTime = mach_absolute_time();
@@ -115,6 +125,22 @@ void TimeSource::sleepUntil(long long targetTime)
 #endif
 }
 
+long long TimeSource::sleepUntilMicrosecs(long long targetTime, long long spinTime)
+{
+    long long overshoot = -1;
+    long long now = getCurrentMicrosecs();
+    long long wakeupTime = targetTime-spinTime;
+    if (now < wakeupTime) {
+        microsleep(wakeupTime-now);
+        now = getCurrentMicrosecs();
+        overshoot = now-wakeupTime;
+    }
+    while (now < targetTime) {
+        now = getCurrentMicrosecs();
+    }
+    return overshoot;
+}
+
 void msleep(int millisecs)
 {
 #if _WIN32
@@ -124,5 +150,14 @@ void msleep(int millisecs)
 #endif
 }
 
+void microsleep(long long microsecs)
+{
+#if _WIN32
+    Sleep(DWORD(microsecs/1000));
+#else
+    usleep(microsecs);
+#endif
+}
+
 }
 
@@ -43,17 +43,25 @@ public:
     long long getCurrentMicrosecs();
     
     void sleepUntil(long long targetTime);
+    // Sleeps until targetTime (in microseconds). OS sleeps are coarse, so the last 
+    // spinTime microseconds are spent busy-waiting. Returns how many microseconds the
+    // OS sleep overshot its wakeup time, or -1 if there was no OS sleep.
+    long long sleepUntilMicrosecs(long long targetTime, long long spinTime);
 
 private:    
     TimeSource();
 #ifdef __APPLE__
     mach_timebase_info_data_t m_TimebaseInfo;
 #endif
+#ifdef _WIN32
+    long long m_PerfCounterFrequency;
+#endif
     
     static TimeSource* m_pTimeSource;
 };
 
 void AVG_API msleep(int millisecs);
+void AVG_API microsleep(long long microsecs);
 
 }
 
@@ -50,6 +50,13 @@ public:
     virtual ~WorkerThread();
     void operator()();
 
+    // Alternative to operator()() for objects that are scheduled by a thread pool
+    // instead of running in a thread of their own. Processes pending commands and 
+    // calls work() once if bWork is set. The caller must make sure that work() won't 
+    // block. Returns false once the object has stopped.
+    bool step(bool bWork);
+    bool hasPendingCmds() const;
+
     void waitForCommand();
     void stop();
 
@@ -65,6 +72,7 @@ private:
 
     std::string m_sName;
     bool m_bShouldStop;
+    bool m_bInitialized;
     CQueue& m_CmdQ;
     category_t m_LogCategory;
 };
@@ -74,6 +82,7 @@ WorkerThread<DERIVED_THREAD>::WorkerThread(const std::string& sName, CQueue& Cmd
         category_t logCategory)
     : m_sName(sName),
       m_bShouldStop(false),
+      m_bInitialized(false),
       m_CmdQ(CmdQ),
       m_LogCategory(logCategory)
 {
@@ -85,6 +94,7 @@ WorkerThread<DERIVED_THREAD>::WorkerThread(WorkerThread const& other)
 {
     m_sName = other.m_sName;
     m_bShouldStop = other.m_bShouldStop;
+    m_bInitialized = other.m_bInitialized;
     m_LogCategory = other.m_LogCategory;
 }
 
@@ -125,6 +135,39 @@ void WorkerThread<DERIVED_THREAD>::operator()()
     }
 }
 
+template<class DERIVED_THREAD>
+bool WorkerThread<DERIVED_THREAD>::step(bool bWork)
+{
+    try {
+        if (!m_bInitialized) {
+            m_bInitialized = true;
+            if (!init()) {
+                return false;
+            }
+        }
+        processCommands();
+        if (bWork && !m_bShouldStop) {
+            if (!work()) {
+                m_bShouldStop = true;
+            }
+        }
+        if (m_bShouldStop) {
+            deinit();
+            return false;
+        }
+        return true;
+    } catch (const Exception& e) {
+         AVG_LOG_ERROR("Uncaught exception in " << m_sName << ": " << e.getStr());
+         throw;
+    }
+}
+
+template<class DERIVED_THREAD>
+bool WorkerThread<DERIVED_THREAD>::hasPendingCmds() const
+{
+    return !m_CmdQ.empty();
+}
+
 template<class DERIVED_THREAD>
 void WorkerThread<DERIVED_THREAD>::waitForCommand() 
 {
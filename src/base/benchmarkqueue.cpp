@@ -0,0 +1,95 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "Queue.h"
+#include "TimeSource.h"
+
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+
+#include <iostream>
+#include <vector>
+
+using namespace avg;
+using namespace std;
+
+typedef Queue<int>::QElementPtr ElemPtr;
+
+static void pushThread(Queue<int>* pQ, int numPushes)
+{
+    ElemPtr pElem(new int(0));
+    for (int i = 0; i < numPushes; ++i) {
+        pQ->push(pElem);
+    }
+}
+
+static void popThread(Queue<int>* pQ, int numPops, bool bBlock)
+{
+    int i = 0;
+    while (i < numPops) {
+        if (pQ->pop(bBlock)) {
+            i++;
+        } else {
+            boost::this_thread::yield();
+        }
+    }
+}
+
+// Elements are preallocated so only the queue operations are measured.
+void runQueueBenchmark(const string& sName, QueueType type, int numProducers,
+        bool bBlockingPop, int numElems=1000000, int queueLength=64)
+{
+    Queue<int> q(queueLength, type);
+    int elemsPerProducer = numElems/numProducers;
+    long long startTime = TimeSource::get()->getCurrentMicrosecs();
+    vector<boost::thread*> pProducers;
+    for (int i = 0; i < numProducers; ++i) {
+        pProducers.push_back(new boost::thread(
+                boost::bind(&pushThread, &q, elemsPerProducer)));
+    }
+    popThread(&q, elemsPerProducer*numProducers, bBlockingPop);
+    for (unsigned i = 0; i < pProducers.size(); ++i) {
+        pProducers[i]->join();
+        delete pProducers[i];
+    }
+    float activeTime = (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000.f;
+    cerr << sName << ": " << activeTime << " ms, "
+            << (elemsPerProducer*numProducers)/(activeTime*1000) << " M elems/s"
+            << endl;
+}
+
+void runQueueBenchmarks(const string& sTitle, int numProducers, bool bBlockingPop)
+{
+    cerr << sTitle << endl;
+    runQueueBenchmark("  Locking", QT_LOCKING, numProducers, bBlockingPop);
+    if (numProducers == 1) {
+        runQueueBenchmark("  Lock-free SP", QT_LOCKFREE_SP, numProducers, bBlockingPop);
+    }
+    runQueueBenchmark("  Lock-free MP", QT_LOCKFREE_MP, numProducers, bBlockingPop);
+}
+
+int main(int nargs, char** args)
+{
+    runQueueBenchmarks("1 producer, blocking pop", 1, true);
+    runQueueBenchmarks("1 producer, polling pop", 1, false);
+    runQueueBenchmarks("4 producers, blocking pop", 4, true);
+}
+
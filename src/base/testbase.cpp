@@ -21,6 +21,9 @@
 
 #include "DAG.h"
 #include "Queue.h"
+#include "LockFreeRing.h"
+#include "RingBuffer.h"
+#include "RollingHistogram.h"
 #include "Command.h"
 #include "WorkerThread.h"
 #include "ObjectCounter.h"
@@ -42,6 +45,8 @@
 #include "TimeSource.h"
 #include "XMLHelper.h"
 #include "Logger.h"
+#include "ThreadProfiler.h"
+#include "ScopeTimer.h"
 
 #include <boost/thread/thread.hpp>
 
@@ -163,7 +168,13 @@ public:
     void runTests() 
     {
         runSingleThreadTests();
-        runMultiThreadTests();
+        runBoundedSingleThreadTests(QT_LOCKING);
+        runMultiThreadTests(QT_LOCKING);
+        runBoundedSingleThreadTests(QT_LOCKFREE_SP);
+        runMultiThreadTests(QT_LOCKFREE_SP);
+        runBoundedSingleThreadTests(QT_LOCKFREE_MP);
+        runMultiThreadTests(QT_LOCKFREE_MP);
+        runRingTests();
     }
 
 private:
@@ -191,18 +202,47 @@ private:
         TEST(!pElem);
     }
 
-    void runMultiThreadTests()
+    void runBoundedSingleThreadTests(QueueType type)
+    {
+        Queue<string> q(3, type);
+        typedef Queue<string>::QElementPtr ElemPtr;
+        TEST(q.getType() == type);
+        TEST(q.empty());
+        q.push(ElemPtr(new string("1")));
+        TEST(q.size() == 1);
+        TEST(!q.empty());
+        q.push(ElemPtr(new string("2")));
+        q.push(ElemPtr(new string("3")));
+        TEST(q.size() == 3);
+        TEST(*q.pop() == "1");
+        TEST(*q.pop() == "2");
+        // Wraps around the end of the ring.
+        q.push(ElemPtr(new string("4")));
+        q.push(ElemPtr(new string("5")));
+        TEST(q.size() == 3);
+        TEST(*q.pop() == "3");
+        TEST(*q.peek() == "4");
+        TEST(*q.pop() == "4");
+        TEST(*q.pop() == "5");
+        TEST(q.empty());
+        ElemPtr pElem = q.pop(false);
+        TEST(!pElem);
+        pElem = q.peek(false);
+        TEST(!pElem);
+    }
+
+    void runMultiThreadTests(QueueType type)
     {
         {
-            Queue<int> q(10);
+            Queue<int> q(10, type);
             thread pusher(boost::bind(&pushThread, &q, 100));
             thread popper(boost::bind(&popThread, &q, 100));
             pusher.join();
             popper.join();
             TEST(q.empty());
         }
-        {
-            Queue<int> q(10);
+        if (type != QT_LOCKFREE_SP) {
+            Queue<int> q(10, type);
             thread pusher1(boost::bind(&pushThread, &q, 100));
             thread pusher2(boost::bind(&pushThread, &q, 100));
             thread popper(boost::bind(&popThread, &q, 200));
@@ -211,14 +251,63 @@ private:
             popper.join();
             TEST(q.empty());
         }
-        {
-            Queue<int> q(10);
+        if (type != QT_LOCKFREE_SP) {
+            Queue<int> q(10, type);
             thread pusher(boost::bind(&pushClearThread, &q, 100));
             thread popper(boost::bind(&popClearThread, &q));
             pusher.join();
             popper.join();
             TEST(q.empty());
         }
+        {
+            // No sleeps: Exercises the blocking paths on full and empty queues.
+            Queue<int> q(4, type);
+            int numErrors = 0;
+            thread pusher(boost::bind(&pushSequenceThread, &q, 0, 20000, 1));
+            thread popper(boost::bind(&popSequenceThread, &q, 20000, &numErrors));
+            pusher.join();
+            popper.join();
+            TEST(numErrors == 0);
+            TEST(q.empty());
+        }
+    }
+
+    void runRingTests()
+    {
+        LockFreeRing<int> ring(3, false);
+        int i;
+        TEST(ring.size() == 0);
+        TEST(!ring.tryPop(i));
+        TEST(ring.tryPush(1) && ring.tryPush(2) && ring.tryPush(3));
+        TEST(!ring.tryPush(4));
+        TEST(ring.size() == 3);
+        TEST(ring.tryPeek(i) && i == 1);
+        TEST(ring.tryPop(i) && i == 1);
+        TEST(ring.tryPush(4));
+        TEST(ring.tryPop(i) && i == 2);
+        TEST(ring.tryPop(i) && i == 3);
+        TEST(ring.tryPop(i) && i == 4);
+        TEST(!ring.tryPop(i));
+        TEST(ring.size() == 0);
+
+        // Several producers, every element must arrive exactly once.
+        Queue<int> q(16, QT_LOCKFREE_MP);
+        thread pusher1(boost::bind(&pushSequenceThread, &q, 0, 10000, 2));
+        thread pusher2(boost::bind(&pushSequenceThread, &q, 1, 10000, 2));
+        vector<int> received(20000, 0);
+        for (int j = 0; j < 20000; ++j) {
+            received[*q.pop()]++;
+        }
+        pusher1.join();
+        pusher2.join();
+        int numWrong = 0;
+        for (int j = 0; j < 20000; ++j) {
+            if (received[j] != 1) {
+                numWrong++;
+            }
+        }
+        TEST(numWrong == 0);
+        TEST(q.empty());
     }
 
     static void pushThread(Queue<int>* pq, int numPushes)
@@ -258,6 +347,61 @@ private:
             pElem = pq->pop();
         } while (*pElem != -1);
     }
+
+    static void pushSequenceThread(Queue<int>* pq, int start, int numPushes, int step)
+    {
+        for (int i=0; i<numPushes; ++i) {
+            pq->push(ElemPtr(new int(start+i*step)));
+        }
+    }
+
+    static void popSequenceThread(Queue<int>* pq, int numPops, int* pNumErrors)
+    {
+        for (int i=0; i<numPops; ++i) {
+            if (*pq->pop() != i) {
+                (*pNumErrors)++;
+            }
+        }
+    }
+};
+
+class RingBufferTest: public Test
+{
+public:
+    RingBufferTest()
+        : Test("RingBufferTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        RingBuffer<int> ring(3);
+        TEST(ring.empty());
+        ring.push(1);
+        ring.push(2);
+        TEST(ring.size() == 2 && ring.front() == 1 && ring.back() == 2);
+        ring.push(3);
+        ring.push(4);
+        ring.push(5);
+        TEST(ring.size() == 3);
+        TEST(ring[0] == 3 && ring[1] == 4 && ring[2] == 5);
+        int elems[4];
+        ring.copyTo(elems);
+        TEST(elems[0] == 3 && elems[1] == 4 && elems[2] == 5);
+
+        // Shrinking keeps the newest elements, growing keeps all of them.
+        ring.setCapacity(2);
+        TEST(ring.size() == 2 && ring[0] == 4 && ring[1] == 5);
+        ring.setCapacity(4);
+        ring.push(6);
+        ring.push(7);
+        TEST(ring.size() == 4 && ring.front() == 4 && ring.back() == 7);
+        ring.push(8);
+        ring.copyTo(elems);
+        TEST(elems[0] == 5 && elems[1] == 6 && elems[2] == 7 && elems[3] == 8);
+        ring.clear();
+        TEST(ring.empty());
+    }
 };
 
 class TestWorkerThread: public WorkerThread<TestWorkerThread>
@@ -303,6 +447,63 @@ private:
 };
 
 
+class RollingHistogramTest: public Test
+{
+public:
+    RollingHistogramTest()
+      : Test("RollingHistogramTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        RollingHistogram hist(100, 10, 100);
+        TEST(hist.getNumSamples() == 0);
+        TEST(hist.getPercentile(50) == 0);
+        TEST(hist.getMax() == 0);
+        for (int i = 1; i <= 100; ++i) {
+            hist.addSample(i*10-5);
+        }
+        TEST(hist.getNumSamples() == 100);
+        TEST(almostEqual(hist.getAverage(), 500.f));
+        TEST(hist.getPercentile(50) == 500);
+        TEST(hist.getPercentile(95) == 950);
+        TEST(hist.getPercentile(100) == 995);
+        TEST(hist.getMax() == 995);
+
+        // Old samples leave the window.
+        for (int i = 0; i < 90; ++i) {
+            hist.addSample(15);
+        }
+        TEST(hist.getNumSamples() == 100);
+        TEST(hist.getPercentile(50) == 20);
+        TEST(hist.getPercentile(95) == 950);
+        TEST(hist.getMax() == 995);
+        for (int i = 0; i < 10; ++i) {
+            hist.addSample(15);
+        }
+        TEST(hist.getMax() == 15);
+        TEST(hist.getPercentile(99) == 15);
+        TEST(almostEqual(hist.getAverage(), 15.f));
+
+        // Overflow bucket.
+        hist.addSample(5000);
+        TEST(hist.getPercentile(100) == 5000);
+        TEST(hist.getBucketCounts()[100] == 1);
+
+        hist.setWindowSize(10);
+        TEST(hist.getWindowSize() == 10);
+        TEST(hist.getNumSamples() == 0);
+        for (int i = 0; i < 25; ++i) {
+            hist.addSample(i);
+        }
+        TEST(hist.getNumSamples() == 10);
+        TEST(hist.getMax() == 24);
+        TEST(almostEqual(hist.getAverage(), 19.5f));
+    }
+};
+
+
 class WorkerThreadTest: public Test
 {
 public:
@@ -534,6 +735,31 @@ public:
 };
 
 
+class TimeSourceTest: public Test
+{
+public:
+    TimeSourceTest()
+      : Test("TimeSourceTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        TimeSource* pTimeSource = TimeSource::get();
+        long long targetTime = pTimeSource->getCurrentMicrosecs()+5000;
+        long long overshoot = pTimeSource->sleepUntilMicrosecs(targetTime, 1000);
+        TEST(pTimeSource->getCurrentMicrosecs() >= targetTime);
+        TEST(overshoot != -1);
+
+        // Short waits are spent busy-waiting.
+        targetTime = pTimeSource->getCurrentMicrosecs()+200;
+        overshoot = pTimeSource->sleepUntilMicrosecs(targetTime, 1000);
+        TEST(pTimeSource->getCurrentMicrosecs() >= targetTime);
+        TEST(overshoot == -1);
+    }
+};
+
+
 class OSTest: public Test
 {
 public:
@@ -975,6 +1201,254 @@ public:
     }
 };
 
+class CountingLogSink: public ILogSink
+{
+public:
+    CountingLogSink(const string& sText, int delay)
+        : m_sText(sText),
+          m_Delay(delay),
+          m_NumMessages(0)
+    {
+    }
+
+    virtual void logMessage(const tm* pTime, unsigned millis, 
+            const category_t& category, severity_t severity, const UTF8String& sMsg)
+    {
+        if (sMsg.find(m_sText) != string::npos) {
+            m_NumMessages++;
+        }
+        if (m_Delay) {
+            msleep(m_Delay);
+        }
+    }
+
+    int getNumMessages() const
+    {
+        return m_NumMessages;
+    }
+
+private:
+    string m_sText;
+    int m_Delay;
+    int m_NumMessages;
+};
+
+typedef boost::shared_ptr<CountingLogSink> CountingLogSinkPtr;
+
+// Needs a lock for every message, like a python sink needs the interpreter lock.
+class LockingLogSink: public ILogSink
+{
+public:
+    LockingLogSink(boost::mutex& mutex)
+        : m_Mutex(mutex),
+          m_NumMessages(0)
+    {
+    }
+
+    virtual void logMessage(const tm* pTime, unsigned millis, 
+            const category_t& category, severity_t severity, const UTF8String& sMsg)
+    {
+        boost::lock_guard<boost::mutex> lock(m_Mutex);
+        if (sMsg.find("AsyncLoggerTest") != string::npos) {
+            m_NumMessages++;
+        }
+    }
+
+    int getNumMessages() const
+    {
+        return m_NumMessages;
+    }
+
+private:
+    boost::mutex& m_Mutex;
+    int m_NumMessages;
+};
+
+typedef boost::shared_ptr<LockingLogSink> LockingLogSinkPtr;
+
+class AsyncLoggerTest: public Test
+{
+public:
+    AsyncLoggerTest()
+      : Test("AsyncLoggerTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        std::stringstream buffer;
+        std::streambuf *sbuf = std::cerr.rdbuf();
+        std::cerr.rdbuf(buffer.rdbuf());
+        Logger *pLogger = Logger::get();
+        category_t category = pLogger->configureCategory("ASYNC_TEST", 
+                Logger::severity::INFO);
+        {
+            // More messages than fit in the thread buffers, so producers block.
+            CountingLogSinkPtr pSink(new CountingLogSink("AsyncLoggerTest", 0));
+            pLogger->addLogSink(pSink);
+            pLogger->setAsync(true, Logger::BLOCK_PRODUCER);
+            TEST(pLogger->isAsync());
+            vector<boost::thread*> pThreads;
+            for (int i = 0; i < 4; ++i) {
+                pThreads.push_back(new boost::thread(
+                        boost::bind(&AsyncLoggerTest::logThread, category, 2000)));
+            }
+            for (unsigned i = 0; i < pThreads.size(); ++i) {
+                pThreads[i]->join();
+                delete pThreads[i];
+            }
+            pLogger->flush();
+            TEST(pSink->getNumMessages() == 8000);
+            TEST(pLogger->getNumDroppedMessages() == 0);
+            pLogger->removeLogSink(pSink);
+        }
+        {
+            // Slow sink: Messages that don't fit are dropped and counted.
+            CountingLogSinkPtr pSink(new CountingLogSink("AsyncLoggerTest", 1));
+            pLogger->addLogSink(pSink);
+            pLogger->setAsync(true, Logger::DROP_MESSAGES);
+            TEST(pLogger->getOverflowPolicy() == Logger::DROP_MESSAGES);
+            logThread(category, 2000);
+            pLogger->flush();
+            long long numDropped = pLogger->getNumDroppedMessages();
+            TEST(numDropped > 0);
+            TEST(pSink->getNumMessages() + numDropped == 2000);
+            pLogger->removeLogSink(pSink);
+        }
+        {
+            // The sink needs a lock the producer holds. Producers give up waiting 
+            // after a while instead of deadlocking.
+            boost::mutex sinkMutex;
+            LockingLogSinkPtr pSink(new LockingLogSink(sinkMutex));
+            pLogger->addLogSink(pSink);
+            pLogger->setAsync(true, Logger::BLOCK_PRODUCER);
+            long long numDroppedBefore = pLogger->getNumDroppedMessages();
+            {
+                boost::lock_guard<boost::mutex> lock(sinkMutex);
+                logThread(category, 2000);
+            }
+            pLogger->flush();
+            long long numDropped = pLogger->getNumDroppedMessages()-numDroppedBefore;
+            TEST(numDropped > 0);
+            TEST(pSink->getNumMessages() + numDropped == 2000);
+            // Once there is room again, producers block as usual.
+            logThread(category, 10);
+            pLogger->flush();
+            TEST(pLogger->getNumDroppedMessages()-numDroppedBefore == numDropped);
+            pLogger->removeLogSink(pSink);
+        }
+        {
+            // Switching async mode off while other threads log doesn't leave messages 
+            // in the thread buffers.
+            CountingLogSinkPtr pSink(new CountingLogSink("AsyncLoggerTest", 0));
+            pLogger->addLogSink(pSink);
+            long long numDroppedBefore = pLogger->getNumDroppedMessages();
+            vector<boost::thread*> pThreads;
+            for (int i = 0; i < 4; ++i) {
+                pThreads.push_back(new boost::thread(
+                        boost::bind(&AsyncLoggerTest::logThread, category, 2000)));
+            }
+            for (int i = 0; i < 20; ++i) {
+                pLogger->setAsync(true, Logger::BLOCK_PRODUCER);
+                pLogger->setAsync(false);
+            }
+            for (unsigned i = 0; i < pThreads.size(); ++i) {
+                pThreads[i]->join();
+                delete pThreads[i];
+            }
+            long long numDropped = pLogger->getNumDroppedMessages()-numDroppedBefore;
+            TEST(pSink->getNumMessages() + numDropped == 8000);
+            pLogger->removeLogSink(pSink);
+        }
+        pLogger->setAsync(false);
+        TEST(!pLogger->isAsync());
+        {
+            CountingLogSinkPtr pSink(new CountingLogSink("AsyncLoggerTest", 0));
+            pLogger->addLogSink(pSink);
+            logThread(category, 10);
+            TEST(pSink->getNumMessages() == 10);
+            pLogger->removeLogSink(pSink);
+        }
+        std::cerr.rdbuf(sbuf);
+    }
+
+private:
+    static void logThread(category_t category, int numMessages)
+    {
+        for (int i = 0; i < numMessages; ++i) {
+            AVG_TRACE(category, Logger::severity::INFO, "AsyncLoggerTest " << i);
+        }
+    }
+};
+
+
+static ProfilingZoneID TraceTestProfilingZone("Trace \"test\" zone", true);
+static ProfilingZoneID TraceTestCounter("Trace test counter", true);
+
+static void traceTestThread()
+{
+    ThreadProfiler::get()->setName("TraceTestThread");
+    {
+        ScopeTimer timer(TraceTestProfilingZone);
+        ThreadProfiler::get()->addCounterValue(TraceTestCounter, 42);
+    }
+    ThreadProfiler::kill();
+}
+
+class TraceTest: public Test
+{
+public:
+    TraceTest()
+      : Test("TraceTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        ThreadProfiler::startTracing(2);
+        TEST(ThreadProfiler::isTracing());
+        TEST(ScopeTimer::timersEnabled());
+        {
+            ScopeTimer timer(TraceTestProfilingZone);
+        }
+        boost::thread thread(&traceTestThread);
+        thread.join();
+        ThreadProfiler::endTraceFrame();
+        TEST(ThreadProfiler::isTracing());
+        ThreadProfiler::endTraceFrame();
+        TEST(!ThreadProfiler::isTracing());
+        {
+            // Not recorded anymore.
+            ScopeTimer timer(TraceTestProfilingZone);
+        }
+        std::string sTrace = ThreadProfiler::getTraceJSON();
+        TEST(countOccurrences(sTrace, "\"Trace \\\"test\\\" zone\",\"ph\":\"X\"") == 2);
+        TEST(countOccurrences(sTrace, "\"TraceTestThread\"") == 1);
+        TEST(countOccurrences(sTrace, "\"args\":{\"value\":42}") == 1);
+        TEST(countOccurrences(sTrace, "\"Frame\",\"ph\":\"i\"") == 2);
+        TEST(ThreadProfiler::getNumDroppedTraceEvents() == 0);
+
+        // A new trace doesn't contain the events of the last one.
+        ThreadProfiler::startTracing();
+        ThreadProfiler::stopTracing();
+        sTrace = ThreadProfiler::getTraceJSON();
+        TEST(countOccurrences(sTrace, "\"ph\":\"X\"") == 0);
+        TEST(countOccurrences(sTrace, "TraceTestThread") == 0);
+    }
+
+private:
+    int countOccurrences(const std::string& s, const std::string& sSub)
+    {
+        int count = 0;
+        for (size_t pos = s.find(sSub); pos != std::string::npos; 
+                pos = s.find(sSub, pos+1))
+        {
+            count++;
+        }
+        return count;
+    }
+};
+
 class BaseTestSuite: public TestSuite
 {
 public:
@@ -983,11 +1457,14 @@ public:
     {
         addTest(TestPtr(new DAGTest));
         addTest(TestPtr(new QueueTest));
+        addTest(TestPtr(new RingBufferTest));
+        addTest(TestPtr(new RollingHistogramTest));
         addTest(TestPtr(new WorkerThreadTest));
         addTest(TestPtr(new ObjectCounterTest));
         addTest(TestPtr(new GeomTest));
         addTest(TestPtr(new TriangleTest));
         addTest(TestPtr(new FileTest));
+        addTest(TestPtr(new TimeSourceTest));
         addTest(TestPtr(new OSTest));
         addTest(TestPtr(new StringTest));
         addTest(TestPtr(new SplineTest));
@@ -996,6 +1473,8 @@ public:
         addTest(TestPtr(new BacktraceTest));
         addTest(TestPtr(new XmlParserTest));
         addTest(TestPtr(new StandardLoggerTest));
+        addTest(TestPtr(new AsyncLoggerTest));
+        addTest(TestPtr(new TraceTest));
     }
 };
 
@@ -23,6 +23,7 @@
 #include "Pixel24.h"
 #include "Pixel16.h"
 #include "Pixel8.h"
+#include "PixelConversion.h"
 #include "Filter3x3.h"
 
 #include "../base/Exception.h"
@@ -181,6 +182,7 @@ void Bitmap::copyPixels(const Bitmap& origBmp)
                     case I8:
                     case A8:
                         YCbCrtoI8(origBmp);
+                        break;
                     default: {
                             Bitmap TempBmp(getSize(), B8G8R8X8, "TempColorConversion");
                             TempBmp.YCbCrtoBGR(origBmp);
@@ -302,214 +304,26 @@ void Bitmap::copyPixels(const Bitmap& origBmp)
     }
 }
 
-#if defined(__SSE__) || defined(_WIN32)
-ostream& operator<<(ostream& os, const __m64 &val)
-{
-    unsigned char * pVal = (unsigned char *)(&val);
-    for (int i = 0; i < 8; ++i) {
-        os << hex << setw(2) << setfill('0') << int(pVal[i]);
-        if (i%2 == 1) {
-            os << " ";
-        }
-        if (i%4 == 3) {
-            os << " ";
-        }
-    }
-    return os;
-}
-#endif
-
-#define YUV_TO_RGB_UNPACK    \
-    /* Input: r, g, b contain 4 words each of the u and v inputs for the color */    \
-    /* channels. ylo and yhi contain 4 words each of the y input. */    \
-\
-    /* duplicate u and v channels and add y    \
-     * each of r,g, b in the form [s1(16), s2(16), s3(16), s4(16)]    \
-     * first interleave, so tmp is [s1(16), s1(16), s2(16), s2(16)]    \
-     * then add y, then interleave again    \
-     * then pack with saturation, to get the desired output of    \
-     *   [s1(8), s1(8), s2(8), s2(8), s3(8), s3(8), s4(8), s4(8)]    \
-     */    \
-    tmp = _m_punpckhwd(r, r);    \
-    tmp = _m_paddsw(tmp, yhi);    \
-    tmp2 = _m_punpcklwd(r, r);    \
-    tmp2 = _m_paddsw(tmp2, ylo);    \
-    r = _m_packuswb(tmp2, tmp);    \
-    \
-    tmp = _m_punpckhwd(g, g);    \
-    tmp2 = _m_punpcklwd(g, g);    \
-    tmp = _m_paddsw(tmp, yhi);    \
-    tmp2 = _m_paddsw(tmp2, ylo);    \
-    g = _m_packuswb(tmp2, tmp);    \
-    \
-    tmp = _m_punpckhwd(b, b);    \
-    tmp2 = _m_punpcklwd(b, b);    \
-    tmp = _m_paddsw(tmp, yhi);    \
-    tmp2 = _m_paddsw(tmp2, ylo);    \
-    b = _m_packuswb(tmp2, tmp);    \
-    \
-    /* now we have 8 8-bit r, g and b samples.  we want these to be packed    \
-     * into 32-bit values.    \
-     */    \
-    imm = _mm_set1_pi32(0xFFFFFFFF);    \
-    tmp = _m_punpcklbw(b, r);    \
-    tmp2 = _m_punpcklbw(g, imm);    \
-    *o++ = _m_punpcklbw(tmp, tmp2);    \
-    *o++ = _m_punpckhbw(tmp, tmp2);    \
-    tmp = _m_punpckhbw(b, r);    \
-    tmp2 = _m_punpckhbw(g, imm);    \
-    *o++ = _m_punpcklbw(tmp, tmp2);    \
-    *o++ = _m_punpckhbw(tmp, tmp2);
-
-
 void Bitmap::copyYUVPixels(const Bitmap& yBmp, const Bitmap& uBmp, const Bitmap& vBmp,
         bool bJPEG)
 {
+    AVG_ASSERT(getBytesPerPixel() == 4);
     int height = min(yBmp.getSize().y, m_Size.y);
     int width = min(yBmp.getSize().x, m_Size.x);
 
-    int yStride = yBmp.getStride();
-    int uStride = uBmp.getStride();
-    int vStride = vBmp.getStride();
-    int destStride = m_Stride/getBytesPerPixel();
-    Pixel32 * pDestLine = (Pixel32*)m_pBits;
-
-#if defined(__SSE__) || defined(_WIN32)
-#pragma pack(16)
-    // Original SSE conversion code taken from liboggplay: oggplay_sse_x86.c
-    int               i;     
-    const unsigned char   * ptry;
-    const unsigned char   * ptru;
-    const unsigned char   * ptrv;
-
-    __m64    *o;
-    __m64    y, ylo, yhi;
-    __m64    zero, ut, vt, imm;
-    __m64    r, g, b;
-    __m64    tmp, tmp2;
-
-    zero = _mm_setzero_si64(); 
-
-    ptry = yBmp.getPixels();
-    ptru = uBmp.getPixels();
-    ptrv = vBmp.getPixels();
-
-    for (i = 0; i < height; i++) {
-        int j;
-        o = (__m64*)pDestLine;
-        pDestLine += destStride;
-        if (bJPEG) {
-            for (j = 0; j < width; j += 8) {
-                // ylo and yhi contain 4 pixels each
-                y = *(__m64*)(&(ptry[j]));
-                ylo = _m_punpcklbw(y, zero);
-               
-                yhi = _m_punpckhbw(y, zero);
-
-                ut = _m_from_int(*(int *)(ptru + j/2));
-                vt = _m_from_int(*(int *)(ptrv + j/2));
-
-                ut = _m_punpcklbw(ut, zero);
-                vt = _m_punpcklbw(vt, zero);
-
-                /* subtract 128 from u and v */ 
-                imm = _mm_set1_pi16(128);
-                ut = _m_psubw(ut, imm);
-                vt = _m_psubw(vt, imm);
-
-                /* transfer and multiply into r, g, b registers */
-                imm = _mm_set1_pi16(-44);
-                g = _m_pmullw(ut, imm);
-                imm = _mm_set1_pi16(113);
-                b = _m_pmullw(ut, imm);
-                imm = _mm_set1_pi16(179);
-                r = _m_pmullw(vt, imm);
-                imm = _mm_set1_pi16(-91);
-                imm = _m_pmullw(vt, imm);
-                g = _m_paddsw(g, imm);
-
-                /* shift r, g and b registers to the right */
-                r = _m_psrawi(r, 7);
-                g = _m_psrawi(g, 7);
-                b = _m_psrawi(b, 6);
-                YUV_TO_RGB_UNPACK
-
-            }
-        } else {
-            for (j = 0; j < width; j += 8) {
-
-                // y' = (298*(y-16))
-                // ylo and yhi contain 4 pixels each
-                y = *(__m64*)(&(ptry[j]));
-                ylo = _m_punpcklbw(y, zero);
-                imm = _mm_set1_pi16(16);
-                ylo = _m_psubusw(ylo, imm);
-                imm = _mm_set1_pi16(149);
-                ylo = _m_pmullw(ylo, imm);
-                ylo = _mm_srli_pi16(ylo, 7);
-               
-                yhi = _m_punpckhbw(y, zero);
-                imm = _mm_set1_pi16(16);
-                yhi = _m_psubusw(yhi, imm);
-                imm = _mm_set1_pi16(149);
-                yhi = _m_pmullw(yhi, imm);
-                yhi = _mm_srli_pi16(yhi, 7);
-
-                ut = _m_from_int(*(int *)(ptru + j/2));
-                vt = _m_from_int(*(int *)(ptrv + j/2));
-
-                ut = _m_punpcklbw(ut, zero);
-                vt = _m_punpcklbw(vt, zero);
-
-                /* subtract 128 from u and v */ 
-                imm = _mm_set1_pi16(128);
-                ut = _m_psubw(ut, imm);
-                vt = _m_psubw(vt, imm);
-
-                /* transfer and multiply into r, g, b registers */
-                imm = _mm_set1_pi16(-50);
-                g = _m_pmullw(ut, imm);
-                imm = _mm_set1_pi16(129);
-                b = _m_pmullw(ut, imm);
-                imm = _mm_set1_pi16(204);
-                r = _m_pmullw(vt, imm);
-                imm = _mm_set1_pi16(-104);
-                imm = _m_pmullw(vt, imm);
-                g = _m_paddsw(g, imm);
-
-                /* shift r, g and b registers to the right */
-                r = _m_psrawi(r, 7);
-                g = _m_psrawi(g, 7);
-                b = _m_psrawi(b, 6);
-                YUV_TO_RGB_UNPACK
-            }
-        }
-        if (i & 0x1) {
-            ptru += uStride;
-            ptrv += vStride;
-        }
-        ptry += yStride;
-    }
-    _m_empty();
-#pragma pack()
-#else
-    AVG_ASSERT(m_PF==B8G8R8X8);
     const unsigned char * pYSrc = yBmp.getPixels();
     const unsigned char * pUSrc = uBmp.getPixels();
     const unsigned char * pVSrc = vBmp.getPixels();
-
+    unsigned char * pDest = m_pBits;
     for (int y = 0; y < height; ++y) {
-        for (int x = 0; x < width; ++x) {
-            YUVtoBGR32Pixel(pDestLine + x, pYSrc[x], pUSrc[x/2], pVSrc[x/2]);
-        }
-        pDestLine += destStride;
-        pYSrc += yStride;
+        convertYUV420ToBGRXLine(pYSrc, pUSrc, pVSrc, pDest, width, bJPEG);
+        pDest += m_Stride;
+        pYSrc += yBmp.getStride();
         if (y % 2 == 1) {
-            pUSrc += uStride;
-            pVSrc += vStride;
+            pUSrc += uBmp.getStride();
+            pVSrc += vBmp.getStride();
         }
     }
-#endif
 }
 
 void Bitmap::save(const UTF8String& sFilename)
@@ -1168,74 +982,6 @@ void Bitmap::allocBits(int stride)
     }
 }
 
-void YUYV422toBGR32Line(const unsigned char* pSrcLine, Pixel32* pDestLine, int width)
-{
-    Pixel32 * pDestPixel = pDestLine;
-    
-    // We need the previous and next values to interpolate between the
-    // sampled u and v values.
-    int v = *(pSrcLine+3);
-    int v0; // Previous v
-    int u;
-    int u1; // Next u;
-    const unsigned char * pSrcPixels = pSrcLine;
-
-    for (int x = 0; x < width/2-1; x++) {
-        // Two pixels at a time.
-        // Source format is YUYV.
-        u = pSrcPixels[1];
-        v0 = v;
-        v = pSrcPixels[3];
-        u1 = pSrcPixels[5];
-
-        YUVtoBGR32Pixel(pDestPixel, pSrcPixels[0], u, (v0+v)/2);
-        YUVtoBGR32Pixel(pDestPixel+1, pSrcPixels[2], (u+u1)/2, v);
-
-        pSrcPixels+=4;
-        pDestPixel+=2;
-    }
-    // Last pixels.
-    u = pSrcPixels[1];
-    v0 = v;
-    v = pSrcPixels[3];
-    YUVtoBGR32Pixel(pDestPixel, pSrcPixels[0], u, v0/2+v/2);
-    YUVtoBGR32Pixel(pDestPixel+1, pSrcPixels[2], u, v);
-}
- 
-void UYVY422toBGR32Line(const unsigned char* pSrcLine, Pixel32* pDestLine, int width)
-{
-    Pixel32 * pDestPixel = pDestLine;
-    
-    // We need the previous and next values to interpolate between the
-    // sampled u and v values.
-    int v = *(pSrcLine+2);
-    int v0; // Previous v
-    int u;
-    int u1; // Next u;
-    const unsigned char * pSrcPixels = pSrcLine;
-
-    for (int x = 0; x < width/2-1; x++) {
-        // Two pixels at a time.
-        // Source format is UYVY.
-        u = pSrcPixels[0];
-        v0 = v;
-        v = pSrcPixels[2];
-        u1 = pSrcPixels[4];
-
-        YUVtoBGR32Pixel(pDestPixel, pSrcPixels[1], u, (v0+v)/2);
-        YUVtoBGR32Pixel(pDestPixel+1, pSrcPixels[3], (u+u1)/2, v);
-
-        pSrcPixels+=4;
-        pDestPixel+=2;
-    }
-    // Last pixels.
-    u = pSrcPixels[0];
-    v0 = v;
-    v = pSrcPixels[2];
-    YUVtoBGR32Pixel(pDestPixel, pSrcPixels[1], u, v0/2+v/2);
-    YUVtoBGR32Pixel(pDestPixel+1, pSrcPixels[3], u, v);
-}
- 
 void YUV411toBGR32Line(const unsigned char* pSrcLine, Pixel32* pDestLine, int width)
 {
     Pixel32 * pDestPixel = pDestLine;
@@ -1284,15 +1030,10 @@ void Bitmap::YCbCrtoBGR(const Bitmap& origBmp)
     int StrideInPixels = m_Stride/getBytesPerPixel();
     switch(origBmp.m_PF) {
         case YCbCr422:
-            for (int y = 0; y < height; ++y) {
-                UYVY422toBGR32Line(pSrc, pDest, width);
-                pDest += StrideInPixels;
-                pSrc += origBmp.getStride();
-            }
-            break;
         case YUYV422:
             for (int y = 0; y < height; ++y) {
-                YUYV422toBGR32Line(pSrc, pDest, width);
+                convertYUV422ToBGRXLine(pSrc, (unsigned char*)pDest, width,
+                        origBmp.m_PF == YCbCr422);
                 pDest += StrideInPixels;
                 pSrc += origBmp.getStride();
             }
@@ -1310,17 +1051,6 @@ void Bitmap::YCbCrtoBGR(const Bitmap& origBmp)
     }
 }
     
-void YUYV422toI8Line(const unsigned char* pSrcLine, unsigned char* pDestLine, int width)
-{
-    const unsigned char * pSrc = pSrcLine;
-    unsigned char * pDest = pDestLine;
-    for (int x = 0; x < width; x++) {
-        *pDest = *pSrc;
-        pDest++;
-        pSrc+=2;
-    }
-}
- 
 void YUV411toI8Line(const unsigned char* pSrcLine, unsigned char* pDestLine, int width)
 {
     const unsigned char * pSrc = pSrcLine;
@@ -1334,7 +1064,7 @@ void YUV411toI8Line(const unsigned char* pSrcLine, unsigned char* pDestLine, int
  
 void Bitmap::YCbCrtoI8(const Bitmap& origBmp)
 {
-    AVG_ASSERT(origBmp.getBytesPerPixel() == 1);
+    AVG_ASSERT(getBytesPerPixel() == 1);
     const unsigned char * pSrc = origBmp.getPixels();
     unsigned char * pDest = m_pBits;
     int height = min(origBmp.getSize().y, m_Size.y);
@@ -1344,14 +1074,14 @@ void Bitmap::YCbCrtoI8(const Bitmap& origBmp)
             for (int y = 0; y < height; ++y) {
                 // src shifted by one byte to account for UYVY to YUYV 
                 // difference in pixel order.
-                YUYV422toI8Line(pSrc+1, pDest, width);
+                convertYUYV422ToI8Line(pSrc+1, pDest, width);
                 pDest += m_Stride;
                 pSrc += origBmp.getStride();
             }
             break;
         case YUYV422:
             for (int y = 0; y < height; ++y) {
-                YUYV422toI8Line(pSrc, pDest, width);
+                convertYUYV422ToI8Line(pSrc, pDest, width);
                 pDest += m_Stride;
                 pSrc += origBmp.getStride();
             }
@@ -1379,11 +1109,7 @@ void Bitmap::I16toI8(const Bitmap& origBmp)
     int width = min(origBmp.getSize().x, m_Size.x);
     int srcStrideInPixels = origBmp.getStride()/origBmp.getBytesPerPixel();
     for (int y = 0; y < height; ++y) {
-        const unsigned short * pSrcPixel = pSrc;
-        unsigned char * pDestPixel = pDest;
-        for (int x=0; x<width; ++x) {
-            *pDestPixel++ = *pSrcPixel++ >> 8;
-        }
+        convertI16ToI8Line(pSrc, pDest, width);
         pDest += m_Stride;
         pSrc += srcStrideInPixels;
     }
@@ -1399,11 +1125,7 @@ void Bitmap::I8toI16(const Bitmap& origBmp)
     int width = min(origBmp.getSize().x, m_Size.x);
     int destStrideInPixels = m_Stride/getBytesPerPixel();
     for (int y=0; y<height; ++y) {
-        const unsigned char * pSrcPixel = pSrc;
-        unsigned short * pDestPixel = pDest;
-        for (int x=0; x<width; ++x) {
-            *pDestPixel++ = *pSrcPixel++ << 8;
-        }
+        convertI8ToI16Line(pSrc, pDest, width);
         pDest += destStrideInPixels;
         pSrc += origBmp.getStride();
     }
@@ -1417,18 +1139,10 @@ void Bitmap::I8toRGB(const Bitmap& origBmp)
     int height = min(origBmp.getSize().y, m_Size.y);
     int width = min(origBmp.getSize().x, m_Size.x);
     if (getBytesPerPixel() == 4) {
-        unsigned int * pDest = (unsigned int *)m_pBits;
-        int destStrideInPixels = m_Stride/getBytesPerPixel();
+        unsigned char * pDest = m_pBits;
         for (int y = 0; y < height; ++y) {
-            const unsigned char * pSrcPixel = pSrc;
-            unsigned int * pDestPixel = pDest;
-            for (int x = 0; x < width; ++x) {
-                *pDestPixel = (((((255 << 8)+(*pSrcPixel)) << 8)+
-                        *pSrcPixel) << 8) +(*pSrcPixel);
-                pDestPixel ++;
-                pSrcPixel++;
-            }
-            pDest += destStrideInPixels;
+            convertI8ToBGRXLine(pSrc, pDest, width);
+            pDest += m_Stride;
             pSrc += origBmp.getStride();
         }
     } else {
@@ -1598,118 +1312,20 @@ void Bitmap::BY8toRGBBilinear(const Bitmap& origBmp)
     int height = min(origBmp.getSize().y, m_Size.y);
     int width = min(origBmp.getSize().x, m_Size.x);
 
-    const int srcStride = width;
-    const int doubleSrcStride = srcStride * 2;
-    const int destStride = 4 * width;
-
     // CFA Pattern selection
     PixelFormat pf = origBmp.getPixelFormat();
-    int blue;
-    int greenFirst;
-    if (pf == BAYER8_BGGR || pf == BAYER8_GBRG) {
-        blue = -1;
-    } else {
-        blue = 1;
-    }
-
-    if (pf == BAYER8_GBRG || pf == BAYER8_GRBG) {
-        greenFirst = 1;
-    } else {
-        greenFirst = 0;
-    }
-
-    const unsigned char *pSrcPixel = origBmp.getPixels();
-    unsigned char *pDestPixel = (unsigned char *) getPixels();
-
-    pDestPixel += destStride + 4 + 1;
-    height -= 2;
-    width -= 2;
-
-    while (height--) {
-        int t0, t1;
-        const unsigned char *pSrcEndBoundary = pSrcPixel + width;
-
-        if (greenFirst) {
-            t0 = (pSrcPixel[1] + pSrcPixel[doubleSrcStride + 1] + 1) >> 1;
-            t1 = (pSrcPixel[srcStride] + pSrcPixel[srcStride + 2] + 1) >> 1;
-            pDestPixel[-blue] = (unsigned char) t0;
-            pDestPixel[0] = pSrcPixel[srcStride + 1];
-            pDestPixel[blue] = (unsigned char) t1;
-            pDestPixel[2] = 255; // Alpha channel
-            ++pSrcPixel;
-            pDestPixel += 4;
-        }
-                
-        if (blue > 0) {
-            while (pSrcPixel <= pSrcEndBoundary - 2) {
-                t0 = (pSrcPixel[0] + pSrcPixel[2] + pSrcPixel[doubleSrcStride] +
-                      pSrcPixel[doubleSrcStride + 2] + 2) >> 2;
-                t1 = (pSrcPixel[1] + pSrcPixel[srcStride] +
-                      pSrcPixel[srcStride + 2] + pSrcPixel[doubleSrcStride + 1] +
-                      2) >> 2;
-                pDestPixel[-1] = (unsigned char) t0;
-                pDestPixel[0] = (unsigned char) t1;
-                pDestPixel[1] = pSrcPixel[srcStride + 1];
-                pDestPixel[2] = 255; // Alpha channel
-
-                t0 = (pSrcPixel[2] + pSrcPixel[doubleSrcStride + 2] + 1) >> 1;
-                t1 = (pSrcPixel[srcStride + 1] + pSrcPixel[srcStride + 3] +
-                      1) >> 1;
-                pDestPixel[3] = (unsigned char) t0;
-                pDestPixel[4] = pSrcPixel[srcStride + 2];
-                pDestPixel[5] = (unsigned char) t1;
-                pDestPixel[6] = 255; // Alpha channel
-                
-                pSrcPixel += 2;
-                pDestPixel += 8;
-            }
-        } else {
-            while (pSrcPixel <= pSrcEndBoundary - 2) {
-                t0 = (pSrcPixel[0] + pSrcPixel[2] + pSrcPixel[doubleSrcStride] +
-                      pSrcPixel[doubleSrcStride + 2] + 2) >> 2;
-                t1 = (pSrcPixel[1] + pSrcPixel[srcStride] +
-                      pSrcPixel[srcStride + 2] + pSrcPixel[doubleSrcStride + 1] +
-                      2) >> 2;
-                pDestPixel[1] = (unsigned char) t0;
-                pDestPixel[0] = (unsigned char) t1;
-                pDestPixel[-1] = pSrcPixel[srcStride + 1];
-                pDestPixel[2] = 255; // Alpha channel
-
-                t0 = (pSrcPixel[2] + pSrcPixel[doubleSrcStride + 2] + 1) >> 1;
-                t1 = (pSrcPixel[srcStride + 1] + pSrcPixel[srcStride + 3] +
-                      1) >> 1;
-                pDestPixel[5] = (unsigned char) t0;
-                pDestPixel[4] = pSrcPixel[srcStride + 2];
-                pDestPixel[3] = (unsigned char) t1;
-                pDestPixel[6] = 255; // Alpha channel
-                
-                pSrcPixel += 2;
-                pDestPixel += 8;
-            }
-        }
-
-        if (pSrcPixel < pSrcEndBoundary) {
-            t0 = (pSrcPixel[0] + pSrcPixel[2] + pSrcPixel[doubleSrcStride] +
-                  pSrcPixel[doubleSrcStride + 2] + 2) >> 2;
-            t1 = (pSrcPixel[1] + pSrcPixel[srcStride] +
-                  pSrcPixel[srcStride + 2] + pSrcPixel[doubleSrcStride + 1] +
-                  2) >> 2;
-            pDestPixel[-blue] = (unsigned char) t0;
-            pDestPixel[0] = (unsigned char) t1;
-            pDestPixel[blue] = pSrcPixel[srcStride + 1];
-            pDestPixel[2] = 255; // Alpha channel
-            pSrcPixel++;
-            pDestPixel += 4;
-        }
-
-        pSrcPixel -= width;
-        pDestPixel -= width * 4;
-
-        blue = -blue;
-        greenFirst = !greenFirst;
-        
-        pSrcPixel += srcStride;
-        pDestPixel += destStride;
+    bool bBlue = (pf != BAYER8_BGGR && pf != BAYER8_GBRG);
+    bool bGreenFirst = (pf == BAYER8_GBRG || pf == BAYER8_GRBG);
+
+    const unsigned char *pSrcLine = origBmp.getPixels();
+    unsigned char *pDestLine = getPixels() + m_Stride + 4;
+    for (int y = 1; y < height-1; ++y) {
+        convertBayerLineBilinear(pSrcLine, origBmp.getStride(), pDestLine, width-2,
+                bBlue, bGreenFirst);
+        bBlue = !bBlue;
+        bGreenFirst = !bGreenFirst;
+        pSrcLine += origBmp.getStride();
+        pDestLine += m_Stride;
     }
 }
 
@@ -32,10 +32,6 @@
 
 #include <boost/shared_ptr.hpp>
 
-#if defined(__SSE__) || defined(_WIN32)
-#include <xmmintrin.h>
-#endif
-
 #include <string>
 #include <vector>
 #include <iostream>
@@ -133,9 +129,5 @@ void Bitmap::setPixel(const IntPoint& p, PIXEL color)
     *(PIXEL*)(&(m_pBits[p.y*m_Stride+p.x*getBytesPerPixel()])) = color;
 }
 
-#if defined(__SSE__) || defined(_WIN32)
-std::ostream& operator<<(std::ostream& os, const __m64 &val);
-#endif
-
 }
 #endif
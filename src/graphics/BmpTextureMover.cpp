@@ -55,11 +55,37 @@ void BmpTextureMover::moveBmpToTexture(BitmapPtr pBmp, GLTexture& tex)
     AVG_ASSERT(getSize() == pBmp->getSize());
     AVG_ASSERT(pBmp->getPixelFormat() == getPF());
     tex.activate(WrapMode());
+    bool bSetRowLength = false;
+    if (pBmp->getStride() != 
+            Bitmap::getPreferredStride(pBmp->getSize().x, pBmp->getPixelFormat()))
+    {
+        // Padded lines, e.g. decoder frames with aligned strides.
+#ifndef AVG_ENABLE_EGL
+        if (!GLContext::getCurrent()->isGLES() && 
+                pBmp->getStride()%pBmp->getBytesPerPixel() == 0)
+        {
+            glPixelStorei(GL_UNPACK_ROW_LENGTH, 
+                    pBmp->getStride()/pBmp->getBytesPerPixel());
+            bSetRowLength = true;
+        }
+#endif
+        if (!bSetRowLength) {
+            // GLES 2 doesn't support GL_UNPACK_ROW_LENGTH, so copy to a tightly 
+            // packed bitmap first.
+            m_pBmp->copyPixels(*pBmp);
+            pBmp = m_pBmp;
+        }
+    }
     unsigned char * pStartPos = pBmp->getPixels();
     IntPoint size = tex.getSize();
     glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, size.x, size.y,
             tex.getGLFormat(getPF()), tex.getGLType(getPF()), 
             pStartPos);
+#ifndef AVG_ENABLE_EGL
+    if (bSetRowLength) {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    }
+#endif
     tex.generateMipmaps();
     GLContext::checkError("BmpTextureMover::moveBmpToTexture: glTexSubImage2D()");
 }
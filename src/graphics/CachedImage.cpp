@@ -39,6 +39,7 @@ namespace avg {
 
 CachedImage::CachedImage(const std::string& sFilename, TexCompression compression)
     : m_bUseMipmaps(false),
+      m_bAllowAtlas(false),
       m_Compression(compression),
       m_BmpRefCount(0),
       m_TexRefCount(0)
@@ -46,8 +47,7 @@ CachedImage::CachedImage(const std::string& sFilename, TexCompression compressio
     ObjectCounter::get()->incRef(&typeid(*this));
     m_sFilename = sFilename;
     AVG_TRACE(Logger::category::MEMORY, Logger::severity::INFO, "Loading " << sFilename);
-    BitmapPtr pBmp = loadBitmap(m_sFilename);
-    m_pBmp = applyCompression(pBmp);
+    m_pBmp = loadBmp();
     incBmpRef(m_Compression);
 }
 
@@ -71,9 +71,8 @@ void CachedImage::incBmpRef(TexCompression compression)
         // Reload from disk, making sure the cache knows about the size change
         int oldSize = m_pBmp->getMemNeeded();
         m_Compression = compression;
-        BitmapPtr pBmp = loadBitmap(m_sFilename);
-        m_pBmp = applyCompression(pBmp);
-        ImageCache::get()->onSizeChange(pBmp->getMemNeeded()-oldSize, STORAGE_CPU);
+        m_pBmp = loadBmp();
+        ImageCache::get()->onSizeChange(m_pBmp->getMemNeeded()-oldSize, STORAGE_CPU);
     }
 }
 
@@ -87,21 +86,25 @@ void CachedImage::decBmpRef()
     }
 }
 
-void CachedImage::incTexRef(bool bUseMipmaps)
+void CachedImage::incTexRef(bool bUseMipmaps, bool bAllowAtlas)
 {
     m_TexRefCount++;
     AVG_ASSERT(m_TexRefCount <= m_BmpRefCount);
     if (m_TexRefCount == 1) {
         m_bUseMipmaps = bUseMipmaps;
+        m_bAllowAtlas = bAllowAtlas;
         if (!m_pTex) {
             createTexture();
             ImageCache::get()->onTexLoad(m_sFilename);
+        } else if (m_pAtlasRegion && (bUseMipmaps || !bAllowAtlas)) {
+            recreateTexture();
         }
-    } else if (bUseMipmaps && !m_bUseMipmaps) {
-        m_bUseMipmaps = true;
-        int oldSize = m_pTex->getMemNeeded();
-        createTexture();
-        ImageCache::get()->onSizeChange(m_pTex->getMemNeeded()-oldSize, STORAGE_GPU);
+    } else if ((bUseMipmaps && !m_bUseMipmaps) || (!bAllowAtlas && m_bAllowAtlas)) {
+        // Atlas textures can't be mipmapped or repeated, so all users of the image 
+        // need to agree on whether the atlas is used.
+        m_bUseMipmaps = m_bUseMipmaps || bUseMipmaps;
+        m_bAllowAtlas = m_bAllowAtlas && bAllowAtlas;
+        recreateTexture();
     }
 }
 
@@ -119,6 +122,7 @@ void CachedImage::unloadTex()
     AVG_ASSERT(m_TexRefCount == 0);
     AVG_ASSERT(m_pTex);
     m_pTex = MCTexturePtr();
+    m_pAtlasRegion = TextureAtlasRegionPtr();
 }
 
 BitmapPtr CachedImage::getBmp()
@@ -133,6 +137,12 @@ MCTexturePtr CachedImage::getTex()
     return m_pTex;
 }
 
+TextureAtlasRegionPtr CachedImage::getAtlasRegion()
+{
+    AVG_ASSERT(m_TexRefCount >= 1);
+    return m_pAtlasRegion;
+}
+
 bool CachedImage::hasTex() const
 {
     return m_pTex != MCTexturePtr();
@@ -144,7 +154,9 @@ int CachedImage::getMemUsed(StorageType st) const
         case CachedImage::STORAGE_CPU:
             return m_pBmp->getMemNeeded();
         case CachedImage::STORAGE_GPU:
-            if (m_pTex) {
+            if (m_pAtlasRegion) {
+                return m_pAtlasRegion->getMemNeeded();
+            } else if (m_pTex) {
                 return m_pTex->getMemNeeded();
             } else {
                 return 0;
@@ -175,6 +187,23 @@ void CachedImage::dump() const
             << ", " << hasTex() << endl;
 }
 
+BitmapPtr CachedImage::loadBmp()
+{
+    ImageDiskCache* pDiskCache = ImageCache::get()->getDiskCache();
+    bool bBlueFirst = BitmapLoader::get()->isBlueFirst();
+    if (pDiskCache) {
+        BitmapPtr pBmp = pDiskCache->load(m_sFilename, m_Compression, bBlueFirst);
+        if (pBmp) {
+            return pBmp;
+        }
+    }
+    BitmapPtr pBmp = applyCompression(loadBitmap(m_sFilename));
+    if (pDiskCache) {
+        pDiskCache->store(m_sFilename, m_Compression, bBlueFirst, pBmp);
+    }
+    return pBmp;
+}
+
 BitmapPtr CachedImage::applyCompression(BitmapPtr pBmp)
 {
     // Duplicated code with GPUImage::setBitmap()
@@ -192,7 +221,21 @@ BitmapPtr CachedImage::applyCompression(BitmapPtr pBmp)
 
 void CachedImage::createTexture()
 {
-    m_pTex = GLContextManager::get()->createTextureFromBmp(m_pBmp, m_bUseMipmaps);
+    TextureAtlas* pAtlas = ImageCache::get()->getAtlas();
+    if (pAtlas && m_bAllowAtlas && !m_bUseMipmaps && pAtlas->isSuitable(m_pBmp)) {
+        m_pAtlasRegion = pAtlas->addBitmap(m_pBmp);
+        m_pTex = m_pAtlasRegion->getTex();
+    } else {
+        m_pAtlasRegion = TextureAtlasRegionPtr();
+        m_pTex = GLContextManager::get()->createTextureFromBmp(m_pBmp, m_bUseMipmaps);
+    }
+}
+
+void CachedImage::recreateTexture()
+{
+    int oldSize = getMemUsed(STORAGE_GPU);
+    createTexture();
+    ImageCache::get()->onSizeChange(getMemUsed(STORAGE_GPU)-oldSize, STORAGE_GPU);
 }
 
 }
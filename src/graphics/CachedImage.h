@@ -25,6 +25,7 @@
 #include "../api.h"
 
 #include "TexInfo.h"
+#include "TextureAtlas.h"
 
 #include <boost/shared_ptr.hpp>
 #include <string>
@@ -51,12 +52,14 @@ class AVG_API CachedImage
 
         void incBmpRef(TexCompression compression);
         void decBmpRef();
-        void incTexRef(bool bUseMipmaps);
+        void incTexRef(bool bUseMipmaps, bool bAllowAtlas=false);
         void decTexRef();
         void unloadTex();
 
         BitmapPtr getBmp();
         MCTexturePtr getTex();
+        // Non-null if the texture is part of a texture atlas.
+        TextureAtlasRegionPtr getAtlasRegion();
         bool hasTex() const;
         int getMemUsed(StorageType st) const;
         int getRefCount(StorageType st) const;
@@ -64,15 +67,19 @@ class AVG_API CachedImage
         void dump() const;
 
     private:
+        BitmapPtr loadBmp();
         BitmapPtr applyCompression(BitmapPtr pBmp);
         void createTexture();
+        void recreateTexture();
         void testDelete();
 
         std::string m_sFilename;
         BitmapPtr m_pBmp;
         MCTexturePtr m_pTex;
+        TextureAtlasRegionPtr m_pAtlasRegion;
 
         bool m_bUseMipmaps;
+        bool m_bAllowAtlas;
         TexCompression m_Compression;
         
         int m_BmpRefCount;
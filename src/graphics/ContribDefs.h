@@ -8,6 +8,19 @@
 
 namespace avg {
 
+typedef struct
+{
+   int *Weights;     // Normalized weights of neighboring pixels
+   int Left,Right;   // Bounds of source pixels window
+} ContributionType;  // Contirbution information for a single pixel
+
+typedef struct
+{
+   ContributionType *ContribRow; // Row (or column) of contribution weights
+   int WindowSize,               // Filter window size (of affecting source pixels)
+       LineLength;               // Length of line (no. or rows / cols)
+} LineContribType;               // Contribution information for an entire line (row or column)
+
 class ContribDef
 {
 public:
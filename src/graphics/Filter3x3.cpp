@@ -20,10 +20,13 @@
 //
 
 #include "Filter3x3.h"
+#include "FilterExecutor.h"
 #include "Pixeldefs.h"
 
 #include "../base/Exception.h"
 
+#include <boost/bind.hpp>
+
 
 namespace avg {
     
@@ -47,22 +50,26 @@ BitmapPtr Filter3x3::apply(BitmapPtr pBmpSource)
     IntPoint newSize(pBmpSource->getSize().x-2, pBmpSource->getSize().y-2);
     BitmapPtr pNewBmp(new Bitmap(newSize, pBmpSource->getPixelFormat(),
             pBmpSource->getName()+"_filtered"));
-            
-    for (int y = 0; y < newSize.y; y++) {
-        const unsigned char * pSrc = pBmpSource->getPixels()+y*pBmpSource->getStride();
-        unsigned char * pDest = pNewBmp->getPixels()+y*pNewBmp->getStride();
-        switch (pBmpSource->getBytesPerPixel()) {
-            case 4:
-                convolveLine<Pixel32>(pSrc, pDest, newSize.x, pBmpSource->getStride());
-                break;
-            case 3:
-                convolveLine<Pixel24>(pSrc, pDest, newSize.x, pBmpSource->getStride());
-                break;
-            default:
-                AVG_ASSERT(false);
+    int bpp = pBmpSource->getBytesPerPixel();
+    AVG_ASSERT(bpp == 4 || bpp == 3);
+    FilterExecutor::get()->run(newSize.y, newSize.x, boost::bind(&Filter3x3::filterRows,
+            this, pBmpSource.get(), pNewBmp.get(), _1, _2));
+    return pNewBmp;
+}
+
+void Filter3x3::filterRows(Bitmap* pSrcBmp, Bitmap* pDestBmp, int startRow, 
+        int endRow) const
+{
+    int lineLen = pDestBmp->getSize().x;
+    for (int y = startRow; y < endRow; y++) {
+        const unsigned char * pSrc = pSrcBmp->getPixels()+y*pSrcBmp->getStride();
+        unsigned char * pDest = pDestBmp->getPixels()+y*pDestBmp->getStride();
+        if (pSrcBmp->getBytesPerPixel() == 4) {
+            convolveLine<Pixel32>(pSrc, pDest, lineLen, pSrcBmp->getStride());
+        } else {
+            convolveLine<Pixel24>(pSrc, pDest, lineLen, pSrcBmp->getStride());
         }
     }
-    return pNewBmp;
 }
 
 }
@@ -42,6 +42,8 @@ public:
     virtual BitmapPtr apply(BitmapPtr pBmpSource);
 
 private:
+    void filterRows(Bitmap* pSrcBmp, Bitmap* pDestBmp, int startRow, int endRow) 
+            const;
     template<class PIXEL>
     void convolveLine(const unsigned char * pSrc, unsigned char * pDest,
             int lineLen, int stride) const;
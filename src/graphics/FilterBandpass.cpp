@@ -20,10 +20,13 @@
 //
 
 #include "FilterBandpass.h"
+#include "FilterExecutor.h"
 #include "Filterfill.h"
 #include "Pixel8.h"
 #include "Bitmap.h"
 
+#include <boost/bind.hpp>
+
 #include <iostream>
 #include <math.h>
 
@@ -49,14 +52,23 @@ BitmapPtr FilterBandpass::apply(BitmapPtr pBmpSrc)
 
     IntPoint Size = pHPBmp->getSize();
     BitmapPtr pDestBmp = BitmapPtr(new Bitmap(Size, I8, pBmpSrc->getName()));
+    FilterExecutor::get()->run(Size.y, Size.x, boost::bind(
+            &FilterBandpass::subtractRows, this, pLPBmp.get(), pHPBmp.get(), 
+            pDestBmp.get(), _1, _2));
+    return pDestBmp;
+}
 
+void FilterBandpass::subtractRows(Bitmap* pLPBmp, Bitmap* pHPBmp, Bitmap* pDestBmp,
+        int startRow, int endRow) const
+{
+    IntPoint Size = pDestBmp->getSize();
     int lpStride = pLPBmp->getStride();
     int hpStride = pHPBmp->getStride();
     int destStride = pDestBmp->getStride();
-    unsigned char * pLPLine = pLPBmp->getPixels()+m_FilterWidthDiff*lpStride;
-    unsigned char * pHPLine = pHPBmp->getPixels();
-    unsigned char * pDestLine = pDestBmp->getPixels();
-    for (int y = 0; y < Size.y; ++y) {
+    unsigned char * pLPLine = pLPBmp->getPixels()+(m_FilterWidthDiff+startRow)*lpStride;
+    unsigned char * pHPLine = pHPBmp->getPixels()+startRow*hpStride;
+    unsigned char * pDestLine = pDestBmp->getPixels()+startRow*destStride;
+    for (int y = startRow; y < endRow; ++y) {
         unsigned char * pLPPixel = pLPLine+m_FilterWidthDiff;
         unsigned char * pHPPixel = pHPLine;
         unsigned char * pDestPixel = pDestLine;
@@ -70,7 +82,6 @@ BitmapPtr FilterBandpass::apply(BitmapPtr pBmpSrc)
         pHPLine += hpStride;
         pDestLine += destStride;
     }
-    return pDestBmp;
 }
 
 
@@ -40,6 +40,9 @@ public:
     virtual BitmapPtr apply(BitmapPtr pBmpSrc);
 
 private:
+    void subtractRows(Bitmap* pLPBmp, Bitmap* pHPBmp, Bitmap* pDestBmp, 
+            int startRow, int endRow) const;
+
     FilterGauss m_HighpassFilter;
     FilterGauss m_LowpassFilter;
     int m_FilterWidthDiff;
@@ -20,12 +20,16 @@
 //
 
 #include "FilterBlur.h"
+#include "FilterExecutor.h"
+#include "FilterKernels.h"
 #include "Filterfill.h"
 #include "Pixel8.h"
 #include "Bitmap.h"
 
 #include "../base/Exception.h"
 
+#include <boost/bind.hpp>
+
 #include <iostream>
 #include <math.h>
 
@@ -47,23 +51,24 @@ BitmapPtr FilterBlur::apply(BitmapPtr pBmpSrc)
     
     IntPoint Size(pBmpSrc->getSize().x-2, pBmpSrc->getSize().y-2);
     BitmapPtr pDestBmp = BitmapPtr(new Bitmap(Size, I8, pBmpSrc->getName()));
-    int srcStride = pBmpSrc->getStride();
+    FilterExecutor::get()->run(Size.y, Size.x, boost::bind(&FilterBlur::blurRows, this,
+            pBmpSrc.get(), pDestBmp.get(), _1, _2));
+    return pDestBmp;
+}
+
+void FilterBlur::blurRows(Bitmap* pSrcBmp, Bitmap* pDestBmp, int startRow, 
+        int endRow) const
+{
+    IntPoint Size = pDestBmp->getSize();
+    int srcStride = pSrcBmp->getStride();
     int destStride = pDestBmp->getStride();
-    unsigned char * pSrcLine = pBmpSrc->getPixels()+srcStride+1;
-    unsigned char * pDestLine = pDestBmp->getPixels();
-    for (int y = 0; y < Size.y; ++y) {
-        unsigned char * pSrcPixel = pSrcLine;
-        unsigned char * pDestPixel = pDestLine;
-        for (int x = 0; x < Size.x; ++x) {
-            *pDestPixel = (*(pSrcPixel-1) + *(pSrcPixel)*4 + *(pSrcPixel+1)
-                    +*(pSrcPixel-srcStride)+*(pSrcPixel+srcStride)+4)/8;
-            ++pSrcPixel;
-            ++pDestPixel;
-        }
+    unsigned char * pSrcLine = pSrcBmp->getPixels()+(startRow+1)*srcStride+1;
+    unsigned char * pDestLine = pDestBmp->getPixels()+startRow*destStride;
+    for (int y = startRow; y < endRow; ++y) {
+        blurLine8(pSrcLine, srcStride, pDestLine, Size.x);
         pSrcLine += srcStride;
         pDestLine += destStride;
     }
-    return pDestBmp;
 }
 
 }
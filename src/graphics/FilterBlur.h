@@ -38,6 +38,8 @@ class AVG_API FilterBlur: public Filter {
         virtual BitmapPtr apply(BitmapPtr pBmpSrc);
 
     private:
+        void blurRows(Bitmap* pSrcBmp, Bitmap* pDestBmp, int startRow, int endRow) 
+                const;
 };
 
 typedef boost::shared_ptr<FilterBlur> FilterBlurPtr;
@@ -24,11 +24,14 @@
 
 #include "../api.h"
 #include "Filter.h"
+#include "FilterExecutor.h"
 
 #include "Pixel8.h"
 #include "Pixel24.h"
 #include "Pixel32.h"
 
+#include <boost/bind.hpp>
+
 #include <iostream>
 
 namespace avg {
@@ -43,6 +46,8 @@ public:
     virtual BitmapPtr apply(BitmapPtr pBmpSource);
 
 private:
+    void filterRows(Bitmap* pSrcBmp, Bitmap* pDestBmp, int startRow, int endRow) 
+            const;
     void convolveLine(const unsigned char* pSrc, unsigned char* pDest, 
             int lineLen, int stride, int offset = 0) const;
     int m_N;
@@ -126,13 +131,22 @@ BitmapPtr FilterConvol<Pixel>::apply(BitmapPtr pBmpSource)
     BitmapPtr pNewBmp(new Bitmap(NewSize, pBmpSource->getPixelFormat(),
             pBmpSource->getName()+"_filtered"));
             
-    for (int y = 0; y < NewSize.y; y++) {
-        const unsigned char * pSrc = pBmpSource->getPixels()+y*pBmpSource->getStride();
-        unsigned char * pDest = pNewBmp->getPixels()+y*pNewBmp->getStride();
-        convolveLine(pSrc, pDest, NewSize.x, pBmpSource->getStride(), m_Offset);
-    }
+    FilterExecutor::get()->run(NewSize.y, NewSize.x, boost::bind(
+            &FilterConvol<Pixel>::filterRows, this, pBmpSource.get(), pNewBmp.get(), 
+            _1, _2));
     return pNewBmp;
 }
+template <class Pixel>
+void FilterConvol<Pixel>::filterRows(Bitmap* pSrcBmp, Bitmap* pDestBmp, int startRow,
+        int endRow) const
+{
+    for (int y = startRow; y < endRow; y++) {
+        const unsigned char * pSrc = pSrcBmp->getPixels()+y*pSrcBmp->getStride();
+        unsigned char * pDest = pDestBmp->getPixels()+y*pDestBmp->getStride();
+        convolveLine(pSrc, pDest, pDestBmp->getSize().x, pSrcBmp->getStride(), 
+                m_Offset);
+    }
+}
 
 
 }
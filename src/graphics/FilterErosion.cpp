@@ -20,9 +20,12 @@
 //
 
 #include "FilterErosion.h"
+#include "FilterExecutor.h"
 
 #include "../base/Exception.h"
 
+#include <boost/bind.hpp>
+
 #include <algorithm>
 
 using namespace std;
@@ -44,10 +47,21 @@ BitmapPtr FilterErosion::apply(BitmapPtr pSrcBmp)
     AVG_ASSERT(pSrcBmp->getPixelFormat() == I8);
     IntPoint size = pSrcBmp->getSize();
     BitmapPtr pDestBmp = BitmapPtr(new Bitmap(size, I8, pSrcBmp->getName()));
-    unsigned char * pSrcLine = pSrcBmp->getPixels();
+    FilterExecutor::get()->run(size.y, size.x, boost::bind(&FilterErosion::filterRows, 
+            this, pSrcBmp.get(), pDestBmp.get(), _1, _2));
+    return pDestBmp;
+}
+
+void FilterErosion::filterRows(Bitmap* pSrcBmp, Bitmap* pDestBmp, int startRow, 
+        int endRow) const
+{
+    IntPoint size = pSrcBmp->getSize();
+    // The row above the first row is the first row itself.
+    unsigned char * pSrcLine = pSrcBmp->getPixels()
+            +max(startRow-1, 0)*pSrcBmp->getStride();
     unsigned char * pNextSrcLine;
-    unsigned char * pDestLine = pDestBmp->getPixels();
-    for (int y = 0; y < size.y; y++) {
+    unsigned char * pDestLine;
+    for (int y = startRow; y < endRow; y++) {
         pDestLine = pDestBmp->getPixels()+y*pDestBmp->getStride();
         unsigned char * pLastSrcLine = pSrcLine;
         pSrcLine = pSrcBmp->getPixels()+y*pSrcBmp->getStride();
@@ -65,7 +79,6 @@ BitmapPtr FilterErosion::apply(BitmapPtr pSrcBmp)
         pDestLine[size.x-1] = min(pSrcLine[size.x-2], min(pSrcLine[size.x-1], 
                 min(pLastSrcLine[size.x-1], pNextSrcLine[size.x-1])));
     }
-    return pDestBmp;
 }
 
 } // namespace
@@ -37,6 +37,7 @@ public:
   virtual BitmapPtr apply(BitmapPtr pBmp);
 
 private:
+  void filterRows(Bitmap* pSrcBmp, Bitmap* pDestBmp, int startRow, int endRow) const;
 };
 
 }
@@ -0,0 +1,219 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "FilterExecutor.h"
+
+#include "../base/ConfigMgr.h"
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+#include "../base/StringHelper.h"
+#include "../base/ThreadHelper.h"
+#include "../base/ThreadProfiler.h"
+
+#include <algorithm>
+#include <stdlib.h>
+
+using namespace std;
+
+namespace avg {
+
+// More bands than threads even out differences in band cost and thread start-up.
+static const int BANDS_PER_THREAD = 4;
+
+FilterExecutor* FilterExecutor::s_pInstance = 0;
+
+void deleteFilterExecutor()
+{
+    delete FilterExecutor::s_pInstance;
+}
+
+FilterExecutor* FilterExecutor::get()
+{
+    if (!s_pInstance) {
+        ConfigMgr* pMgr = ConfigMgr::get();
+        int numThreads = pMgr->getIntOption("scr", "filterthreads", 0);
+        int minPixels = pMgr->getIntOption("scr", "filterminpixels", 65536);
+        s_pInstance = new FilterExecutor(numThreads, minPixels);
+        atexit(deleteFilterExecutor);
+    }
+    return s_pInstance;
+}
+
+FilterExecutor::FilterExecutor(int numThreads, int minPixels)
+    : m_MinPixels(minPixels),
+      m_bStop(false),
+      m_JobID(0),
+      m_bJobActive(false),
+      m_NumBusyWorkers(0),
+      m_pFunc(0),
+      m_NumRows(0),
+      m_NumBands(0),
+      m_NextBand(0)
+{
+    startWorkers(numThreads);
+}
+
+FilterExecutor::~FilterExecutor()
+{
+    stopWorkers();
+    if (s_pInstance == this) {
+        s_pInstance = 0;
+    }
+}
+
+void FilterExecutor::run(int numRows, int rowWidth, const RowFunc& func)
+{
+    if (m_pWorkers.empty() || numRows < 2 || (long long)numRows*rowWidth < m_MinPixels
+            || !m_RunMutex.try_lock())
+    {
+        func(0, numRows);
+        return;
+    }
+    boost::mutex::scoped_lock runLock(m_RunMutex, boost::adopt_lock);
+    {
+        boost::mutex::scoped_lock lock(m_Mutex);
+        m_pFunc = &func;
+        m_NumRows = numRows;
+        m_NumBands = min(numRows, int(m_pWorkers.size()+1)*BANDS_PER_THREAD);
+        m_NextBand = 0;
+        m_JobID++;
+        m_bJobActive = true;
+        m_JobCond.notify_all();
+    }
+    try {
+        processBands();
+    } catch (...) {
+        finishJob();
+        throw;
+    }
+    finishJob();
+}
+
+void FilterExecutor::setNumThreads(int numThreads)
+{
+    boost::mutex::scoped_lock runLock(m_RunMutex);
+    stopWorkers();
+    startWorkers(numThreads);
+}
+
+int FilterExecutor::getNumThreads() const
+{
+    return int(m_pWorkers.size())+1;
+}
+
+void FilterExecutor::setMinPixels(int minPixels)
+{
+    m_MinPixels = minPixels;
+}
+
+int FilterExecutor::getMinPixels() const
+{
+    return m_MinPixels;
+}
+
+void FilterExecutor::startWorkers(int numThreads)
+{
+    if (numThreads <= 0) {
+        numThreads = max(int(boost::thread::hardware_concurrency()), 1);
+    }
+    m_bStop = false;
+    for (int i = 0; i < numThreads-1; ++i) {
+        m_pWorkers.push_back(new boost::thread(&FilterExecutor::workerLoop, this, i));
+    }
+}
+
+void FilterExecutor::stopWorkers()
+{
+    {
+        boost::mutex::scoped_lock lock(m_Mutex);
+        m_bStop = true;
+        m_JobCond.notify_all();
+    }
+    for (unsigned i = 0; i < m_pWorkers.size(); ++i) {
+        m_pWorkers[i]->join();
+        delete m_pWorkers[i];
+    }
+    m_pWorkers.clear();
+}
+
+void FilterExecutor::workerLoop(int workerIndex)
+{
+    setAffinityMask(false);
+    ThreadProfiler* pProfiler = ThreadProfiler::get();
+    pProfiler->setName("Filter Worker " + toString(workerIndex));
+    pProfiler->setLogCategory(Logger::category::PROFILE);
+    pProfiler->start();
+
+    int lastJobID = 0;
+    boost::mutex::scoped_lock lock(m_Mutex);
+    while (true) {
+        while (!m_bStop && (!m_bJobActive || m_JobID == lastJobID)) {
+            m_JobCond.wait(lock);
+        }
+        if (m_bStop) {
+            break;
+        }
+        lastJobID = m_JobID;
+        m_NumBusyWorkers++;
+        lock.unlock();
+
+        processBands();
+
+        lock.lock();
+        m_NumBusyWorkers--;
+        if (m_NumBusyWorkers == 0) {
+            m_DoneCond.notify_all();
+        }
+    }
+    lock.unlock();
+
+    pProfiler->dumpStatistics();
+    pProfiler->kill();
+}
+
+void FilterExecutor::finishJob()
+{
+    // Bands that are still running reference func.
+    boost::mutex::scoped_lock lock(m_Mutex);
+    m_NextBand = m_NumBands;
+    while (m_NumBusyWorkers > 0) {
+        m_DoneCond.wait(lock);
+    }
+    // Workers that wake up from now on ignore the job.
+    m_bJobActive = false;
+    m_pFunc = 0;
+}
+
+void FilterExecutor::processBands()
+{
+    while (true) {
+        int band = m_NextBand++;
+        if (band >= m_NumBands) {
+            break;
+        }
+        int startRow = int((long long)band*m_NumRows/m_NumBands);
+        int endRow = int((long long)(band+1)*m_NumRows/m_NumBands);
+        (*m_pFunc)(startRow, endRow);
+    }
+}
+
+}
@@ -0,0 +1,99 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _FilterExecutor_H_
+#define _FilterExecutor_H_
+
+#include "../api.h"
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread.hpp>
+#include <boost/function.hpp>
+
+#include <atomic>
+#include <vector>
+
+namespace avg {
+
+// Splits the rows of a CPU filter into bands and runs them on a set of worker 
+// threads shared by all filters. The calling thread processes bands as well and 
+// run() returns when all rows are done, so filters stay synchronous. Every row is 
+// computed exactly as in a single-threaded loop, so results don't depend on the 
+// number of threads.
+//
+// Images smaller than the size threshold are processed on the calling thread. So are
+// calls from inside a band and calls made while another thread is using the 
+// executor.
+class AVG_API FilterExecutor
+{
+public:
+    // Processes rows [startRow, endRow).
+    typedef boost::function<void (int startRow, int endRow)> RowFunc;
+
+    static FilterExecutor* get();
+    // numThreads includes the calling thread. 0 uses one thread per core.
+    FilterExecutor(int numThreads, int minPixels);
+    virtual ~FilterExecutor();
+
+    void run(int numRows, int rowWidth, const RowFunc& func);
+
+    void setNumThreads(int numThreads);
+    int getNumThreads() const;
+    void setMinPixels(int minPixels);
+    int getMinPixels() const;
+
+private:
+    void startWorkers(int numThreads);
+    void stopWorkers();
+    void workerLoop(int workerIndex);
+    void finishJob();
+    void processBands();
+
+    std::vector<boost::thread*> m_pWorkers;
+    int m_MinPixels;
+    bool m_bStop;
+
+    // Held by the thread that currently distributes a job.
+    boost::mutex m_RunMutex;
+
+    boost::mutex m_Mutex;
+    // Signalled when a new job starts.
+    boost::condition m_JobCond;
+    // Signalled when the last worker has left a job.
+    boost::condition m_DoneCond;
+    int m_JobID;
+    bool m_bJobActive;
+    int m_NumBusyWorkers;
+
+    const RowFunc* m_pFunc;
+    int m_NumRows;
+    int m_NumBands;
+    std::atomic<int> m_NextBand;
+
+    static FilterExecutor* s_pInstance;
+    friend void deleteFilterExecutor();
+};
+
+}
+
+#endif
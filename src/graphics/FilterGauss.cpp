@@ -20,6 +20,8 @@
 //
 
 #include "FilterGauss.h"
+#include "FilterExecutor.h"
+#include "FilterKernels.h"
 #include "Filterfill.h"
 #include "Pixel8.h"
 #include "Bitmap.h"
@@ -27,17 +29,54 @@
 #include "../base/MathHelper.h"
 #include "../base/Exception.h"
 
+#include <boost/bind.hpp>
+
 #include <iostream>
+#include <vector>
 #include <math.h>
 
 using namespace std;
 
 namespace avg {
+
+namespace {
+
+// Fixed-point reciprocal for dividing box sums: (sum*recip+32768) >> 16 rounds to the
+// nearest integer for all sums that occur.
+inline int getBoxRecip(int boxRadius)
+{
+    return int(65536.f/(boxRadius*2+1)+0.5f);
+}
+
+void boxBlurLine(const unsigned char* pSrc, unsigned char* pDest, int destWidth, 
+        int boxRadius)
+{
+    int boxWidth = boxRadius*2+1;
+    int recip = getBoxRecip(boxRadius);
+    int sum = 0;
+    for (int i = 0; i < boxWidth; ++i) {
+        sum += pSrc[i];
+    }
+    for (int x = 0; x < destWidth-1; ++x) {
+        pDest[x] = (unsigned char)((sum*recip+32768) >> 16);
+        sum += pSrc[x+boxWidth]-pSrc[x];
+    }
+    pDest[destWidth-1] = (unsigned char)((sum*recip+32768) >> 16);
+}
+
+}
     
-FilterGauss::FilterGauss(float radius)
-    : m_Radius(radius)
+FilterGauss::FilterGauss(float radius, bool bBoxBlur)
+    : m_Radius(radius),
+      m_bBoxBlur(bBoxBlur)
 {
-    calcKernel();
+    if (m_bBoxBlur) {
+        m_KernelWidth = 0;
+        calcBoxRadii();
+    } else {
+        AVG_ASSERT(m_Radius <= 7);
+        calcKernel();
+    }
 }
 
 FilterGauss::~FilterGauss()
@@ -47,134 +86,156 @@ FilterGauss::~FilterGauss()
 BitmapPtr FilterGauss::apply(BitmapPtr pBmpSrc)
 {
     AVG_ASSERT(pBmpSrc->getPixelFormat() == I8);
+    if (m_bBoxBlur) {
+        return applyBoxBlur(pBmpSrc);
+    }
     int intRadius = int(ceil(m_Radius));
+    FilterExecutor* pExecutor = FilterExecutor::get();
     
     // Convolve in x-direction
     IntPoint tempSize(pBmpSrc->getSize().x-2*intRadius, pBmpSrc->getSize().y);
     BitmapPtr pTempBmp = BitmapPtr(new Bitmap(tempSize, I8, pBmpSrc->getName()));
-    int srcStride = pBmpSrc->getStride();
+    pExecutor->run(tempSize.y, tempSize.x, boost::bind(&FilterGauss::convolveRowsX, 
+            this, pBmpSrc.get(), pTempBmp.get(), _1, _2));
+
+    // Convolve in y-direction
+    IntPoint destSize(tempSize.x, tempSize.y-2*intRadius);
+    BitmapPtr pDestBmp = BitmapPtr(new Bitmap(destSize, I8, pBmpSrc->getName()));
+    pExecutor->run(destSize.y, destSize.x, boost::bind(&FilterGauss::convolveRowsY, 
+            this, pTempBmp.get(), pDestBmp.get(), _1, _2));
+    return pDestBmp;
+}
+
+BitmapPtr FilterGauss::applyBoxBlur(BitmapPtr pBmpSrc)
+{
+    // The boxes together cover fewer pixels than the gaussian kernel, so the source 
+    // is cropped to keep the result size the same in both modes.
+    int intRadius = int(ceil(m_Radius));
+    int border = intRadius-(m_BoxRadii[0]+m_BoxRadii[1]+m_BoxRadii[2]);
+    FilterExecutor* pExecutor = FilterExecutor::get();
+
+    // All three boxes in x-direction in one pass.
+    IntPoint size(pBmpSrc->getSize().x-2*intRadius, pBmpSrc->getSize().y-2*border);
+    BitmapPtr pBmp = BitmapPtr(new Bitmap(size, I8, pBmpSrc->getName()));
+    pExecutor->run(size.y, size.x, boost::bind(&FilterGauss::boxBlurRowsX, 
+            this, pBmpSrc.get(), pBmp.get(), _1, _2));
+
+    // One pass per box in y-direction.
+    for (int i = 0; i < 3; ++i) {
+        size.y -= 2*m_BoxRadii[i];
+        BitmapPtr pDestBmp = BitmapPtr(new Bitmap(size, I8, pBmpSrc->getName()));
+        pExecutor->run(size.y, size.x, boost::bind(&FilterGauss::boxBlurRowsY, 
+                this, pBmp.get(), pDestBmp.get(), m_BoxRadii[i], _1, _2));
+        pBmp = pDestBmp;
+    }
+    return pBmp;
+}
+
+void FilterGauss::convolveRowsX(Bitmap* pSrcBmp, Bitmap* pTempBmp, int startRow, 
+        int endRow) const
+{
+    int intRadius = int(ceil(m_Radius));
+    // The original code divides every product by 256 for the radii that didn't have
+    // an unrolled version. Kept for identical results.
+    bool bDividePerTap = intRadius < 1 || intRadius > 3;
+    int width = pTempBmp->getSize().x;
+    int srcStride = pSrcBmp->getStride();
     int tempStride = pTempBmp->getStride();
-    unsigned char * pSrcLine = pBmpSrc->getPixels();
-    unsigned char * pTempLine = pTempBmp->getPixels();
-    for (int y = 0; y < tempSize.y; ++y) {
-        unsigned char * pSrcPixel = pSrcLine+intRadius;
-        unsigned char * pTempPixel = pTempLine;
-        switch (intRadius) {
-            case 3:
-                for (int x = 0; x < tempSize.x; ++x) {
-                    *pTempPixel = (*(pSrcPixel-3)*m_Kernel[0] + 
-                            *(pSrcPixel-2)*m_Kernel[1] +
-                            *(pSrcPixel-1)*m_Kernel[2] + 
-                            *(pSrcPixel)*m_Kernel[3] +
-                            *(pSrcPixel+1)*m_Kernel[4] + 
-                            *(pSrcPixel+2)*m_Kernel[5] +
-                            *(pSrcPixel+3)*m_Kernel[6])/256;
-                    ++pSrcPixel;
-                    ++pTempPixel;
-                }
-                break;
-            case 2:
-                for (int x = 0; x < tempSize.x; ++x) {
-                    *pTempPixel = (*(pSrcPixel-2)*m_Kernel[0] +
-                            *(pSrcPixel-1)*m_Kernel[1] + 
-                            *(pSrcPixel)*m_Kernel[2] +
-                            *(pSrcPixel+1)*m_Kernel[3] + 
-                            *(pSrcPixel+2)*m_Kernel[4])/256;
-                    ++pSrcPixel;
-                    ++pTempPixel;
-                }
-                break;
-            case 1:
-                for (int x = 0; x < tempSize.x; ++x) {
-                    *pTempPixel = (*(pSrcPixel-1)*m_Kernel[0] + 
-                            *(pSrcPixel)*m_Kernel[1] +
-                            *(pSrcPixel+1)*m_Kernel[2])/256;
-                    ++pSrcPixel;
-                    ++pTempPixel;
-                }
-                break;
-            default:
-                // This is _really_ slow!
-                for (int x = 0; x < tempSize.x; ++x) {
-                    *pTempPixel = 0;
-                    unsigned char * pKernelPixel = pSrcPixel-intRadius;
-                    for (int w=0; w <= intRadius*2; ++w) {
-                        *pTempPixel += ((*pKernelPixel)*m_Kernel[w])/256;
-                        pKernelPixel++;
-                    }
-                    ++pSrcPixel;
-                    ++pTempPixel;
-                }
-        }
+    unsigned char * pSrcLine = pSrcBmp->getPixels()+startRow*srcStride;
+    unsigned char * pTempLine = pTempBmp->getPixels()+startRow*tempStride;
+    for (int y = startRow; y < endRow; ++y) {
+        convolveLine8(pSrcLine+intRadius, 1, pTempLine, width, m_Kernel, intRadius, 
+                bDividePerTap);
         pSrcLine += srcStride;
         pTempLine += tempStride;
     }
+}
 
-    // Convolve in y-direction
-    IntPoint destSize(tempSize.x, tempSize.y-2*intRadius);
-    BitmapPtr pDestBmp = BitmapPtr(new Bitmap(destSize, I8, pBmpSrc->getName()));
+void FilterGauss::convolveRowsY(Bitmap* pTempBmp, Bitmap* pDestBmp, int startRow, 
+        int endRow) const
+{
+    int intRadius = int(ceil(m_Radius));
+    bool bDividePerTap = intRadius < 1 || intRadius > 3;
+    int width = pDestBmp->getSize().x;
+    int tempStride = pTempBmp->getStride();
     int destStride = pDestBmp->getStride();
-    pTempLine = pTempBmp->getPixels()+intRadius*tempStride;
-    unsigned char * pDestLine = pDestBmp->getPixels();
-    for (int y = 0; y < destSize.y; ++y) {
-        unsigned char * pTempPixel = pTempLine;
-        unsigned char * pDestPixel = pDestLine;
-        switch (intRadius) {
-            case 3:
-                for (int x = 0; x < destSize.x; ++x) {
-                    *pDestPixel = (*(pTempPixel-3*tempStride)*m_Kernel[0] +
-                            *(pTempPixel-2*tempStride)*m_Kernel[1] +
-                            *(pTempPixel-1*tempStride)*m_Kernel[2] + 
-                            *(pTempPixel)*m_Kernel[3] +
-                            *(pTempPixel+1*tempStride)*m_Kernel[4] + 
-                            *(pTempPixel+2*tempStride)*m_Kernel[5] +
-                            *(pTempPixel+3*tempStride)*m_Kernel[6])/256;
-                    ++pTempPixel;
-                    ++pDestPixel;
-                }
-                break;
-            case 2:
-                for (int x = 0; x < destSize.x; ++x) {
-                    *pDestPixel = (*(pTempPixel-2*tempStride)*m_Kernel[0] +
-                            *(pTempPixel-1*tempStride)*m_Kernel[1] + 
-                            *(pTempPixel)*m_Kernel[2] +
-                            *(pTempPixel+1*tempStride)*m_Kernel[3] + 
-                            *(pTempPixel+2*tempStride)*m_Kernel[4])/256;
-                    ++pTempPixel;
-                    ++pDestPixel;
-                }
-                break;
-            case 1:
-                for (int x = 0; x < destSize.x; ++x) {
-                    *pDestPixel = (*(pTempPixel-1*tempStride)*m_Kernel[0] + 
-                            *(pTempPixel)*m_Kernel[1] +
-                            *(pTempPixel+1*tempStride)*m_Kernel[2])/256;
-                    ++pTempPixel;
-                    ++pDestPixel;
-                }
-                break;
-            default:
-                // This is _really_ slow!
-                for (int x = 0; x < tempSize.x; ++x) {
-                    *pDestPixel = 0;
-                    unsigned char * pKernelPixel = pTempPixel-intRadius*tempStride;
-                    for (int w = 0; w <= intRadius*2; ++w) {
-                        *pDestPixel += (*pKernelPixel*m_Kernel[w])/256;
-                        pKernelPixel += tempStride;
-                    }
-                    ++pTempPixel;
-                    ++pDestPixel;
-                }
-        }
+    unsigned char * pTempLine = pTempBmp->getPixels()+(startRow+intRadius)*tempStride;
+    unsigned char * pDestLine = pDestBmp->getPixels()+startRow*destStride;
+    for (int y = startRow; y < endRow; ++y) {
+        convolveLine8(pTempLine, tempStride, pDestLine, width, m_Kernel, intRadius, 
+                bDividePerTap);
         pTempLine += tempStride;
         pDestLine += destStride;
     }
-    return pDestBmp;
+}
+
+void FilterGauss::boxBlurRowsX(Bitmap* pSrcBmp, Bitmap* pTempBmp, int startRow, 
+        int endRow) const
+{
+    int boxTotal = m_BoxRadii[0]+m_BoxRadii[1]+m_BoxRadii[2];
+    int border = int(ceil(m_Radius))-boxTotal;
+    int width = pTempBmp->getSize().x;
+    int srcStride = pSrcBmp->getStride();
+    int tempStride = pTempBmp->getStride();
+    vector<unsigned char> line0(width+2*boxTotal);
+    vector<unsigned char> line1(width+2*boxTotal);
+    const unsigned char * pSrcLine = pSrcBmp->getPixels()+(startRow+border)*srcStride
+            +border;
+    unsigned char * pTempLine = pTempBmp->getPixels()+startRow*tempStride;
+    for (int y = startRow; y < endRow; ++y) {
+        int lineWidth = width+2*(boxTotal-m_BoxRadii[0]);
+        boxBlurLine(pSrcLine, &line0[0], lineWidth, m_BoxRadii[0]);
+        lineWidth -= 2*m_BoxRadii[1];
+        boxBlurLine(&line0[0], &line1[0], lineWidth, m_BoxRadii[1]);
+        boxBlurLine(&line1[0], pTempLine, width, m_BoxRadii[2]);
+        pSrcLine += srcStride;
+        pTempLine += tempStride;
+    }
+}
+
+void FilterGauss::boxBlurRowsY(Bitmap* pSrcBmp, Bitmap* pDestBmp, int boxRadius, 
+        int startRow, int endRow) const
+{
+    // Running sums per column. Each band starts its own sums, so bands don't depend on
+    // each other.
+    int width = pDestBmp->getSize().x;
+    int boxWidth = boxRadius*2+1;
+    int recip = getBoxRecip(boxRadius);
+    int srcStride = pSrcBmp->getStride();
+    int destStride = pDestBmp->getStride();
+    vector<int> sums(width, 0);
+    const unsigned char * pSrcLine = pSrcBmp->getPixels()+startRow*srcStride;
+    for (int i = 0; i < boxWidth; ++i) {
+        for (int x = 0; x < width; ++x) {
+            sums[x] += pSrcLine[x];
+        }
+        pSrcLine += srcStride;
+    }
+    const unsigned char * pOldLine = pSrcBmp->getPixels()+startRow*srcStride;
+    unsigned char * pDestLine = pDestBmp->getPixels()+startRow*destStride;
+    for (int y = startRow; y < endRow; ++y) {
+        for (int x = 0; x < width; ++x) {
+            pDestLine[x] = (unsigned char)((sums[x]*recip+32768) >> 16);
+        }
+        if (y+1 < endRow) {
+            for (int x = 0; x < width; ++x) {
+                sums[x] += pSrcLine[x]-pOldLine[x];
+            }
+            pSrcLine += srcStride;
+            pOldLine += srcStride;
+        }
+        pDestLine += destStride;
+    }
 }
 
 void FilterGauss::dumpKernel()
 {
     cerr << "Gauss, radius " << m_Radius << endl;
+    if (m_bBoxBlur) {
+        cerr << "  Box radii: " << m_BoxRadii[0] << ", " << m_BoxRadii[1] << ", " 
+                << m_BoxRadii[2] << endl;
+        return;
+    }
     cerr << "  Kernel width: " << m_KernelWidth << endl;
     for (int i = 0; i < m_KernelWidth; ++i) {
         cerr << "  " << m_Kernel[i] << endl;
@@ -200,4 +261,21 @@ void FilterGauss::calcKernel()
     }
 }
 
+void FilterGauss::calcBoxRadii()
+{
+    // Odd box widths for a cascade of three boxes with approximately the variance of
+    // the kernel in calcKernel(). The boxes are lowerWidth or lowerWidth+2 pixels 
+    // wide.
+    float variance = m_Radius/2;
+    int idealWidth = int(sqrt(4*variance+1));
+    int lowerWidth = (idealWidth%2 == 0) ? idealWidth-1 : idealWidth;
+    int numLower = int(floor((12*variance-3*lowerWidth*lowerWidth-12*lowerWidth-9)
+            /(-4*lowerWidth-4)+0.5f));
+    for (int i = 0; i < 3; ++i) {
+        int width = (i < numLower) ? lowerWidth : lowerWidth+2;
+        m_BoxRadii[i] = (width-1)/2;
+    }
+    AVG_ASSERT(m_BoxRadii[0]+m_BoxRadii[1]+m_BoxRadii[2] <= int(ceil(m_Radius)));
+}
+
 }
@@ -30,9 +30,13 @@
 
 namespace avg {
 
+// Gaussian blur of an I8 bitmap. The result is smaller than the source by 
+// ceil(radius) pixels on every side. In the default mode, radius can be up to 7.
+// bBoxBlur selects an approximation by a cascade of three box blurs that has a 
+// constant cost per pixel and no limit on the radius.
 class AVG_API FilterGauss: public Filter{
     public:
-        FilterGauss(float Radius);
+        FilterGauss(float Radius, bool bBoxBlur=false);
         virtual ~FilterGauss();
 
         virtual BitmapPtr apply(BitmapPtr pBmpSrc);
@@ -40,11 +44,23 @@ class AVG_API FilterGauss: public Filter{
         void dumpKernel();
 
     private:
+        BitmapPtr applyBoxBlur(BitmapPtr pBmpSrc);
+        void convolveRowsX(Bitmap* pSrcBmp, Bitmap* pTempBmp, int startRow, 
+                int endRow) const;
+        void convolveRowsY(Bitmap* pTempBmp, Bitmap* pDestBmp, int startRow, 
+                int endRow) const;
+        void boxBlurRowsX(Bitmap* pSrcBmp, Bitmap* pTempBmp, int startRow, 
+                int endRow) const;
+        void boxBlurRowsY(Bitmap* pSrcBmp, Bitmap* pDestBmp, int boxRadius, 
+                int startRow, int endRow) const;
         void calcKernel();
+        void calcBoxRadii();
 
         float m_Radius;
+        bool m_bBoxBlur;
         int m_KernelWidth;
         int m_Kernel[15];
+        int m_BoxRadii[3];
 };
 
 typedef boost::shared_ptr<FilterGauss> FilterGaussPtr;
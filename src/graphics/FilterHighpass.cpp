@@ -20,12 +20,15 @@
 //
 
 #include "FilterHighpass.h"
+#include "FilterExecutor.h"
 #include "Filterfill.h"
 #include "Pixel8.h"
 #include "Bitmap.h"
 
 #include "../base/Exception.h"
 
+#include <boost/bind.hpp>
+
 #include <cstring>
 #include <iostream>
 #include <sstream>
@@ -47,12 +50,29 @@ BitmapPtr FilterHighpass::apply(BitmapPtr pBmpSrc)
     AVG_ASSERT(pBmpSrc->getPixelFormat() == I8);
     BitmapPtr pBmpDest = BitmapPtr(new Bitmap(pBmpSrc->getSize(), I8,
             pBmpSrc->getName()));
+    IntPoint size = pBmpDest->getSize();
+    if (size.y > 6) {
+        FilterExecutor::get()->run(size.y-6, size.x, boost::bind(
+                &FilterHighpass::filterRows, this, pBmpSrc.get(), pBmpDest.get(), 
+                _1, _2));
+    }
+    // Set top and bottom borders.
+    int destStride = pBmpDest->getStride();
+    memset(pBmpDest->getPixels(), 128, destStride*3);
+    memset(pBmpDest->getPixels()+destStride*(size.y-3), 128, destStride*3);
+    return pBmpDest;
+}
+
+void FilterHighpass::filterRows(Bitmap* pBmpSrc, Bitmap* pBmpDest, int startRow,
+        int endRow) const
+{
+    // Rows are counted from the first row below the top border.
     int srcStride = pBmpSrc->getStride();
     int destStride = pBmpDest->getStride();
-    unsigned char * pSrcLine = pBmpSrc->getPixels()+3*srcStride;
-    unsigned char * pDestLine = pBmpDest->getPixels()+3*destStride;
+    unsigned char * pSrcLine = pBmpSrc->getPixels()+(startRow+3)*srcStride;
+    unsigned char * pDestLine = pBmpDest->getPixels()+(startRow+3)*destStride;
     IntPoint size = pBmpDest->getSize();
-    for (int y = 3; y < size.y-3; ++y) {
+    for (int y = startRow+3; y < endRow+3; ++y) {
         unsigned char * pSrcPixel = pSrcLine+3;
         unsigned char * pDstPixel = pDestLine;
         *pDstPixel++ = 128;
@@ -85,10 +105,6 @@ BitmapPtr FilterHighpass::apply(BitmapPtr pBmpSrc)
         pSrcLine += srcStride;
         pDestLine += destStride;
     }
-    // Set top and bottom borders.
-    memset(pBmpDest->getPixels(), 128, destStride*3);
-    memset(pBmpDest->getPixels()+destStride*(size.y-3), 128, destStride*3);
-    return pBmpDest;
 }
 
 }
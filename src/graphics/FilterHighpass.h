@@ -39,6 +39,8 @@ class AVG_API FilterHighpass: public Filter{
         virtual BitmapPtr apply(BitmapPtr pBmpSrc);
 
     private:
+        void filterRows(Bitmap* pBmpSrc, Bitmap* pBmpDest, int startRow, int endRow)
+                const;
 };
 
 typedef boost::shared_ptr<FilterHighpass> FilterHighpassPtr;
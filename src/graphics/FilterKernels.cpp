@@ -0,0 +1,738 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "FilterKernels.h"
+
+#include "../base/SIMDHelper.h"
+#include "../base/Exception.h"
+
+#include <cstring>
+
+namespace avg {
+
+namespace {
+
+// ------------------------------------------------------------------------
+// Scalar versions. These define the results the vectorized versions must match.
+
+void convolveLine8Scalar(const unsigned char* pSrc, int tapStep, unsigned char* pDest,
+        int start, int width, const int* pKernel, int radius, bool bDividePerTap)
+{
+    const unsigned char* pFirstTap = pSrc-radius*tapStep;
+    for (int x = start; x < width; ++x) {
+        const unsigned char* pTap = pFirstTap+x;
+        int sum = 0;
+        if (bDividePerTap) {
+            for (int i = 0; i <= radius*2; ++i) {
+                sum += (*pTap*pKernel[i])/256;
+                pTap += tapStep;
+            }
+        } else {
+            for (int i = 0; i <= radius*2; ++i) {
+                sum += *pTap*pKernel[i];
+                pTap += tapStep;
+            }
+            sum /= 256;
+        }
+        pDest[x] = (unsigned char)sum;
+    }
+}
+
+void blurLine8Scalar(const unsigned char* pSrc, int srcStride, unsigned char* pDest,
+        int start, int width)
+{
+    for (int x = start; x < width; ++x) {
+        const unsigned char* pSrcPixel = pSrc+x;
+        pDest[x] = (*(pSrcPixel-1) + *(pSrcPixel)*4 + *(pSrcPixel+1)
+                + *(pSrcPixel-srcStride) + *(pSrcPixel+srcStride) + 4)/8;
+    }
+}
+
+template<int BPP>
+void resampleLineHorizScalar(const unsigned char* pSrc, unsigned char* pDest,
+        int start, int destWidth, const LineContribType* pContrib)
+{
+    for (int x = start; x < destWidth; ++x) {
+        const ContributionType& contrib = pContrib->ContribRow[x];
+        const unsigned char* pPixel = pSrc+contrib.Left*BPP;
+        int sums[BPP];
+        for (int c = 0; c < BPP; ++c) {
+            sums[c] = 0;
+        }
+        for (int i = 0; i <= contrib.Right-contrib.Left; ++i) {
+            for (int c = 0; c < BPP; ++c) {
+                sums[c] += contrib.Weights[i]*pPixel[c];
+            }
+            pPixel += BPP;
+        }
+        for (int c = 0; c < BPP; ++c) {
+            pDest[x*BPP+c] = (unsigned char)((sums[c]+128)/256);
+        }
+    }
+}
+
+void resampleLineHorizScalar(const unsigned char* pSrc, unsigned char* pDest,
+        int start, int destWidth, int bpp, const LineContribType* pContrib)
+{
+    switch (bpp) {
+        case 1:
+            resampleLineHorizScalar<1>(pSrc, pDest, start, destWidth, pContrib);
+            break;
+        case 3:
+            resampleLineHorizScalar<3>(pSrc, pDest, start, destWidth, pContrib);
+            break;
+        case 4:
+            resampleLineHorizScalar<4>(pSrc, pDest, start, destWidth, pContrib);
+            break;
+        default:
+            AVG_ASSERT(false);
+    }
+}
+
+void resampleLineVertScalar(const unsigned char* pSrc, int srcStride,
+        unsigned char* pDest, int start, int numBytes, const ContributionType& contrib)
+{
+    int numTaps = contrib.Right-contrib.Left+1;
+    for (int b = start; b < numBytes; ++b) {
+        const unsigned char* pTap = pSrc+b;
+        int sum = 0;
+        for (int i = 0; i < numTaps; ++i) {
+            sum += contrib.Weights[i]*(*pTap);
+            pTap += srcStride;
+        }
+        pDest[b] = (unsigned char)((sum+128)/256);
+    }
+}
+
+// ------------------------------------------------------------------------
+// The vectorized versions process as many pixels as fit into whole vectors and
+// return the number of pixels where the scalar code needs to continue.
+//
+// Products of 8-bit values and weights of up to 256 fit into 16 bits. So do the
+// resampling sums, because their weights sum up to 256 or less. The convolution
+// sums can exceed 16 bits and are accumulated in 32 bits.
+
+#ifdef AVG_SIMD_X86
+
+int convolveLine8SSE2(const unsigned char* pSrc, int tapStep, unsigned char* pDest,
+        int width, const int* pKernel, int radius, bool bDividePerTap)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const unsigned char* pFirstTap = pSrc-radius*tapStep;
+    int numTaps = radius*2+1;
+    int x = 0;
+    if (bDividePerTap) {
+        const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+        __m128i kernel[15];
+        for (int i = 0; i < numTaps; ++i) {
+            kernel[i] = _mm_set1_epi16(short(pKernel[i]));
+        }
+        for (; x+16 <= width; x += 16) {
+            const unsigned char* pTap = pFirstTap+x;
+            __m128i sumLo = zero;
+            __m128i sumHi = zero;
+            for (int i = 0; i < numTaps; ++i) {
+                __m128i val = _mm_loadu_si128((const __m128i*)pTap);
+                // (val*256)*kernel/65536 == val*kernel/256.
+                sumLo = _mm_add_epi16(sumLo, 
+                        _mm_mulhi_epu16(_mm_unpacklo_epi8(zero, val), kernel[i]));
+                sumHi = _mm_add_epi16(sumHi, 
+                        _mm_mulhi_epu16(_mm_unpackhi_epi8(zero, val), kernel[i]));
+                pTap += tapStep;
+            }
+            _mm_storeu_si128((__m128i*)(pDest+x), _mm_packus_epi16(
+                    _mm_and_si128(sumLo, lowBytes), _mm_and_si128(sumHi, lowBytes)));
+        }
+    } else {
+        // Taps are processed in pairs, the second weight of the last pair is 0.
+        const __m128i lowBytes = _mm_set1_epi32(0xFF);
+        int numPairs = radius+1;
+        __m128i kernelPairs[8];
+        for (int i = 0; i < numPairs; ++i) {
+            int weight1 = (i*2+1 < numTaps) ? pKernel[i*2+1] : 0;
+            kernelPairs[i] = _mm_set1_epi32((weight1 << 16) | pKernel[i*2]);
+        }
+        for (; x+16 <= width; x += 16) {
+            const unsigned char* pTap = pFirstTap+x;
+            __m128i sum0 = zero;
+            __m128i sum1 = zero;
+            __m128i sum2 = zero;
+            __m128i sum3 = zero;
+            for (int i = 0; i < numPairs; ++i) {
+                __m128i val0 = _mm_loadu_si128((const __m128i*)pTap);
+                __m128i val1 = val0;
+                if (i*2+1 < numTaps) {
+                    val1 = _mm_loadu_si128((const __m128i*)(pTap+tapStep));
+                }
+                __m128i lo = _mm_unpacklo_epi8(val0, val1);
+                __m128i hi = _mm_unpackhi_epi8(val0, val1);
+                sum0 = _mm_add_epi32(sum0, _mm_madd_epi16(_mm_unpacklo_epi8(lo, zero), 
+                        kernelPairs[i]));
+                sum1 = _mm_add_epi32(sum1, _mm_madd_epi16(_mm_unpackhi_epi8(lo, zero), 
+                        kernelPairs[i]));
+                sum2 = _mm_add_epi32(sum2, _mm_madd_epi16(_mm_unpacklo_epi8(hi, zero), 
+                        kernelPairs[i]));
+                sum3 = _mm_add_epi32(sum3, _mm_madd_epi16(_mm_unpackhi_epi8(hi, zero), 
+                        kernelPairs[i]));
+                pTap += tapStep*2;
+            }
+            sum0 = _mm_and_si128(_mm_srli_epi32(sum0, 8), lowBytes);
+            sum1 = _mm_and_si128(_mm_srli_epi32(sum1, 8), lowBytes);
+            sum2 = _mm_and_si128(_mm_srli_epi32(sum2, 8), lowBytes);
+            sum3 = _mm_and_si128(_mm_srli_epi32(sum3, 8), lowBytes);
+            _mm_storeu_si128((__m128i*)(pDest+x), _mm_packus_epi16(
+                    _mm_packs_epi32(sum0, sum1), _mm_packs_epi32(sum2, sum3)));
+        }
+    }
+    return x;
+}
+
+int blurLine8SSE2(const unsigned char* pSrc, int srcStride, unsigned char* pDest,
+        int width)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i four = _mm_set1_epi16(4);
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        const unsigned char* pSrcPixel = pSrc+x;
+        __m128i left = _mm_loadu_si128((const __m128i*)(pSrcPixel-1));
+        __m128i center = _mm_loadu_si128((const __m128i*)pSrcPixel);
+        __m128i right = _mm_loadu_si128((const __m128i*)(pSrcPixel+1));
+        __m128i above = _mm_loadu_si128((const __m128i*)(pSrcPixel-srcStride));
+        __m128i below = _mm_loadu_si128((const __m128i*)(pSrcPixel+srcStride));
+        __m128i sumLo = _mm_add_epi16(
+                _mm_add_epi16(_mm_unpacklo_epi8(left, zero), _mm_unpacklo_epi8(right, zero)),
+                _mm_add_epi16(_mm_unpacklo_epi8(above, zero), _mm_unpacklo_epi8(below, zero)));
+        sumLo = _mm_add_epi16(sumLo, 
+                _mm_slli_epi16(_mm_unpacklo_epi8(center, zero), 2));
+        __m128i sumHi = _mm_add_epi16(
+                _mm_add_epi16(_mm_unpackhi_epi8(left, zero), _mm_unpackhi_epi8(right, zero)),
+                _mm_add_epi16(_mm_unpackhi_epi8(above, zero), _mm_unpackhi_epi8(below, zero)));
+        sumHi = _mm_add_epi16(sumHi, 
+                _mm_slli_epi16(_mm_unpackhi_epi8(center, zero), 2));
+        _mm_storeu_si128((__m128i*)(pDest+x), _mm_packus_epi16(
+                _mm_srli_epi16(_mm_add_epi16(sumLo, four), 3),
+                _mm_srli_epi16(_mm_add_epi16(sumHi, four), 3)));
+    }
+    return x;
+}
+
+// Vectorizes over the taps of each destination pixel. For R8G8B8A8, two source pixels
+// fit into one vector. For I8, this only pays off for long filter windows. For 
+// R8G8B8, it doesn't pay off and the scalar code does the complete line.
+int resampleLineHorizSSE2(const unsigned char* pSrc, unsigned char* pDest,
+        int destWidth, int bpp, const LineContribType* pContrib)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c128 = _mm_set1_epi16(128);
+    if (bpp == 4) {
+        for (int x = 0; x < destWidth; ++x) {
+            const ContributionType& contrib = pContrib->ContribRow[x];
+            const unsigned char* pPixel = pSrc+contrib.Left*4;
+            const int* pWeights = contrib.Weights;
+            int numTaps = contrib.Right-contrib.Left+1;
+            __m128i sum = zero;
+            int i = 0;
+            for (; i+2 <= numTaps; i += 2) {
+                __m128i val = _mm_unpacklo_epi8(
+                        _mm_loadl_epi64((const __m128i*)(pPixel+i*4)), zero);
+                __m128i weights = _mm_unpacklo_epi64(
+                        _mm_set1_epi16(short(pWeights[i])), 
+                        _mm_set1_epi16(short(pWeights[i+1])));
+                sum = _mm_add_epi16(sum, _mm_mullo_epi16(val, weights));
+            }
+            if (i < numTaps) {
+                int pixel;
+                memcpy(&pixel, pPixel+i*4, 4);
+                __m128i val = _mm_unpacklo_epi8(_mm_cvtsi32_si128(pixel), zero);
+                sum = _mm_add_epi16(sum, 
+                        _mm_mullo_epi16(val, _mm_set1_epi16(short(pWeights[i]))));
+            }
+            sum = _mm_add_epi16(sum, _mm_srli_si128(sum, 8));
+            sum = _mm_srli_epi16(_mm_add_epi16(sum, c128), 8);
+            int pixel = _mm_cvtsi128_si32(_mm_packus_epi16(sum, sum));
+            memcpy(pDest+x*4, &pixel, 4);
+        }
+        return destWidth;
+    } else if (bpp == 1) {
+        for (int x = 0; x < destWidth; ++x) {
+            const ContributionType& contrib = pContrib->ContribRow[x];
+            const unsigned char* pPixel = pSrc+contrib.Left;
+            const int* pWeights = contrib.Weights;
+            int numTaps = contrib.Right-contrib.Left+1;
+            int total = 0;
+            int i = 0;
+            if (numTaps >= 8) {
+                __m128i sum = zero;
+                for (; i+8 <= numTaps; i += 8) {
+                    __m128i val = _mm_unpacklo_epi8(
+                            _mm_loadl_epi64((const __m128i*)(pPixel+i)), zero);
+                    __m128i weights = _mm_packs_epi32(
+                            _mm_loadu_si128((const __m128i*)(pWeights+i)),
+                            _mm_loadu_si128((const __m128i*)(pWeights+i+4)));
+                    sum = _mm_add_epi32(sum, _mm_madd_epi16(val, weights));
+                }
+                sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(1,0,3,2)));
+                sum = _mm_add_epi32(sum, _mm_shuffle_epi32(sum, _MM_SHUFFLE(2,3,0,1)));
+                total = _mm_cvtsi128_si32(sum);
+            }
+            for (; i < numTaps; ++i) {
+                total += pWeights[i]*pPixel[i];
+            }
+            pDest[x] = (unsigned char)((total+128)/256);
+        }
+        return destWidth;
+    } else {
+        return 0;
+    }
+}
+
+int resampleLineVertSSE2(const unsigned char* pSrc, int srcStride, unsigned char* pDest,
+        int numBytes, const ContributionType& contrib)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c128 = _mm_set1_epi16(128);
+    int numTaps = contrib.Right-contrib.Left+1;
+    int b = 0;
+    for (; b+16 <= numBytes; b += 16) {
+        const unsigned char* pTap = pSrc+b;
+        __m128i sumLo = zero;
+        __m128i sumHi = zero;
+        for (int i = 0; i < numTaps; ++i) {
+            __m128i weight = _mm_set1_epi16(short(contrib.Weights[i]));
+            __m128i val = _mm_loadu_si128((const __m128i*)pTap);
+            sumLo = _mm_add_epi16(sumLo, 
+                    _mm_mullo_epi16(_mm_unpacklo_epi8(val, zero), weight));
+            sumHi = _mm_add_epi16(sumHi, 
+                    _mm_mullo_epi16(_mm_unpackhi_epi8(val, zero), weight));
+            pTap += srcStride;
+        }
+        _mm_storeu_si128((__m128i*)(pDest+b), _mm_packus_epi16(
+                _mm_srli_epi16(_mm_add_epi16(sumLo, c128), 8),
+                _mm_srli_epi16(_mm_add_epi16(sumHi, c128), 8)));
+    }
+    return b;
+}
+
+// AVX2 versions. Unpacking and packing both work per 128-bit lane, so they restore 
+// the pixel order without permutes.
+
+AVG_TARGET_AVX2 int convolveLine8AVX2(const unsigned char* pSrc, int tapStep, 
+        unsigned char* pDest, int width, const int* pKernel, int radius, 
+        bool bDividePerTap)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const unsigned char* pFirstTap = pSrc-radius*tapStep;
+    int numTaps = radius*2+1;
+    int x = 0;
+    if (bDividePerTap) {
+        const __m256i lowBytes = _mm256_set1_epi16(0x00FF);
+        __m256i kernel[15];
+        for (int i = 0; i < numTaps; ++i) {
+            kernel[i] = _mm256_set1_epi16(short(pKernel[i]));
+        }
+        for (; x+32 <= width; x += 32) {
+            const unsigned char* pTap = pFirstTap+x;
+            __m256i sumLo = zero;
+            __m256i sumHi = zero;
+            for (int i = 0; i < numTaps; ++i) {
+                __m256i val = _mm256_loadu_si256((const __m256i*)pTap);
+                sumLo = _mm256_add_epi16(sumLo, 
+                        _mm256_mulhi_epu16(_mm256_unpacklo_epi8(zero, val), kernel[i]));
+                sumHi = _mm256_add_epi16(sumHi, 
+                        _mm256_mulhi_epu16(_mm256_unpackhi_epi8(zero, val), kernel[i]));
+                pTap += tapStep;
+            }
+            _mm256_storeu_si256((__m256i*)(pDest+x), _mm256_packus_epi16(
+                    _mm256_and_si256(sumLo, lowBytes), _mm256_and_si256(sumHi, lowBytes)));
+        }
+    } else {
+        const __m256i lowBytes = _mm256_set1_epi32(0xFF);
+        int numPairs = radius+1;
+        __m256i kernelPairs[8];
+        for (int i = 0; i < numPairs; ++i) {
+            int weight1 = (i*2+1 < numTaps) ? pKernel[i*2+1] : 0;
+            kernelPairs[i] = _mm256_set1_epi32((weight1 << 16) | pKernel[i*2]);
+        }
+        for (; x+32 <= width; x += 32) {
+            const unsigned char* pTap = pFirstTap+x;
+            __m256i sum0 = zero;
+            __m256i sum1 = zero;
+            __m256i sum2 = zero;
+            __m256i sum3 = zero;
+            for (int i = 0; i < numPairs; ++i) {
+                __m256i val0 = _mm256_loadu_si256((const __m256i*)pTap);
+                __m256i val1 = val0;
+                if (i*2+1 < numTaps) {
+                    val1 = _mm256_loadu_si256((const __m256i*)(pTap+tapStep));
+                }
+                __m256i lo = _mm256_unpacklo_epi8(val0, val1);
+                __m256i hi = _mm256_unpackhi_epi8(val0, val1);
+                sum0 = _mm256_add_epi32(sum0, _mm256_madd_epi16(
+                        _mm256_unpacklo_epi8(lo, zero), kernelPairs[i]));
+                sum1 = _mm256_add_epi32(sum1, _mm256_madd_epi16(
+                        _mm256_unpackhi_epi8(lo, zero), kernelPairs[i]));
+                sum2 = _mm256_add_epi32(sum2, _mm256_madd_epi16(
+                        _mm256_unpacklo_epi8(hi, zero), kernelPairs[i]));
+                sum3 = _mm256_add_epi32(sum3, _mm256_madd_epi16(
+                        _mm256_unpackhi_epi8(hi, zero), kernelPairs[i]));
+                pTap += tapStep*2;
+            }
+            sum0 = _mm256_and_si256(_mm256_srli_epi32(sum0, 8), lowBytes);
+            sum1 = _mm256_and_si256(_mm256_srli_epi32(sum1, 8), lowBytes);
+            sum2 = _mm256_and_si256(_mm256_srli_epi32(sum2, 8), lowBytes);
+            sum3 = _mm256_and_si256(_mm256_srli_epi32(sum3, 8), lowBytes);
+            _mm256_storeu_si256((__m256i*)(pDest+x), _mm256_packus_epi16(
+                    _mm256_packs_epi32(sum0, sum1), _mm256_packs_epi32(sum2, sum3)));
+        }
+    }
+    return x;
+}
+
+AVG_TARGET_AVX2 int blurLine8AVX2(const unsigned char* pSrc, int srcStride, 
+        unsigned char* pDest, int width)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i four = _mm256_set1_epi16(4);
+    int x = 0;
+    for (; x+32 <= width; x += 32) {
+        const unsigned char* pSrcPixel = pSrc+x;
+        __m256i left = _mm256_loadu_si256((const __m256i*)(pSrcPixel-1));
+        __m256i center = _mm256_loadu_si256((const __m256i*)pSrcPixel);
+        __m256i right = _mm256_loadu_si256((const __m256i*)(pSrcPixel+1));
+        __m256i above = _mm256_loadu_si256((const __m256i*)(pSrcPixel-srcStride));
+        __m256i below = _mm256_loadu_si256((const __m256i*)(pSrcPixel+srcStride));
+        __m256i sumLo = _mm256_add_epi16(
+                _mm256_add_epi16(_mm256_unpacklo_epi8(left, zero), 
+                        _mm256_unpacklo_epi8(right, zero)),
+                _mm256_add_epi16(_mm256_unpacklo_epi8(above, zero), 
+                        _mm256_unpacklo_epi8(below, zero)));
+        sumLo = _mm256_add_epi16(sumLo, 
+                _mm256_slli_epi16(_mm256_unpacklo_epi8(center, zero), 2));
+        __m256i sumHi = _mm256_add_epi16(
+                _mm256_add_epi16(_mm256_unpackhi_epi8(left, zero), 
+                        _mm256_unpackhi_epi8(right, zero)),
+                _mm256_add_epi16(_mm256_unpackhi_epi8(above, zero), 
+                        _mm256_unpackhi_epi8(below, zero)));
+        sumHi = _mm256_add_epi16(sumHi, 
+                _mm256_slli_epi16(_mm256_unpackhi_epi8(center, zero), 2));
+        _mm256_storeu_si256((__m256i*)(pDest+x), _mm256_packus_epi16(
+                _mm256_srli_epi16(_mm256_add_epi16(sumLo, four), 3),
+                _mm256_srli_epi16(_mm256_add_epi16(sumHi, four), 3)));
+    }
+    return x;
+}
+
+AVG_TARGET_AVX2 int resampleLineVertAVX2(const unsigned char* pSrc, int srcStride, 
+        unsigned char* pDest, int numBytes, const ContributionType& contrib)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i c128 = _mm256_set1_epi16(128);
+    int numTaps = contrib.Right-contrib.Left+1;
+    int b = 0;
+    for (; b+32 <= numBytes; b += 32) {
+        const unsigned char* pTap = pSrc+b;
+        __m256i sumLo = zero;
+        __m256i sumHi = zero;
+        for (int i = 0; i < numTaps; ++i) {
+            __m256i weight = _mm256_set1_epi16(short(contrib.Weights[i]));
+            __m256i val = _mm256_loadu_si256((const __m256i*)pTap);
+            sumLo = _mm256_add_epi16(sumLo, 
+                    _mm256_mullo_epi16(_mm256_unpacklo_epi8(val, zero), weight));
+            sumHi = _mm256_add_epi16(sumHi, 
+                    _mm256_mullo_epi16(_mm256_unpackhi_epi8(val, zero), weight));
+            pTap += srcStride;
+        }
+        _mm256_storeu_si256((__m256i*)(pDest+b), _mm256_packus_epi16(
+                _mm256_srli_epi16(_mm256_add_epi16(sumLo, c128), 8),
+                _mm256_srli_epi16(_mm256_add_epi16(sumHi, c128), 8)));
+    }
+    return b;
+}
+
+#endif
+
+#ifdef AVG_SIMD_NEON
+
+int convolveLine8NEON(const unsigned char* pSrc, int tapStep, unsigned char* pDest,
+        int width, const int* pKernel, int radius, bool bDividePerTap)
+{
+    const unsigned char* pFirstTap = pSrc-radius*tapStep;
+    int numTaps = radius*2+1;
+    int x = 0;
+    if (bDividePerTap) {
+        for (; x+16 <= width; x += 16) {
+            const unsigned char* pTap = pFirstTap+x;
+            uint16x8_t sumLo = vdupq_n_u16(0);
+            uint16x8_t sumHi = vdupq_n_u16(0);
+            for (int i = 0; i < numTaps; ++i) {
+                uint8x16_t val = vld1q_u8(pTap);
+                uint16_t weight = uint16_t(pKernel[i]);
+                sumLo = vaddq_u16(sumLo, vshrq_n_u16(
+                        vmulq_n_u16(vmovl_u8(vget_low_u8(val)), weight), 8));
+                sumHi = vaddq_u16(sumHi, vshrq_n_u16(
+                        vmulq_n_u16(vmovl_u8(vget_high_u8(val)), weight), 8));
+                pTap += tapStep;
+            }
+            // Narrowing keeps the low byte.
+            vst1q_u8(pDest+x, vcombine_u8(vmovn_u16(sumLo), vmovn_u16(sumHi)));
+        }
+    } else {
+        for (; x+16 <= width; x += 16) {
+            const unsigned char* pTap = pFirstTap+x;
+            uint32x4_t sum0 = vdupq_n_u32(0);
+            uint32x4_t sum1 = vdupq_n_u32(0);
+            uint32x4_t sum2 = vdupq_n_u32(0);
+            uint32x4_t sum3 = vdupq_n_u32(0);
+            for (int i = 0; i < numTaps; ++i) {
+                uint8x16_t val = vld1q_u8(pTap);
+                uint16x8_t lo = vmovl_u8(vget_low_u8(val));
+                uint16x8_t hi = vmovl_u8(vget_high_u8(val));
+                uint16_t weight = uint16_t(pKernel[i]);
+                sum0 = vmlal_n_u16(sum0, vget_low_u16(lo), weight);
+                sum1 = vmlal_n_u16(sum1, vget_high_u16(lo), weight);
+                sum2 = vmlal_n_u16(sum2, vget_low_u16(hi), weight);
+                sum3 = vmlal_n_u16(sum3, vget_high_u16(hi), weight);
+                pTap += tapStep;
+            }
+            uint16x8_t lo = vcombine_u16(vmovn_u32(vshrq_n_u32(sum0, 8)), 
+                    vmovn_u32(vshrq_n_u32(sum1, 8)));
+            uint16x8_t hi = vcombine_u16(vmovn_u32(vshrq_n_u32(sum2, 8)), 
+                    vmovn_u32(vshrq_n_u32(sum3, 8)));
+            vst1q_u8(pDest+x, vcombine_u8(vmovn_u16(lo), vmovn_u16(hi)));
+        }
+    }
+    return x;
+}
+
+int blurLine8NEON(const unsigned char* pSrc, int srcStride, unsigned char* pDest,
+        int width)
+{
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        const unsigned char* pSrcPixel = pSrc+x;
+        uint8x16_t left = vld1q_u8(pSrcPixel-1);
+        uint8x16_t center = vld1q_u8(pSrcPixel);
+        uint8x16_t right = vld1q_u8(pSrcPixel+1);
+        uint8x16_t above = vld1q_u8(pSrcPixel-srcStride);
+        uint8x16_t below = vld1q_u8(pSrcPixel+srcStride);
+        uint16x8_t sumLo = vaddq_u16(
+                vaddl_u8(vget_low_u8(left), vget_low_u8(right)),
+                vaddl_u8(vget_low_u8(above), vget_low_u8(below)));
+        sumLo = vaddq_u16(sumLo, vshll_n_u8(vget_low_u8(center), 2));
+        uint16x8_t sumHi = vaddq_u16(
+                vaddl_u8(vget_high_u8(left), vget_high_u8(right)),
+                vaddl_u8(vget_high_u8(above), vget_high_u8(below)));
+        sumHi = vaddq_u16(sumHi, vshll_n_u8(vget_high_u8(center), 2));
+        vst1q_u8(pDest+x, vcombine_u8(vrshrn_n_u16(sumLo, 3), vrshrn_n_u16(sumHi, 3)));
+    }
+    return x;
+}
+
+// Same structure as resampleLineHorizSSE2().
+int resampleLineHorizNEON(const unsigned char* pSrc, unsigned char* pDest,
+        int destWidth, int bpp, const LineContribType* pContrib)
+{
+    if (bpp == 4) {
+        for (int x = 0; x < destWidth; ++x) {
+            const ContributionType& contrib = pContrib->ContribRow[x];
+            const unsigned char* pPixel = pSrc+contrib.Left*4;
+            const int* pWeights = contrib.Weights;
+            int numTaps = contrib.Right-contrib.Left+1;
+            uint16x8_t sum = vdupq_n_u16(0);
+            int i = 0;
+            for (; i+2 <= numTaps; i += 2) {
+                uint16x8_t val = vmovl_u8(vld1_u8(pPixel+i*4));
+                uint16x8_t weights = vcombine_u16(vdup_n_u16(uint16_t(pWeights[i])), 
+                        vdup_n_u16(uint16_t(pWeights[i+1])));
+                sum = vmlaq_u16(sum, val, weights);
+            }
+            uint16x4_t pixelSum = vadd_u16(vget_low_u16(sum), vget_high_u16(sum));
+            if (i < numTaps) {
+                uint32_t pixel;
+                memcpy(&pixel, pPixel+i*4, 4);
+                uint16x4_t val = vget_low_u16(vmovl_u8(
+                        vreinterpret_u8_u32(vdup_n_u32(pixel))));
+                pixelSum = vmla_n_u16(pixelSum, val, uint16_t(pWeights[i]));
+            }
+            uint8x8_t result = vrshrn_n_u16(vcombine_u16(pixelSum, pixelSum), 8);
+            uint32_t pixel = vget_lane_u32(vreinterpret_u32_u8(result), 0);
+            memcpy(pDest+x*4, &pixel, 4);
+        }
+        return destWidth;
+    } else if (bpp == 1) {
+        for (int x = 0; x < destWidth; ++x) {
+            const ContributionType& contrib = pContrib->ContribRow[x];
+            const unsigned char* pPixel = pSrc+contrib.Left;
+            const int* pWeights = contrib.Weights;
+            int numTaps = contrib.Right-contrib.Left+1;
+            int total = 0;
+            int i = 0;
+            if (numTaps >= 8) {
+                uint32x4_t sum = vdupq_n_u32(0);
+                for (; i+8 <= numTaps; i += 8) {
+                    uint16x8_t val = vmovl_u8(vld1_u8(pPixel+i));
+                    uint16x4_t weights0 = vmovn_u32(vreinterpretq_u32_s32(
+                            vld1q_s32(pWeights+i)));
+                    uint16x4_t weights1 = vmovn_u32(vreinterpretq_u32_s32(
+                            vld1q_s32(pWeights+i+4)));
+                    sum = vmlal_u16(sum, vget_low_u16(val), weights0);
+                    sum = vmlal_u16(sum, vget_high_u16(val), weights1);
+                }
+                uint64x2_t pairSums = vpaddlq_u32(sum);
+                total = int(vgetq_lane_u64(pairSums, 0)+vgetq_lane_u64(pairSums, 1));
+            }
+            for (; i < numTaps; ++i) {
+                total += pWeights[i]*pPixel[i];
+            }
+            pDest[x] = (unsigned char)((total+128)/256);
+        }
+        return destWidth;
+    } else {
+        return 0;
+    }
+}
+
+int resampleLineVertNEON(const unsigned char* pSrc, int srcStride, unsigned char* pDest,
+        int numBytes, const ContributionType& contrib)
+{
+    int numTaps = contrib.Right-contrib.Left+1;
+    int b = 0;
+    for (; b+16 <= numBytes; b += 16) {
+        const unsigned char* pTap = pSrc+b;
+        uint16x8_t sumLo = vdupq_n_u16(0);
+        uint16x8_t sumHi = vdupq_n_u16(0);
+        for (int i = 0; i < numTaps; ++i) {
+            uint8x16_t val = vld1q_u8(pTap);
+            uint16_t weight = uint16_t(contrib.Weights[i]);
+            sumLo = vmlaq_n_u16(sumLo, vmovl_u8(vget_low_u8(val)), weight);
+            sumHi = vmlaq_n_u16(sumHi, vmovl_u8(vget_high_u8(val)), weight);
+            pTap += srcStride;
+        }
+        vst1q_u8(pDest+b, vcombine_u8(vrshrn_n_u16(sumLo, 8), vrshrn_n_u16(sumHi, 8)));
+    }
+    return b;
+}
+
+#endif
+
+}
+
+void convolveLine8(const unsigned char* pSrc, int tapStep, unsigned char* pDest,
+        int width, const int* pKernel, int radius, bool bDividePerTap)
+{
+    AVG_ASSERT(radius >= 0 && radius <= 7);
+    int x = 0;
+    switch (getSIMDLevel()) {
+#ifdef AVG_SIMD_X86
+        case SIMD_AVX2:
+            x = convolveLine8AVX2(pSrc, tapStep, pDest, width, pKernel, radius, 
+                    bDividePerTap);
+            break;
+        case SIMD_SSE2:
+            x = convolveLine8SSE2(pSrc, tapStep, pDest, width, pKernel, radius, 
+                    bDividePerTap);
+            break;
+#endif
+#ifdef AVG_SIMD_NEON
+        case SIMD_NEON:
+            x = convolveLine8NEON(pSrc, tapStep, pDest, width, pKernel, radius, 
+                    bDividePerTap);
+            break;
+#endif
+        default:
+            break;
+    }
+    convolveLine8Scalar(pSrc, tapStep, pDest, x, width, pKernel, radius, bDividePerTap);
+}
+
+void blurLine8(const unsigned char* pSrc, int srcStride, unsigned char* pDest,
+        int width)
+{
+    int x = 0;
+    switch (getSIMDLevel()) {
+#ifdef AVG_SIMD_X86
+        case SIMD_AVX2:
+            x = blurLine8AVX2(pSrc, srcStride, pDest, width);
+            break;
+        case SIMD_SSE2:
+            x = blurLine8SSE2(pSrc, srcStride, pDest, width);
+            break;
+#endif
+#ifdef AVG_SIMD_NEON
+        case SIMD_NEON:
+            x = blurLine8NEON(pSrc, srcStride, pDest, width);
+            break;
+#endif
+        default:
+            break;
+    }
+    blurLine8Scalar(pSrc, srcStride, pDest, x, width);
+}
+
+void resampleLineHoriz(const unsigned char* pSrc, unsigned char* pDest,
+        int destWidth, int bpp, const LineContribType* pContrib)
+{
+    int x = 0;
+    switch (getSIMDLevel()) {
+#ifdef AVG_SIMD_X86
+        // There is too little work per destination pixel for wider vectors.
+        case SIMD_AVX2:
+        case SIMD_SSE2:
+            x = resampleLineHorizSSE2(pSrc, pDest, destWidth, bpp, pContrib);
+            break;
+#endif
+#ifdef AVG_SIMD_NEON
+        case SIMD_NEON:
+            x = resampleLineHorizNEON(pSrc, pDest, destWidth, bpp, pContrib);
+            break;
+#endif
+        default:
+            break;
+    }
+    resampleLineHorizScalar(pSrc, pDest, x, destWidth, bpp, pContrib);
+}
+
+void resampleLineVert(const unsigned char* pSrc, int srcStride, unsigned char* pDest,
+        int numBytes, const ContributionType& contrib)
+{
+    int b = 0;
+    switch (getSIMDLevel()) {
+#ifdef AVG_SIMD_X86
+        case SIMD_AVX2:
+            b = resampleLineVertAVX2(pSrc, srcStride, pDest, numBytes, contrib);
+            break;
+        case SIMD_SSE2:
+            b = resampleLineVertSSE2(pSrc, srcStride, pDest, numBytes, contrib);
+            break;
+#endif
+#ifdef AVG_SIMD_NEON
+        case SIMD_NEON:
+            b = resampleLineVertNEON(pSrc, srcStride, pDest, numBytes, contrib);
+            break;
+#endif
+        default:
+            break;
+    }
+    resampleLineVertScalar(pSrc, srcStride, pDest, b, numBytes, contrib);
+}
+
+}
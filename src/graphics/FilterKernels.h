@@ -0,0 +1,63 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _FilterKernels_H_
+#define _FilterKernels_H_
+
+#include "../api.h"
+#include "ContribDefs.h"
+
+namespace avg {
+
+// Line kernels for the CPU filters. As with the pixel format conversions, every 
+// kernel has a scalar version that defines the result and SSE2, AVX2 and NEON 
+// versions that produce bit-identical results. The version used is selected at 
+// runtime via getSIMDLevel().
+
+// One line of a separable convolution of an I8 bitmap with 2*radius+1 taps, as used
+// by FilterGauss. Weights are scaled by 256. pSrc points to the source pixel under 
+// the center of the kernel for the first destination pixel. Tap i is read from 
+// pSrc+(i-radius)*tapStep, so tapStep is 1 for horizontal and the stride for 
+// vertical passes. Sums are divided by 256 and truncated to 8 bits. If bDividePerTap
+// is set, every product is divided by 256 before it is added instead. radius must be
+// 7 or less.
+AVG_API void convolveLine8(const unsigned char* pSrc, int tapStep, unsigned char* pDest,
+        int width, const int* pKernel, int radius, bool bDividePerTap);
+
+// FilterBlur: (left + 4*center + right + above + below + 4)/8. pSrc points to the
+// center pixel of the first destination pixel.
+AVG_API void blurLine8(const unsigned char* pSrc, int srcStride, unsigned char* pDest,
+        int width);
+
+// The resampling passes of TwoPassScale for bitmaps with 8 bits per channel. The 
+// weights of each destination pixel must be non-negative and sum up to 256 or less.
+// resampleLineHoriz() computes destWidth pixels of bpp (1, 3 or 4) bytes each from 
+// one source line. resampleLineVert() computes numBytes bytes from the source lines described by
+// contrib; pSrc points to line contrib.Left.
+AVG_API void resampleLineHoriz(const unsigned char* pSrc, unsigned char* pDest,
+        int destWidth, int bpp, const LineContribType* pContrib);
+AVG_API void resampleLineVert(const unsigned char* pSrc, int srcStride, 
+        unsigned char* pDest, int numBytes, const ContributionType& contrib);
+
+}
+
+#endif
@@ -63,6 +63,20 @@ ImageCache::ImageCache()
     AVG_TRACE(Logger::category::CONFIG, Logger::severity::INFO,
             "Image cache size: CPU=" << m_CPUCacheCapacity/(1024*1024) <<
             "MB, GPU=" << m_GPUCacheCapacity/(1024*1024) << "MB" << endl);
+
+    string sDiskCacheDir;
+    ConfigMgr::get()->getStringOption("scr", "imgdiskcachedir", "", sDiskCacheDir);
+    if (sDiskCacheDir != "") {
+        long long diskCacheCapacity = 
+                (long long)(ConfigMgr::get()->getIntOption("scr", "imgdiskcachesize", 
+                1024))*1024*1024;
+        setDiskCache(sDiskCacheDir, diskCacheCapacity);
+    }
+
+    int atlasPageSize = ConfigMgr::get()->getIntOption("scr", "imgatlaspagesize", 0);
+    int atlasMaxImageSize = 
+            ConfigMgr::get()->getIntOption("scr", "imgatlasmaximagesize", 128);
+    setAtlas(atlasPageSize, atlasMaxImageSize);
 }
 
 ImageCache::~ImageCache()
@@ -170,6 +184,46 @@ int ImageCache::getNumGPUImages() const
     return numGPUImages;
 }
 
+void ImageCache::setDiskCache(const std::string& sDir, long long capacity)
+{
+    if (sDir == "") {
+        m_pDiskCache = ImageDiskCachePtr();
+    } else if (m_pDiskCache && m_pDiskCache->getDir() == sDir) {
+        m_pDiskCache->setCapacity(capacity);
+    } else {
+        m_pDiskCache = ImageDiskCachePtr(new ImageDiskCache(sDir, capacity));
+    }
+}
+
+ImageDiskCache* ImageCache::getDiskCache() const
+{
+    return m_pDiskCache.get();
+}
+
+void ImageCache::setAtlas(int pageSize, int maxImageSize)
+{
+    if (pageSize == 0) {
+        m_pAtlas = TextureAtlasPtr();
+    } else if (!m_pAtlas || m_pAtlas->getPageSize() != pageSize || 
+            m_pAtlas->getMaxImageSize() != maxImageSize)
+    {
+        // Images already in the old atlas keep their pages alive until they're unloaded.
+        m_pAtlas = TextureAtlasPtr(new TextureAtlas(pageSize, maxImageSize));
+    }
+}
+
+TextureAtlas* ImageCache::getAtlas() const
+{
+    return m_pAtlas.get();
+}
+
+void ImageCache::defragmentAtlas()
+{
+    if (m_pAtlas) {
+        m_pAtlas->defragment();
+    }
+}
+
 void ImageCache::unloadAllTextures()
 {
     for (LRUListType::const_iterator it=m_pLRUList.begin(); it!=m_pLRUList.end(); ++it) {
@@ -180,6 +234,7 @@ void ImageCache::unloadAllTextures()
             pImg->unloadTex();
         }
     }
+    defragmentAtlas();
 }
 
 void ImageCache::dump() const
@@ -187,6 +242,12 @@ void ImageCache::dump() const
     cerr << "----------------" << endl;
     cerr << "ImageCache: " << m_pLRUList.size() << ", CPU used: " << m_CPUCacheUsed <<
             ", GPU used: " << m_GPUCacheUsed << endl;
+    if (m_pDiskCache) {
+        m_pDiskCache->dump();
+    }
+    if (m_pAtlas) {
+        m_pAtlas->dump();
+    }
     for (LRUListType::const_iterator it=m_pLRUList.begin(); it!=m_pLRUList.end(); ++it) {
         (*it)->dump();
     }
@@ -27,6 +27,8 @@
 #include "../base/GLMHelper.h"
 
 #include "CachedImage.h"
+#include "ImageDiskCache.h"
+#include "TextureAtlas.h"
 #include "TexInfo.h"
 
 #include <boost/shared_ptr.hpp>
@@ -61,6 +63,16 @@ class AVG_API ImageCache
         int getNumCPUImages() const;
         int getNumGPUImages() const;
 
+        // An empty directory disables the disk cache.
+        void setDiskCache(const std::string& sDir, long long capacity);
+        ImageDiskCache* getDiskCache() const;
+
+        // Small images are packed into shared textures. A page size of 0 disables the 
+        // atlas. Images that already have a texture are not affected.
+        void setAtlas(int pageSize, int maxImageSize);
+        TextureAtlas* getAtlas() const;
+        void defragmentAtlas();
+
         void unloadAllTextures();
         void dump() const;
 
@@ -90,6 +102,9 @@ class AVG_API ImageCache
         long long m_CPUCacheUsed;
         long long m_GPUCacheUsed;
 
+        ImageDiskCachePtr m_pDiskCache;
+        TextureAtlasPtr m_pAtlas;
+
         static ImageCache * s_pImageCache;
 };
 
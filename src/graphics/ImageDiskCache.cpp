@@ -0,0 +1,518 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "ImageDiskCache.h"
+
+#include "Bitmap.h"
+
+#include "../base/Exception.h"
+#include "../base/FileHelper.h"
+#include "../base/Logger.h"
+#include "../base/ScopeTimer.h"
+
+#include <stdio.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#ifdef _WIN32
+#include <windows.h>
+#include <direct.h>
+#include <sys/utime.h>
+#else
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <utime.h>
+#endif
+
+#include <algorithm>
+#include <sstream>
+#include <iomanip>
+#include <iostream>
+
+using namespace std;
+
+#define ENTRY_VERSION 1
+#define ENTRY_SUFFIX ".avgimg"
+// Offset of the pixel data in an entry file is aligned to this.
+#define DATA_ALIGN 64
+
+namespace avg {
+
+namespace {
+
+struct EntryHeader {
+    char m_Magic[8];
+    int m_Version;
+    int m_Width;
+    int m_Height;
+    int m_Stride;
+    int m_PixelFormat;
+    int m_KeyLen;
+    long long m_DataOffset;
+};
+
+const char ENTRY_MAGIC[8] = {'A', 'V', 'G', 'I', 'M', 'G', 'C', '\0'};
+
+// Read-only view of a complete file. Writes to the memory go to private copies of 
+// the pages involved, so the file itself never changes.
+class MappedFile
+{
+public:
+    MappedFile(const string& sPath)
+        : m_pData(0),
+          m_Size(0)
+    {
+#ifdef _WIN32
+        m_hFile = CreateFileA(sPath.c_str(), GENERIC_READ, FILE_SHARE_READ, 0, 
+                OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, 0);
+        m_hMapping = 0;
+        if (m_hFile == INVALID_HANDLE_VALUE) {
+            return;
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(m_hFile, &size) || size.QuadPart == 0) {
+            return;
+        }
+        m_hMapping = CreateFileMapping(m_hFile, 0, PAGE_WRITECOPY, 0, 0, 0);
+        if (!m_hMapping) {
+            return;
+        }
+        m_pData = (unsigned char*)MapViewOfFile(m_hMapping, FILE_MAP_COPY, 0, 0, 0);
+        if (m_pData) {
+            m_Size = size.QuadPart;
+        }
+#else
+        int fd = open(sPath.c_str(), O_RDONLY);
+        if (fd == -1) {
+            return;
+        }
+        struct stat fileStat;
+        if (fstat(fd, &fileStat) == 0 && fileStat.st_size > 0) {
+            void* pData = mmap(0, fileStat.st_size, PROT_READ | PROT_WRITE, MAP_PRIVATE,
+                    fd, 0);
+            if (pData != MAP_FAILED) {
+                m_pData = (unsigned char*)pData;
+                m_Size = fileStat.st_size;
+            }
+        }
+        // The mapping stays valid after the descriptor is closed.
+        close(fd);
+#endif
+    }
+
+    ~MappedFile()
+    {
+#ifdef _WIN32
+        if (m_pData) {
+            UnmapViewOfFile(m_pData);
+        }
+        if (m_hMapping) {
+            CloseHandle(m_hMapping);
+        }
+        if (m_hFile != INVALID_HANDLE_VALUE) {
+            CloseHandle(m_hFile);
+        }
+#else
+        if (m_pData) {
+            munmap(m_pData, m_Size);
+        }
+#endif
+    }
+
+    unsigned char* getData() const
+    {
+        return m_pData;
+    }
+
+    long long getSize() const
+    {
+        return m_Size;
+    }
+
+private:
+    unsigned char* m_pData;
+    long long m_Size;
+#ifdef _WIN32
+    HANDLE m_hFile;
+    HANDLE m_hMapping;
+#endif
+};
+
+typedef boost::shared_ptr<MappedFile> MappedFilePtr;
+
+// Keeps the file mapped as long as the Bitmap exists.
+class MappedBmpDeleter
+{
+public:
+    MappedBmpDeleter(const MappedFilePtr& pFile)
+        : m_pFile(pFile)
+    {
+    }
+
+    void operator()(Bitmap* pBmp)
+    {
+        delete pBmp;
+        m_pFile = MappedFilePtr();
+    }
+
+private:
+    MappedFilePtr m_pFile;
+};
+
+struct DirEntry {
+    string m_sName;
+    long long m_Size;
+    long long m_ModTime;
+
+    bool operator<(const DirEntry& other) const
+    {
+        return m_ModTime < other.m_ModTime;
+    }
+};
+
+void listDir(const string& sDir, vector<DirEntry>& entries)
+{
+    vector<string> sNames;
+#ifdef _WIN32
+    WIN32_FIND_DATAA findData;
+    HANDLE hFind = FindFirstFileA((sDir+"/*"+ENTRY_SUFFIX).c_str(), &findData);
+    if (hFind != INVALID_HANDLE_VALUE) {
+        do {
+            sNames.push_back(findData.cFileName);
+        } while (FindNextFileA(hFind, &findData));
+        FindClose(hFind);
+    }
+#else
+    DIR* pDir = opendir(sDir.c_str());
+    if (pDir) {
+        struct dirent* pDirEnt;
+        while ((pDirEnt = readdir(pDir)) != 0) {
+            sNames.push_back(pDirEnt->d_name);
+        }
+        closedir(pDir);
+    }
+#endif
+    string sSuffix(ENTRY_SUFFIX);
+    for (unsigned i = 0; i < sNames.size(); ++i) {
+        const string& sName = sNames[i];
+        if (sName.size() > sSuffix.size() && 
+                sName.compare(sName.size()-sSuffix.size(), sSuffix.size(), sSuffix) == 0)
+        {
+            DirEntry entry;
+            entry.m_sName = sName;
+            if (statFile(sDir+"/"+sName, entry.m_Size, entry.m_ModTime)) {
+                entries.push_back(entry);
+            }
+        }
+    }
+}
+
+// Packed RGB formats, as produced by BitmapLoader and texture compression.
+bool isCacheablePixelFormat(PixelFormat pf)
+{
+    return pf >= B5G6R5 && pf <= X8R8G8B8;
+}
+
+long long alignUp(long long i, long long align)
+{
+    return (i+align-1)/align*align;
+}
+
+}
+
+ImageDiskCache::ImageDiskCache(const string& sDir, long long capacity)
+    : m_sDir(sDir),
+      m_Capacity(capacity),
+      m_MemUsed(0),
+      m_UseCounter(0),
+      m_NumHits(0),
+      m_NumMisses(0),
+      m_NumEvictions(0)
+{
+    AVG_ASSERT(!sDir.empty());
+    makeDir(m_sDir);
+    scanDir();
+    AVG_TRACE(Logger::category::CONFIG, Logger::severity::INFO,
+            "Image disk cache: " << m_sDir << ", " << m_Entries.size() << " entries, "
+            << m_MemUsed/(1024*1024) << "MB used, capacity " 
+            << m_Capacity/(1024*1024) << "MB");
+    checkCapacity();
+}
+
+ImageDiskCache::~ImageDiskCache()
+{
+}
+
+static ProfilingZoneID DiskCacheLoadProfilingZone("ImageDiskCache load", true);
+static ProfilingZoneID DiskCacheStoreProfilingZone("ImageDiskCache store", true);
+
+BitmapPtr ImageDiskCache::load(const string& sFilename, TexCompression compression,
+        bool bBlueFirst)
+{
+    ScopeTimer timer(DiskCacheLoadProfilingZone);
+    string sKey;
+    if (!getKey(sFilename, compression, bBlueFirst, sKey)) {
+        m_NumMisses++;
+        return BitmapPtr();
+    }
+    string sName = getEntryName(sKey);
+    EntryMap::iterator it = m_Entries.find(sName);
+    if (it == m_Entries.end()) {
+        m_NumMisses++;
+        return BitmapPtr();
+    }
+
+    MappedFilePtr pFile(new MappedFile(getEntryPath(sName)));
+    const unsigned char* pData = pFile->getData();
+    bool bValid = false;
+    EntryHeader header;
+    if (pData && pFile->getSize() >= (long long)sizeof(EntryHeader)) {
+        memcpy(&header, pData, sizeof(EntryHeader));
+        bValid = (memcmp(header.m_Magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC)) == 0 &&
+                header.m_Version == ENTRY_VERSION &&
+                header.m_KeyLen == int(sKey.size()) &&
+                (long long)sizeof(EntryHeader)+header.m_KeyLen <= pFile->getSize() &&
+                memcmp(pData+sizeof(EntryHeader), sKey.c_str(), sKey.size()) == 0 &&
+                header.m_Width > 0 && header.m_Height > 0 &&
+                isCacheablePixelFormat(PixelFormat(header.m_PixelFormat)) &&
+                header.m_Stride >= header.m_Width*int(getBytesPerPixel(
+                        PixelFormat(header.m_PixelFormat))) &&
+                header.m_DataOffset % DATA_ALIGN == 0 &&
+                header.m_DataOffset + (long long)(header.m_Stride)*header.m_Height <=
+                        pFile->getSize());
+    }
+    if (!bValid) {
+        // Truncated file, hash collision or incompatible version.
+        removeEntry(it);
+        m_NumMisses++;
+        return BitmapPtr();
+    }
+    touchEntry(sName, it->second);
+    m_NumHits++;
+    IntPoint size(header.m_Width, header.m_Height);
+    return BitmapPtr(new Bitmap(size, PixelFormat(header.m_PixelFormat), 
+            pFile->getData()+header.m_DataOffset, header.m_Stride, false, sFilename),
+            MappedBmpDeleter(pFile));
+}
+
+void ImageDiskCache::store(const string& sFilename, TexCompression compression,
+        bool bBlueFirst, BitmapPtr pBmp)
+{
+    ScopeTimer timer(DiskCacheStoreProfilingZone);
+    string sKey;
+    if (!isCacheablePixelFormat(pBmp->getPixelFormat()) || 
+            !getKey(sFilename, compression, bBlueFirst, sKey))
+    {
+        return;
+    }
+    EntryHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.m_Magic, ENTRY_MAGIC, sizeof(ENTRY_MAGIC));
+    header.m_Version = ENTRY_VERSION;
+    header.m_Width = pBmp->getSize().x;
+    header.m_Height = pBmp->getSize().y;
+    header.m_Stride = pBmp->getStride();
+    header.m_PixelFormat = pBmp->getPixelFormat();
+    header.m_KeyLen = int(sKey.size());
+    header.m_DataOffset = alignUp(sizeof(EntryHeader)+sKey.size(), DATA_ALIGN);
+    long long fileSize = header.m_DataOffset + 
+            (long long)(header.m_Stride)*header.m_Height;
+    if (fileSize > m_Capacity) {
+        return;
+    }
+
+    string sName = getEntryName(sKey);
+    EntryMap::iterator it = m_Entries.find(sName);
+    if (it != m_Entries.end()) {
+        removeEntry(it);
+    }
+    // Write to a temporary file first so other processes never see partial entries.
+    string sPath = getEntryPath(sName);
+    string sTempPath = sPath+".tmp";
+    FILE* pFile = fopen(sTempPath.c_str(), "wb");
+    if (!pFile) {
+        AVG_LOG_WARNING("Image disk cache: Can't write " << sTempPath << ".");
+        return;
+    }
+    bool bOk = fwrite(&header, sizeof(header), 1, pFile) == 1;
+    bOk = bOk && fwrite(sKey.c_str(), sKey.size(), 1, pFile) == 1;
+    vector<char> padding(header.m_DataOffset-sizeof(EntryHeader)-sKey.size(), 0);
+    if (!padding.empty()) {
+        bOk = bOk && fwrite(&padding[0], padding.size(), 1, pFile) == 1;
+    }
+    for (int y = 0; y < header.m_Height && bOk; ++y) {
+        bOk = fwrite(pBmp->getPixels()+y*pBmp->getStride(), header.m_Stride, 1, pFile)
+                == 1;
+    }
+    bOk = (fclose(pFile) == 0) && bOk;
+#ifdef _WIN32
+    // rename() doesn't replace existing files under windows.
+    remove(sPath.c_str());
+#endif
+    if (!bOk || rename(sTempPath.c_str(), sPath.c_str()) != 0) {
+        AVG_LOG_WARNING("Image disk cache: Can't write " << sPath << ".");
+        remove(sTempPath.c_str());
+        return;
+    }
+    Entry entry;
+    entry.m_Size = fileSize;
+    entry.m_LastUsed = m_UseCounter++;
+    m_Entries[sName] = entry;
+    m_MemUsed += fileSize;
+    checkCapacity();
+}
+
+void ImageDiskCache::clear()
+{
+    while (!m_Entries.empty()) {
+        removeEntry(m_Entries.begin());
+    }
+}
+
+const string& ImageDiskCache::getDir() const
+{
+    return m_sDir;
+}
+
+void ImageDiskCache::setCapacity(long long capacity)
+{
+    m_Capacity = capacity;
+    checkCapacity();
+}
+
+long long ImageDiskCache::getCapacity() const
+{
+    return m_Capacity;
+}
+
+long long ImageDiskCache::getMemUsed() const
+{
+    return m_MemUsed;
+}
+
+int ImageDiskCache::getNumEntries() const
+{
+    return int(m_Entries.size());
+}
+
+long long ImageDiskCache::getNumHits() const
+{
+    return m_NumHits;
+}
+
+long long ImageDiskCache::getNumMisses() const
+{
+    return m_NumMisses;
+}
+
+long long ImageDiskCache::getNumEvictions() const
+{
+    return m_NumEvictions;
+}
+
+void ImageDiskCache::dump() const
+{
+    cerr << "ImageDiskCache: " << m_sDir << ", entries: " << m_Entries.size() 
+            << ", used: " << m_MemUsed << ", capacity: " << m_Capacity 
+            << ", hits: " << m_NumHits << ", misses: " << m_NumMisses 
+            << ", evictions: " << m_NumEvictions << endl;
+}
+
+bool ImageDiskCache::getKey(const string& sFilename, TexCompression compression,
+        bool bBlueFirst, string& sKey) const
+{
+    long long size;
+    long long modTime;
+    if (!statFile(sFilename, size, modTime)) {
+        return false;
+    }
+    stringstream ss;
+    ss << sFilename << "|" << modTime << "|" << size << "|" 
+            << texCompression2String(compression) << "|" << (bBlueFirst ? "BGR" : "RGB");
+    sKey = ss.str();
+    return true;
+}
+
+string ImageDiskCache::getEntryName(const string& sKey) const
+{
+    stringstream ss;
+    ss << hex << setw(16) << setfill('0') << hashString(sKey) << ENTRY_SUFFIX;
+    return ss.str();
+}
+
+string ImageDiskCache::getEntryPath(const string& sName) const
+{
+    return m_sDir+"/"+sName;
+}
+
+void ImageDiskCache::scanDir()
+{
+    vector<DirEntry> dirEntries;
+    listDir(m_sDir, dirEntries);
+    // Entry modification times are updated on every hit, so they reflect the LRU
+    // order of previous runs.
+    sort(dirEntries.begin(), dirEntries.end());
+    for (unsigned i = 0; i < dirEntries.size(); ++i) {
+        Entry entry;
+        entry.m_Size = dirEntries[i].m_Size;
+        entry.m_LastUsed = m_UseCounter++;
+        m_Entries[dirEntries[i].m_sName] = entry;
+        m_MemUsed += entry.m_Size;
+    }
+}
+
+void ImageDiskCache::touchEntry(const string& sName, Entry& entry)
+{
+    entry.m_LastUsed = m_UseCounter++;
+    // Sets the modification time to now.
+    utime(getEntryPath(sName).c_str(), 0);
+}
+
+void ImageDiskCache::removeEntry(EntryMap::iterator it)
+{
+    // If the entry is still mapped, the file stays accessible until it's unmapped
+    // (Posix). Under windows, removing a mapped file fails; in that case, the file is
+    // just forgotten and deleted in a later run.
+    remove(getEntryPath(it->first).c_str());
+    m_MemUsed -= it->second.m_Size;
+    m_Entries.erase(it);
+}
+
+void ImageDiskCache::checkCapacity()
+{
+    if (m_MemUsed <= m_Capacity) {
+        return;
+    }
+    vector<pair<long long, string> > lruOrder;
+    for (EntryMap::iterator it = m_Entries.begin(); it != m_Entries.end(); ++it) {
+        lruOrder.push_back(make_pair(it->second.m_LastUsed, it->first));
+    }
+    sort(lruOrder.begin(), lruOrder.end());
+    for (unsigned i = 0; i < lruOrder.size() && m_MemUsed > m_Capacity; ++i) {
+        removeEntry(m_Entries.find(lruOrder[i].second));
+        m_NumEvictions++;
+    }
+}
+
+}
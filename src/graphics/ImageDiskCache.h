@@ -0,0 +1,100 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _ImageDiskCache_H_
+#define _ImageDiskCache_H_
+
+#include "../api.h"
+
+#include "TexInfo.h"
+
+#include <boost/shared_ptr.hpp>
+#include <string>
+#include <map>
+
+namespace avg {
+
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+
+// Persistent cache of decoded images. Entries hold the final pixels (after format
+// conversion and texture compression) in a raw format that is memory-mapped on load,
+// so cached images don't need to be decoded again in later runs.
+// Entries are keyed by source path, modification time, file size, compression and
+// channel order; an entry becomes stale automatically when the source file changes.
+// If the cache exceeds its capacity, least recently used entries are deleted.
+class AVG_API ImageDiskCache
+{
+public:
+    ImageDiskCache(const std::string& sDir, long long capacity);
+    virtual ~ImageDiskCache();
+
+    // Returns an empty BitmapPtr if there is no valid entry for the file.
+    BitmapPtr load(const std::string& sFilename, TexCompression compression,
+            bool bBlueFirst);
+    void store(const std::string& sFilename, TexCompression compression, 
+            bool bBlueFirst, BitmapPtr pBmp);
+    void clear();
+
+    const std::string& getDir() const;
+    void setCapacity(long long capacity);
+    long long getCapacity() const;
+    long long getMemUsed() const;
+    int getNumEntries() const;
+    long long getNumHits() const;
+    long long getNumMisses() const;
+    long long getNumEvictions() const;
+
+    void dump() const;
+
+private:
+    struct Entry {
+        long long m_Size;
+        long long m_LastUsed;
+    };
+    typedef std::map<std::string, Entry> EntryMap;
+
+    bool getKey(const std::string& sFilename, TexCompression compression,
+            bool bBlueFirst, std::string& sKey) const;
+    std::string getEntryName(const std::string& sKey) const;
+    std::string getEntryPath(const std::string& sName) const;
+    void scanDir();
+    void touchEntry(const std::string& sName, Entry& entry);
+    void removeEntry(EntryMap::iterator it);
+    void checkCapacity();
+
+    std::string m_sDir;
+    long long m_Capacity;
+    long long m_MemUsed;
+    EntryMap m_Entries;
+    long long m_UseCounter;
+
+    long long m_NumHits;
+    long long m_NumMisses;
+    long long m_NumEvictions;
+};
+
+typedef boost::shared_ptr<ImageDiskCache> ImageDiskCachePtr;
+
+}
+
+#endif
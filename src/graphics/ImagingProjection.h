@@ -45,6 +45,9 @@ public:
     virtual ~ImagingProjection();
 
     void setColor(const Pixel32& color);
+    // Part of the source texture that contains the image. Defaults to the whole
+    // texture.
+    void setTexCoordRect(const FRect& texCoordRect);
     void draw(GLContext* pContext, const OGLShaderPtr& pShader);
 
 private:
@@ -53,6 +56,7 @@ private:
     IntPoint m_SrcSize;
     IntRect m_DestRect;
     IntPoint m_Offset;
+    FRect m_TexCoordRect;
     Pixel32 m_Color;
     VertexArrayPtr m_pVA;
     Mat4fGLShaderParamPtr m_pTransformParam;
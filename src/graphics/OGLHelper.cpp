@@ -47,7 +47,6 @@ namespace avg {
 
 namespace glproc {
 #ifndef AVG_ENABLE_EGL
-    PFNGLBUFFERSUBDATAPROC BufferSubData;
     PFNGLGETBUFFERSUBDATAPROC GetBufferSubData;
     PFNGLBLITFRAMEBUFFERPROC BlitFramebuffer;
     PFNGLDRAWBUFFERSPROC DrawBuffers;
@@ -56,6 +55,7 @@ namespace glproc {
 #endif
     PFNGLGENBUFFERSPROC GenBuffers;
     PFNGLBUFFERDATAPROC BufferData;
+    PFNGLBUFFERSUBDATAPROC BufferSubData;
     PFNGLDEBUGMESSAGECALLBACKPROC DebugMessageCallback;
     PFNGLDELETEBUFFERSPROC DeleteBuffers;
     PFNGLBINDBUFFERPROC BindBuffer;
@@ -341,6 +341,7 @@ namespace glproc {
         
         GenBuffers = (PFNGLGENBUFFERSPROC)getFuzzyProcAddress("glGenBuffers");
         BufferData = (PFNGLBUFFERDATAPROC)getFuzzyProcAddress("glBufferData");
+        BufferSubData = (PFNGLBUFFERSUBDATAPROC)getFuzzyProcAddress("glBufferSubData");
         DeleteBuffers = (PFNGLDELETEBUFFERSPROC)getFuzzyProcAddress("glDeleteBuffers");
         BindBuffer = (PFNGLBINDBUFFERPROC)getFuzzyProcAddress("glBindBuffer");
         MapBuffer = (PFNGLMAPBUFFERPROC)getFuzzyProcAddress("glMapBuffer");
@@ -402,7 +403,6 @@ namespace glproc {
         DeleteRenderbuffers = (PFNGLDELETERENDERBUFFERSPROC)
                 getFuzzyProcAddress("glDeleteRenderbuffers");
 #ifndef AVG_ENABLE_EGL
-        BufferSubData = (PFNGLBUFFERSUBDATAPROC)getFuzzyProcAddress("glBufferSubData");
         GetBufferSubData = (PFNGLGETBUFFERSUBDATAPROC)getFuzzyProcAddress
             ("glGetBufferSubData");
         GetObjectParameteriv = (PFNGLGETOBJECTPARAMETERIVARBPROC)
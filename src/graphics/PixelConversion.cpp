@@ -0,0 +1,1057 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "PixelConversion.h"
+#include "Pixel32.h"
+
+#include "../base/SIMDHelper.h"
+
+#include <algorithm>
+
+namespace avg {
+
+namespace {
+
+inline unsigned char clampToByte(int val)
+{
+    if (val < 0) {
+        return 0;
+    } else if (val > 255) {
+        return 255;
+    } else {
+        return (unsigned char)val;
+    }
+}
+
+// ------------------------------------------------------------------------
+// Scalar versions. These define the results the vectorized versions must match.
+
+// Fixed-point math of the liboggplay MMX code this replaces: chroma is scaled with
+// 16-bit multiplies and arithmetic shifts and added to luma with saturation.
+void yuv420ToBGRXScalar(const unsigned char* pY, const unsigned char* pU,
+        const unsigned char* pV, unsigned char* pDest, int start, int end, bool bJPEG)
+{
+    for (int x = start; x < end; ++x) {
+        int y = pY[x];
+        int u = pU[x/2]-128;
+        int v = pV[x/2]-128;
+        int r, g, b;
+        if (bJPEG) {
+            r = (v*179) >> 7;
+            g = (u*-44 + v*-91) >> 7;
+            b = (u*113) >> 6;
+        } else {
+            y = (y < 16) ? 0 : ((y-16)*149) >> 7;
+            r = (v*204) >> 7;
+            g = (u*-50 + v*-104) >> 7;
+            b = (u*129) >> 6;
+        }
+        unsigned char* pPixel = pDest+x*4;
+        pPixel[0] = clampToByte(y+b);
+        pPixel[1] = clampToByte(y+g);
+        pPixel[2] = clampToByte(y+r);
+        pPixel[3] = 255;
+    }
+}
+
+// Converts the pixel pairs [start, end). Every pair needs the v of the previous pair
+// and the u of the next one; the first pair uses its own v instead.
+void yuv422ToBGRXScalar(const unsigned char* pSrc, unsigned char* pDest, int start,
+        int end, bool bUYVY)
+{
+    int yOfs = bUYVY ? 1 : 0;
+    int uOfs = bUYVY ? 0 : 1;
+    int vOfs = uOfs+2;
+    for (int i = start; i < end; ++i) {
+        const unsigned char* pPair = pSrc+i*4;
+        int u = pPair[uOfs];
+        int v = pPair[vOfs];
+        int v0 = (i == 0) ? v : pPair[vOfs-4];
+        int u1 = pPair[uOfs+4];
+        Pixel32* pDestPixel = (Pixel32*)(pDest+i*8);
+        YUVtoBGR32Pixel(pDestPixel, pPair[yOfs], u, (v0+v)/2);
+        YUVtoBGR32Pixel(pDestPixel+1, pPair[yOfs+2], (u+u1)/2, v);
+    }
+}
+
+void yuv422LastPairToBGRX(const unsigned char* pSrc, unsigned char* pDest, int numPairs,
+        bool bUYVY)
+{
+    int yOfs = bUYVY ? 1 : 0;
+    int uOfs = bUYVY ? 0 : 1;
+    int vOfs = uOfs+2;
+    int i = numPairs-1;
+    const unsigned char* pPair = pSrc+i*4;
+    int u = pPair[uOfs];
+    int v = pPair[vOfs];
+    int v0 = (i == 0) ? v : pPair[vOfs-4];
+    Pixel32* pDestPixel = (Pixel32*)(pDest+i*8);
+    YUVtoBGR32Pixel(pDestPixel, pPair[yOfs], u, v0/2+v/2);
+    YUVtoBGR32Pixel(pDestPixel+1, pPair[yOfs+2], u, v);
+}
+
+// Bayer demosaicking. pSrcPixel points to the upper left neighbour of the pixel
+// converted, pDestPixel to the green channel of the destination pixel. blue is the
+// offset of the channel that gets the color sampled at the pixel.
+inline void bayerGreenPixel(const unsigned char* pSrcPixel, int srcStride,
+        unsigned char* pDestPixel, int blue)
+{
+    int doubleSrcStride = srcStride*2;
+    int t0 = (pSrcPixel[1] + pSrcPixel[doubleSrcStride + 1] + 1) >> 1;
+    int t1 = (pSrcPixel[srcStride] + pSrcPixel[srcStride + 2] + 1) >> 1;
+    pDestPixel[-blue] = (unsigned char) t0;
+    pDestPixel[0] = pSrcPixel[srcStride + 1];
+    pDestPixel[blue] = (unsigned char) t1;
+    pDestPixel[2] = 255; // Alpha channel
+}
+
+inline void bayerColorPixel(const unsigned char* pSrcPixel, int srcStride,
+        unsigned char* pDestPixel, int blue)
+{
+    int doubleSrcStride = srcStride*2;
+    int t0 = (pSrcPixel[0] + pSrcPixel[2] + pSrcPixel[doubleSrcStride] +
+            pSrcPixel[doubleSrcStride + 2] + 2) >> 2;
+    int t1 = (pSrcPixel[1] + pSrcPixel[srcStride] +
+            pSrcPixel[srcStride + 2] + pSrcPixel[doubleSrcStride + 1] + 2) >> 2;
+    pDestPixel[-blue] = (unsigned char) t0;
+    pDestPixel[0] = (unsigned char) t1;
+    pDestPixel[blue] = pSrcPixel[srcStride + 1];
+    pDestPixel[2] = 255; // Alpha channel
+}
+
+// ------------------------------------------------------------------------
+// The vectorized versions process as many pixels as fit into whole vectors and
+// return the number of pixels (or, for 4:2:2, the index of the pixel pair) where the
+// scalar code needs to continue.
+
+#ifdef AVG_SIMD_X86
+
+// Interleaves 16 b, g and r bytes into 16 32-bit pixels.
+inline void storeBGRXSSE2(unsigned char* pDest, __m128i b, __m128i g, __m128i r)
+{
+    const __m128i alpha = _mm_set1_epi8(-1);
+    __m128i bg = _mm_unpacklo_epi8(b, g);
+    __m128i ra = _mm_unpacklo_epi8(r, alpha);
+    __m128i* pDest128 = (__m128i*)pDest;
+    _mm_storeu_si128(pDest128, _mm_unpacklo_epi16(bg, ra));
+    _mm_storeu_si128(pDest128+1, _mm_unpackhi_epi16(bg, ra));
+    bg = _mm_unpackhi_epi8(b, g);
+    ra = _mm_unpackhi_epi8(r, alpha);
+    _mm_storeu_si128(pDest128+2, _mm_unpacklo_epi16(bg, ra));
+    _mm_storeu_si128(pDest128+3, _mm_unpackhi_epi16(bg, ra));
+}
+
+// Adds 8 chroma values to 16 luma values, every chroma value covering two pixels.
+inline __m128i addLumaSSE2(__m128i chroma, __m128i yLo, __m128i yHi)
+{
+    return _mm_packus_epi16(_mm_adds_epi16(_mm_unpacklo_epi16(chroma, chroma), yLo),
+            _mm_adds_epi16(_mm_unpackhi_epi16(chroma, chroma), yHi));
+}
+
+int yuv420ToBGRXSSE2(const unsigned char* pY, const unsigned char* pU,
+        const unsigned char* pV, unsigned char* pDest, int width, bool bJPEG)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c16 = _mm_set1_epi16(16);
+    const __m128i c128 = _mm_set1_epi16(128);
+    const __m128i c149 = _mm_set1_epi16(149);
+    const __m128i ug = _mm_set1_epi16(bJPEG ? -44 : -50);
+    const __m128i vg = _mm_set1_epi16(bJPEG ? -91 : -104);
+    const __m128i ub = _mm_set1_epi16(bJPEG ? 113 : 129);
+    const __m128i vr = _mm_set1_epi16(bJPEG ? 179 : 204);
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        __m128i y = _mm_loadu_si128((const __m128i*)(pY+x));
+        __m128i yLo = _mm_unpacklo_epi8(y, zero);
+        __m128i yHi = _mm_unpackhi_epi8(y, zero);
+        if (!bJPEG) {
+            yLo = _mm_srli_epi16(_mm_mullo_epi16(_mm_subs_epu16(yLo, c16), c149), 7);
+            yHi = _mm_srli_epi16(_mm_mullo_epi16(_mm_subs_epu16(yHi, c16), c149), 7);
+        }
+        __m128i u = _mm_sub_epi16(
+                _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(pU+x/2)), zero), c128);
+        __m128i v = _mm_sub_epi16(
+                _mm_unpacklo_epi8(_mm_loadl_epi64((const __m128i*)(pV+x/2)), zero), c128);
+        __m128i r = _mm_srai_epi16(_mm_mullo_epi16(v, vr), 7);
+        __m128i g = _mm_srai_epi16(
+                _mm_adds_epi16(_mm_mullo_epi16(u, ug), _mm_mullo_epi16(v, vg)), 7);
+        __m128i b = _mm_srai_epi16(_mm_mullo_epi16(u, ub), 6);
+        storeBGRXSSE2(pDest+x*4, addLumaSSE2(b, yLo, yHi), addLumaSSE2(g, yLo, yHi),
+                addLumaSSE2(r, yLo, yHi));
+    }
+    return x;
+}
+
+inline __m128i setPairSSE2(short lo, short hi)
+{
+    return _mm_set1_epi32((int)(((unsigned)(unsigned short)hi << 16) |
+            (unsigned short)lo));
+}
+
+// Converts 8 pixels. y, u and v are 16-bit values with the offsets already
+// subtracted. Same math as YUVtoBGR32Pixel(), using 32-bit multiply-adds.
+inline void yuvToBGRXSSE2(unsigned char* pDest, __m128i y, __m128i u, __m128i v)
+{
+    const __m128i bCoeffs = setPairSSE2(298, 516);
+    const __m128i guCoeffs = setPairSSE2(298, -100);
+    const __m128i gvCoeffs = setPairSSE2(0, -208);
+    const __m128i rCoeffs = setPairSSE2(298, 409);
+    __m128i yuLo = _mm_unpacklo_epi16(y, u);
+    __m128i yuHi = _mm_unpackhi_epi16(y, u);
+    __m128i yvLo = _mm_unpacklo_epi16(y, v);
+    __m128i yvHi = _mm_unpackhi_epi16(y, v);
+    __m128i b = _mm_packs_epi32(
+            _mm_srai_epi32(_mm_madd_epi16(yuLo, bCoeffs), 8),
+            _mm_srai_epi32(_mm_madd_epi16(yuHi, bCoeffs), 8));
+    __m128i g = _mm_packs_epi32(
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yuLo, guCoeffs),
+                    _mm_madd_epi16(yvLo, gvCoeffs)), 8),
+            _mm_srai_epi32(_mm_add_epi32(_mm_madd_epi16(yuHi, guCoeffs),
+                    _mm_madd_epi16(yvHi, gvCoeffs)), 8));
+    __m128i r = _mm_packs_epi32(
+            _mm_srai_epi32(_mm_madd_epi16(yvLo, rCoeffs), 8),
+            _mm_srai_epi32(_mm_madd_epi16(yvHi, rCoeffs), 8));
+
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i c255 = _mm_set1_epi16(255);
+    b = _mm_min_epi16(_mm_max_epi16(b, zero), c255);
+    g = _mm_min_epi16(_mm_max_epi16(g, zero), c255);
+    r = _mm_min_epi16(_mm_max_epi16(r, zero), c255);
+    __m128i bg = _mm_or_si128(b, _mm_slli_epi16(g, 8));
+    __m128i ra = _mm_or_si128(r, _mm_set1_epi16(short(0xFF00)));
+    _mm_storeu_si128((__m128i*)pDest, _mm_unpacklo_epi16(bg, ra));
+    _mm_storeu_si128((__m128i*)(pDest+16), _mm_unpackhi_epi16(bg, ra));
+}
+
+int yuv422ToBGRXSSE2(const unsigned char* pSrc, unsigned char* pDest, int numPairs,
+        bool bUYVY)
+{
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    const __m128i evenWords = _mm_set1_epi32(0x0000FFFF);
+    const __m128i c16 = _mm_set1_epi16(16);
+    const __m128i c128 = _mm_set1_epi16(128);
+    int i = 1;
+    for (; i+4 <= numPairs-1; i += 4) {
+        const unsigned char* pPair = pSrc+i*4;
+        __m128i cur = _mm_loadu_si128((const __m128i*)pPair);
+        __m128i prev = _mm_loadu_si128((const __m128i*)(pPair-4));
+        __m128i next = _mm_loadu_si128((const __m128i*)(pPair+4));
+        __m128i y;
+        __m128i chroma;
+        __m128i prevChroma;
+        __m128i nextChroma;
+        if (bUYVY) {
+            y = _mm_srli_epi16(cur, 8);
+            chroma = _mm_and_si128(cur, lowBytes);
+            prevChroma = _mm_and_si128(prev, lowBytes);
+            nextChroma = _mm_and_si128(next, lowBytes);
+        } else {
+            y = _mm_and_si128(cur, lowBytes);
+            chroma = _mm_srli_epi16(cur, 8);
+            prevChroma = _mm_srli_epi16(prev, 8);
+            nextChroma = _mm_srli_epi16(next, 8);
+        }
+        // chroma alternates u and v. Even pixels get their pair's u and the average
+        // of the previous and current v, odd pixels the average of the current and
+        // next u and their pair's v.
+        __m128i uAvg = _mm_srli_epi16(_mm_add_epi16(chroma, nextChroma), 1);
+        __m128i vAvg = _mm_srli_epi16(_mm_add_epi16(prevChroma, chroma), 1);
+        __m128i u = _mm_or_si128(_mm_and_si128(chroma, evenWords),
+                _mm_andnot_si128(evenWords, _mm_slli_si128(uAvg, 2)));
+        __m128i v = _mm_or_si128(_mm_and_si128(_mm_srli_si128(vAvg, 2), evenWords),
+                _mm_andnot_si128(evenWords, chroma));
+        yuvToBGRXSSE2(pDest+i*8, _mm_sub_epi16(y, c16), _mm_sub_epi16(u, c128),
+                _mm_sub_epi16(v, c128));
+    }
+    return i;
+}
+
+int yuyv422ToI8SSE2(const unsigned char* pSrc, unsigned char* pDest, int width)
+{
+    const __m128i lowBytes = _mm_set1_epi16(0x00FF);
+    int x = 0;
+    // Strict comparison: pSrc may be offset by one byte into the line.
+    for (; x+16 < width; x += 16) {
+        __m128i lo = _mm_loadu_si128((const __m128i*)(pSrc+x*2));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(pSrc+x*2+16));
+        _mm_storeu_si128((__m128i*)(pDest+x), _mm_packus_epi16(
+                _mm_and_si128(lo, lowBytes), _mm_and_si128(hi, lowBytes)));
+    }
+    return x;
+}
+
+int i8ToBGRXSSE2(const unsigned char* pSrc, unsigned char* pDest, int width)
+{
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        __m128i val = _mm_loadu_si128((const __m128i*)(pSrc+x));
+        storeBGRXSSE2(pDest+x*4, val, val, val);
+    }
+    return x;
+}
+
+int i16ToI8SSE2(const unsigned short* pSrc, unsigned char* pDest, int width)
+{
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        __m128i lo = _mm_loadu_si128((const __m128i*)(pSrc+x));
+        __m128i hi = _mm_loadu_si128((const __m128i*)(pSrc+x+8));
+        _mm_storeu_si128((__m128i*)(pDest+x), _mm_packus_epi16(
+                _mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+    }
+    return x;
+}
+
+int i8ToI16SSE2(const unsigned char* pSrc, unsigned short* pDest, int width)
+{
+    const __m128i zero = _mm_setzero_si128();
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        __m128i val = _mm_loadu_si128((const __m128i*)(pSrc+x));
+        _mm_storeu_si128((__m128i*)(pDest+x), _mm_unpacklo_epi8(zero, val));
+        _mm_storeu_si128((__m128i*)(pDest+x+8), _mm_unpackhi_epi8(zero, val));
+    }
+    return x;
+}
+
+// (a+b+c+d+2)/4 for 16 bytes.
+inline __m128i average4SSE2(__m128i a, __m128i b, __m128i c, __m128i d)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i two = _mm_set1_epi16(2);
+    __m128i lo = _mm_add_epi16(
+            _mm_add_epi16(_mm_unpacklo_epi8(a, zero), _mm_unpacklo_epi8(b, zero)),
+            _mm_add_epi16(_mm_unpacklo_epi8(c, zero), _mm_unpacklo_epi8(d, zero)));
+    __m128i hi = _mm_add_epi16(
+            _mm_add_epi16(_mm_unpackhi_epi8(a, zero), _mm_unpackhi_epi8(b, zero)),
+            _mm_add_epi16(_mm_unpackhi_epi8(c, zero), _mm_unpackhi_epi8(d, zero)));
+    return _mm_packus_epi16(_mm_srli_epi16(_mm_add_epi16(lo, two), 2),
+            _mm_srli_epi16(_mm_add_epi16(hi, two), 2));
+}
+
+inline __m128i selectSSE2(__m128i mask, __m128i a, __m128i b)
+{
+    return _mm_or_si128(_mm_and_si128(mask, a), _mm_andnot_si128(mask, b));
+}
+
+// pSrc points to the upper left neighbour of the first pixel, which must be a red or
+// blue one. pDest points to the first destination pixel.
+int bayerBilinearSSE2(const unsigned char* pSrc, int srcStride, unsigned char* pDest,
+        int numPixels, bool bBlue)
+{
+    // Even pixels are red or blue, odd pixels green.
+    const __m128i colorMask = _mm_set1_epi16(0x00FF);
+    int x = 0;
+    for (; x+16 <= numPixels; x += 16) {
+        const unsigned char* pAbove = pSrc+x;
+        const unsigned char* pCur = pAbove+srcStride;
+        const unsigned char* pBelow = pCur+srcStride;
+        __m128i above0 = _mm_loadu_si128((const __m128i*)pAbove);
+        __m128i above1 = _mm_loadu_si128((const __m128i*)(pAbove+1));
+        __m128i above2 = _mm_loadu_si128((const __m128i*)(pAbove+2));
+        __m128i cur0 = _mm_loadu_si128((const __m128i*)pCur);
+        __m128i cur1 = _mm_loadu_si128((const __m128i*)(pCur+1));
+        __m128i cur2 = _mm_loadu_si128((const __m128i*)(pCur+2));
+        __m128i below0 = _mm_loadu_si128((const __m128i*)pBelow);
+        __m128i below1 = _mm_loadu_si128((const __m128i*)(pBelow+1));
+        __m128i below2 = _mm_loadu_si128((const __m128i*)(pBelow+2));
+
+        __m128i diagonal = average4SSE2(above0, above2, below0, below2);
+        __m128i cross = average4SSE2(above1, cur0, cur2, below1);
+        __m128i vertical = _mm_avg_epu8(above1, below1);
+        __m128i horizontal = _mm_avg_epu8(cur0, cur2);
+
+        __m128i green = selectSSE2(colorMask, cross, cur1);
+        __m128i sampled = selectSSE2(colorMask, cur1, horizontal);
+        __m128i interpolated = selectSSE2(colorMask, diagonal, vertical);
+        if (bBlue) {
+            storeBGRXSSE2(pDest+x*4, interpolated, green, sampled);
+        } else {
+            storeBGRXSSE2(pDest+x*4, sampled, green, interpolated);
+        }
+    }
+    return x;
+}
+
+// AVX2 versions. Most AVX2 instructions work on two independent 128-bit lanes, so
+// unpacked intermediate values are ordered lane by lane and need a final permute.
+
+// Interleaves 32 b, g and r bytes into 32 32-bit pixels.
+AVG_TARGET_AVX2 inline void storeBGRXAVX2(unsigned char* pDest, __m256i b, __m256i g,
+        __m256i r)
+{
+    const __m256i alpha = _mm256_set1_epi8(-1);
+    __m256i bgLo = _mm256_unpacklo_epi8(b, g);    // Pixels 0-7, 16-23
+    __m256i raLo = _mm256_unpacklo_epi8(r, alpha);
+    __m256i bgHi = _mm256_unpackhi_epi8(b, g);    // Pixels 8-15, 24-31
+    __m256i raHi = _mm256_unpackhi_epi8(r, alpha);
+    __m256i q0 = _mm256_unpacklo_epi16(bgLo, raLo);  // Pixels 0-3, 16-19
+    __m256i q1 = _mm256_unpackhi_epi16(bgLo, raLo);  // Pixels 4-7, 20-23
+    __m256i q2 = _mm256_unpacklo_epi16(bgHi, raHi);  // Pixels 8-11, 24-27
+    __m256i q3 = _mm256_unpackhi_epi16(bgHi, raHi);  // Pixels 12-15, 28-31
+    __m256i* pDest256 = (__m256i*)pDest;
+    _mm256_storeu_si256(pDest256, _mm256_permute2x128_si256(q0, q1, 0x20));
+    _mm256_storeu_si256(pDest256+1, _mm256_permute2x128_si256(q2, q3, 0x20));
+    _mm256_storeu_si256(pDest256+2, _mm256_permute2x128_si256(q0, q1, 0x31));
+    _mm256_storeu_si256(pDest256+3, _mm256_permute2x128_si256(q2, q3, 0x31));
+}
+
+AVG_TARGET_AVX2 inline __m256i addLumaAVX2(__m256i chroma, __m256i yLo, __m256i yHi)
+{
+    return _mm256_packus_epi16(
+            _mm256_adds_epi16(_mm256_unpacklo_epi16(chroma, chroma), yLo),
+            _mm256_adds_epi16(_mm256_unpackhi_epi16(chroma, chroma), yHi));
+}
+
+AVG_TARGET_AVX2 int yuv420ToBGRXAVX2(const unsigned char* pY, const unsigned char* pU,
+        const unsigned char* pV, unsigned char* pDest, int width, bool bJPEG)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i c16 = _mm256_set1_epi16(16);
+    const __m256i c128 = _mm256_set1_epi16(128);
+    const __m256i c149 = _mm256_set1_epi16(149);
+    const __m256i ug = _mm256_set1_epi16(bJPEG ? -44 : -50);
+    const __m256i vg = _mm256_set1_epi16(bJPEG ? -91 : -104);
+    const __m256i ub = _mm256_set1_epi16(bJPEG ? 113 : 129);
+    const __m256i vr = _mm256_set1_epi16(bJPEG ? 179 : 204);
+    int x = 0;
+    for (; x+32 <= width; x += 32) {
+        // Luma unpacked per lane (pixels 0-7, 16-23 and 8-15, 24-31) matches the
+        // order of the per-lane chroma duplication in addLumaAVX2().
+        __m256i y = _mm256_loadu_si256((const __m256i*)(pY+x));
+        __m256i yLo = _mm256_unpacklo_epi8(y, zero);
+        __m256i yHi = _mm256_unpackhi_epi8(y, zero);
+        if (!bJPEG) {
+            yLo = _mm256_srli_epi16(
+                    _mm256_mullo_epi16(_mm256_subs_epu16(yLo, c16), c149), 7);
+            yHi = _mm256_srli_epi16(
+                    _mm256_mullo_epi16(_mm256_subs_epu16(yHi, c16), c149), 7);
+        }
+        __m256i u = _mm256_sub_epi16(_mm256_cvtepu8_epi16(
+                _mm_loadu_si128((const __m128i*)(pU+x/2))), c128);
+        __m256i v = _mm256_sub_epi16(_mm256_cvtepu8_epi16(
+                _mm_loadu_si128((const __m128i*)(pV+x/2))), c128);
+        __m256i r = _mm256_srai_epi16(_mm256_mullo_epi16(v, vr), 7);
+        __m256i g = _mm256_srai_epi16(_mm256_adds_epi16(
+                _mm256_mullo_epi16(u, ug), _mm256_mullo_epi16(v, vg)), 7);
+        __m256i b = _mm256_srai_epi16(_mm256_mullo_epi16(u, ub), 6);
+        storeBGRXAVX2(pDest+x*4, addLumaAVX2(b, yLo, yHi), addLumaAVX2(g, yLo, yHi),
+                addLumaAVX2(r, yLo, yHi));
+    }
+    return x;
+}
+
+AVG_TARGET_AVX2 inline __m256i setPairAVX2(short lo, short hi)
+{
+    return _mm256_set1_epi32((int)(((unsigned)(unsigned short)hi << 16) |
+            (unsigned short)lo));
+}
+
+AVG_TARGET_AVX2 inline __m256i clampToByteAVX2(__m256i val)
+{
+    return _mm256_min_epi16(_mm256_max_epi16(val, _mm256_setzero_si256()),
+            _mm256_set1_epi16(255));
+}
+
+// 16 pixels, see yuvToBGRXSSE2().
+AVG_TARGET_AVX2 inline void yuvToBGRXAVX2(unsigned char* pDest, __m256i y, __m256i u,
+        __m256i v)
+{
+    const __m256i bCoeffs = setPairAVX2(298, 516);
+    const __m256i guCoeffs = setPairAVX2(298, -100);
+    const __m256i gvCoeffs = setPairAVX2(0, -208);
+    const __m256i rCoeffs = setPairAVX2(298, 409);
+    __m256i yuLo = _mm256_unpacklo_epi16(y, u);   // Pixels 0-3, 8-11
+    __m256i yuHi = _mm256_unpackhi_epi16(y, u);   // Pixels 4-7, 12-15
+    __m256i yvLo = _mm256_unpacklo_epi16(y, v);
+    __m256i yvHi = _mm256_unpackhi_epi16(y, v);
+    // Packing per lane restores the pixel order.
+    __m256i b = _mm256_packs_epi32(
+            _mm256_srai_epi32(_mm256_madd_epi16(yuLo, bCoeffs), 8),
+            _mm256_srai_epi32(_mm256_madd_epi16(yuHi, bCoeffs), 8));
+    __m256i g = _mm256_packs_epi32(
+            _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yuLo, guCoeffs),
+                    _mm256_madd_epi16(yvLo, gvCoeffs)), 8),
+            _mm256_srai_epi32(_mm256_add_epi32(_mm256_madd_epi16(yuHi, guCoeffs),
+                    _mm256_madd_epi16(yvHi, gvCoeffs)), 8));
+    __m256i r = _mm256_packs_epi32(
+            _mm256_srai_epi32(_mm256_madd_epi16(yvLo, rCoeffs), 8),
+            _mm256_srai_epi32(_mm256_madd_epi16(yvHi, rCoeffs), 8));
+
+    __m256i bg = _mm256_or_si256(clampToByteAVX2(b),
+            _mm256_slli_epi16(clampToByteAVX2(g), 8));
+    __m256i ra = _mm256_or_si256(clampToByteAVX2(r), _mm256_set1_epi16(short(0xFF00)));
+    __m256i q0 = _mm256_unpacklo_epi16(bg, ra);   // Pixels 0-3, 8-11
+    __m256i q1 = _mm256_unpackhi_epi16(bg, ra);   // Pixels 4-7, 12-15
+    _mm256_storeu_si256((__m256i*)pDest, _mm256_permute2x128_si256(q0, q1, 0x20));
+    _mm256_storeu_si256((__m256i*)(pDest+32), _mm256_permute2x128_si256(q0, q1, 0x31));
+}
+
+AVG_TARGET_AVX2 int yuv422ToBGRXAVX2(const unsigned char* pSrc, unsigned char* pDest,
+        int numPairs, bool bUYVY)
+{
+    const __m256i lowBytes = _mm256_set1_epi16(0x00FF);
+    const __m256i evenWords = _mm256_set1_epi32(0x0000FFFF);
+    const __m256i c16 = _mm256_set1_epi16(16);
+    const __m256i c128 = _mm256_set1_epi16(128);
+    int i = 1;
+    for (; i+8 <= numPairs-1; i += 8) {
+        const unsigned char* pPair = pSrc+i*4;
+        __m256i cur = _mm256_loadu_si256((const __m256i*)pPair);
+        __m256i prev = _mm256_loadu_si256((const __m256i*)(pPair-4));
+        __m256i next = _mm256_loadu_si256((const __m256i*)(pPair+4));
+        __m256i y;
+        __m256i chroma;
+        __m256i prevChroma;
+        __m256i nextChroma;
+        if (bUYVY) {
+            y = _mm256_srli_epi16(cur, 8);
+            chroma = _mm256_and_si256(cur, lowBytes);
+            prevChroma = _mm256_and_si256(prev, lowBytes);
+            nextChroma = _mm256_and_si256(next, lowBytes);
+        } else {
+            y = _mm256_and_si256(cur, lowBytes);
+            chroma = _mm256_srli_epi16(cur, 8);
+            prevChroma = _mm256_srli_epi16(prev, 8);
+            nextChroma = _mm256_srli_epi16(next, 8);
+        }
+        // The byte shifts work per lane, but they only move values within a pair.
+        __m256i uAvg = _mm256_srli_epi16(_mm256_add_epi16(chroma, nextChroma), 1);
+        __m256i vAvg = _mm256_srli_epi16(_mm256_add_epi16(prevChroma, chroma), 1);
+        __m256i u = _mm256_or_si256(_mm256_and_si256(chroma, evenWords),
+                _mm256_andnot_si256(evenWords, _mm256_slli_si256(uAvg, 2)));
+        __m256i v = _mm256_or_si256(
+                _mm256_and_si256(_mm256_srli_si256(vAvg, 2), evenWords),
+                _mm256_andnot_si256(evenWords, chroma));
+        yuvToBGRXAVX2(pDest+i*8, _mm256_sub_epi16(y, c16), _mm256_sub_epi16(u, c128),
+                _mm256_sub_epi16(v, c128));
+    }
+    return i;
+}
+
+AVG_TARGET_AVX2 int yuyv422ToI8AVX2(const unsigned char* pSrc, unsigned char* pDest,
+        int width)
+{
+    const __m256i lowBytes = _mm256_set1_epi16(0x00FF);
+    int x = 0;
+    for (; x+32 < width; x += 32) {
+        __m256i lo = _mm256_loadu_si256((const __m256i*)(pSrc+x*2));
+        __m256i hi = _mm256_loadu_si256((const __m256i*)(pSrc+x*2+32));
+        __m256i packed = _mm256_packus_epi16(_mm256_and_si256(lo, lowBytes),
+                _mm256_and_si256(hi, lowBytes));
+        _mm256_storeu_si256((__m256i*)(pDest+x),
+                _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    return x;
+}
+
+AVG_TARGET_AVX2 int i8ToBGRXAVX2(const unsigned char* pSrc, unsigned char* pDest,
+        int width)
+{
+    int x = 0;
+    for (; x+32 <= width; x += 32) {
+        __m256i val = _mm256_loadu_si256((const __m256i*)(pSrc+x));
+        storeBGRXAVX2(pDest+x*4, val, val, val);
+    }
+    return x;
+}
+
+AVG_TARGET_AVX2 int i16ToI8AVX2(const unsigned short* pSrc, unsigned char* pDest,
+        int width)
+{
+    int x = 0;
+    for (; x+32 <= width; x += 32) {
+        __m256i lo = _mm256_loadu_si256((const __m256i*)(pSrc+x));
+        __m256i hi = _mm256_loadu_si256((const __m256i*)(pSrc+x+16));
+        __m256i packed = _mm256_packus_epi16(_mm256_srli_epi16(lo, 8),
+                _mm256_srli_epi16(hi, 8));
+        _mm256_storeu_si256((__m256i*)(pDest+x),
+                _mm256_permute4x64_epi64(packed, _MM_SHUFFLE(3, 1, 2, 0)));
+    }
+    return x;
+}
+
+AVG_TARGET_AVX2 int i8ToI16AVX2(const unsigned char* pSrc, unsigned short* pDest,
+        int width)
+{
+    int x = 0;
+    for (; x+32 <= width; x += 32) {
+        __m256i lo = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(pSrc+x)));
+        __m256i hi = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(pSrc+x+16)));
+        _mm256_storeu_si256((__m256i*)(pDest+x), _mm256_slli_epi16(lo, 8));
+        _mm256_storeu_si256((__m256i*)(pDest+x+16), _mm256_slli_epi16(hi, 8));
+    }
+    return x;
+}
+
+AVG_TARGET_AVX2 inline __m256i average4AVX2(__m256i a, __m256i b, __m256i c, __m256i d)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i two = _mm256_set1_epi16(2);
+    __m256i lo = _mm256_add_epi16(
+            _mm256_add_epi16(_mm256_unpacklo_epi8(a, zero), _mm256_unpacklo_epi8(b, zero)),
+            _mm256_add_epi16(_mm256_unpacklo_epi8(c, zero), _mm256_unpacklo_epi8(d, zero)));
+    __m256i hi = _mm256_add_epi16(
+            _mm256_add_epi16(_mm256_unpackhi_epi8(a, zero), _mm256_unpackhi_epi8(b, zero)),
+            _mm256_add_epi16(_mm256_unpackhi_epi8(c, zero), _mm256_unpackhi_epi8(d, zero)));
+    return _mm256_packus_epi16(_mm256_srli_epi16(_mm256_add_epi16(lo, two), 2),
+            _mm256_srli_epi16(_mm256_add_epi16(hi, two), 2));
+}
+
+AVG_TARGET_AVX2 int bayerBilinearAVX2(const unsigned char* pSrc, int srcStride,
+        unsigned char* pDest, int numPixels, bool bBlue)
+{
+    const __m256i colorMask = _mm256_set1_epi16(0x00FF);
+    int x = 0;
+    for (; x+32 <= numPixels; x += 32) {
+        const unsigned char* pAbove = pSrc+x;
+        const unsigned char* pCur = pAbove+srcStride;
+        const unsigned char* pBelow = pCur+srcStride;
+        __m256i above0 = _mm256_loadu_si256((const __m256i*)pAbove);
+        __m256i above1 = _mm256_loadu_si256((const __m256i*)(pAbove+1));
+        __m256i above2 = _mm256_loadu_si256((const __m256i*)(pAbove+2));
+        __m256i cur0 = _mm256_loadu_si256((const __m256i*)pCur);
+        __m256i cur1 = _mm256_loadu_si256((const __m256i*)(pCur+1));
+        __m256i cur2 = _mm256_loadu_si256((const __m256i*)(pCur+2));
+        __m256i below0 = _mm256_loadu_si256((const __m256i*)pBelow);
+        __m256i below1 = _mm256_loadu_si256((const __m256i*)(pBelow+1));
+        __m256i below2 = _mm256_loadu_si256((const __m256i*)(pBelow+2));
+
+        __m256i diagonal = average4AVX2(above0, above2, below0, below2);
+        __m256i cross = average4AVX2(above1, cur0, cur2, below1);
+        __m256i vertical = _mm256_avg_epu8(above1, below1);
+        __m256i horizontal = _mm256_avg_epu8(cur0, cur2);
+
+        __m256i green = _mm256_blendv_epi8(cur1, cross, colorMask);
+        __m256i sampled = _mm256_blendv_epi8(horizontal, cur1, colorMask);
+        __m256i interpolated = _mm256_blendv_epi8(vertical, diagonal, colorMask);
+        if (bBlue) {
+            storeBGRXAVX2(pDest+x*4, interpolated, green, sampled);
+        } else {
+            storeBGRXAVX2(pDest+x*4, sampled, green, interpolated);
+        }
+    }
+    return x;
+}
+
+#endif
+
+#ifdef AVG_SIMD_NEON
+
+int yuv420ToBGRXNEON(const unsigned char* pY, const unsigned char* pU,
+        const unsigned char* pV, unsigned char* pDest, int width, bool bJPEG)
+{
+    const int16x8_t c128 = vdupq_n_s16(128);
+    const int16x8_t ug = vdupq_n_s16(bJPEG ? -44 : -50);
+    const int16x8_t vg = vdupq_n_s16(bJPEG ? -91 : -104);
+    const int16x8_t ub = vdupq_n_s16(bJPEG ? 113 : 129);
+    const int16x8_t vr = vdupq_n_s16(bJPEG ? 179 : 204);
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        uint8x16_t y = vld1q_u8(pY+x);
+        uint16x8_t yLo = vmovl_u8(vget_low_u8(y));
+        uint16x8_t yHi = vmovl_u8(vget_high_u8(y));
+        if (!bJPEG) {
+            const uint16x8_t c16 = vdupq_n_u16(16);
+            const uint16x8_t c149 = vdupq_n_u16(149);
+            yLo = vshrq_n_u16(vmulq_u16(vqsubq_u16(yLo, c16), c149), 7);
+            yHi = vshrq_n_u16(vmulq_u16(vqsubq_u16(yHi, c16), c149), 7);
+        }
+        int16x8_t u = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(pU+x/2))), c128);
+        int16x8_t v = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(vld1_u8(pV+x/2))), c128);
+        int16x8_t chroma[3];
+        chroma[0] = vshrq_n_s16(vmulq_s16(u, ub), 6);
+        chroma[1] = vshrq_n_s16(vqaddq_s16(vmulq_s16(u, ug), vmulq_s16(v, vg)), 7);
+        chroma[2] = vshrq_n_s16(vmulq_s16(v, vr), 7);
+        uint8x16x4_t pixels;
+        for (int i = 0; i < 3; ++i) {
+            // Every chroma value covers two pixels.
+            int16x8x2_t doubled = vzipq_s16(chroma[i], chroma[i]);
+            pixels.val[i] = vcombine_u8(
+                    vqmovun_s16(vqaddq_s16(doubled.val[0], vreinterpretq_s16_u16(yLo))),
+                    vqmovun_s16(vqaddq_s16(doubled.val[1], vreinterpretq_s16_u16(yHi))));
+        }
+        pixels.val[3] = vdupq_n_u8(255);
+        vst4q_u8(pDest+x*4, pixels);
+    }
+    return x;
+}
+
+inline uint8x8_t shiftAndClampNEON(int32x4_t lo, int32x4_t hi)
+{
+    return vqmovun_s16(vcombine_s16(vqmovn_s32(vshrq_n_s32(lo, 8)),
+            vqmovn_s32(vshrq_n_s32(hi, 8))));
+}
+
+// 8 pixels, see YUVtoBGR32Pixel(). Returns b, g and r.
+inline uint8x8x3_t yuvToBGRNEON(uint8x8_t y, uint8x8_t u, uint8x8_t v)
+{
+    int16x8_t ys = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(y)), vdupq_n_s16(16));
+    int16x8_t us = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(u)), vdupq_n_s16(128));
+    int16x8_t vs = vsubq_s16(vreinterpretq_s16_u16(vmovl_u8(v)), vdupq_n_s16(128));
+    int32x4_t yLo = vmull_n_s16(vget_low_s16(ys), 298);
+    int32x4_t yHi = vmull_n_s16(vget_high_s16(ys), 298);
+    uint8x8x3_t bgr;
+    bgr.val[0] = shiftAndClampNEON(vmlal_n_s16(yLo, vget_low_s16(us), 516),
+            vmlal_n_s16(yHi, vget_high_s16(us), 516));
+    bgr.val[1] = shiftAndClampNEON(
+            vmlal_n_s16(vmlal_n_s16(yLo, vget_low_s16(us), -100), vget_low_s16(vs), -208),
+            vmlal_n_s16(vmlal_n_s16(yHi, vget_high_s16(us), -100), vget_high_s16(vs),
+                    -208));
+    bgr.val[2] = shiftAndClampNEON(vmlal_n_s16(yLo, vget_low_s16(vs), 409),
+            vmlal_n_s16(yHi, vget_high_s16(vs), 409));
+    return bgr;
+}
+
+int yuv422ToBGRXNEON(const unsigned char* pSrc, unsigned char* pDest, int numPairs,
+        bool bUYVY)
+{
+    int yIdx = bUYVY ? 1 : 0;
+    int uIdx = bUYVY ? 0 : 1;
+    int i = 1;
+    for (; i+8 <= numPairs-1; i += 8) {
+        const unsigned char* pPair = pSrc+i*4;
+        // De-interleaves 8 pairs into y0, u, y1, v (YUYV) or u, y0, v, y1 (UYVY).
+        uint8x8x4_t cur = vld4_u8(pPair);
+        uint8x8x4_t prev = vld4_u8(pPair-4);
+        uint8x8x4_t next = vld4_u8(pPair+4);
+        uint8x8_t u = cur.val[uIdx];
+        uint8x8_t v = cur.val[uIdx+2];
+        uint8x8x3_t even = yuvToBGRNEON(cur.val[yIdx], u,
+                vhadd_u8(prev.val[uIdx+2], v));
+        uint8x8x3_t odd = yuvToBGRNEON(cur.val[yIdx+2], vhadd_u8(u, next.val[uIdx]), v);
+        uint8x16x4_t pixels;
+        for (int j = 0; j < 3; ++j) {
+            uint8x8x2_t zipped = vzip_u8(even.val[j], odd.val[j]);
+            pixels.val[j] = vcombine_u8(zipped.val[0], zipped.val[1]);
+        }
+        pixels.val[3] = vdupq_n_u8(255);
+        vst4q_u8(pDest+i*8, pixels);
+    }
+    return i;
+}
+
+int yuyv422ToI8NEON(const unsigned char* pSrc, unsigned char* pDest, int width)
+{
+    int x = 0;
+    for (; x+16 < width; x += 16) {
+        vst1q_u8(pDest+x, vld2q_u8(pSrc+x*2).val[0]);
+    }
+    return x;
+}
+
+int i8ToBGRXNEON(const unsigned char* pSrc, unsigned char* pDest, int width)
+{
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        uint8x16x4_t pixels;
+        pixels.val[0] = vld1q_u8(pSrc+x);
+        pixels.val[1] = pixels.val[0];
+        pixels.val[2] = pixels.val[0];
+        pixels.val[3] = vdupq_n_u8(255);
+        vst4q_u8(pDest+x*4, pixels);
+    }
+    return x;
+}
+
+int i16ToI8NEON(const unsigned short* pSrc, unsigned char* pDest, int width)
+{
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        vst1q_u8(pDest+x, vcombine_u8(vshrn_n_u16(vld1q_u16(pSrc+x), 8),
+                vshrn_n_u16(vld1q_u16(pSrc+x+8), 8)));
+    }
+    return x;
+}
+
+int i8ToI16NEON(const unsigned char* pSrc, unsigned short* pDest, int width)
+{
+    int x = 0;
+    for (; x+16 <= width; x += 16) {
+        uint8x16_t val = vld1q_u8(pSrc+x);
+        vst1q_u16(pDest+x, vshll_n_u8(vget_low_u8(val), 8));
+        vst1q_u16(pDest+x+8, vshll_n_u8(vget_high_u8(val), 8));
+    }
+    return x;
+}
+
+inline uint8x16_t average4NEON(uint8x16_t a, uint8x16_t b, uint8x16_t c, uint8x16_t d)
+{
+    uint16x8_t lo = vaddq_u16(vaddl_u8(vget_low_u8(a), vget_low_u8(b)),
+            vaddl_u8(vget_low_u8(c), vget_low_u8(d)));
+    uint16x8_t hi = vaddq_u16(vaddl_u8(vget_high_u8(a), vget_high_u8(b)),
+            vaddl_u8(vget_high_u8(c), vget_high_u8(d)));
+    // Rounding shift: (sum+2) >> 2.
+    return vcombine_u8(vrshrn_n_u16(lo, 2), vrshrn_n_u16(hi, 2));
+}
+
+int bayerBilinearNEON(const unsigned char* pSrc, int srcStride, unsigned char* pDest,
+        int numPixels, bool bBlue)
+{
+    const uint8x16_t colorMask = vreinterpretq_u8_u16(vdupq_n_u16(0x00FF));
+    int x = 0;
+    for (; x+16 <= numPixels; x += 16) {
+        const unsigned char* pAbove = pSrc+x;
+        const unsigned char* pCur = pAbove+srcStride;
+        const unsigned char* pBelow = pCur+srcStride;
+        uint8x16_t above1 = vld1q_u8(pAbove+1);
+        uint8x16_t cur0 = vld1q_u8(pCur);
+        uint8x16_t cur1 = vld1q_u8(pCur+1);
+        uint8x16_t cur2 = vld1q_u8(pCur+2);
+        uint8x16_t below1 = vld1q_u8(pBelow+1);
+
+        uint8x16_t diagonal = average4NEON(vld1q_u8(pAbove), vld1q_u8(pAbove+2),
+                vld1q_u8(pBelow), vld1q_u8(pBelow+2));
+        uint8x16_t cross = average4NEON(above1, cur0, cur2, below1);
+        // vrhaddq: (a+b+1) >> 1.
+        uint8x16_t vertical = vrhaddq_u8(above1, below1);
+        uint8x16_t horizontal = vrhaddq_u8(cur0, cur2);
+
+        uint8x16x4_t pixels;
+        uint8x16_t sampled = vbslq_u8(colorMask, cur1, horizontal);
+        uint8x16_t interpolated = vbslq_u8(colorMask, diagonal, vertical);
+        pixels.val[0] = bBlue ? interpolated : sampled;
+        pixels.val[1] = vbslq_u8(colorMask, cross, cur1);
+        pixels.val[2] = bBlue ? sampled : interpolated;
+        pixels.val[3] = vdupq_n_u8(255);
+        vst4q_u8(pDest+x*4, pixels);
+    }
+    return x;
+}
+
+#endif
+
+}
+
+void convertYUV420ToBGRXLine(const unsigned char* pY, const unsigned char* pU,
+        const unsigned char* pV, unsigned char* pDest, int width, bool bJPEG)
+{
+    int x = 0;
+    switch (getSIMDLevel()) {
+#ifdef AVG_SIMD_X86
+        case SIMD_AVX2:
+            x = yuv420ToBGRXAVX2(pY, pU, pV, pDest, width, bJPEG);
+            break;
+        case SIMD_SSE2:
+            x = yuv420ToBGRXSSE2(pY, pU, pV, pDest, width, bJPEG);
+            break;
+#endif
+#ifdef AVG_SIMD_NEON
+        case SIMD_NEON:
+            x = yuv420ToBGRXNEON(pY, pU, pV, pDest, width, bJPEG);
+            break;
+#endif
+        default:
+            break;
+    }
+    yuv420ToBGRXScalar(pY, pU, pV, pDest, x, width, bJPEG);
+}
+
+void convertYUV422ToBGRXLine(const unsigned char* pSrc, unsigned char* pDest,
+        int width, bool bUYVY)
+{
+    int numPairs = width/2;
+    if (numPairs == 0) {
+        return;
+    }
+    // The first and last pairs need special treatment, so they're always converted
+    // by the scalar code.
+    yuv422ToBGRXScalar(pSrc, pDest, 0, std::min(1, numPairs-1), bUYVY);
+    int i = 1;
+    switch (getSIMDLevel()) {
+#ifdef AVG_SIMD_X86
+        case SIMD_AVX2:
+            i = yuv422ToBGRXAVX2(pSrc, pDest, numPairs, bUYVY);
+            break;
+        case SIMD_SSE2:
+            i = yuv422ToBGRXSSE2(pSrc, pDest, numPairs, bUYVY);
+            break;
+#endif
+#ifdef AVG_SIMD_NEON
+        case SIMD_NEON:
+            i = yuv422ToBGRXNEON(pSrc, pDest, numPairs, bUYVY);
+            break;
+#endif
+        default:
+            break;
+    }
+    yuv422ToBGRXScalar(pSrc, pDest, i, numPairs-1, bUYVY);
+    yuv422LastPairToBGRX(pSrc, pDest, numPairs, bUYVY);
+}
+
+void convertYUYV422ToI8Line(const unsigned char* pSrc, unsigned char* pDest, int width)
+{
+    int x = 0;
+    switch (getSIMDLevel()) {
+#ifdef AVG_SIMD_X86
+        case SIMD_AVX2:
+            x = yuyv422ToI8AVX2(pSrc, pDest, width);
+            break;
+        case SIMD_SSE2:
+            x = yuyv422ToI8SSE2(pSrc, pDest, width);
+            break;
+#endif
+#ifdef AVG_SIMD_NEON
+        case SIMD_NEON:
+            x = yuyv422ToI8NEON(pSrc, pDest, width);
+            break;
+#endif
+        default:
+            break;
+    }
+    for (; x < width; ++x) {
+        pDest[x] = pSrc[x*2];
+    }
+}
+
+void convertI8ToBGRXLine(const unsigned char* pSrc, unsigned char* pDest, int width)
+{
+    int x = 0;
+    switch (getSIMDLevel()) {
+#ifdef AVG_SIMD_X86
+        case SIMD_AVX2:
+            x = i8ToBGRXAVX2(pSrc, pDest, width);
+            break;
+        case SIMD_SSE2:
+            x = i8ToBGRXSSE2(pSrc, pDest, width);
+            break;
+#endif
+#ifdef AVG_SIMD_NEON
+        case SIMD_NEON:
+            x = i8ToBGRXNEON(pSrc, pDest, width);
+            break;
+#endif
+        default:
+            break;
+    }
+    for (; x < width; ++x) {
+        unsigned char* pPixel = pDest+x*4;
+        pPixel[0] = pSrc[x];
+        pPixel[1] = pSrc[x];
+        pPixel[2] = pSrc[x];
+        pPixel[3] = 255;
+    }
+}
+
+void convertI16ToI8Line(const unsigned short* pSrc, unsigned char* pDest, int width)
+{
+    int x = 0;
+    switch (getSIMDLevel()) {
+#ifdef AVG_SIMD_X86
+        case SIMD_AVX2:
+            x = i16ToI8AVX2(pSrc, pDest, width);
+            break;
+        case SIMD_SSE2:
+            x = i16ToI8SSE2(pSrc, pDest, width);
+            break;
+#endif
+#ifdef AVG_SIMD_NEON
+        case SIMD_NEON:
+            x = i16ToI8NEON(pSrc, pDest, width);
+            break;
+#endif
+        default:
+            break;
+    }
+    for (; x < width; ++x) {
+        pDest[x] = pSrc[x] >> 8;
+    }
+}
+
+void convertI8ToI16Line(const unsigned char* pSrc, unsigned short* pDest, int width)
+{
+    int x = 0;
+    switch (getSIMDLevel()) {
+#ifdef AVG_SIMD_X86
+        case SIMD_AVX2:
+            x = i8ToI16AVX2(pSrc, pDest, width);
+            break;
+        case SIMD_SSE2:
+            x = i8ToI16SSE2(pSrc, pDest, width);
+            break;
+#endif
+#ifdef AVG_SIMD_NEON
+        case SIMD_NEON:
+            x = i8ToI16NEON(pSrc, pDest, width);
+            break;
+#endif
+        default:
+            break;
+    }
+    for (; x < width; ++x) {
+        pDest[x] = pSrc[x] << 8;
+    }
+}
+
+// Code has been taken and adapted from libdc1394 Bayer conversion
+// Original source is OpenCV Bayer pattern decoding
+void convertBayerLineBilinear(const unsigned char* pSrc, int srcStride,
+        unsigned char* pDest, int width, bool bBlue, bool bGreenFirst)
+{
+    if (width <= 0) {
+        return;
+    }
+    int blue = bBlue ? 1 : -1;
+    const unsigned char* pSrcPixel = pSrc;
+    const unsigned char* pSrcEndBoundary = pSrc + width;
+    unsigned char* pDestPixel = pDest + 1;
+
+    if (bGreenFirst) {
+        bayerGreenPixel(pSrcPixel, srcStride, pDestPixel, blue);
+        ++pSrcPixel;
+        pDestPixel += 4;
+    }
+
+    int numPixels = int(pSrcEndBoundary - pSrcPixel);
+    int x = 0;
+    switch (getSIMDLevel()) {
+#ifdef AVG_SIMD_X86
+        case SIMD_AVX2:
+            x = bayerBilinearAVX2(pSrcPixel, srcStride, pDestPixel-1, numPixels, bBlue);
+            break;
+        case SIMD_SSE2:
+            x = bayerBilinearSSE2(pSrcPixel, srcStride, pDestPixel-1, numPixels, bBlue);
+            break;
+#endif
+#ifdef AVG_SIMD_NEON
+        case SIMD_NEON:
+            x = bayerBilinearNEON(pSrcPixel, srcStride, pDestPixel-1, numPixels, bBlue);
+            break;
+#endif
+        default:
+            break;
+    }
+    pSrcPixel += x;
+    pDestPixel += x*4;
+
+    while (pSrcPixel <= pSrcEndBoundary - 2) {
+        bayerColorPixel(pSrcPixel, srcStride, pDestPixel, blue);
+        bayerGreenPixel(pSrcPixel+1, srcStride, pDestPixel+4, blue);
+        pSrcPixel += 2;
+        pDestPixel += 8;
+    }
+    if (pSrcPixel < pSrcEndBoundary) {
+        bayerColorPixel(pSrcPixel, srcStride, pDestPixel, blue);
+    }
+}
+
+}
@@ -0,0 +1,66 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _PixelConversion_H_
+#define _PixelConversion_H_
+
+#include "../api.h"
+
+namespace avg {
+
+// Line kernels for the pixel format conversions in Bitmap. Every kernel has a
+// scalar version and SSE2, AVX2 and NEON versions that produce bit-identical
+// results; the version used is selected at runtime via getSIMDLevel().
+// All 32-bit destinations are written in B, G, R, 255 byte order.
+
+// Planar 4:2:0 YCbCr to 32 bit. pU and pV point to the chroma lines belonging to
+// pY. Uses the fixed-point coefficients of the former MMX code.
+AVG_API void convertYUV420ToBGRXLine(const unsigned char* pY, const unsigned char* pU,
+        const unsigned char* pV, unsigned char* pDest, int width, bool bJPEG);
+
+// Packed 4:2:2 YCbCr to 32 bit, interpolating chroma between samples.
+// bUYVY selects UYVY (YCbCr422) instead of YUYV byte order.
+AVG_API void convertYUV422ToBGRXLine(const unsigned char* pSrc, unsigned char* pDest,
+        int width, bool bUYVY);
+
+// Extracts every second byte: the luminance channel of a YUYV line. Pass pSrc+1
+// for UYVY.
+AVG_API void convertYUYV422ToI8Line(const unsigned char* pSrc, unsigned char* pDest,
+        int width);
+
+AVG_API void convertI8ToBGRXLine(const unsigned char* pSrc, unsigned char* pDest,
+        int width);
+AVG_API void convertI16ToI8Line(const unsigned short* pSrc, unsigned char* pDest,
+        int width);
+AVG_API void convertI8ToI16Line(const unsigned char* pSrc, unsigned short* pDest,
+        int width);
+
+// Bilinear bayer pattern demosaicking of one line. pSrc points to the first pixel
+// of the source line above the one converted, pDest to the second pixel of the
+// destination line. width is the number of pixels written, i.e. the bitmap width
+// minus 2. bBlue and bGreenFirst describe the pattern at the start of the line.
+AVG_API void convertBayerLineBilinear(const unsigned char* pSrc, int srcStride,
+        unsigned char* pDest, int width, bool bBlue, bool bGreenFirst);
+
+}
+
+#endif
@@ -0,0 +1,148 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "SkylinePacker.h"
+
+#include "../base/Exception.h"
+
+using namespace std;
+
+namespace avg {
+
+SkylinePacker::Segment::Segment(int x, int y, int width)
+    : m_X(x),
+      m_Y(y),
+      m_Width(width)
+{
+}
+
+SkylinePacker::SkylinePacker(const IntPoint& size)
+    : m_Size(size)
+{
+    AVG_ASSERT(size.x > 0 && size.y > 0);
+    reset();
+}
+
+SkylinePacker::~SkylinePacker()
+{
+}
+
+bool SkylinePacker::insert(const IntPoint& size, IntPoint& pos)
+{
+    AVG_ASSERT(size.x > 0 && size.y > 0);
+    int bestIndex = -1;
+    int bestTop = m_Size.y+1;
+    int bestWidth = m_Size.x+1;
+    for (unsigned i = 0; i < m_Skyline.size(); ++i) {
+        int y;
+        if (fits(i, size, y)) {
+            // Prefer the lowest position; on ties, the narrowest segment.
+            int top = y+size.y;
+            if (top < bestTop || (top == bestTop && m_Skyline[i].m_Width < bestWidth)) {
+                bestIndex = i;
+                bestTop = top;
+                bestWidth = m_Skyline[i].m_Width;
+                pos = IntPoint(m_Skyline[i].m_X, y);
+            }
+        }
+    }
+    if (bestIndex == -1) {
+        return false;
+    }
+    addSegment(bestIndex, pos, size);
+    m_UsedArea += (long long)(size.x)*size.y;
+    return true;
+}
+
+void SkylinePacker::reset()
+{
+    m_Skyline.clear();
+    m_Skyline.push_back(Segment(0, 0, m_Size.x));
+    m_UsedArea = 0;
+}
+
+const IntPoint& SkylinePacker::getSize() const
+{
+    return m_Size;
+}
+
+long long SkylinePacker::getUsedArea() const
+{
+    return m_UsedArea;
+}
+
+bool SkylinePacker::fits(unsigned i, const IntPoint& size, int& y) const
+{
+    int x = m_Skyline[i].m_X;
+    if (x+size.x > m_Size.x) {
+        return false;
+    }
+    // The rectangle rests on the highest segment it spans.
+    int widthLeft = size.x;
+    y = m_Skyline[i].m_Y;
+    while (widthLeft > 0) {
+        AVG_ASSERT(i < m_Skyline.size());
+        y = max(y, m_Skyline[i].m_Y);
+        if (y+size.y > m_Size.y) {
+            return false;
+        }
+        widthLeft -= m_Skyline[i].m_Width;
+        i++;
+    }
+    return true;
+}
+
+void SkylinePacker::addSegment(unsigned i, const IntPoint& pos, const IntPoint& size)
+{
+    m_Skyline.insert(m_Skyline.begin()+i, Segment(pos.x, pos.y+size.y, size.x));
+
+    // Shrink or remove the segments now covered by the new one.
+    unsigned j = i+1;
+    while (j < m_Skyline.size()) {
+        const Segment& prev = m_Skyline[j-1];
+        Segment& cur = m_Skyline[j];
+        int overlap = prev.m_X+prev.m_Width - cur.m_X;
+        if (overlap <= 0) {
+            break;
+        }
+        cur.m_X += overlap;
+        cur.m_Width -= overlap;
+        if (cur.m_Width <= 0) {
+            m_Skyline.erase(m_Skyline.begin()+j);
+        } else {
+            break;
+        }
+    }
+
+    // Merge neighbouring segments at the same height.
+    j = 0;
+    while (j+1 < m_Skyline.size()) {
+        if (m_Skyline[j].m_Y == m_Skyline[j+1].m_Y) {
+            m_Skyline[j].m_Width += m_Skyline[j+1].m_Width;
+            m_Skyline.erase(m_Skyline.begin()+j+1);
+        } else {
+            j++;
+        }
+    }
+}
+
+}
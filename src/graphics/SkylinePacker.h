@@ -0,0 +1,67 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _SkylinePacker_H_
+#define _SkylinePacker_H_
+
+#include "../api.h"
+
+#include "../base/GLMHelper.h"
+
+#include <vector>
+
+namespace avg {
+
+// Packs rectangles into a fixed-size area using the skyline bottom-left heuristic. 
+// Rectangles can't be removed individually; reset() frees the complete area.
+class AVG_API SkylinePacker
+{
+public:
+    SkylinePacker(const IntPoint& size);
+    virtual ~SkylinePacker();
+
+    bool insert(const IntPoint& size, IntPoint& pos);
+    void reset();
+
+    const IntPoint& getSize() const;
+    long long getUsedArea() const;
+
+private:
+    struct Segment {
+        Segment(int x, int y, int width);
+
+        int m_X;
+        int m_Y;
+        int m_Width;
+    };
+
+    bool fits(unsigned i, const IntPoint& size, int& y) const;
+    void addSegment(unsigned i, const IntPoint& pos, const IntPoint& size);
+
+    IntPoint m_Size;
+    std::vector<Segment> m_Skyline;
+    long long m_UsedArea;
+};
+
+}
+
+#endif
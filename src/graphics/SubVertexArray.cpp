@@ -55,6 +55,13 @@ void SubVertexArray::init(VertexArray* pVertexArray, unsigned startVertex,
     m_NumIndexes = 0;
 }
 
+void SubVertexArray::setPos(int vertex, const glm::vec2& pos, 
+        const glm::vec2& texPos, const Pixel32& color)
+{
+    AVG_ASSERT(vertex < m_NumVerts);
+    m_pVA->setPos(m_StartVertex+vertex, pos, texPos, color);
+}
+
 void SubVertexArray::appendTriIndexes(int v0, int v1, int v2)
 {
     m_pVA->appendTriIndexes(v0+m_StartVertex, v1+m_StartVertex, v2+m_StartVertex);
@@ -87,6 +94,21 @@ int SubVertexArray::getNumVerts() const
     return m_NumVerts;
 }
 
+int SubVertexArray::getNumIndexes() const
+{
+    return m_NumIndexes;
+}
+
+unsigned SubVertexArray::getStartVertex() const
+{
+    return m_StartVertex;
+}
+
+unsigned SubVertexArray::getStartIndex() const
+{
+    return m_StartIndex;
+}
+
 void SubVertexArray::draw()
 {
     m_pVA->draw(m_StartIndex, m_NumIndexes, m_StartVertex, m_StartIndex);
@@ -41,12 +41,18 @@ public:
 
     void appendPos(const glm::vec2& pos, 
             const glm::vec2& texPos, const Pixel32& color = Pixel32(0,0,0,0));
+    // vertex is relative to the start of the SubVertexArray.
+    void setPos(int vertex, const glm::vec2& pos, 
+            const glm::vec2& texPos, const Pixel32& color = Pixel32(0,0,0,0));
     void appendTriIndexes(int v0, int v1, int v2);
     void appendQuadIndexes(int v0, int v1, int v2, int v3);
     void addLineData(Pixel32 color, const glm::vec2& p1, const glm::vec2& p2, 
             float width, float tc1=0, float tc2=1);
     void appendVertexData(VertexDataPtr pVertexes);
     int getNumVerts() const;
+    int getNumIndexes() const;
+    unsigned getStartVertex() const;
+    unsigned getStartIndex() const;
 
     void draw();
     void dump() const;
@@ -0,0 +1,386 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "TextureAtlas.h"
+
+#include "Bitmap.h"
+#include "MCTexture.h"
+#include "GLContextManager.h"
+
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+#include "../base/ObjectCounter.h"
+
+#include <algorithm>
+#include <iostream>
+#include <string.h>
+
+using namespace std;
+
+namespace avg {
+
+static IntRect addBorder(const IntRect& rect)
+{
+    return IntRect(rect.tl-IntPoint(1,1), rect.br+IntPoint(1,1));
+}
+
+static long long getArea(const IntRect& rect)
+{
+    return (long long)(rect.width())*rect.height();
+}
+
+// Copies srcBmp to pos and duplicates its edge pixels into the surrounding border.
+static void copyWithBorder(Bitmap& destBmp, const IntPoint& pos, const Bitmap& srcBmp)
+{
+    IntPoint size = srcBmp.getSize();
+    Bitmap destRegion(destBmp, IntRect(pos, pos+size));
+    destRegion.copyPixels(srcBmp);
+
+    int bpp = destBmp.getBytesPerPixel();
+    int stride = destBmp.getStride();
+    unsigned char* pPixels = destBmp.getPixels();
+    for (int y = pos.y; y < pos.y+size.y; ++y) {
+        unsigned char* pLine = pPixels+size_t(y)*stride;
+        memcpy(pLine+(pos.x-1)*bpp, pLine+pos.x*bpp, bpp);
+        memcpy(pLine+(pos.x+size.x)*bpp, pLine+(pos.x+size.x-1)*bpp, bpp);
+    }
+    int lineLen = (size.x+2)*bpp;
+    unsigned char* pLeft = pPixels+(pos.x-1)*bpp;
+    memcpy(pLeft+size_t(pos.y-1)*stride, pLeft+size_t(pos.y)*stride, lineLen);
+    memcpy(pLeft+size_t(pos.y+size.y)*stride, pLeft+size_t(pos.y+size.y-1)*stride,
+            lineLen);
+}
+
+static bool isTaller(const TextureAtlasRegion* pRegion1, 
+        const TextureAtlasRegion* pRegion2)
+{
+    IntPoint size1 = pRegion1->getRect().size();
+    IntPoint size2 = pRegion2->getRect().size();
+    if (size1.y != size2.y) {
+        return size1.y > size2.y;
+    } else {
+        return size1.x > size2.x;
+    }
+}
+
+
+TextureAtlasRegion::TextureAtlasRegion(TextureAtlasPagePtr pPage, const IntRect& rect)
+    : m_pPage(pPage),
+      m_Rect(rect),
+      m_Version(0)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+    m_pPage->addRegion(this);
+}
+
+TextureAtlasRegion::~TextureAtlasRegion()
+{
+    m_pPage->removeRegion(this);
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+MCTexturePtr TextureAtlasRegion::getTex() const
+{
+    return m_pPage->getTex();
+}
+
+const IntRect& TextureAtlasRegion::getRect() const
+{
+    return m_Rect;
+}
+
+FRect TextureAtlasRegion::getTexCoordRect() const
+{
+    glm::vec2 texSize(m_pPage->getTex()->getGLSize());
+    return FRect(m_Rect.tl.x/texSize.x, m_Rect.tl.y/texSize.y, 
+            m_Rect.br.x/texSize.x, m_Rect.br.y/texSize.y);
+}
+
+int TextureAtlasRegion::getVersion() const
+{
+    return m_Version;
+}
+
+int TextureAtlasRegion::getMemNeeded() const
+{
+    return int(getArea(addBorder(m_Rect)))*getBytesPerPixel(m_pPage->getPixelFormat());
+}
+
+void TextureAtlasRegion::move(const IntRect& rect)
+{
+    m_Rect = rect;
+    m_Version++;
+}
+
+
+TextureAtlasPage::TextureAtlasPage(const IntPoint& size, PixelFormat pf)
+    : m_Size(size),
+      m_PF(pf),
+      m_Packer(size),
+      m_UsedArea(0)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+    AVG_TRACE(Logger::category::MEMORY, Logger::severity::INFO, 
+            "Creating texture atlas page: " << size << ", " << getPixelFormatString(pf));
+    m_pBmp = BitmapPtr(new Bitmap(size, pf, "texture atlas"));
+    m_pTex = GLContextManager::get()->createTexture(size, pf);
+}
+
+TextureAtlasPage::~TextureAtlasPage()
+{
+    AVG_ASSERT(m_pRegions.empty());
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+bool TextureAtlasPage::insert(const BitmapPtr& pBmp, IntRect& rect)
+{
+    AVG_ASSERT(pBmp->getPixelFormat() == m_PF);
+    IntPoint size = pBmp->getSize();
+    IntPoint pos;
+    if (!m_Packer.insert(size+IntPoint(2,2), pos)) {
+        return false;
+    }
+    rect = IntRect(pos+IntPoint(1,1), pos+IntPoint(1,1)+size);
+    copyWithBorder(*m_pBmp, rect.tl, *pBmp);
+    scheduleUpload();
+    return true;
+}
+
+bool TextureAtlasPage::defragment()
+{
+    // Repacking the largest images first packs considerably tighter.
+    vector<TextureAtlasRegion*> pRegions = m_pRegions;
+    sort(pRegions.begin(), pRegions.end(), isTaller);
+    SkylinePacker packer(m_Size);
+    vector<IntRect> newRects;
+    for (unsigned i = 0; i < pRegions.size(); ++i) {
+        IntPoint size = pRegions[i]->getRect().size();
+        IntPoint pos;
+        if (!packer.insert(size+IntPoint(2,2), pos)) {
+            return false;
+        }
+        newRects.push_back(IntRect(pos+IntPoint(1,1), pos+IntPoint(1,1)+size));
+    }
+
+    BitmapPtr pNewBmp(new Bitmap(m_Size, m_PF, "texture atlas"));
+    for (unsigned i = 0; i < pRegions.size(); ++i) {
+        Bitmap srcBmp(*m_pBmp, addBorder(pRegions[i]->getRect()));
+        Bitmap destBmp(*pNewBmp, addBorder(newRects[i]));
+        destBmp.copyPixels(srcBmp);
+        pRegions[i]->move(newRects[i]);
+    }
+    m_pBmp = pNewBmp;
+    m_Packer = packer;
+    scheduleUpload();
+    return true;
+}
+
+void TextureAtlasPage::addRegion(TextureAtlasRegion* pRegion)
+{
+    m_pRegions.push_back(pRegion);
+    m_UsedArea += getArea(addBorder(pRegion->getRect()));
+}
+
+void TextureAtlasPage::removeRegion(TextureAtlasRegion* pRegion)
+{
+    vector<TextureAtlasRegion*>::iterator it = 
+            find(m_pRegions.begin(), m_pRegions.end(), pRegion);
+    AVG_ASSERT(it != m_pRegions.end());
+    m_pRegions.erase(it);
+    m_UsedArea -= getArea(addBorder(pRegion->getRect()));
+}
+
+MCTexturePtr TextureAtlasPage::getTex() const
+{
+    return m_pTex;
+}
+
+PixelFormat TextureAtlasPage::getPixelFormat() const
+{
+    return m_PF;
+}
+
+const IntPoint& TextureAtlasPage::getSize() const
+{
+    return m_Size;
+}
+
+int TextureAtlasPage::getNumRegions() const
+{
+    return int(m_pRegions.size());
+}
+
+long long TextureAtlasPage::getUsedArea() const
+{
+    return m_UsedArea;
+}
+
+long long TextureAtlasPage::getWastedArea() const
+{
+    return m_Packer.getUsedArea() - m_UsedArea;
+}
+
+void TextureAtlasPage::scheduleUpload()
+{
+    // Several changes in one frame result in a single upload.
+    GLContextManager::get()->scheduleTexUpload(m_pTex, m_pBmp);
+}
+
+
+TextureAtlas::TextureAtlas(int pageSize, int maxImageSize)
+    : m_PageSize(pageSize),
+      m_MaxImageSize(maxImageSize),
+      m_NumDefragmentations(0)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+    if (maxImageSize+2 > pageSize) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE, 
+                "TextureAtlas: maximum image size must be smaller than page size.");
+    }
+}
+
+TextureAtlas::~TextureAtlas()
+{
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+int TextureAtlas::getPageSize() const
+{
+    return m_PageSize;
+}
+
+int TextureAtlas::getMaxImageSize() const
+{
+    return m_MaxImageSize;
+}
+
+bool TextureAtlas::isSuitable(const BitmapPtr& pBmp) const
+{
+    IntPoint size = pBmp->getSize();
+    return size.x <= m_MaxImageSize && size.y <= m_MaxImageSize &&
+            !pixelFormatIsPlanar(pBmp->getPixelFormat());
+}
+
+TextureAtlasRegionPtr TextureAtlas::addBitmap(const BitmapPtr& pBmp)
+{
+    AVG_ASSERT(isSuitable(pBmp));
+    PixelFormat pf = pBmp->getPixelFormat();
+    TextureAtlasRegionPtr pRegion;
+    for (unsigned i = 0; i < m_pPages.size() && !pRegion; ++i) {
+        if (m_pPages[i]->getPixelFormat() == pf) {
+            pRegion = insert(m_pPages[i], pBmp);
+        }
+    }
+
+    // Try to reclaim space freed by evicted images before adding a page.
+    IntPoint size = pBmp->getSize()+IntPoint(2,2);
+    long long area = (long long)(size.x)*size.y;
+    for (unsigned i = 0; i < m_pPages.size() && !pRegion; ++i) {
+        TextureAtlasPagePtr pPage = m_pPages[i];
+        if (pPage->getPixelFormat() == pf && pPage->getWastedArea() >= area && 
+                pPage->defragment())
+        {
+            m_NumDefragmentations++;
+            pRegion = insert(pPage, pBmp);
+        }
+    }
+
+    if (!pRegion) {
+        TextureAtlasPagePtr pPage(new TextureAtlasPage(
+                IntPoint(m_PageSize, m_PageSize), pf));
+        m_pPages.push_back(pPage);
+        pRegion = insert(pPage, pBmp);
+        AVG_ASSERT(pRegion);
+    }
+    return pRegion;
+}
+
+void TextureAtlas::defragment()
+{
+    vector<TextureAtlasPagePtr>::iterator it = m_pPages.begin();
+    while (it != m_pPages.end()) {
+        TextureAtlasPagePtr pPage = *it;
+        if (pPage->getNumRegions() == 0) {
+            it = m_pPages.erase(it);
+        } else {
+            if (needsDefragmentation(pPage) && pPage->defragment()) {
+                m_NumDefragmentations++;
+            }
+            ++it;
+        }
+    }
+}
+
+int TextureAtlas::getNumPages() const
+{
+    return int(m_pPages.size());
+}
+
+float TextureAtlas::getOccupancy() const
+{
+    if (m_pPages.empty()) {
+        return 0;
+    }
+    long long usedArea = 0;
+    for (unsigned i = 0; i < m_pPages.size(); ++i) {
+        usedArea += m_pPages[i]->getUsedArea();
+    }
+    return float(usedArea)/(float(m_PageSize)*m_PageSize*m_pPages.size());
+}
+
+int TextureAtlas::getNumDefragmentations() const
+{
+    return m_NumDefragmentations;
+}
+
+void TextureAtlas::dump() const
+{
+    cerr << "TextureAtlas: " << m_pPages.size() << " pages of " << m_PageSize << "x" 
+            << m_PageSize << ", occupancy: " << getOccupancy() << ", defragmentations: "
+            << m_NumDefragmentations << endl;
+    for (unsigned i = 0; i < m_pPages.size(); ++i) {
+        TextureAtlasPagePtr pPage = m_pPages[i];
+        cerr << "  " << getPixelFormatString(pPage->getPixelFormat()) << ": " 
+                << pPage->getNumRegions() << " images, used: " << pPage->getUsedArea()
+                << ", wasted: " << pPage->getWastedArea() << endl;
+    }
+}
+
+TextureAtlasRegionPtr TextureAtlas::insert(const TextureAtlasPagePtr& pPage, 
+        const BitmapPtr& pBmp)
+{
+    IntRect rect;
+    if (pPage->insert(pBmp, rect)) {
+        return TextureAtlasRegionPtr(new TextureAtlasRegion(pPage, rect));
+    } else {
+        return TextureAtlasRegionPtr();
+    }
+}
+
+bool TextureAtlas::needsDefragmentation(const TextureAtlasPagePtr& pPage) const
+{
+    // Repacking means uploading the complete page, so only do it if a significant 
+    // part of the page is unused.
+    return pPage->getWastedArea() > (long long)(m_PageSize)*m_PageSize/4;
+}
+
+}
@@ -0,0 +1,142 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _TextureAtlas_H_
+#define _TextureAtlas_H_
+
+#include "../api.h"
+
+#include "PixelFormat.h"
+#include "SkylinePacker.h"
+
+#include "../base/GLMHelper.h"
+#include "../base/Rect.h"
+
+#include <boost/shared_ptr.hpp>
+#include <vector>
+
+namespace avg {
+
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+class MCTexture;
+typedef boost::shared_ptr<MCTexture> MCTexturePtr;
+class TextureAtlasRegion;
+class TextureAtlasPage;
+typedef boost::shared_ptr<TextureAtlasPage> TextureAtlasPagePtr;
+
+// Part of an atlas page that holds one image. The region is freed when the last 
+// reference to it goes away. Defragmenting a page can move the region; getVersion()
+// changes whenever that happens.
+class AVG_API TextureAtlasRegion
+{
+public:
+    TextureAtlasRegion(TextureAtlasPagePtr pPage, const IntRect& rect);
+    virtual ~TextureAtlasRegion();
+
+    MCTexturePtr getTex() const;
+    // Position of the image in the page, excluding the border.
+    const IntRect& getRect() const;
+    // Position of the image in normalized texture coordinates.
+    FRect getTexCoordRect() const;
+    int getVersion() const;
+    int getMemNeeded() const;
+
+    void move(const IntRect& rect);
+
+private:
+    TextureAtlasPagePtr m_pPage;
+    IntRect m_Rect;
+    int m_Version;
+};
+
+typedef boost::shared_ptr<TextureAtlasRegion> TextureAtlasRegionPtr;
+
+// One texture holding images of a single pixel format. Every image is surrounded by
+// a one-pixel border that duplicates its edge pixels so linear filtering doesn't 
+// pick up neighbouring images.
+class AVG_API TextureAtlasPage
+{
+public:
+    TextureAtlasPage(const IntPoint& size, PixelFormat pf);
+    virtual ~TextureAtlasPage();
+
+    bool insert(const BitmapPtr& pBmp, IntRect& rect);
+    bool defragment();
+
+    void addRegion(TextureAtlasRegion* pRegion);
+    void removeRegion(TextureAtlasRegion* pRegion);
+
+    MCTexturePtr getTex() const;
+    PixelFormat getPixelFormat() const;
+    const IntPoint& getSize() const;
+    int getNumRegions() const;
+    long long getUsedArea() const;
+    long long getWastedArea() const;
+
+private:
+    void scheduleUpload();
+
+    IntPoint m_Size;
+    PixelFormat m_PF;
+    MCTexturePtr m_pTex;
+    BitmapPtr m_pBmp;
+    SkylinePacker m_Packer;
+    std::vector<TextureAtlasRegion*> m_pRegions;
+    long long m_UsedArea;
+};
+
+// Packs small images into a few large textures so they can share texture state.
+class AVG_API TextureAtlas
+{
+public:
+    TextureAtlas(int pageSize, int maxImageSize);
+    virtual ~TextureAtlas();
+
+    int getPageSize() const;
+    int getMaxImageSize() const;
+    bool isSuitable(const BitmapPtr& pBmp) const;
+    TextureAtlasRegionPtr addBitmap(const BitmapPtr& pBmp);
+    // Frees empty pages and repacks pages with too much unused space. 
+    void defragment();
+
+    int getNumPages() const;
+    float getOccupancy() const;
+    int getNumDefragmentations() const;
+    void dump() const;
+
+private:
+    TextureAtlasRegionPtr insert(const TextureAtlasPagePtr& pPage, 
+            const BitmapPtr& pBmp);
+    bool needsDefragmentation(const TextureAtlasPagePtr& pPage) const;
+
+    int m_PageSize;
+    int m_MaxImageSize;
+    std::vector<TextureAtlasPagePtr> m_pPages;
+    int m_NumDefragmentations;
+};
+
+typedef boost::shared_ptr<TextureAtlas> TextureAtlasPtr;
+
+}
+
+#endif
@@ -5,104 +5,35 @@
 #define _TwoPassScale_h_
 
 #include "ContribDefs.h"
+#include "FilterExecutor.h"
+#include "FilterKernels.h"
 
 #include "../base/Exception.h"
 
+#include <boost/bind.hpp>
+
 #include <math.h>
 #include <algorithm>
 #include <cstring>
 
 namespace avg {
 
-typedef struct
-{
-   int *Weights;     // Normalized weights of neighboring pixels
-   int Left,Right;   // Bounds of source pixels window
-} ContributionType;  // Contirbution information for a single pixel
-
-typedef struct
-{
-   ContributionType *ContribRow; // Row (or column) of contribution weights
-   int WindowSize,               // Filter window size (of affecting source pixels)
-       LineLength;               // Length of line (no. or rows / cols)
-} LineContribType;               // Contribution information for an entire line (row or column)
-
+// Pixel types. The resampling itself is done by the kernels in FilterKernels.h.
 class CDataA_UBYTE
 {
 public:
   typedef unsigned char PixelClass;
-  class _Accumulator {
-  public:
-      _Accumulator ()
-      {
-        val = 0;
-      };
-      void Accumulate (int Weight, PixelClass &value)
-      {
-        val += (Weight * value);
-      };
-
-      void Store (PixelClass* value)
-      {
-        *value = (unsigned char) ((val + 128)/256);
-      };
-      int val;
-  };
 };
 
 class CDataRGB_UBYTE
 {
 public:
   typedef unsigned char PixelClass[3];
-  class _Accumulator {
-  public:
-      _Accumulator ()
-      {
-        val [0] = val [1] = val [2] = 0;
-      };
-      void Accumulate (int Weight, PixelClass &value)
-      {
-        val [0] += (Weight * value [0]);
-        val [1] += (Weight * value [1]);
-        val [2] += (Weight * value [2]);
-      };
-
-      void Store (PixelClass* value)
-      {
-        (*value) [0] = (unsigned char) ((val [0] + 128)/256);
-        (*value) [1] = (unsigned char) ((val [1] + 128)/256);
-        (*value) [2] = (unsigned char) ((val [2] + 128)/256);
-      };
-      int val [3];
-  };
 };
 
 class CDataRGBA_UBYTE {
 public:
   typedef unsigned char PixelClass[4];
-  class _Accumulator {
-  public:
-      _Accumulator ()
-      {
-        val [0] = val [1] = val [2] = val [3] = 0;
-      };
-      void Accumulate (int dWeight, PixelClass &value)
-      {
-        val [0] += (dWeight * (value [0]));
-        val [1] += (dWeight * (value [1]));
-        val [2] += (dWeight * (value [2]));
-        val [3] += (dWeight * (value [3]));
-      };
-
-      void Store (PixelClass* value)
-      {
-        (*value) [0] = (unsigned char) ((val [0] + 128)/256);
-        (*value) [1] = (unsigned char) ((val [1] + 128)/256);
-        (*value) [2] = (unsigned char) ((val [2] + 128)/256);
-        (*value) [3] = (unsigned char) ((val [3] + 128)/256);
-      };
-      int val [4];
-  };
 };
 
 template <class DataClass>
@@ -121,6 +52,16 @@ public:
             PixelClass *pDstData, const IntPoint& dstSize, int dstStride);
 
 private:
+    // Parameters of one pass, shared by all row bands.
+    struct PassInfo {
+        PixelClass * m_pSrcData;
+        int m_SrcStride;
+        PixelClass * m_pDestData;
+        IntPoint m_DestSize;
+        int m_DestStride;
+        LineContribType * m_pContrib;
+    };
+
     LineContribType *AllocContributions (unsigned uLineLength,
                                          unsigned uWindowSize);
 
@@ -129,15 +70,16 @@ private:
     LineContribType *CalcContributions (unsigned    uLineSize,
                                         unsigned    uSrcSize);
 
-    void ScaleRow(PixelClass *pSrc, int uSrcWidth, PixelClass *pDest, int uResWidth, 
-            LineContribType *pContrib);
-
     void HorizScale(PixelClass * pSrcData, const IntPoint& srcSize, int srcStride, 
             PixelClass *pDestData, const IntPoint& destSize, int destStride);
 
+    void HorizScaleRows(const PassInfo& pass, int startRow, int endRow);
+
     void VertScale(PixelClass *pSrcData, const IntPoint& srcSize, int srcStride,
             PixelClass *pDestData, const IntPoint& destSize, int destStride);
 
+    void VertScaleRows(const PassInfo& pass, int startRow, int endRow);
+
     const ContribDef& m_ContribDef;
 };
 
@@ -240,27 +182,6 @@ TwoPassScale<DataClass>::CalcContributions(unsigned uLineSize, unsigned uSrcSize
    return res;
 }
 
-template <class DataClass>
-void
-TwoPassScale<DataClass>::ScaleRow(PixelClass *pSrc, int uSrcWidth,
-        PixelClass *pDest, int uResWidth, LineContribType *pContrib)
-{
-    PixelClass * pDestPixel = pDest;
-    for (int x = 0; x < uResWidth; x++) {
-        typename DataClass::_Accumulator a;
-        int iLeft = pContrib->ContribRow[x].Left;    // Retrieve left boundries
-        int iRight = pContrib->ContribRow[x].Right;  // Retrieve right boundries
-        int * Weights = pContrib->ContribRow[x].Weights;
-        for (int i = iLeft; i <= iRight; i++) {
-            // Scan between boundries
-            // Accumulate weighted effect of each neighboring pixel
-            a.Accumulate(Weights[i-iLeft], pSrc[i]);
-        }
-        a.Store(pDestPixel);
-        pDestPixel++;
-    }
-}
-
 template <class DataClass>
 void TwoPassScale<DataClass>::HorizScale(PixelClass * pSrcData, const IntPoint& srcSize, 
         int srcStride, PixelClass *pDestData, const IntPoint& destSize, int destStride)
@@ -275,13 +196,28 @@ void TwoPassScale<DataClass>::HorizScale(PixelClass * pSrcData, const IntPoint&
             pDest = (PixelClass*)((char*)(pDest)+destStride);
         }
     } else {
-        LineContribType * pContrib = CalcContributions(destSize.x, srcSize.x);
-        for (int y = 0; y < destSize.y; y++) {
-            ScaleRow(pSrc, srcSize.x, pDest, destSize.x, pContrib);
-            pSrc = (PixelClass*)((char*)(pSrc)+srcStride);
-            pDest = (PixelClass*)((char*)(pDest)+destStride);
-        }
-        FreeContributions(pContrib);  // Free contributions structure
+        PassInfo pass = {pSrcData, srcStride, pDestData, destSize, destStride,
+                CalcContributions(destSize.x, srcSize.x)};
+        FilterExecutor::get()->run(destSize.y, destSize.x, boost::bind(
+                &TwoPassScale<DataClass>::HorizScaleRows, this, boost::cref(pass), 
+                _1, _2));
+        FreeContributions(pass.m_pContrib);  // Free contributions structure
+    }
+}
+
+template <class DataClass>
+void TwoPassScale<DataClass>::HorizScaleRows(const PassInfo& pass, int startRow,
+        int endRow)
+{
+    PixelClass * pSrc = (PixelClass*)((char*)(pass.m_pSrcData)
+            + size_t(startRow)*pass.m_SrcStride);
+    PixelClass * pDest = (PixelClass*)((char*)(pass.m_pDestData)
+            + size_t(startRow)*pass.m_DestStride);
+    for (int y = startRow; y < endRow; y++) {
+        resampleLineHoriz((unsigned char*)pSrc, (unsigned char*)pDest, 
+                pass.m_DestSize.x, sizeof(PixelClass), pass.m_pContrib);
+        pSrc = (PixelClass*)((char*)(pSrc)+pass.m_SrcStride);
+        pDest = (PixelClass*)((char*)(pDest)+pass.m_DestStride);
     }
 }
 
@@ -300,32 +236,30 @@ void TwoPassScale<DataClass>::VertScale(PixelClass *pSrcData, const IntPoint& sr
             pDest = (PixelClass*)((char*)(pDest)+destStride);
         }
     } else {
-        LineContribType * pContrib = CalcContributions(destSize.y, srcSize.y);
-        for (int y = 0; y < destSize.y; y++) {
-            PixelClass * pDestPixel = pDest;
-            int * pWeights = pContrib->ContribRow[y].Weights;
-            int iLeft = pContrib->ContribRow[y].Left;
-            int iRight = pContrib->ContribRow[y].Right;
-            PixelClass* pSrcPixelBase = (PixelClass*)((char*)(pSrc)
-                    + size_t(iLeft)*srcStride);
-            for (int x = 0; x < destSize.x; x++) {
-                typename DataClass::_Accumulator a;
-                int * pWeight = pWeights;
-                PixelClass * pSrcPixel = pSrcPixelBase;
-                pSrcPixelBase++;
-                for (int i = iLeft; i <= iRight; i++) {
-                    // Scan between boundries
-                    // Accumulate weighted effect of each neighboring pixel
-                    a.Accumulate(*pWeight, *pSrcPixel);
-                    pWeight++;
-                    pSrcPixel = (PixelClass*)((char*)(pSrcPixel)+srcStride);
-                }
-                a.Store(pDestPixel);
-                pDestPixel++;
-            }
-            pDest = (PixelClass*)((char*)(pDest)+destStride);
-        }
-        FreeContributions(pContrib);     // Free contributions structure
+        PassInfo pass = {pSrcData, srcStride, pDestData, destSize, destStride,
+                CalcContributions(destSize.y, srcSize.y)};
+        FilterExecutor::get()->run(destSize.y, destSize.x, boost::bind(
+                &TwoPassScale<DataClass>::VertScaleRows, this, boost::cref(pass), 
+                _1, _2));
+        FreeContributions(pass.m_pContrib);     // Free contributions structure
+    }
+}
+
+template <class DataClass>
+void TwoPassScale<DataClass>::VertScaleRows(const PassInfo& pass, int startRow, 
+        int endRow)
+{
+    LineContribType * pContrib = pass.m_pContrib;
+    int srcStride = pass.m_SrcStride;
+    PixelClass * pDest = (PixelClass*)((char*)(pass.m_pDestData)
+            + size_t(startRow)*pass.m_DestStride);
+    for (int y = startRow; y < endRow; y++) {
+        const ContributionType& contrib = pContrib->ContribRow[y];
+        unsigned char* pSrc = (unsigned char*)(pass.m_pSrcData)
+                + size_t(contrib.Left)*srcStride;
+        resampleLineVert(pSrc, srcStride, (unsigned char*)pDest, 
+                pass.m_DestSize.x*sizeof(PixelClass), contrib);
+        pDest = (PixelClass*)((char*)(pDest)+pass.m_DestStride);
     }
 }
 
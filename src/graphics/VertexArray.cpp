@@ -43,7 +43,8 @@ const unsigned VertexArray::POS_INDEX = 1;
 const unsigned VertexArray::COLOR_INDEX = 2;
 
 VertexArray::VertexArray(int reserveVerts, int reserveIndexes)
-    : VertexData(reserveVerts, reserveIndexes)
+    : VertexData(reserveVerts, reserveIndexes),
+      m_NumBytesUploaded(0)
 {
     GLContext* pContext = GLContext::getCurrent();
     m_bUseMapBuffer = (!pContext->isGLES());
@@ -59,6 +60,11 @@ void VertexArray::initForGLContext(GLContext* pContext)
     m_VertexBufferIDMap[pContext] = vertexBufferID;
     glproc::GenBuffers(1, &indexBufferID);
     m_IndexBufferIDMap[pContext] = indexBufferID;
+    UploadState state;
+    state.m_PassNumber = -1;
+    state.m_ReserveVerts = 0;
+    state.m_ReserveIndexes = 0;
+    m_UploadStateMap[pContext] = state;
 }
 
 VertexArray::~VertexArray()
@@ -70,23 +76,29 @@ VertexArray::~VertexArray()
 void VertexArray::update(GLContext* pContext)
 {
     AVG_ASSERT(!m_VertexBufferIDMap.empty());
-    if (hasDataChanged()) {
+    m_NumBytesUploaded = 0;
+    UploadState& state = m_UploadStateMap[pContext];
+    // Data that hasn't been rewritten in this pass is only valid in the GL buffers
+    // if they were filled in this or the last pass and haven't been resized since.
+    bool bRealloc = (state.m_ReserveVerts != getReserveVerts() ||
+            state.m_ReserveIndexes != getReserveIndexes() ||
+            !(state.m_PassNumber == getPassNumber() ||
+              isFromLastPass(state.m_PassNumber)));
+    if (bRealloc || hasDataChanged()) {
         unsigned vertexBufferID = m_VertexBufferIDMap[pContext];
-        transferBuffer(GL_ARRAY_BUFFER, vertexBufferID, 
-                getReserveVerts()*sizeof(Vertex), 
-                getNumVerts()*sizeof(Vertex), getVertexPointer());
+        transferBuffer(GL_ARRAY_BUFFER, vertexBufferID, bRealloc,
+                getReserveVerts()*sizeof(Vertex), getNumVerts()*sizeof(Vertex), 
+                sizeof(Vertex), getDirtyVertRanges(), getVertexPointer());
         unsigned indexBufferID = m_IndexBufferIDMap[pContext];
-#ifdef AVG_ENABLE_EGL        
-        transferBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID, 
-                getReserveIndexes()*sizeof(unsigned short),
-                getNumIndexes()*sizeof(unsigned short), getIndexPointer());
-#else
-        transferBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID, 
-                getReserveIndexes()*sizeof(unsigned int),
-                getNumIndexes()*sizeof(unsigned int), getIndexPointer());
-#endif
+        transferBuffer(GL_ELEMENT_ARRAY_BUFFER, indexBufferID, bRealloc,
+                getReserveIndexes()*sizeof(GL_INDEX_TYPE), 
+                getNumIndexes()*sizeof(GL_INDEX_TYPE), sizeof(GL_INDEX_TYPE), 
+                getDirtyIndexRanges(), getIndexPointer());
         GLContext::checkError("VertexArray::update()");
     }
+    state.m_PassNumber = getPassNumber();
+    state.m_ReserveVerts = getReserveVerts();
+    state.m_ReserveIndexes = getReserveIndexes();
 }
 
 void VertexArray::activate(GLContext* pContext)
@@ -141,17 +153,40 @@ void VertexArray::startSubVA(SubVertexArray& subVA)
     subVA.init(this, getNumVerts(), getNumIndexes());
 }
 
-void VertexArray::transferBuffer(GLenum target, unsigned bufferID, unsigned reservedSize, 
-        unsigned usedSize, const void* pData)
+int VertexArray::getNumBytesUploaded() const
+{
+    return m_NumBytesUploaded;
+}
+
+void VertexArray::transferBuffer(GLenum target, unsigned bufferID, bool bRealloc,
+        unsigned reservedSize, unsigned usedSize, unsigned elementSize,
+        const vector<DirtyRange>& dirtyRanges, const void* pData)
 {
     glproc::BindBuffer(target, bufferID);
-    if (m_bUseMapBuffer) {
+    unsigned dirtySize = 0;
+    for (unsigned i = 0; i < dirtyRanges.size(); ++i) {
+        dirtySize += (dirtyRanges[i].m_End-dirtyRanges[i].m_Start)*elementSize;
+    }
+    // If most of the buffer changed, orphaning it and transferring everything is 
+    // cheaper than a partial update that may have to wait for the last frame's draw 
+    // calls to finish.
+    if (bRealloc || dirtySize*2 > usedSize) {
         glproc::BufferData(target, reservedSize, 0, GL_STREAM_DRAW);
-        void * pBuffer = glproc::MapBuffer(target, GL_WRITE_ONLY);
-        memcpy(pBuffer, pData, usedSize);
-        glproc::UnmapBuffer(target);
+        if (m_bUseMapBuffer) {
+            void * pBuffer = glproc::MapBuffer(target, GL_WRITE_ONLY);
+            memcpy(pBuffer, pData, usedSize);
+            glproc::UnmapBuffer(target);
+        } else {
+            glproc::BufferSubData(target, 0, usedSize, pData);
+        }
+        m_NumBytesUploaded += usedSize;
     } else {
-        glproc::BufferData(target, usedSize, pData, GL_STREAM_DRAW);
+        for (unsigned i = 0; i < dirtyRanges.size(); ++i) {
+            unsigned start = dirtyRanges[i].m_Start*elementSize;
+            unsigned size = (dirtyRanges[i].m_End-dirtyRanges[i].m_Start)*elementSize;
+            glproc::BufferSubData(target, start, size, (const char*)pData+start);
+        }
+        m_NumBytesUploaded += dirtySize;
     }
 }
 
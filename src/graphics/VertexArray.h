@@ -52,15 +52,29 @@ public:
 
     void startSubVA(SubVertexArray& subVA);
 
+    // Number of bytes transferred to the GPU by the last update() call.
+    int getNumBytesUploaded() const;
+
 private:
-    void transferBuffer(GLenum target, unsigned bufferID, unsigned reservedSize, 
-            unsigned usedSize, const void* pData);
+    void transferBuffer(GLenum target, unsigned bufferID, bool bRealloc,
+            unsigned reservedSize, unsigned usedSize, unsigned elementSize,
+            const std::vector<DirtyRange>& dirtyRanges, const void* pData);
 
     typedef std::map<const GLContext*, unsigned> BufferIDMap;
     BufferIDMap m_VertexBufferIDMap;
     BufferIDMap m_IndexBufferIDMap;
 
+    // What the buffers of a context currently contain.
+    struct UploadState {
+        int m_PassNumber;
+        int m_ReserveVerts;
+        int m_ReserveIndexes;
+    };
+    typedef std::map<const GLContext*, UploadState> UploadStateMap;
+    UploadStateMap m_UploadStateMap;
+
     bool m_bUseMapBuffer;
+    int m_NumBytesUploaded;
 };
 
 typedef boost::shared_ptr<VertexArray> VertexArrayPtr;
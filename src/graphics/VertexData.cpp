@@ -38,6 +38,8 @@ namespace avg {
     
 const int VertexData::MIN_VERTEXES = 100;
 const int VertexData::MIN_INDEXES = 100;
+// Further dirty ranges are merged into the last one.
+const unsigned MAX_DIRTY_RANGES = 16;
 
 glm::vec2 Vertex::posAsVec()
 {
@@ -50,8 +52,10 @@ VertexData::VertexData(int reserveVerts, int reserveIndexes)
       m_NumIndexes(0),
       m_ReserveVerts(reserveVerts),
       m_ReserveIndexes(reserveIndexes),
-      m_bDataChanged(true)
+      m_bDataChanged(true),
+      m_PassNumber(0)
 {
+    clearDirtyRanges();
     ObjectCounter::get()->incRef(&typeid(*this));
     if (m_ReserveVerts < MIN_VERTEXES) {
         m_ReserveVerts = MIN_VERTEXES;
@@ -78,16 +82,17 @@ void VertexData::appendPos(const glm::vec2& pos, const glm::vec2& texPos,
     if (m_NumVerts >= m_ReserveVerts-1) {
         grow();
     }
-    Vertex* pVertex = &(m_pVertexData[m_NumVerts]);
-    pVertex->m_Pos[0] = (GLfloat)(pos.x);
-    pVertex->m_Pos[1] = (GLfloat)(pos.y);
-    pVertex->m_Tex[0] = (GLfloat)(texPos.x);
-    pVertex->m_Tex[1] = (GLfloat)(texPos.y);
-    pVertex->m_Color = color;
-    m_bDataChanged = true;
+    writeVertex(m_NumVerts, pos, texPos, color);
     m_NumVerts++;
 }
 
+void VertexData::setPos(int vertex, const glm::vec2& pos, const glm::vec2& texPos,
+        const Pixel32& color)
+{
+    AVG_ASSERT(vertex < m_NumVerts);
+    writeVertex(vertex, pos, texPos, color);
+}
+
 void VertexData::appendTriIndexes(int v0, int v1, int v2)
 {
     if (m_NumIndexes >= m_ReserveIndexes-3) {
@@ -96,6 +101,7 @@ void VertexData::appendTriIndexes(int v0, int v1, int v2)
     m_pIndexData[m_NumIndexes] = v0;
     m_pIndexData[m_NumIndexes+1] = v1;
     m_pIndexData[m_NumIndexes+2] = v2;
+    markIndexesDirty(m_NumIndexes, m_NumIndexes+3);
     m_NumIndexes += 3;
 }
 
@@ -110,6 +116,7 @@ void VertexData::appendQuadIndexes(int v0, int v1, int v2, int v3)
     m_pIndexData[m_NumIndexes+3] = v1;
     m_pIndexData[m_NumIndexes+4] = v2;
     m_pIndexData[m_NumIndexes+5] = v3;
+    markIndexesDirty(m_NumIndexes, m_NumIndexes+6);
     m_NumIndexes += 6;
 }
 
@@ -141,7 +148,8 @@ void VertexData::appendVertexData(const VertexDataPtr& pVertexes)
     for (int i=0; i<numIndexes; ++i) {
         m_pIndexData[oldNumIndexes+i] = pVertexes->m_pIndexData[i] + oldNumVerts;
     }
-    m_bDataChanged = true;
+    markVertsDirty(oldNumVerts, m_NumVerts);
+    markIndexesDirty(oldNumIndexes, m_NumIndexes);
 }
 
 bool VertexData::hasDataChanged() const
@@ -152,13 +160,39 @@ bool VertexData::hasDataChanged() const
 void VertexData::resetDataChanged()
 {
     m_bDataChanged = false;
+    clearDirtyRanges();
 }
 
-void VertexData::reset()
+void VertexData::reset(bool bKeepData)
 {
     m_NumVerts = 0;
     m_NumIndexes = 0;
     m_bDataChanged = false;
+    clearDirtyRanges();
+    if (bKeepData) {
+        m_PassNumber++;
+    } else {
+        // No pass number from before the reset refers to the last pass.
+        m_PassNumber += 2;
+    }
+}
+
+void VertexData::skip(int numVerts, int numIndexes)
+{
+    AVG_ASSERT(m_NumVerts+numVerts <= m_ReserveVerts);
+    AVG_ASSERT(m_NumIndexes+numIndexes <= m_ReserveIndexes);
+    m_NumVerts += numVerts;
+    m_NumIndexes += numIndexes;
+}
+
+int VertexData::getPassNumber() const
+{
+    return m_PassNumber;
+}
+
+bool VertexData::isFromLastPass(int passNumber) const
+{
+    return passNumber == m_PassNumber-1;
 }
 
 FRect VertexData::calcBoundingRect() const
@@ -262,6 +296,65 @@ int VertexData::getReserveIndexes() const
     return m_ReserveIndexes;
 }
 
+const vector<VertexData::DirtyRange>& VertexData::getDirtyVertRanges() const
+{
+    return m_DirtyVertRanges;
+}
+
+const vector<VertexData::DirtyRange>& VertexData::getDirtyIndexRanges() const
+{
+    return m_DirtyIndexRanges;
+}
+
+void VertexData::writeVertex(int vertex, const glm::vec2& pos, const glm::vec2& texPos,
+        const Pixel32& color)
+{
+    Vertex* pVertex = &(m_pVertexData[vertex]);
+    pVertex->m_Pos[0] = (GLfloat)(pos.x);
+    pVertex->m_Pos[1] = (GLfloat)(pos.y);
+    pVertex->m_Tex[0] = (GLfloat)(texPos.x);
+    pVertex->m_Tex[1] = (GLfloat)(texPos.y);
+    pVertex->m_Color = color;
+    markVertsDirty(vertex, vertex+1);
+}
+
+void VertexData::markVertsDirty(int start, int end)
+{
+    addDirtyRange(m_DirtyVertRanges, start, end);
+}
+
+void VertexData::markIndexesDirty(int start, int end)
+{
+    addDirtyRange(m_DirtyIndexRanges, start, end);
+}
+
+void VertexData::addDirtyRange(vector<DirtyRange>& ranges, int start, int end)
+{
+    m_bDataChanged = true;
+    if (!ranges.empty()) {
+        // Data is mostly written in order, so new data usually continues the last 
+        // range.
+        DirtyRange& lastRange = ranges.back();
+        if ((start <= lastRange.m_End && end >= lastRange.m_Start) || 
+                ranges.size() >= MAX_DIRTY_RANGES)
+        {
+            lastRange.m_Start = min(lastRange.m_Start, start);
+            lastRange.m_End = max(lastRange.m_End, end);
+            return;
+        }
+    }
+    DirtyRange range;
+    range.m_Start = start;
+    range.m_End = end;
+    ranges.push_back(range);
+}
+
+void VertexData::clearDirtyRanges()
+{
+    m_DirtyVertRanges.clear();
+    m_DirtyIndexRanges.clear();
+}
+
 std::ostream& operator<<(std::ostream& os, const Vertex& v)
 {
     os << "  ((" << v.m_Pos[0] << ", " << v.m_Pos[1] << "), (" 
@@ -31,6 +31,7 @@
 #include "../base/Rect.h"
 
 #include <boost/shared_ptr.hpp>
+#include <vector>
 
 namespace avg {
 
@@ -57,6 +58,9 @@ public:
 
     void appendPos(const glm::vec2& pos, 
             const glm::vec2& texPos, const Pixel32& color = Pixel32(0,0,0,0));
+    // Overwrites a vertex that has already been appended or skipped in this pass.
+    void setPos(int vertex, const glm::vec2& pos, const glm::vec2& texPos, 
+            const Pixel32& color = Pixel32(0,0,0,0));
     void appendTriIndexes(int v0, int v1, int v2);
     void appendQuadIndexes(int v0, int v1, int v2, int v3);
     void addLineData(Pixel32 color, const glm::vec2& p1, const glm::vec2& p2, 
@@ -64,7 +68,14 @@ public:
     void appendVertexData(const VertexDataPtr& pVertexes);
     bool hasDataChanged() const;
     void resetDataChanged();
-    void reset();
+
+    // Starts a new pass. Data appended in the previous pass stays in the buffer, so
+    // callers that append the same data at the same offsets again can skip() it
+    // instead. If bKeepData is false, the previous pass is invalidated.
+    void reset(bool bKeepData=true);
+    void skip(int numVerts, int numIndexes);
+    int getPassNumber() const;
+    bool isFromLastPass(int passNumber) const;
     FRect calcBoundingRect() const;
 
     int getNumVerts() const;
@@ -80,11 +91,27 @@ protected:
     int getReserveVerts() const;
     int getReserveIndexes() const;
 
+    // Ranges of the data written since the last reset(), in vertexes and indexes.
+    // Everything else in the used part of the buffers is unchanged since the last 
+    // pass.
+    struct DirtyRange {
+        int m_Start;
+        int m_End;
+    };
+    const std::vector<DirtyRange>& getDirtyVertRanges() const;
+    const std::vector<DirtyRange>& getDirtyIndexRanges() const;
+
     static const int MIN_VERTEXES;
     static const int MIN_INDEXES;
 
 private:
     void grow();
+    void writeVertex(int vertex, const glm::vec2& pos, const glm::vec2& texPos,
+            const Pixel32& color);
+    void markVertsDirty(int start, int end);
+    void markIndexesDirty(int start, int end);
+    void addDirtyRange(std::vector<DirtyRange>& ranges, int start, int end);
+    void clearDirtyRanges();
 
     int m_NumVerts;
     int m_NumIndexes;
@@ -94,6 +121,9 @@ private:
     GL_INDEX_TYPE * m_pIndexData;
 
     bool m_bDataChanged;
+    int m_PassNumber;
+    std::vector<DirtyRange> m_DirtyVertRanges;
+    std::vector<DirtyRange> m_DirtyIndexRanges;
 };
 
 std::ostream& operator<<(std::ostream& os, const Vertex& v);
@@ -36,10 +36,16 @@
 #include "FilterGauss.h"
 #include "FilterBlur.h"
 #include "FilterBandpass.h"
+#include "FilterResizeGaussian.h"
+#include "FilterResizeBilinear.h"
+#include "FilterExecutor.h"
 
 #include "../base/TimeSource.h"
+#include "../base/SIMDHelper.h"
 
+#include <cstring>
 #include <iostream>
+#include <sstream>
 #include <stdio.h>
 #include <stdlib.h>
 
@@ -233,6 +239,163 @@ private:
         
 };
 
+BitmapPtr createNoiseBmp(const IntPoint& size, PixelFormat pf)
+{
+    BitmapPtr pBmp(new Bitmap(size, pf));
+    unsigned char * pPixels = pBmp->getPixels();
+    for (int i = 0; i < pBmp->getStride()*pBmp->getSize().y; ++i) {
+        pPixels[i] = rand() & 0xFF;
+    }
+    return pBmp;
+}
+
+// Measures one row of the conversion matrix: a full HD conversion at every
+// instruction set the machine supports. Planar YCbCr sources are converted using
+// copyYUVPixels().
+void runConversionBenchmark(PixelFormat srcPF, PixelFormat destPF, int numRuns=50)
+{
+    IntPoint size(1920, 1080);
+    BitmapPtr pSrcBmp;
+    BitmapPtr pUBmp;
+    BitmapPtr pVBmp;
+    bool bPlanar = pixelFormatIsPlanar(srcPF);
+    if (bPlanar) {
+        pSrcBmp = createNoiseBmp(size, I8);
+        pUBmp = createNoiseBmp(size/2, I8);
+        pVBmp = createNoiseBmp(size/2, I8);
+    } else {
+        pSrcBmp = createNoiseBmp(size, srcPF);
+    }
+    Bitmap destBmp(size, destPF);
+
+    cerr << "  " << srcPF << "->" << destPF << ":";
+    SIMDLevel origLevel = getSIMDLevel();
+    for (int i = SIMD_NONE; i <= SIMD_NEON; ++i) {
+        SIMDLevel level = SIMDLevel(i);
+        if (!isSIMDLevelSupported(level)) {
+            continue;
+        }
+        setSIMDLevel(level);
+        long long startTime = TimeSource::get()->getCurrentMicrosecs();
+        for (int j = 0; j < numRuns; ++j) {
+            if (bPlanar) {
+                destBmp.copyYUVPixels(*pSrcBmp, *pUBmp, *pVBmp, srcPF == YCbCrJ420p);
+            } else {
+                destBmp.copyPixels(*pSrcBmp);
+            }
+        }
+        float activeTime = (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000.f;
+        float mPixPerSec = float(size.x)*size.y*numRuns/(activeTime*1000);
+        cerr << " " << getSIMDLevelName(level) << " " << mPixPerSec << " MPix/s";
+    }
+    setSIMDLevel(origLevel);
+    cerr << endl;
+}
+
+void runConversionBenchmarks()
+{
+    cerr << "Pixel format conversions:" << endl;
+    runConversionBenchmark(YCbCr420p, B8G8R8X8);
+    runConversionBenchmark(YCbCrJ420p, B8G8R8X8);
+    runConversionBenchmark(YCbCr422, B8G8R8X8);
+    runConversionBenchmark(YUYV422, B8G8R8X8);
+    runConversionBenchmark(YCbCr422, I8);
+    runConversionBenchmark(YUYV422, I8);
+    runConversionBenchmark(I8, B8G8R8X8);
+    runConversionBenchmark(I16, I8);
+    runConversionBenchmark(I8, I16);
+    runConversionBenchmark(BAYER8_RGGB, B8G8R8X8);
+    runConversionBenchmark(BAYER8_GBRG, B8G8R8X8);
+}
+
+// Throughput of one filter at every instruction set the machine supports, in source
+// megapixels per second. Runs single-threaded so the numbers measure the kernels.
+void runKernelBenchmark(const string& sName, FilterPtr pFilter, PixelFormat pf,
+        int numRuns=10)
+{
+    IntPoint size(1920, 1080);
+    BitmapPtr pSrcBmp = createNoiseBmp(size, pf);
+    FilterExecutor* pExecutor = FilterExecutor::get();
+    int numThreads = pExecutor->getNumThreads();
+    pExecutor->setNumThreads(1);
+
+    cerr << "  " << sName << ", " << pf << ":";
+    SIMDLevel origLevel = getSIMDLevel();
+    for (int i = SIMD_NONE; i <= SIMD_NEON; ++i) {
+        SIMDLevel level = SIMDLevel(i);
+        if (!isSIMDLevelSupported(level)) {
+            continue;
+        }
+        setSIMDLevel(level);
+        long long startTime = TimeSource::get()->getCurrentMicrosecs();
+        for (int j = 0; j < numRuns; ++j) {
+            pFilter->apply(pSrcBmp);
+        }
+        float activeTime = (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000.f;
+        float mPixPerSec = float(size.x)*size.y*numRuns/(activeTime*1000);
+        cerr << " " << getSIMDLevelName(level) << " " << mPixPerSec << " MPix/s";
+    }
+    setSIMDLevel(origLevel);
+    pExecutor->setNumThreads(numThreads);
+    cerr << endl;
+}
+
+void runKernelBenchmarks()
+{
+    cerr << "Filter kernels:" << endl;
+    float radii[] = {1, 2, 3, 5, 7};
+    for (unsigned i = 0; i < sizeof(radii)/sizeof(float); ++i) {
+        stringstream ss;
+        ss << "Gauss, radius " << radii[i];
+        runKernelBenchmark(ss.str(), FilterPtr(new FilterGauss(radii[i])), I8);
+    }
+    float boxRadii[] = {3, 7, 15, 30, 60};
+    for (unsigned i = 0; i < sizeof(boxRadii)/sizeof(float); ++i) {
+        stringstream ss;
+        ss << "Gauss box cascade, radius " << boxRadii[i];
+        runKernelBenchmark(ss.str(), FilterPtr(new FilterGauss(boxRadii[i], true)), I8);
+    }
+    runKernelBenchmark("Blur", FilterPtr(new FilterBlur()), I8);
+    PixelFormat pfs[] = {I8, R8G8B8, R8G8B8A8};
+    for (unsigned i = 0; i < sizeof(pfs)/sizeof(PixelFormat); ++i) {
+        runKernelBenchmark("ResizeGaussian 1/2", 
+                FilterPtr(new FilterResizeGaussian(IntPoint(960, 540), 1.5f)), pfs[i]);
+        runKernelBenchmark("ResizeBilinear 1/2", 
+                FilterPtr(new FilterResizeBilinear(IntPoint(960, 540))), pfs[i]);
+        runKernelBenchmark("ResizeBilinear 1/4", 
+                FilterPtr(new FilterResizeBilinear(IntPoint(480, 270))), pfs[i]);
+        runKernelBenchmark("ResizeBilinear 3/2", 
+                FilterPtr(new FilterResizeBilinear(IntPoint(2880, 1620))), pfs[i], 3);
+    }
+}
+
+// The camera tracking preprocessing chain: blur followed by bandpass on a 1280x960
+// image, single-threaded and on all configured filter threads.
+void runFilterBenchmark(int numRuns=20)
+{
+    IntPoint size(1280, 960);
+    BitmapPtr pSrcBmp = createNoiseBmp(size, I8);
+    FilterExecutor* pExecutor = FilterExecutor::get();
+    int numThreads = pExecutor->getNumThreads();
+    cerr << "Blur + bandpass, " << size.x << "x" << size.y << ":";
+    int threadCounts[] = {1, numThreads};
+    for (int i = 0; i < 2; ++i) {
+        if (i == 1 && numThreads == 1) {
+            break;
+        }
+        pExecutor->setNumThreads(threadCounts[i]);
+        long long startTime = TimeSource::get()->getCurrentMicrosecs();
+        for (int j = 0; j < numRuns; ++j) {
+            BitmapPtr pBlurredBmp = FilterBlur().apply(pSrcBmp);
+            FilterBandpass(1.9f, 3).apply(pBlurredBmp);
+        }
+        float activeTime = (TimeSource::get()->getCurrentMicrosecs()-startTime)/1000.f;
+        cerr << " " << threadCounts[i] << " threads " << activeTime/numRuns << " ms";
+    }
+    pExecutor->setNumThreads(numThreads);
+    cerr << endl;
+}
+
 void runPerformanceTests()
 {
     runPerformanceTest<LoadPNGPerfTest>();
@@ -250,5 +413,8 @@ int main(int nargs, char** args)
 {
     BitmapLoader::init(true);
     runPerformanceTests();
+    runConversionBenchmarks();
+    runKernelBenchmarks();
+    runFilterBenchmark();
 }
 
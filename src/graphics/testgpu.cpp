@@ -37,6 +37,7 @@
 #include "PBO.h"
 #include "ImageCache.h"
 #include "CachedImage.h"
+#include "TextureAtlas.h"
 
 #include "../base/TestSuite.h"
 #include "../base/Exception.h"
@@ -44,6 +45,7 @@
 #include "../base/StringHelper.h"
 #include "../base/FileHelper.h"
 #include "../base/OSHelper.h"
+#include "../base/MathHelper.h"
 
 #include <math.h>
 #include <iostream>
@@ -505,6 +507,84 @@ private:
 };
 
 
+class TextureAtlasTest: public GraphicsTest {
+public:
+    TextureAtlasTest()
+        : GraphicsTest("TextureAtlasTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        vector<BitmapPtr> pBmps;
+        pBmps.push_back(loadTestBmp("rgb24-64x64", B8G8R8A8));
+        pBmps.push_back(loadTestBmp("rgb24alpha-64x64", B8G8R8A8));
+        pBmps.push_back(loadTestBmp("i8-64x64", B8G8R8A8));
+        BitmapPtr pBmp65 = loadTestBmp("rgb24-65x65", B8G8R8A8);
+        pBmps.push_back(BitmapPtr(new Bitmap(*pBmp65, IntRect(0, 0, 64, 64))));
+
+        // Four 64x64 images plus borders fill a 132x132 page exactly.
+        TextureAtlas atlas(132, 64);
+        TEST(!atlas.isSuitable(pBmp65));
+        vector<TextureAtlasRegionPtr> pRegions;
+        for (unsigned i = 0; i < pBmps.size(); ++i) {
+            pRegions.push_back(atlas.addBitmap(pBmps[i]));
+        }
+        TEST(atlas.getNumPages() == 1);
+        TEST(almostEqual(atlas.getOccupancy(), 1.f));
+        testRegions(pRegions, pBmps, "TextureAtlas1");
+
+        // Freed space is reclaimed by repacking the page.
+        pRegions.erase(pRegions.begin());
+        pBmps.erase(pBmps.begin());
+        TEST(almostEqual(atlas.getOccupancy(), 0.75f));
+        TEST(atlas.getNumDefragmentations() == 0);
+        vector<int> versions;
+        for (unsigned i = 0; i < pRegions.size(); ++i) {
+            versions.push_back(pRegions[i]->getVersion());
+        }
+        pBmps.push_back(loadTestBmp("rgb24-64x64", B8G8R8A8));
+        pRegions.push_back(atlas.addBitmap(pBmps.back()));
+        TEST(atlas.getNumPages() == 1);
+        TEST(atlas.getNumDefragmentations() == 1);
+        for (unsigned i = 0; i < versions.size(); ++i) {
+            TEST(pRegions[i]->getVersion() == versions[i]+1);
+        }
+        testRegions(pRegions, pBmps, "TextureAtlas2");
+
+        // No space left: New page.
+        pRegions.push_back(atlas.addBitmap(pBmps[0]));
+        TEST(atlas.getNumPages() == 2);
+        TEST(pRegions.back()->getTex() != pRegions[0]->getTex());
+        pBmps.push_back(pBmps[0]);
+        testRegions(pRegions, pBmps, "TextureAtlas3");
+
+        pRegions.clear();
+        atlas.defragment();
+        TEST(atlas.getNumPages() == 0);
+        TEST(atlas.getOccupancy() == 0);
+    }
+
+private:
+    void testRegions(const vector<TextureAtlasRegionPtr>& pRegions, 
+            const vector<BitmapPtr>& pBmps, const string& sName)
+    {
+        GLContextManager::get()->uploadData();
+        if (GLContext::getCurrent()->isGLES()) {
+            // moveTextureToBmp() isn't supported.
+            return;
+        }
+        for (unsigned i = 0; i < pRegions.size(); ++i) {
+            GLContext* pContext = GLContext::getCurrent();
+            BitmapPtr pPageBmp = pRegions[i]->getTex()->getTex(pContext)
+                    ->moveTextureToBmp();
+            Bitmap regionBmp(*pPageBmp, pRegions[i]->getRect());
+            testEqual(regionBmp, *pBmps[i], sName, 0, 0);
+        }
+    }
+};
+
+
 class GPUTestSuite: public TestSuite {
 public:
     GPUTestSuite(const string& sVariant) 
@@ -512,6 +592,7 @@ public:
     {
         addTest(TestPtr(new TextureMoverTest));
         addTest(TestPtr(new ImageCacheTest));
+        addTest(TestPtr(new TextureAtlasTest));
         addTest(TestPtr(new BrightnessFilterTest));
         addTest(TestPtr(new HueSatFilterTest));
         addTest(TestPtr(new InvertFilterTest));
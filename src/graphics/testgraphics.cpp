@@ -46,11 +46,17 @@
 #include "FilterErosion.h"
 #include "FilterGetAlpha.h"
 #include "FilterResizeBilinear.h"
+#include "FilterResizeGaussian.h"
+#include "FilterExecutor.h"
 #include "FilterUnmultiplyAlpha.h"
+#include "ImageDiskCache.h"
+#include "SkylinePacker.h"
 
 #include "../base/TestSuite.h"
 #include "../base/Exception.h"
+#include "../base/FileHelper.h"
 #include "../base/MathHelper.h"
+#include "../base/SIMDHelper.h"
 
 #ifdef _WIN32
 #pragma warning(push)
@@ -60,6 +66,8 @@
 #pragma warning(pop)
 #endif
 
+#include <boost/bind.hpp>
+
 #include <cstring>
 #include <iostream>
 #include <stdio.h>
@@ -442,6 +450,130 @@ private:
 
 };
 
+BitmapPtr createRandomBmp(const IntPoint& size, PixelFormat pf)
+{
+    BitmapPtr pBmp(new Bitmap(size, pf));
+    unsigned char * pPixels = pBmp->getPixels();
+    for (int i = 0; i < pBmp->getStride()*pBmp->getSize().y; ++i) {
+        pPixels[i] = rand() & 0xFF;
+    }
+    return pBmp;
+}
+
+bool isBitExact(const Bitmap& bmp1, const Bitmap& bmp2)
+{
+    if (bmp1.getSize() != bmp2.getSize()) {
+        return false;
+    }
+    for (int y = 0; y < bmp1.getSize().y; ++y) {
+        const unsigned char * pLine1 = bmp1.getPixels()+y*bmp1.getStride();
+        const unsigned char * pLine2 = bmp2.getPixels()+y*bmp2.getStride();
+        if (memcmp(pLine1, pLine2, bmp1.getLineLen()) != 0) {
+            return false;
+        }
+    }
+    return true;
+}
+
+class PixelConversionTest: public GraphicsTest {
+public:
+    PixelConversionTest()
+        : GraphicsTest("PixelConversionTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        SIMDLevel origLevel = getSIMDLevel();
+        for (int i = SIMD_SSE2; i <= SIMD_NEON; ++i) {
+            SIMDLevel level = SIMDLevel(i);
+            if (isSIMDLevelSupported(level)) {
+                cerr << "    Testing " << getSIMDLevelName(level) << " kernels." << endl;
+                runLevelTests(level);
+            }
+        }
+        setSIMDLevel(origLevel);
+    }
+
+private:
+    void runLevelTests(SIMDLevel level)
+    {
+        // Widths that exercise whole vectors as well as the scalar tails. 4:2:2
+        // formats need even widths.
+        int widths[] = {2, 30, 64, 70, 102};
+        for (unsigned i = 0; i < sizeof(widths)/sizeof(int); ++i) {
+            IntPoint size(widths[i], 6);
+            testConversion(level, YCbCr422, B8G8R8X8, size);
+            testConversion(level, YUYV422, B8G8R8X8, size);
+            testConversion(level, YCbCr422, I8, size);
+            testConversion(level, YUYV422, I8, size);
+            testYUV420(level, size, false);
+            testYUV420(level, size, true);
+
+            // Odd widths for everything else.
+            size.x++;
+            testYUV420(level, size, false);
+            testConversion(level, I8, B8G8R8X8, size);
+            testConversion(level, I8, R8G8B8A8, size);
+            testConversion(level, I16, I8, size);
+            testConversion(level, I8, I16, size);
+            testConversion(level, BAYER8_RGGB, B8G8R8X8, size);
+            testConversion(level, BAYER8_GBRG, B8G8R8X8, size);
+            testConversion(level, BAYER8_GRBG, R8G8B8A8, size);
+            testConversion(level, BAYER8_BGGR, R8G8B8A8, size);
+        }
+    }
+
+    void testConversion(SIMDLevel level, PixelFormat srcPF, PixelFormat destPF,
+            const IntPoint& size)
+    {
+        BitmapPtr pSrcBmp = createRandomBmp(size, srcPF);
+        setSIMDLevel(SIMD_NONE);
+        BitmapPtr pBaselineBmp = createEmptyBmp(size, destPF);
+        pBaselineBmp->copyPixels(*pSrcBmp);
+        setSIMDLevel(level);
+        BitmapPtr pBmp = createEmptyBmp(size, destPF);
+        pBmp->copyPixels(*pSrcBmp);
+        if (!isBitExact(*pBmp, *pBaselineBmp)) {
+            cerr << "      " << srcPF << "->" << destPF << ", width " << size.x
+                    << " differs from scalar version." << endl;
+            TEST_FAILED("");
+        } else {
+            TEST(true);
+        }
+    }
+
+    void testYUV420(SIMDLevel level, const IntPoint& size, bool bJPEG)
+    {
+        IntPoint chromaSize((size.x+1)/2, (size.y+1)/2);
+        BitmapPtr pYBmp = createRandomBmp(size, I8);
+        BitmapPtr pUBmp = createRandomBmp(chromaSize, I8);
+        BitmapPtr pVBmp = createRandomBmp(chromaSize, I8);
+        setSIMDLevel(SIMD_NONE);
+        BitmapPtr pBaselineBmp = createEmptyBmp(size, B8G8R8X8);
+        pBaselineBmp->copyYUVPixels(*pYBmp, *pUBmp, *pVBmp, bJPEG);
+        setSIMDLevel(level);
+        BitmapPtr pBmp = createEmptyBmp(size, B8G8R8X8);
+        pBmp->copyYUVPixels(*pYBmp, *pUBmp, *pVBmp, bJPEG);
+        if (!isBitExact(*pBmp, *pBaselineBmp)) {
+            cerr << "      YUV420" << (bJPEG ? "J" : "") << "->B8G8R8X8, width "
+                    << size.x << " differs from scalar version." << endl;
+            TEST_FAILED("");
+        } else {
+            TEST(true);
+        }
+    }
+
+    // Bayer conversion doesn't touch the border pixels, so they need to be
+    // initialized.
+    BitmapPtr createEmptyBmp(const IntPoint& size, PixelFormat pf)
+    {
+        BitmapPtr pBmp(new Bitmap(size, pf));
+        memset(pBmp->getPixels(), 0, pBmp->getStride()*pBmp->getSize().y);
+        return pBmp;
+    }
+};
+
 class FilterColorizeTest: public GraphicsTest {
 public:
     FilterColorizeTest()
@@ -997,6 +1129,301 @@ private:
 
 };
 
+class FilterExecutorTest: public GraphicsTest {
+public:
+    FilterExecutorTest()
+        : GraphicsTest("FilterExecutorTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        FilterExecutor* pExecutor = FilterExecutor::get();
+        int origNumThreads = pExecutor->getNumThreads();
+        int origMinPixels = pExecutor->getMinPixels();
+
+        testRowCoverage(pExecutor);
+
+        // Odd sizes so bands have different heights.
+        IntPoint sizes[] = {IntPoint(67, 53), IntPoint(320, 241)};
+        for (unsigned i = 0; i < sizeof(sizes)/sizeof(IntPoint); ++i) {
+            IntPoint size = sizes[i];
+            testFilter("Blur", FilterPtr(new FilterBlur()), size, I8);
+            testFilter("Highpass", FilterPtr(new FilterHighpass()), size, I8);
+            testFilter("Bandpass", FilterPtr(new FilterBandpass(1.9f, 3)), size, I8);
+            testFilter("Dilation", FilterPtr(new FilterDilation()), size, I8);
+            testFilter("Erosion", FilterPtr(new FilterErosion()), size, I8);
+            testFilter("Gauss1", FilterPtr(new FilterGauss(1)), size, I8);
+            testFilter("Gauss15", FilterPtr(new FilterGauss(1.5f)), size, I8);
+            testFilter("Gauss3", FilterPtr(new FilterGauss(3)), size, I8);
+            testFilter("Gauss5", FilterPtr(new FilterGauss(5)), size, I8);
+            float mat3x3[3][3] = {{0.1f, 0, 0.2f}, {0, 0.3f, 0}, {0.1f, 0, 0.2f}};
+            testFilter("3x3", FilterPtr(new Filter3x3(mat3x3)), size, R8G8B8X8);
+            testFilter("3x3", FilterPtr(new Filter3x3(mat3x3)), size, R8G8B8);
+            float mat[9] = {0.1f, 0, 0.2f, 0, 0.3f, 0, 0.1f, 0, 0.2f};
+            testFilter("Convol", FilterPtr(new FilterConvol<Pixel8>(mat, 3, 3, 8)), 
+                    size, I8);
+            testFilter("Convol", FilterPtr(new FilterConvol<Pixel32>(mat, 3, 3)), 
+                    size, R8G8B8X8);
+            FilterPtr pFilter(new FilterResizeGaussian(size/2, 1.5f));
+            testFilter("ResizeGaussian", pFilter, size, B8G8R8A8);
+            testFilter("ResizeGaussian", pFilter, size, I8);
+            pFilter = FilterPtr(new FilterResizeBilinear(size/2));
+            testFilter("ResizeBilinear", pFilter, size, B8G8R8);
+        }
+
+        pExecutor->setNumThreads(origNumThreads);
+        pExecutor->setMinPixels(origMinPixels);
+    }
+
+private:
+    void testRowCoverage(FilterExecutor* pExecutor)
+    {
+        pExecutor->setNumThreads(4);
+        pExecutor->setMinPixels(0);
+        for (int numRows = 0; numRows < 40; ++numRows) {
+            vector<int> rowCounts(numRows, 0);
+            pExecutor->run(numRows, 1, boost::bind(&FilterExecutorTest::countRows,
+                    this, pExecutor, &rowCounts, _1, _2));
+            for (int y = 0; y < numRows; ++y) {
+                // Every row is processed once by the outer job and once by the inline
+                // nested job.
+                QUIET_TEST(rowCounts[y] == 2);
+            }
+        }
+    }
+
+    void countRows(FilterExecutor* pExecutor, vector<int>* pRowCounts, int startRow,
+            int endRow)
+    {
+        for (int y = startRow; y < endRow; ++y) {
+            (*pRowCounts)[y]++;
+        }
+        // Nested jobs run on the calling thread.
+        pExecutor->run(endRow-startRow, 1, boost::bind(&FilterExecutorTest::addRows, 
+                this, pRowCounts, startRow, _1, _2));
+    }
+
+    void addRows(vector<int>* pRowCounts, int offset, int startRow, int endRow)
+    {
+        for (int y = startRow; y < endRow; ++y) {
+            (*pRowCounts)[offset+y]++;
+        }
+    }
+
+    void testFilter(const string& sName, FilterPtr pFilter, const IntPoint& size,
+            PixelFormat pf)
+    {
+        BitmapPtr pSrcBmp = createRandomBmp(size, pf);
+        FilterExecutor* pExecutor = FilterExecutor::get();
+        pExecutor->setNumThreads(1);
+        BitmapPtr pBaselineBmp = pFilter->apply(pSrcBmp);
+        pExecutor->setNumThreads(7);
+        pExecutor->setMinPixels(0);
+        BitmapPtr pBmp = pFilter->apply(pSrcBmp);
+        if (!isBitExact(*pBmp, *pBaselineBmp)) {
+            cerr << "      " << sName << ", " << size << ", " << pf 
+                    << ": multithreaded result differs." << endl;
+            TEST_FAILED("");
+        } else {
+            TEST(true);
+        }
+    }
+};
+
+class FilterKernelTest: public GraphicsTest {
+public:
+    FilterKernelTest()
+        : GraphicsTest("FilterKernelTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        SIMDLevel origLevel = getSIMDLevel();
+        for (int i = SIMD_SSE2; i <= SIMD_NEON; ++i) {
+            SIMDLevel level = SIMDLevel(i);
+            if (isSIMDLevelSupported(level)) {
+                cerr << "    Testing " << getSIMDLevelName(level) << " kernels." << endl;
+                runLevelTests(level);
+            }
+        }
+        setSIMDLevel(origLevel);
+        testBoxBlur();
+    }
+
+private:
+    void runLevelTests(SIMDLevel level)
+    {
+        // Widths that exercise whole vectors as well as the scalar tails.
+        int widths[] = {17, 64, 101};
+        for (unsigned i = 0; i < sizeof(widths)/sizeof(int); ++i) {
+            IntPoint size(widths[i], 23);
+            float radii[] = {1, 1.5f, 3, 5, 7};
+            for (unsigned j = 0; j < sizeof(radii)/sizeof(float); ++j) {
+                testFilter(level, "Gauss", FilterPtr(new FilterGauss(radii[j])), size, 
+                        I8);
+            }
+            testFilter(level, "Blur", FilterPtr(new FilterBlur()), size, I8);
+            PixelFormat pfs[] = {I8, R8G8B8, R8G8B8A8};
+            for (unsigned j = 0; j < sizeof(pfs)/sizeof(PixelFormat); ++j) {
+                PixelFormat pf = pfs[j];
+                // Downscaling by large factors needs many taps per pixel.
+                IntPoint destSizes[] = {size/5, IntPoint(size.x-2, size.y/2), 
+                        IntPoint(size.x*2+1, size.y*2)};
+                for (unsigned k = 0; k < sizeof(destSizes)/sizeof(IntPoint); ++k) {
+                    IntPoint destSize = destSizes[k];
+                    testFilter(level, "ResizeGaussian", 
+                            FilterPtr(new FilterResizeGaussian(destSize, 1.5f)), size, pf);
+                    testFilter(level, "ResizeBilinear", 
+                            FilterPtr(new FilterResizeBilinear(destSize)), size, pf);
+                }
+            }
+        }
+    }
+
+    void testFilter(SIMDLevel level, const string& sName, FilterPtr pFilter, 
+            const IntPoint& size, PixelFormat pf)
+    {
+        BitmapPtr pSrcBmp = createRandomBmp(size, pf);
+        setSIMDLevel(SIMD_NONE);
+        BitmapPtr pBaselineBmp = pFilter->apply(pSrcBmp);
+        setSIMDLevel(level);
+        BitmapPtr pBmp = pFilter->apply(pSrcBmp);
+        if (!isBitExact(*pBmp, *pBaselineBmp)) {
+            cerr << "      " << sName << ", " << size << ", " << pf 
+                    << ": result differs from scalar version." << endl;
+            TEST_FAILED("");
+        } else {
+            QUIET_TEST(true);
+        }
+    }
+
+    void testBoxBlur()
+    {
+        IntPoint size(80, 61);
+        BitmapPtr pBmp(new Bitmap(size, I8));
+        FilterFill<Pixel8>(Pixel8(77)).applyInPlace(pBmp);
+        for (int radius = 2; radius <= 28; radius += 13) {
+            BitmapPtr pDestBmp = FilterGauss(float(radius), true).apply(pBmp);
+            TEST(pDestBmp->getSize() == size-IntPoint(2*radius, 2*radius));
+            int min;
+            int max;
+            pDestBmp->getMinMax(1, min, max);
+            TEST(min == 77 && max == 77);
+        }
+
+        // Close to the exact filter for a smooth image. Radii above 3 aren't compared
+        // because the exact filter truncates every tap and darkens the image there.
+        BitmapPtr pSrcBmp(new Bitmap(size, I8));
+        for (int y = 0; y < size.y; ++y) {
+            unsigned char* pLine = pSrcBmp->getPixels()+y*pSrcBmp->getStride();
+            for (int x = 0; x < size.x; ++x) {
+                pLine[x] = (unsigned char)((x*3 + ((x/8+y/8)%2)*100) % 256);
+            }
+        }
+        BitmapPtr pExactBmp = FilterGauss(3).apply(pSrcBmp);
+        BitmapPtr pBoxBmp = FilterGauss(3, true).apply(pSrcBmp);
+        TEST(pBoxBmp->getSize() == pExactBmp->getSize());
+        TEST(pBoxBmp->subtract(*pExactBmp)->getAvg() < 2);
+    }
+};
+
+class ImageDiskCacheTest: public GraphicsTest {
+public:
+    ImageDiskCacheTest()
+        : GraphicsTest("ImageDiskCacheTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        string sDir = "imgdiskcache";
+        // Only the file's size and modification time matter for the cache.
+        string sSrcFile = "imgdiskcache-src.png";
+        writeWholeFile(sSrcFile, "dummy");
+        BitmapPtr pBmp = initBmp(B8G8R8A8);
+        {
+            ImageDiskCache cache(sDir, 1024*1024);
+            cache.clear();
+            TEST(!cache.load(sSrcFile, TEXCOMPRESSION_NONE, true));
+            cache.store(sSrcFile, TEXCOMPRESSION_NONE, true, pBmp);
+            TEST(cache.getNumEntries() == 1);
+            TEST(cache.getNumMisses() == 1);
+        }
+        {
+            // New instance: Entry is found on disk.
+            ImageDiskCache cache(sDir, 1024*1024);
+            TEST(cache.getNumEntries() == 1);
+            BitmapPtr pCachedBmp = cache.load(sSrcFile, TEXCOMPRESSION_NONE, true);
+            TEST(pCachedBmp && *pCachedBmp == *pBmp);
+            TEST(cache.getNumHits() == 1);
+            TEST(!cache.load(sSrcFile, TEXCOMPRESSION_B5G6R5, true));
+            TEST(!cache.load(sSrcFile, TEXCOMPRESSION_NONE, false));
+
+            // Source file changed: Entry is stale.
+            writeWholeFile(sSrcFile, "changed dummy");
+            TEST(!cache.load(sSrcFile, TEXCOMPRESSION_NONE, true));
+            cache.store(sSrcFile, TEXCOMPRESSION_NONE, true, pBmp);
+            TEST(cache.getNumEntries() == 2);
+
+            // Mapped bitmaps stay valid after eviction.
+            pCachedBmp = cache.load(sSrcFile, TEXCOMPRESSION_NONE, true);
+            cache.setCapacity(0);
+            TEST(cache.getNumEntries() == 0);
+            TEST(cache.getMemUsed() == 0);
+            TEST(cache.getNumEvictions() == 2);
+            TEST(*pCachedBmp == *pBmp);
+        }
+        remove(sSrcFile.c_str());
+        remove(sDir.c_str());
+    }
+};
+
+class SkylinePackerTest: public Test {
+public:
+    SkylinePackerTest()
+        : Test("SkylinePackerTest", 2)
+    {
+    }
+
+    void runTests() 
+    {
+        SkylinePacker packer(IntPoint(64, 64));
+        IntPoint pos;
+        TEST(packer.insert(IntPoint(32, 16), pos));
+        TEST(pos == IntPoint(0, 0));
+        TEST(packer.insert(IntPoint(32, 32), pos));
+        TEST(pos == IntPoint(32, 0));
+        // Lowest position wins.
+        TEST(packer.insert(IntPoint(32, 16), pos));
+        TEST(pos == IntPoint(0, 16));
+        TEST(packer.getUsedArea() == 2048);
+        TEST(!packer.insert(IntPoint(65, 1), pos));
+        TEST(!packer.insert(IntPoint(1, 65), pos));
+
+        // Fill the rest of the area with small rects and check for overlaps.
+        vector<IntRect> rects;
+        rects.push_back(IntRect(0, 0, 64, 32));
+        while (packer.insert(IntPoint(7, 5), pos)) {
+            IntRect rect(pos, pos+IntPoint(7, 5));
+            TEST(rect.br.x <= 64 && rect.br.y <= 64);
+            for (unsigned i = 0; i < rects.size(); ++i) {
+                IntRect intersection = rects[i];
+                intersection.intersect(rect);
+                TEST(intersection.width() <= 0 || intersection.height() <= 0);
+            }
+            rects.push_back(rect);
+        }
+        TEST(rects.size() == 1+9*6);
+        
+        packer.reset();
+        TEST(packer.getUsedArea() == 0);
+        TEST(packer.insert(IntPoint(64, 64), pos));
+        TEST(pos == IntPoint(0, 0));
+    }
+};
+
 class GraphicsTestSuite: public TestSuite {
 public:
     GraphicsTestSuite() 
@@ -1006,6 +1433,7 @@ public:
         addTest(TestPtr(new PixelTest));
         addTest(TestPtr(new ColorTest));
         addTest(TestPtr(new BitmapTest));
+        addTest(TestPtr(new PixelConversionTest));
         addTest(TestPtr(new Filter3x3Test));
         addTest(TestPtr(new FilterConvolTest));
         addTest(TestPtr(new FilterColorizeTest));
@@ -1028,6 +1456,10 @@ public:
         addTest(TestPtr(new FilterAlphaTest));
         addTest(TestPtr(new FilterResizeBilinearTest));
         addTest(TestPtr(new FilterUnmultiplyAlphaTest));
+        addTest(TestPtr(new FilterExecutorTest));
+        addTest(TestPtr(new FilterKernelTest));
+        addTest(TestPtr(new ImageDiskCacheTest));
+        addTest(TestPtr(new SkylinePackerTest));
     }
 };
 
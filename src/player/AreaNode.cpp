@@ -111,6 +111,8 @@ void AreaNode::connectDisplay()
         notifySubscribers("SIZE_CHANGED", m_RelViewport.size());
     }
     m_bTransformChanged = true;
+    hitTestBoundsChanged();
+    setCanvasDirty();
     Node::connectDisplay();
 }
 
@@ -186,6 +188,8 @@ void AreaNode::setAngle(float angle)
 {
     m_Angle = fmod(angle, 2*(float)M_PI);
     m_bTransformChanged = true;
+    hitTestBoundsChanged();
+    setCanvasDirty();
 }
 
 glm::vec2 AreaNode::getPivot() const
@@ -203,6 +207,8 @@ void AreaNode::setPivot(const glm::vec2& pt)
     m_Pivot.y = pt.y;
     m_bHasCustomPivot = true;
     m_bTransformChanged = true;
+    hitTestBoundsChanged();
+    setCanvasDirty();
 }
 
 const std::string& AreaNode::getElementOutlineColor() const
@@ -218,6 +224,7 @@ void AreaNode::setElementOutlineColor(const std::string& sColor)
     } else {
         m_ElementOutlineColor = Color(m_sElementOutlineColor);
     }
+    setCanvasDirty();
 }
 
 glm::vec2 AreaNode::toLocal(const glm::vec2& globalPos) const
@@ -241,6 +248,19 @@ void AreaNode::getElementsByPos(const glm::vec2& pos, NodeChainPtr& pElements)
     }
 }
 
+bool AreaNode::getHitTestBounds(FRect& bounds) const
+{
+    glm::vec2 size = getSize();
+    bounds = FRect(toGlobal(glm::vec2(0,0)), toGlobal(glm::vec2(0,0)));
+    bounds.expand(toGlobal(glm::vec2(size.x, 0)));
+    bounds.expand(toGlobal(glm::vec2(0, size.y)));
+    bounds.expand(toGlobal(size));
+    // Make up for rounding errors in toLocal().
+    bounds.tl -= glm::vec2(1,1);
+    bounds.br += glm::vec2(1,1);
+    return true;
+}
+
 void AreaNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
         float parentEffectiveOpacity)
 {
@@ -258,6 +278,11 @@ void AreaNode::maybeRender(GLContext* pContext, const glm::mat4& parentTransform
     }
 }
 
+const glm::mat4& AreaNode::getLocalTransform() const
+{
+    return m_LocalTransform;
+}
+
 void AreaNode::renderOutlines(const VertexArrayPtr& pVA, Pixel32 parentColor)
 {
     Pixel32 effColor = getEffectiveOutlineColor(parentColor);
@@ -306,6 +331,8 @@ void AreaNode::setViewport(float x, float y, float width, float height)
         notifySubscribers("SIZE_CHANGED", m_RelViewport.size());
     }
     m_bTransformChanged = true;
+    hitTestBoundsChanged();
+    setCanvasDirty();
 }
 
 const FRect& AreaNode::getRelViewport() const
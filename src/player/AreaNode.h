@@ -85,6 +85,7 @@ class AVG_API AreaNode: public Node
         virtual glm::vec2 toGlobal(const glm::vec2& localPos) const;
         
         virtual void getElementsByPos(const glm::vec2& pos, NodeChainPtr& pElements);
+        virtual bool getHitTestBounds(FRect& bounds) const;
 
         virtual void preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
                 float parentEffectiveOpacity);
@@ -103,6 +104,7 @@ class AVG_API AreaNode: public Node
     protected:
         AreaNode(const std::string& sPublisherName);
         glm::vec2 getUserSize() const;
+        const glm::mat4& getLocalTransform() const;
         Pixel32 getEffectiveOutlineColor(Pixel32 parentColor) const;
 
     private:
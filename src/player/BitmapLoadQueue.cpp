@@ -0,0 +1,203 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "BitmapLoadQueue.h"
+
+#include "../base/Exception.h"
+
+using namespace std;
+
+namespace avg {
+
+BitmapLoadQueue::BitmapLoadQueue()
+    : m_NextSeq(0),
+      m_NextSubQueue(0),
+      m_NumPending(0),
+      m_bClosed(false)
+{
+    setNumSubQueues(1);
+}
+
+BitmapLoadQueue::~BitmapLoadQueue()
+{
+    for (unsigned i = 0; i < m_pSubQueues.size(); ++i) {
+        delete m_pSubQueues[i];
+    }
+}
+
+void BitmapLoadQueue::setNumSubQueues(int numSubQueues)
+{
+    AVG_ASSERT(numSubQueues > 0);
+    vector<pair<EntryKey, Entry> > entries;
+    for (unsigned i = 0; i < m_pSubQueues.size(); ++i) {
+        EntryMap& subQueueEntries = m_pSubQueues[i]->m_Entries;
+        for (auto it = subQueueEntries.begin(); it != subQueueEntries.end(); ++it) {
+            if (it->second.m_Generation == it->second.m_pMsg->getGeneration()) {
+                entries.push_back(*it);
+            }
+        }
+        delete m_pSubQueues[i];
+    }
+    m_pSubQueues.clear();
+    for (int i = 0; i < numSubQueues; ++i) {
+        m_pSubQueues.push_back(new SubQueue);
+    }
+    for (unsigned i = 0; i < entries.size(); ++i) {
+        m_pSubQueues[i % numSubQueues]->m_Entries.insert(entries[i]);
+    }
+}
+
+void BitmapLoadQueue::push(BitmapManagerMsgPtr pMsg)
+{
+    m_NumPending++;
+    insert(pMsg);
+    boost::mutex::scoped_lock lock(m_WaitMutex);
+    m_WaitCond.notify_one();
+}
+
+void BitmapLoadQueue::setPriority(BitmapManagerMsgPtr pMsg, int priority)
+{
+    if (pMsg->getPriority() != priority) {
+        pMsg->setPriority(priority);
+        // Invalidates the current entry.
+        pMsg->incGeneration();
+        insert(pMsg);
+    }
+}
+
+bool BitmapLoadQueue::cancel(BitmapManagerMsgPtr pMsg)
+{
+    if (pMsg->cancelLoading()) {
+        m_NumPending--;
+        return true;
+    } else {
+        return false;
+    }
+}
+
+BitmapManagerMsgPtr BitmapLoadQueue::pop(int subQueueIndex)
+{
+    while (true) {
+        {
+            boost::mutex::scoped_lock lock(m_WaitMutex);
+            while (m_NumPending == 0 && !m_bClosed) {
+                m_WaitCond.wait(lock);
+            }
+            if (m_bClosed) {
+                return BitmapManagerMsgPtr();
+            }
+        }
+        BitmapManagerMsgPtr pMsg = tryPop(subQueueIndex);
+        if (pMsg) {
+            return pMsg;
+        }
+    }
+}
+
+void BitmapLoadQueue::close()
+{
+    boost::mutex::scoped_lock lock(m_WaitMutex);
+    m_bClosed = true;
+    m_WaitCond.notify_all();
+}
+
+void BitmapLoadQueue::open()
+{
+    boost::mutex::scoped_lock lock(m_WaitMutex);
+    m_bClosed = false;
+}
+
+void BitmapLoadQueue::clear()
+{
+    for (unsigned i = 0; i < m_pSubQueues.size(); ++i) {
+        boost::mutex::scoped_lock lock(m_pSubQueues[i]->m_Mutex);
+        EntryMap& entries = m_pSubQueues[i]->m_Entries;
+        for (auto it = entries.begin(); it != entries.end(); ++it) {
+            if (it->second.m_Generation == it->second.m_pMsg->getGeneration()) {
+                cancel(it->second.m_pMsg);
+            }
+        }
+        entries.clear();
+    }
+}
+
+int BitmapLoadQueue::getNumPending() const
+{
+    return m_NumPending;
+}
+
+void BitmapLoadQueue::insert(BitmapManagerMsgPtr pMsg)
+{
+    SubQueue& subQueue = *m_pSubQueues[m_NextSubQueue++ % m_pSubQueues.size()];
+    Entry entry;
+    entry.m_pMsg = pMsg;
+    entry.m_Generation = pMsg->getGeneration();
+    EntryKey key(-pMsg->getPriority(), m_NextSeq++);
+    boost::mutex::scoped_lock lock(subQueue.m_Mutex);
+    subQueue.m_Entries[key] = entry;
+}
+
+bool BitmapLoadQueue::popBest(SubQueue& subQueue, Entry& entry)
+{
+    boost::mutex::scoped_lock lock(subQueue.m_Mutex);
+    EntryMap& entries = subQueue.m_Entries;
+    while (!entries.empty() && 
+            entries.begin()->second.m_Generation != 
+                    entries.begin()->second.m_pMsg->getGeneration())
+    {
+        entries.erase(entries.begin());
+    }
+    if (entries.empty()) {
+        return false;
+    } else {
+        entry = entries.begin()->second;
+        entries.erase(entries.begin());
+        return true;
+    }
+}
+
+BitmapManagerMsgPtr BitmapLoadQueue::tryPop(int subQueueIndex)
+{
+    // Only the own sub-queue is locked as long as it has work. Other sub-queues are
+    // visited only when it is empty, starting with the next one so the victims are
+    // spread among the threads.
+    int numSubQueues = int(m_pSubQueues.size());
+    Entry entry;
+    bool bFound = false;
+    for (int i = 0; i < numSubQueues && !bFound; ++i) {
+        int index = (subQueueIndex+i) % numSubQueues;
+        bFound = popBest(*m_pSubQueues[index], entry);
+    }
+    if (!bFound) {
+        return BitmapManagerMsgPtr();
+    }
+    BitmapManagerMsgPtr pMsg = entry.m_pMsg;
+    if (pMsg->startLoading()) {
+        m_NumPending--;
+        return pMsg;
+    } else {
+        // Cancelled.
+        return BitmapManagerMsgPtr();
+    }
+}
+
+}
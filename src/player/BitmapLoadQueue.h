@@ -0,0 +1,96 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _BitmapLoadQueue_H_
+#define _BitmapLoadQueue_H_
+
+#include "../api.h"
+
+#include "BitmapManagerMsg.h"
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+
+#include <atomic>
+#include <map>
+#include <vector>
+
+namespace avg {
+
+// Pending BitmapManager requests, sorted by priority and then by age. There is one
+// sub-queue per loader thread and requests are distributed among the sub-queues
+// round-robin. A thread takes the most important request of its own sub-queue and
+// only steals from the other sub-queues when its own one is empty. Priorities are
+// therefore strict within a sub-queue and approximate across threads.
+//
+// Cancelled and requeued requests leave stale entries behind. These are discarded
+// when they reach the head of their sub-queue.
+class AVG_API BitmapLoadQueue
+{
+public:
+    BitmapLoadQueue();
+    virtual ~BitmapLoadQueue();
+
+    // Must only be called if no thread is waiting in pop().
+    void setNumSubQueues(int numSubQueues);
+    void push(BitmapManagerMsgPtr pMsg);
+    void setPriority(BitmapManagerMsgPtr pMsg, int priority);
+    bool cancel(BitmapManagerMsgPtr pMsg);
+
+    // Blocks until a request is available. Returns an empty pointer after close(). 
+    BitmapManagerMsgPtr pop(int subQueueIndex);
+    void close();
+    void open();
+    void clear();
+
+    int getNumPending() const;
+
+private:
+    // Priority (inverted, so higher priorities sort first) and sequence number.
+    typedef std::pair<int, long long> EntryKey;
+    struct Entry {
+        BitmapManagerMsgPtr m_pMsg;
+        int m_Generation;
+    };
+    typedef std::map<EntryKey, Entry> EntryMap;
+    struct SubQueue {
+        boost::mutex m_Mutex;
+        EntryMap m_Entries;
+    };
+
+    void insert(BitmapManagerMsgPtr pMsg);
+    bool popBest(SubQueue& subQueue, Entry& entry);
+    BitmapManagerMsgPtr tryPop(int subQueueIndex);
+
+    std::vector<SubQueue*> m_pSubQueues;
+    std::atomic<long long> m_NextSeq;
+    std::atomic<unsigned> m_NextSubQueue;
+    std::atomic<int> m_NumPending;
+
+    boost::mutex m_WaitMutex;
+    boost::condition m_WaitCond;
+    bool m_bClosed;
+};
+
+}
+
+#endif
@@ -30,6 +30,8 @@
 
 #include "../base/OSHelper.h"
 
+#include <climits>
+
 using namespace std;
 
 namespace avg {
@@ -37,13 +39,16 @@ namespace avg {
 BitmapManager * BitmapManager::s_pBitmapManager=0;
 
 BitmapManager::BitmapManager()
+    : m_NextRequestID(1)
 {
     if (s_pBitmapManager) {
         throw Exception(AVG_ERR_UNKNOWN, "BitmapMananger has already been instantiated.");
     }
     
     m_pCmdQueue = BitmapManagerThread::CQueuePtr(new BitmapManagerThread::CQueue);
-    m_pMsgQueue = BitmapManagerMsgQueuePtr(new BitmapManagerMsgQueue(8));
+    // Unbounded, so loader threads never block when the main thread waits for them
+    // to stop.
+    m_pMsgQueue = BitmapManagerMsgQueuePtr(new BitmapManagerMsgQueue());
 
     startThreads(1);
 
@@ -52,6 +57,7 @@ BitmapManager::BitmapManager()
 
 BitmapManager::~BitmapManager()
 {
+    m_LoadQueue.clear();
     while (!m_pCmdQueue->empty()) {
         m_pCmdQueue->pop();
     }
@@ -70,22 +76,68 @@ BitmapManager* BitmapManager::get()
     return s_pBitmapManager;
 }
 
-void BitmapManager::loadBitmapPy(const UTF8String& sUtf8FileName,
-        const boost::python::object& pyFunc, PixelFormat pf)
+int BitmapManager::loadBitmapPy(const UTF8String& sUtf8FileName,
+        const boost::python::object& pyFunc, PixelFormat pf, int priority)
 {
-    std::string sFileName = convertUTF8ToFilename(sUtf8FileName);
     BitmapManagerMsgPtr pMsg = BitmapManagerMsgPtr(
-            new BitmapManagerMsg(sUtf8FileName, pyFunc, pf));
-    internalLoadBitmap(pMsg);
+            new BitmapManagerMsg(m_NextRequestID++, sUtf8FileName, pyFunc, pf, priority));
+    return internalLoadBitmap(pMsg, priority);
 }
 
-void BitmapManager::loadBitmap(const UTF8String& sUtf8FileName,
-        IBitmapLoadedListener* pLoadedListener, PixelFormat pf)
+int BitmapManager::loadBitmap(const UTF8String& sUtf8FileName,
+        IBitmapLoadedListener* pLoadedListener, PixelFormat pf, int priority)
 {
-    std::string sFileName = convertUTF8ToFilename(sUtf8FileName);
-    BitmapManagerMsgPtr pMsg = BitmapManagerMsgPtr(
-            new BitmapManagerMsg(sUtf8FileName, pLoadedListener, pf));
-    internalLoadBitmap(pMsg);
+    BitmapManagerMsgPtr pMsg = BitmapManagerMsgPtr(new BitmapManagerMsg(
+            m_NextRequestID++, sUtf8FileName, pLoadedListener, pf, priority));
+    return internalLoadBitmap(pMsg, priority);
+}
+
+bool BitmapManager::cancelRequest(int requestID)
+{
+    RequestMap::iterator it = m_Requests.find(requestID);
+    if (it == m_Requests.end()) {
+        return false;
+    }
+    LoadKey key = getLoadKey(it->second.m_pMsg);
+    m_Requests.erase(it);
+    LoadMap::iterator loadIt = m_pLoads.find(key);
+    if (loadIt != m_pLoads.end()) {
+        loadIt->second->removeFollower(requestID);
+        updateLoad(loadIt);
+    }
+    return true;
+}
+
+void BitmapManager::cancelRequests(IBitmapLoadedListener* pLoadedListener)
+{
+    vector<int> requestIDs;
+    for (RequestMap::iterator it = m_Requests.begin(); it != m_Requests.end(); ++it) {
+        if (it->second.m_pMsg->getLoadedListener() == pLoadedListener) {
+            requestIDs.push_back(it->first);
+        }
+    }
+    for (unsigned i = 0; i < requestIDs.size(); ++i) {
+        cancelRequest(requestIDs[i]);
+    }
+}
+
+bool BitmapManager::setPriority(int requestID, int priority)
+{
+    RequestMap::iterator it = m_Requests.find(requestID);
+    if (it == m_Requests.end()) {
+        return false;
+    }
+    it->second.m_Priority = priority;
+    LoadMap::iterator loadIt = m_pLoads.find(getLoadKey(it->second.m_pMsg));
+    if (loadIt != m_pLoads.end()) {
+        updateLoad(loadIt);
+    }
+    return true;
+}
+
+int BitmapManager::getNumPendingRequests() const
+{
+    return m_LoadQueue.getNumPending();
 }
 
 void BitmapManager::setNumThreads(int numThreads)
@@ -98,12 +150,17 @@ void BitmapManager::onFrameEnd()
 {
     while (!m_pMsgQueue->empty()) {
         BitmapManagerMsgPtr pMsg = m_pMsgQueue->pop();
-        pMsg->executeCallback();
+        dispatchResult(pMsg);
     }
 }
 
-void BitmapManager::internalLoadBitmap(BitmapManagerMsgPtr pMsg)
+int BitmapManager::internalLoadBitmap(BitmapManagerMsgPtr pMsg, int priority)
 {
+    Request request;
+    request.m_pMsg = pMsg;
+    request.m_Priority = priority;
+    m_Requests[pMsg->getID()] = request;
+
 #ifdef WIN32
     int rc = _access(pMsg->getFilename().c_str(), 04);
 #else
@@ -117,25 +174,87 @@ void BitmapManager::internalLoadBitmap(BitmapManagerMsgPtr pMsg)
                 strerror(errno)));
         m_pMsgQueue->push(pMsg);
     } else {
-        m_pCmdQueue->pushCmd(boost::bind(&BitmapManagerThread::loadBitmap, _1, pMsg));
+        LoadKey key = getLoadKey(pMsg);
+        LoadMap::iterator loadIt = m_pLoads.find(key);
+        if (loadIt == m_pLoads.end()) {
+            m_pLoads[key] = pMsg;
+            m_LoadQueue.push(pMsg);
+        } else {
+            // The file is already being loaded.
+            loadIt->second->addFollower(pMsg);
+            updateLoad(loadIt);
+        }
+    }
+    return pMsg->getID();
+}
+
+void BitmapManager::updateLoad(LoadMap::iterator loadIt)
+{
+    // The load gets the highest priority of all requests it serves.
+    BitmapManagerMsgPtr pLoad = loadIt->second;
+    bool bUsed = false;
+    int priority = INT_MIN;
+    RequestMap::iterator it = m_Requests.find(pLoad->getID());
+    if (it != m_Requests.end()) {
+        bUsed = true;
+        priority = it->second.m_Priority;
+    }
+    const vector<BitmapManagerMsgPtr>& pFollowers = pLoad->getFollowers();
+    for (unsigned i = 0; i < pFollowers.size(); ++i) {
+        bUsed = true;
+        priority = max(priority, m_Requests[pFollowers[i]->getID()].m_Priority);
+    }
+    if (bUsed) {
+        m_LoadQueue.setPriority(pLoad, priority);
+    } else if (m_LoadQueue.cancel(pLoad)) {
+        m_pLoads.erase(loadIt);
+    }
+    // else: The file is already being loaded. The result will be discarded.
+}
+
+void BitmapManager::dispatchResult(BitmapManagerMsgPtr pMsg)
+{
+    vector<BitmapManagerMsgPtr> pMsgs(1, pMsg);
+    LoadMap::iterator loadIt = m_pLoads.find(getLoadKey(pMsg));
+    if (loadIt != m_pLoads.end() && loadIt->second == pMsg) {
+        const vector<BitmapManagerMsgPtr>& pFollowers = pMsg->getFollowers();
+        for (unsigned i = 0; i < pFollowers.size(); ++i) {
+            pFollowers[i]->setResult(*pMsg);
+            pMsgs.push_back(pFollowers[i]);
+        }
+        m_pLoads.erase(loadIt);
+    }
+    for (unsigned i = 0; i < pMsgs.size(); ++i) {
+        RequestMap::iterator it = m_Requests.find(pMsgs[i]->getID());
+        // Requests that have been cancelled aren't in the map anymore.
+        if (it != m_Requests.end()) {
+            m_Requests.erase(it);
+            pMsgs[i]->executeCallback();
+        }
     }
 }
 
+BitmapManager::LoadKey BitmapManager::getLoadKey(BitmapManagerMsgPtr pMsg)
+{
+    return LoadKey(pMsg->getFilename(), pMsg->getPixelFormat());
+}
+
 void BitmapManager::startThreads(int numThreads)
 {
+    m_LoadQueue.setNumSubQueues(numThreads);
+    m_LoadQueue.open();
     for (int i=0; i<numThreads; ++i) {
         boost::thread* pThread = new boost::thread(
-                BitmapManagerThread(*m_pCmdQueue, *m_pMsgQueue));
+                BitmapManagerThread(*m_pCmdQueue, m_LoadQueue, i, *m_pMsgQueue));
         m_pBitmapManagerThreads.push_back(pThread);
     }
 }
 
 void BitmapManager::stopThreads()
 {
+    // Threads finish their current load and exit. Pending requests stay queued.
+    m_LoadQueue.close();
     int numThreads = m_pBitmapManagerThreads.size();
-    for (int i=0; i<numThreads; ++i) {
-        m_pCmdQueue->pushCmd(boost::bind(&BitmapManagerThread::stop, _1));
-    }
     for (int i=0; i<numThreads; ++i) {
         boost::thread* pThread = m_pBitmapManagerThreads[i];
         pThread->join();
@@ -26,12 +26,15 @@
 
 #include "BitmapManagerThread.h"
 #include "BitmapManagerMsg.h"
+#include "BitmapLoadQueue.h"
 
 #include "../base/Queue.h"
 #include "../base/IFrameEndListener.h"
 
 #include <boost/thread.hpp>
 
+#include <map>
+#include <string>
 #include <vector>
 
 namespace avg {
@@ -42,16 +45,37 @@ class AVG_API BitmapManager : public IFrameEndListener
         BitmapManager();
         ~BitmapManager();
         static BitmapManager* get();
-        void loadBitmapPy(const UTF8String& sUtf8FileName,
-                const boost::python::object& pyFunc, PixelFormat pf=NO_PIXELFORMAT);
-        void loadBitmap(const UTF8String& sUtf8FileName,
-                IBitmapLoadedListener* pLoadedListener, PixelFormat pf=NO_PIXELFORMAT);
+        // The load functions return a request id that can be used to cancel the
+        // request or change its priority. Requests with higher priorities are loaded
+        // first.
+        int loadBitmapPy(const UTF8String& sUtf8FileName,
+                const boost::python::object& pyFunc, PixelFormat pf=NO_PIXELFORMAT,
+                int priority=0);
+        int loadBitmap(const UTF8String& sUtf8FileName,
+                IBitmapLoadedListener* pLoadedListener, PixelFormat pf=NO_PIXELFORMAT,
+                int priority=0);
+        // After a successful cancel, the callback isn't invoked anymore.
+        bool cancelRequest(int requestID);
+        void cancelRequests(IBitmapLoadedListener* pLoadedListener);
+        bool setPriority(int requestID, int priority);
+        int getNumPendingRequests() const;
         void setNumThreads(int numThreads);
 
         virtual void onFrameEnd();
         
     private:
-        void internalLoadBitmap(BitmapManagerMsgPtr pMsg);
+        typedef std::pair<std::string, PixelFormat> LoadKey;
+        struct Request {
+            BitmapManagerMsgPtr m_pMsg;
+            int m_Priority;
+        };
+        typedef std::map<int, Request> RequestMap;
+        typedef std::map<LoadKey, BitmapManagerMsgPtr> LoadMap;
+
+        int internalLoadBitmap(BitmapManagerMsgPtr pMsg, int priority);
+        void updateLoad(LoadMap::iterator loadIt);
+        void dispatchResult(BitmapManagerMsgPtr pMsg);
+        LoadKey getLoadKey(BitmapManagerMsgPtr pMsg);
         void startThreads(int numThreads);
         void stopThreads();
 
@@ -59,7 +83,15 @@ class AVG_API BitmapManager : public IFrameEndListener
 
         std::vector<boost::thread*> m_pBitmapManagerThreads;
         BitmapManagerThread::CQueuePtr m_pCmdQueue;
+        BitmapLoadQueue m_LoadQueue;
         BitmapManagerMsgQueuePtr m_pMsgQueue;
+
+        int m_NextRequestID;
+        // All requests that haven't been answered or cancelled yet.
+        RequestMap m_Requests;
+        // Requests that actually load a file. Requests for the same file and pixel 
+        // format are attached to these as followers.
+        LoadMap m_pLoads;
 };
 
 }
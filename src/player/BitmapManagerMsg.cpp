@@ -29,20 +29,20 @@
 
 namespace avg {
 
-BitmapManagerMsg::BitmapManagerMsg(const UTF8String& sFilename,
-        const boost::python::object& onLoadedCb, PixelFormat pf) 
+BitmapManagerMsg::BitmapManagerMsg(int id, const UTF8String& sFilename,
+        const boost::python::object& onLoadedCb, PixelFormat pf, int priority) 
 {
     ObjectCounter::get()->incRef(&typeid(*this));
-    init(sFilename, pf);
+    init(id, sFilename, pf, priority);
     m_OnLoadedCb = onLoadedCb;
     m_pLoadedListener = 0;
 }
 
-BitmapManagerMsg::BitmapManagerMsg(const UTF8String& sFilename,
-        IBitmapLoadedListener* pLoadedListener, PixelFormat pf)
+BitmapManagerMsg::BitmapManagerMsg(int id, const UTF8String& sFilename,
+        IBitmapLoadedListener* pLoadedListener, PixelFormat pf, int priority)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
-    init(sFilename, pf);
+    init(id, sFilename, pf, priority);
     m_OnLoadedCb = boost::python::object();
     m_pLoadedListener = pLoadedListener;
 }
@@ -55,13 +55,18 @@ BitmapManagerMsg::~BitmapManagerMsg()
     ObjectCounter::get()->decRef(&typeid(*this));
 }
 
-void BitmapManagerMsg::init(const UTF8String& sFilename, PixelFormat pf)
+void BitmapManagerMsg::init(int id, const UTF8String& sFilename, PixelFormat pf,
+        int priority)
 {
+    m_ID = id;
     m_sFilename = sFilename;
-    m_StartTime = TimeSource::get()->getCurrentMicrosecs()/1000.0f;
+    m_StartTime = TimeSource::get()->getCurrentMicrosecs();
     m_PF = pf;
     m_MsgType = REQUEST;
     m_pEx = 0;
+    m_LoadState = PENDING;
+    m_Priority = priority;
+    m_Generation = 0;
 }
 
 void BitmapManagerMsg::executeCallback()
@@ -87,12 +92,17 @@ void BitmapManagerMsg::executeCallback()
     }
 }
     
+int BitmapManagerMsg::getID() const
+{
+    return m_ID;
+}
+
 const UTF8String BitmapManagerMsg::getFilename()
 {
     return m_sFilename;
 }
 
-float BitmapManagerMsg::getStartTime()
+long long BitmapManagerMsg::getStartTime()
 {
     AVG_ASSERT(m_MsgType == REQUEST);
     return m_StartTime;
@@ -100,10 +110,14 @@ float BitmapManagerMsg::getStartTime()
     
 PixelFormat BitmapManagerMsg::getPixelFormat()
 {
-    AVG_ASSERT(m_MsgType == REQUEST);
     return m_PF;
 }
 
+IBitmapLoadedListener* BitmapManagerMsg::getLoadedListener() const
+{
+    return m_pLoadedListener;
+}
+
 void BitmapManagerMsg::setBitmap(BitmapPtr pBmp)
 {
     AVG_ASSERT(m_MsgType == REQUEST);
@@ -118,4 +132,71 @@ void BitmapManagerMsg::setError(const Exception& ex)
     m_pEx = new Exception(ex);
 }
 
+void BitmapManagerMsg::setResult(const BitmapManagerMsg& otherMsg)
+{
+    switch (otherMsg.m_MsgType) {
+        case BITMAP:
+            setBitmap(otherMsg.m_pBmp);
+            break;
+        case ERROR:
+            setError(*otherMsg.m_pEx);
+            break;
+        default:
+            AVG_ASSERT(false);
+    }
+}
+
+bool BitmapManagerMsg::startLoading()
+{
+    int state = PENDING;
+    return m_LoadState.compare_exchange_strong(state, LOADING);
+}
+
+bool BitmapManagerMsg::cancelLoading()
+{
+    int state = PENDING;
+    return m_LoadState.compare_exchange_strong(state, CANCELLED);
+}
+
+int BitmapManagerMsg::getPriority() const
+{
+    return m_Priority;
+}
+
+void BitmapManagerMsg::setPriority(int priority)
+{
+    m_Priority = priority;
+}
+
+int BitmapManagerMsg::getGeneration() const
+{
+    return m_Generation;
+}
+
+int BitmapManagerMsg::incGeneration()
+{
+    return ++m_Generation;
+}
+
+void BitmapManagerMsg::addFollower(BitmapManagerMsgPtr pMsg)
+{
+    m_pFollowers.push_back(pMsg);
+}
+
+bool BitmapManagerMsg::removeFollower(int id)
+{
+    for (auto it = m_pFollowers.begin(); it != m_pFollowers.end(); ++it) {
+        if ((*it)->getID() == id) {
+            m_pFollowers.erase(it);
+            return true;
+        }
+    }
+    return false;
+}
+
+const std::vector<BitmapManagerMsgPtr>& BitmapManagerMsg::getFollowers() const
+{
+    return m_pFollowers;
+}
+
 }
@@ -34,6 +34,9 @@
 #include <boost/shared_ptr.hpp>
 #include <boost/python.hpp>
 
+#include <atomic>
+#include <vector>
+
 
 namespace avg {
 
@@ -41,39 +44,70 @@ class Bitmap;
 typedef boost::shared_ptr<Bitmap> BitmapPtr;
 class IBitmapLoadedListener;
 
+class BitmapManagerMsg;
+typedef boost::shared_ptr<BitmapManagerMsg> BitmapManagerMsgPtr;
+
 class AVG_API BitmapManagerMsg
 {
 public:
     enum MsgType {REQUEST, BITMAP, ERROR};
 
-    BitmapManagerMsg(const UTF8String& sFilename,
-            const boost::python::object& onLoadedCb, PixelFormat pf);
-    BitmapManagerMsg(const UTF8String& sFilename,
-            IBitmapLoadedListener* pLoadedListener, PixelFormat pf);
+    BitmapManagerMsg(int id, const UTF8String& sFilename,
+            const boost::python::object& onLoadedCb, PixelFormat pf, int priority);
+    BitmapManagerMsg(int id, const UTF8String& sFilename,
+            IBitmapLoadedListener* pLoadedListener, PixelFormat pf, int priority);
     virtual ~BitmapManagerMsg();
-    void init(const UTF8String& sFilename, PixelFormat pf);
+    void init(int id, const UTF8String& sFilename, PixelFormat pf, int priority);
 
     void executeCallback();
+    int getID() const;
     const UTF8String getFilename();
-    float getStartTime();
+    long long getStartTime();
     PixelFormat getPixelFormat();
+    IBitmapLoadedListener* getLoadedListener() const;
     void setBitmap(BitmapPtr pBmp);
     void setError(const Exception& ex);
+    void setResult(const BitmapManagerMsg& otherMsg);
 
     MsgType getType() { return m_MsgType; };
 
+    // Load state, shared between the main thread and the loader threads. Exactly one
+    // of startLoading() and cancelLoading() succeeds.
+    bool startLoading();
+    bool cancelLoading();
+
+    // The generation changes whenever the request is requeued with a different
+    // priority. Queue entries of older generations are stale.
+    int getPriority() const;
+    void setPriority(int priority);
+    int getGeneration() const;
+    int incGeneration();
+
+    // Requests for the same file that are served by this request's load. 
+    // Main thread only.
+    void addFollower(BitmapManagerMsgPtr pMsg);
+    bool removeFollower(int id);
+    const std::vector<BitmapManagerMsgPtr>& getFollowers() const;
+
 private:
+    enum LoadState {PENDING, LOADING, CANCELLED};
+
+    int m_ID;
     UTF8String m_sFilename;
-    float m_StartTime;
+    long long m_StartTime;
     BitmapPtr m_pBmp;
     boost::python::object m_OnLoadedCb;
     IBitmapLoadedListener* m_pLoadedListener;
     PixelFormat m_PF;
     MsgType m_MsgType;
     Exception* m_pEx;
+
+    std::atomic<int> m_LoadState;
+    int m_Priority;
+    std::atomic<int> m_Generation;
+    std::vector<BitmapManagerMsgPtr> m_pFollowers;
 };
 
-typedef boost::shared_ptr<BitmapManagerMsg> BitmapManagerMsgPtr;
 typedef Queue<BitmapManagerMsg> BitmapManagerMsgQueue;
 typedef boost::shared_ptr<BitmapManagerMsgQueue> BitmapManagerMsgQueuePtr;
 }
@@ -32,17 +32,33 @@
 
 namespace avg {
 
-BitmapManagerThread::BitmapManagerThread(CQueue& cmdQ, BitmapManagerMsgQueue& MsgQueue)
+BitmapManagerThread::BitmapManagerThread(CQueue& cmdQ, BitmapLoadQueue& loadQueue,
+        int threadIndex, BitmapManagerMsgQueue& MsgQueue)
     : WorkerThread<BitmapManagerThread>("BitmapManager", cmdQ),
+      m_LoadQueue(loadQueue),
+      m_ThreadIndex(threadIndex),
       m_MsgQueue(MsgQueue),
       m_TotalLatency(0),
       m_NumBmpsLoaded(0)
 {
 }
 
+static ProfilingZoneID QueueDepthCounter("BitmapManager queue depth", true);
+static ProfilingZoneID WaitTimeCounter("BitmapManager wait time (us)", true);
+static ProfilingZoneID LatencyCounter("BitmapManager latency (us)", true);
+
 bool BitmapManagerThread::work()
 {
-    waitForCommand();
+    BitmapManagerMsgPtr pRequest = m_LoadQueue.pop(m_ThreadIndex);
+    if (!pRequest) {
+        // Queue closed.
+        return false;
+    }
+    ThreadProfiler* pProfiler = ThreadProfiler::get();
+    pProfiler->addCounterValue(QueueDepthCounter, m_LoadQueue.getNumPending());
+    pProfiler->addCounterValue(WaitTimeCounter, 
+            TimeSource::get()->getCurrentMicrosecs() - pRequest->getStartTime());
+    loadBitmap(pRequest);
     return true;
 }
 
@@ -60,18 +76,21 @@ static ProfilingZoneID LoaderProfilingZone("loadBitmap", true);
 void BitmapManagerThread::loadBitmap(BitmapManagerMsgPtr pRequest)
 {
     BitmapPtr pBmp;
-    ScopeTimer timer(LoaderProfilingZone);
-    float startTime = pRequest->getStartTime();
-    try {
-        pBmp = avg::loadBitmap(pRequest->getFilename(), pRequest->getPixelFormat());
-        pRequest->setBitmap(pBmp);
-    } catch (const Exception& ex) {
-        pRequest->setError(ex);
+    long long startTime = pRequest->getStartTime();
+    {
+        ScopeTimer timer(LoaderProfilingZone);
+        try {
+            pBmp = avg::loadBitmap(pRequest->getFilename(), pRequest->getPixelFormat());
+            pRequest->setBitmap(pBmp);
+        } catch (const Exception& ex) {
+            pRequest->setError(ex);
+        }
     }
+    long long curLatency = TimeSource::get()->getCurrentMicrosecs() - startTime;
     m_MsgQueue.push(pRequest);
     m_NumBmpsLoaded++;
-    float curLatency = TimeSource::get()->getCurrentMicrosecs()/1000 - startTime;
-    m_TotalLatency += curLatency;
+    m_TotalLatency += curLatency/1000.f;
+    ThreadProfiler::get()->addCounterValue(LatencyCounter, curLatency);
     ThreadProfiler::get()->reset();
 }
 
@@ -25,6 +25,7 @@
 #include "../api.h"
 
 #include "BitmapManagerMsg.h"
+#include "BitmapLoadQueue.h"
 
 #include "../base/WorkerThread.h"
 
@@ -36,13 +37,16 @@ namespace avg {
 class AVG_API BitmapManagerThread : public WorkerThread<BitmapManagerThread>
 {
     public:
-        BitmapManagerThread(CQueue& cmdQ, BitmapManagerMsgQueue& MsgQueue);
+        BitmapManagerThread(CQueue& cmdQ, BitmapLoadQueue& loadQueue, int threadIndex,
+                BitmapManagerMsgQueue& MsgQueue);
                 
         void loadBitmap(BitmapManagerMsgPtr pRequest);
         
     private:
         virtual bool work();
         virtual void deinit();
+        BitmapLoadQueue& m_LoadQueue;
+        int m_ThreadIndex;
         BitmapManagerMsgQueue& m_MsgQueue;
 
         float m_TotalLatency;
@@ -160,11 +160,13 @@ void CameraNode::play()
         open();
     }
     m_bIsPlaying = true;
+    setCanvasDirty();
 }
 
 void CameraNode::stop()
 {
     m_bIsPlaying = false;
+    setCanvasDirty();
 }
 
 bool CameraNode::isAvailable()
@@ -342,6 +344,8 @@ void CameraNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
         if (m_bAutoUpdateCameraImage) {
             ScopeTimer Timer(CameraFetchImage);
             updateToLatestCameraImage();
+            // Images arrive asynchronously, so the canvas needs to poll every frame.
+            setCanvasDirty();
         }
         if (isVisible()) {
             if (m_bNewBmp) {
@@ -398,6 +402,9 @@ void CameraNode::updateCameraImage()
 {
     if (!m_bAutoUpdateCameraImage) {
         m_pCurBmp = m_pCamera->getImage(false);
+        if (m_pCurBmp) {
+            setCanvasDirty();
+        }
     }
 }
 
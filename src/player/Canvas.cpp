@@ -30,10 +30,13 @@
 #include "../base/Exception.h"
 #include "../base/Logger.h"
 #include "../base/ScopeTimer.h"
+#include "../base/ThreadProfiler.h"
 
 #include "../graphics/StandardShader.h"
 #include "../graphics/GLContextManager.h"
 #include "../graphics/MCFBO.h"
+#include "../graphics/ImageCache.h"
+#include "../graphics/TextureAtlas.h"
 
 #include <iostream>
 
@@ -46,10 +49,18 @@ namespace avg {
 Canvas::Canvas(Player * pPlayer)
     : m_pPlayer(pPlayer),
       m_bIsPlaying(false),
+      m_StdSubVAPassNumber(-1),
       m_PlaybackEndSignal(&IPlaybackEndListener::onPlaybackEnd),
       m_FrameEndSignal(&IFrameEndListener::onFrameEnd),
       m_PreRenderSignal(&IPreRenderListener::onPreRender),
-      m_ClipLevel(0)
+      m_ClipLevel(0),
+      m_NumDrawCalls(0),
+      m_NumUnbatchedDrawCalls(0),
+      m_NumVertexBytesUploaded(0),
+      m_NumPreRenderUpdates(0),
+      m_bDirty(true),
+      m_NumSkippedFrames(0),
+      m_NumAtlasDefragmentations(0)
 {
 }
 
@@ -72,6 +83,9 @@ void Canvas::initPlayback(int multiSampleSamples)
     m_pRootNode->connectDisplay();
     m_MultiSampleSamples = multiSampleSamples;
     m_pVertexArray = GLContextManager::get()->createVertexArray(2000, 3000);
+    m_StdSubVAPassNumber = -1;
+    m_bDirty = true;
+    m_NumSkippedFrames = 0;
 }
 
 void Canvas::stopPlayback(bool bIsAbort)
@@ -142,27 +156,20 @@ CanvasNodePtr Canvas::getRootNode() const
 }
 
 static ProfilingZoneID RenderProfilingZone("Render");
+static ProfilingZoneID DrawCallsCounter("Draw calls", true);
+static ProfilingZoneID UnbatchedDrawCallsCounter("Draw calls without batching", true);
+static ProfilingZoneID VertexBytesUploadedCounter("VA Transfer: bytes uploaded", true);
 
 void Canvas::doFrame(bool bPythonAvailable)
 {
     emitPreRenderSignal();
     if (!m_pPlayer->isStopping()) {
-        ScopeTimer Timer(RenderProfilingZone);
-        Player::get()->startTraversingTree();
-        if (bPythonAvailable) {
-            Py_BEGIN_ALLOW_THREADS;
-            try {
-                renderTree();
-            } catch(...) {
-                Py_BLOCK_THREADS;
-                Player::get()->endTraversingTree();
-                throw;
-            }
-            Py_END_ALLOW_THREADS;
+        if (isRenderNeeded()) {
+            render(bPythonAvailable);
         } else {
-            renderTree();
+            // Nothing changed since the last render, so the old image is still valid.
+            m_NumSkippedFrames++;
         }
-        Player::get()->endTraversingTree();
     }
     resetFXSchedule();
     emitFrameEndSignal();
@@ -233,14 +240,47 @@ Player* Canvas::getPlayer() const
 }
 
 static ProfilingZoneID PreRenderProfilingZone("PreRender");
+static ProfilingZoneID PreRenderVisitsCounter("PreRender: nodes visited");
+static ProfilingZoneID PreRenderUpdatesCounter("PreRender: nodes updated");
 static ProfilingZoneID VATransferProfilingZone("VA Transfer");
 
 void Canvas::preRender()
 {
     ScopeTimer Timer(PreRenderProfilingZone);
-    m_pVertexArray->reset();
-    createStdSubVA();
-    m_pRootNode->preRender(m_pVertexArray, true, 1.0f);
+    m_bDirty = false;
+    m_NumDrawCalls = 0;
+    m_NumUnbatchedDrawCalls = 0;
+    m_NumVertexBytesUploaded = 0;
+    m_pVertexArray->reset(!isAtlasDefragmented());
+    if (m_pVertexArray->isFromLastPass(m_StdSubVAPassNumber)) {
+        m_pVertexArray->skip(m_StdSubVA.getNumVerts(), m_StdSubVA.getNumIndexes());
+    } else {
+        createStdSubVA();
+    }
+    m_StdSubVAPassNumber = m_pVertexArray->getPassNumber();
+
+    Node::resetPreRenderCounts();
+    // Vertexes of the last pass are intact unless reset() invalidated them. In that
+    // case, no node has written or kept anything in getPassNumber()-1.
+    m_pRootNode->maybePreRender(m_pVertexArray, true, 1.0f, 
+            m_pVertexArray->getPassNumber()-1);
+    ThreadProfiler* pProfiler = ThreadProfiler::get();
+    pProfiler->addCounterValue(PreRenderVisitsCounter, Node::getNumPreRenderVisits());
+    m_NumPreRenderUpdates = Node::getNumPreRenderUpdates();
+    pProfiler->addCounterValue(PreRenderUpdatesCounter, m_NumPreRenderUpdates);
+}
+
+bool Canvas::isAtlasDefragmented()
+{
+    // Defragmentation moves images in the atlas without changing the nodes that
+    // display them, so their texture coordinates need to be recalculated.
+    int numDefragmentations = 0;
+    if (ImageCache::exists() && ImageCache::get()->getAtlas()) {
+        numDefragmentations = ImageCache::get()->getAtlas()->getNumDefragmentations();
+    }
+    bool bDefragmented = (numDefragmentations != m_NumAtlasDefragmentations);
+    m_NumAtlasDefragmentations = numDefragmentations;
+    return bDefragmented;
 }
 
 static ProfilingZoneID RootRenderProfilingZone("RootNode: render");
@@ -270,6 +310,7 @@ void Canvas::renderWindow(WindowPtr pWindow, MCFBOPtr pFBO, const IntRect& viewp
     {
         ScopeTimer Timer(VATransferProfilingZone);
         m_pVertexArray->update(pContext);
+        m_NumVertexBytesUploaded += m_pVertexArray->getNumBytesUploaded();
     }
     clearGLBuffers(GL_COLOR_BUFFER_BIT | GL_STENCIL_BUFFER_BIT | GL_DEPTH_BUFFER_BIT,
             !pFBO);
@@ -292,6 +333,76 @@ SubVertexArray& Canvas::getStdSubVA()
     return m_StdSubVA;
 }
 
+void Canvas::addDrawCalls(int numDrawCalls, int numUnbatchedDrawCalls)
+{
+    m_NumDrawCalls += numDrawCalls;
+    m_NumUnbatchedDrawCalls += numUnbatchedDrawCalls;
+}
+
+int Canvas::getNumDrawCalls() const
+{
+    return m_NumDrawCalls;
+}
+
+int Canvas::getNumUnbatchedDrawCalls() const
+{
+    return m_NumUnbatchedDrawCalls;
+}
+
+int Canvas::getNumVertexBytesUploaded() const
+{
+    return m_NumVertexBytesUploaded;
+}
+
+int Canvas::getNumPreRenderUpdates() const
+{
+    return m_NumPreRenderUpdates;
+}
+
+void Canvas::setDirty()
+{
+    m_bDirty = true;
+}
+
+int Canvas::getNumSkippedFrames() const
+{
+    return m_NumSkippedFrames;
+}
+
+bool Canvas::isDirty() const
+{
+    return m_bDirty;
+}
+
+bool Canvas::isRenderNeeded() const
+{
+    return true;
+}
+
+void Canvas::render(bool bPythonAvailable)
+{
+    ScopeTimer Timer(RenderProfilingZone);
+    Player::get()->startTraversingTree();
+    if (bPythonAvailable) {
+        Py_BEGIN_ALLOW_THREADS;
+        try {
+            renderTree();
+        } catch(...) {
+            Py_BLOCK_THREADS;
+            Player::get()->endTraversingTree();
+            throw;
+        }
+        Py_END_ALLOW_THREADS;
+    } else {
+        renderTree();
+    }
+    Player::get()->endTraversingTree();
+    ThreadProfiler* pProfiler = ThreadProfiler::get();
+    pProfiler->addCounterValue(DrawCallsCounter, m_NumDrawCalls);
+    pProfiler->addCounterValue(UnbatchedDrawCallsCounter, m_NumUnbatchedDrawCalls);
+    pProfiler->addCounterValue(VertexBytesUploadedCounter, m_NumVertexBytesUploaded);
+}
+
 void Canvas::renderOutlines(GLContext* pContext, const glm::mat4& transform)
 {
     VertexArrayPtr pVA = GLContextManager::get()->createVertexArray();
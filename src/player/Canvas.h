@@ -106,18 +106,31 @@ class AVG_API Canvas: public ExportedObject
         void scheduleFXRender(const RasterNodePtr& pNode);
         SubVertexArray& getStdSubVA();
 
+        void addDrawCalls(int numDrawCalls, int numUnbatchedDrawCalls);
+        int getNumDrawCalls() const;
+        int getNumUnbatchedDrawCalls() const;
+        int getNumVertexBytesUploaded() const;
+        int getNumPreRenderUpdates() const;
+
+        void setDirty();
+        int getNumSkippedFrames() const;
+
     protected:
         Player * getPlayer() const;
         void preRender();
+        bool isDirty() const;
+        virtual bool isRenderNeeded() const;
         void emitPreRenderSignal(); 
         void emitFrameEndSignal();
 
     private:
         virtual void renderTree()=0;
+        void render(bool bPythonAvailable);
         void renderFX(GLContext* pContext);
         void resetFXSchedule();
         void renderOutlines(GLContext* pContext, const glm::mat4& transform);
         void createStdSubVA();
+        bool isAtlasDefragmented();
 
         void clip(GLContext* pContext, const glm::mat4& transform, SubVertexArray& va,
                 GLenum stencilOp);
@@ -126,6 +139,7 @@ class AVG_API Canvas: public ExportedObject
         bool m_bIsPlaying;
         VertexArrayPtr m_pVertexArray;
         SubVertexArray m_StdSubVA;
+        int m_StdSubVAPassNumber;
        
         typedef std::map<std::string, NodePtr> NodeIDMap;
         NodeIDMap m_IDMap;
@@ -137,6 +151,20 @@ class AVG_API Canvas: public ExportedObject
         int m_MultiSampleSamples;
         int m_ClipLevel;
 
+        // Per-frame draw call statistics. Unbatched is the number of draw calls that 
+        // would have been issued without batching.
+        int m_NumDrawCalls;
+        int m_NumUnbatchedDrawCalls;
+        int m_NumVertexBytesUploaded;
+        int m_NumPreRenderUpdates;
+
+        // Set whenever something in the tree changes that affects the rendered
+        // image. Only offscreen canvases use this to skip renders.
+        bool m_bDirty;
+        int m_NumSkippedFrames;
+
+        int m_NumAtlasDefragmentations;
+
         std::vector<RasterNodePtr> m_pScheduledFXNodes;
 };
 
@@ -30,14 +30,17 @@
 #include "../base/Exception.h"
 #include "../base/StringHelper.h"
 #include "../base/Logger.h"
+#include "../base/ConfigMgr.h"
 
 #include <iostream>
+#include <algorithm>
 
 using namespace std;
 
 namespace avg {
 
 int Contact::s_LastListenerID = 0;
+int Contact::s_HistoryLength = 0;
 
 void Contact::registerType()
 {
@@ -46,14 +49,36 @@ void Contact::registerType()
     pPubDef->addMessage("CURSOR_UP");
 }
 
+void Contact::setHistoryLength(int length)
+{
+    if (length < 1) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE, 
+                "Contact.setHistoryLength: length must be at least 1.");
+    }
+    s_HistoryLength = length;
+}
+
+int Contact::getHistoryLength()
+{
+    if (s_HistoryLength == 0) {
+        s_HistoryLength = std::max(1, 
+                ConfigMgr::get()->getIntOption("touch", "contacthistorylength", 256));
+    }
+    return s_HistoryLength;
+}
+
 Contact::Contact(CursorEventPtr pEvent)
     : Publisher("Contact"),
+      m_pFirstEvent(pEvent),
+      m_Events(getHistoryLength()),
+      m_History(getHistoryLength()),
       m_bSendingEvents(false),
       m_bCurListenerIsDead(false),
       m_CursorID(pEvent->getCursorID()),
       m_DistanceTravelled(0)
 {
-    m_Events.push_back(pEvent);
+    m_Events.push(pEvent);
+    addSample(pEvent);
 }
 
 Contact::~Contact()
@@ -88,7 +113,7 @@ void Contact::disconnectListener(int id)
 
 long long Contact::getAge() const
 {
-    return m_Events.back()->getWhen() - m_Events[0]->getWhen();
+    return m_Events.back()->getWhen() - m_pFirstEvent->getWhen();
 }
 
 float Contact::getDistanceFromStart() const
@@ -108,7 +133,7 @@ float Contact::getMotionAngle() const
 
 glm::vec2 Contact::getMotionVec() const
 {
-    return m_Events.back()->getPos() - m_Events[0]->getPos();
+    return m_Events.back()->getPos() - m_pFirstEvent->getPos();
 }
 
 float Contact::getDistanceTravelled() const
@@ -118,7 +143,19 @@ float Contact::getDistanceTravelled() const
 
 vector<CursorEventPtr> Contact::getEvents() const
 {
-    return m_Events;
+    vector<CursorEventPtr> events(m_Events.size());
+    m_Events.copyTo(&events[0]);
+    return events;
+}
+
+int Contact::getNumHistorySamples() const
+{
+    return m_History.size();
+}
+
+void Contact::copyHistory(ContactSample* pDest) const
+{
+    m_History.copyTo(pDest);
 }
 
 void Contact::addEvent(CursorEventPtr pEvent)
@@ -128,7 +165,8 @@ void Contact::addEvent(CursorEventPtr pEvent)
     calcSpeed(pEvent, m_Events.back());
     updateDistanceTravelled(m_Events.back(), pEvent);
     m_Events.back()->clearNodeData();
-    m_Events.push_back(pEvent);
+    m_Events.push(pEvent);
+    addSample(pEvent);
 }
 
 void Contact::sendEventToListeners(CursorEventPtr pCursorEvent)
@@ -216,6 +254,15 @@ void Contact::updateDistanceTravelled(CursorEventPtr pEvent1, CursorEventPtr pEv
     m_DistanceTravelled += dist;
 }
 
+void Contact::addSample(CursorEventPtr pEvent)
+{
+    ContactSample sample;
+    sample.m_Pos = pEvent->getPos();
+    sample.m_Speed = pEvent->getSpeed();
+    sample.m_Time = float(pEvent->getWhen() - m_pFirstEvent->getWhen());
+    m_History.push(sample);
+}
+
 void Contact::dumpListeners(string sFuncName)
 {
     cerr << "  " << sFuncName << ": ";
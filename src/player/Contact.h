@@ -25,6 +25,7 @@
 #include "Publisher.h"
 
 #include "../base/GLMHelper.h"
+#include "../base/RingBuffer.h"
 
 #include <boost/shared_ptr.hpp>
 #include <boost/enable_shared_from_this.hpp>
@@ -46,9 +47,24 @@ typedef boost::shared_ptr<class NodeChain> NodeChainPtr;
 class Node;
 typedef boost::shared_ptr<class Node> NodePtr;
 
+// One sample of the motion history of a contact. Python gets the history as five
+// 32-bit floats per sample in this order.
+struct ContactSample {
+    glm::vec2 m_Pos;
+    glm::vec2 m_Speed;
+    float m_Time;  // Milliseconds since the down event.
+};
+static_assert(sizeof(ContactSample) == 5*sizeof(float), 
+        "ContactSample must be packed, python reads it as five floats.");
+
 class AVG_API Contact: public Publisher {
 public:
     static void registerType();
+    // Number of events and samples kept per contact. Applies to contacts created
+    // afterwards.
+    static void setHistoryLength(int length);
+    static int getHistoryLength();
+
     Contact(CursorEventPtr pEvent);
     virtual ~Contact();
 
@@ -61,6 +77,8 @@ public:
     glm::vec2 getMotionVec() const;
     float getDistanceTravelled() const;
     std::vector<CursorEventPtr> getEvents() const;
+    int getNumHistorySamples() const;
+    void copyHistory(ContactSample* pDest) const;
 
     void addEvent(CursorEventPtr pEvent);
     void sendEventToListeners(CursorEventPtr pCursorEvent);
@@ -74,9 +92,16 @@ public:
 private:
     void calcSpeed(CursorEventPtr pEvent, CursorEventPtr pOldEvent);
     void updateDistanceTravelled(CursorEventPtr pEvent1, CursorEventPtr pEvent2);
+    void addSample(CursorEventPtr pEvent);
     void dumpListeners(std::string sFuncName);
 
-    std::vector<CursorEventPtr> m_Events;
+    static int s_HistoryLength;
+
+    // Only the most recent events are kept. The statistics refer to the complete
+    // contact, so the first event is kept separately.
+    CursorEventPtr m_pFirstEvent;
+    RingBuffer<CursorEventPtr> m_Events;
+    RingBuffer<ContactSample> m_History;
 
     bool m_bSendingEvents;
 
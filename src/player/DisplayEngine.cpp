@@ -60,6 +60,8 @@
 
 #include <signal.h>
 #include <iostream>
+#include <algorithm>
+#include <cstdlib>
 
 #ifdef _WIN32
 #include <windows.h>
@@ -70,6 +72,18 @@ using namespace boost;
 
 namespace avg {
 
+const int DEFAULT_FRAME_TIME_WINDOW = 600;
+
+// Precise pacing: Bounds for the busy-wait time and a safety margin added to the 
+// measured oversleep, all in microseconds.
+const long long MIN_SPIN_TIME = 200;
+const long long MAX_SPIN_TIME = 3000;
+const long long SPIN_MARGIN = 100;
+// Low-latency pacing: Frame start is delayed by the frame duration minus the 95th 
+// percentile of recent render times minus this margin.
+const long long FRAME_START_MARGIN = 1000;
+const int MIN_FRAMES_FOR_PREDICTION = 30;
+
 void DisplayEngine::initSDL()
 {
     int err = SDL_Init(SDL_INIT_VIDEO);
@@ -87,15 +101,24 @@ DisplayEngine::DisplayEngine()
     : InputDevice("DisplayEngine"),
       m_Size(0,0),
       m_NumFrames(0),
+      m_FramesTooLate(0),
+      m_NumConsecutiveLateFrames(0),
+      m_MaxConsecutiveLateFrames(0),
       m_VBRate(0),
       m_Framerate(60),
       m_bInitialized(false),
-      m_EffFramerate(0)
+      m_EffFramerate(0),
+      m_FramePacing(DEFAULT_PACING),
+      m_SpinTime(MAX_SPIN_TIME)
 {
 //    _Xdebug = 1;
     m_Gamma[0] = 1.0;
     m_Gamma[1] = 1.0;
     m_Gamma[2] = 1.0;
+    for (int i = 0; i < NUM_FRAME_TIME_TYPES; ++i) {
+        m_pFrameTimeHistograms.push_back(RollingHistogramPtr(
+                new RollingHistogram(DEFAULT_FRAME_TIME_WINDOW)));
+    }
 }
 
 DisplayEngine::~DisplayEngine()
@@ -144,9 +167,15 @@ void DisplayEngine::initRender()
 {
     m_NumFrames = 0;
     m_FramesTooLate = 0;
+    m_NumConsecutiveLateFrames = 0;
+    m_MaxConsecutiveLateFrames = 0;
+    for (int i = 0; i < NUM_FRAME_TIME_TYPES; ++i) {
+        m_pFrameTimeHistograms[i]->reset();
+    }
     m_TimeSpentWaiting = 0;
     m_StartTime = TimeSource::get()->getCurrentMicrosecs();
     m_LastFrameTime = m_StartTime;
+    m_FrameStartTime = m_StartTime;
     m_bInitialized = true;
     if (m_VBRate != 0) {
         setVBlankRate(m_VBRate);
@@ -170,6 +199,13 @@ void DisplayEngine::deinitRender()
             "  Framerate achieved: " << actualFramerate);
     AVG_TRACE(Logger::category::PROFILE,  Logger::severity::INFO,
             "  Frames too late: " << m_FramesTooLate);
+    AVG_TRACE(Logger::category::PROFILE,  Logger::severity::INFO,
+            "  Max. consecutive frames too late: " << m_MaxConsecutiveLateFrames);
+    FrameTimeStats stats = getFrameTimeStats(TOTAL_TIME);
+    AVG_TRACE(Logger::category::PROFILE,  Logger::severity::INFO,
+            "  Frame time (last " << stats.m_NumFrames << " frames): p50 " 
+            << stats.m_P50 << " ms, p95 " << stats.m_P95 << " ms, p99 " 
+            << stats.m_P99 << " ms, max " << stats.m_Max << " ms");
     AVG_TRACE(Logger::category::PROFILE,  Logger::severity::INFO,
             "  Percent of time spent waiting: " 
             << float (m_TimeSpentWaiting)/(10000*TotalTime));
@@ -228,6 +264,56 @@ bool DisplayEngine::wasFrameLate()
     return m_bFrameLate;
 }
 
+int DisplayEngine::getNumFramesTooLate() const
+{
+    return m_FramesTooLate;
+}
+
+int DisplayEngine::getNumConsecutiveLateFrames() const
+{
+    return m_NumConsecutiveLateFrames;
+}
+
+int DisplayEngine::getMaxConsecutiveLateFrames() const
+{
+    return m_MaxConsecutiveLateFrames;
+}
+
+void DisplayEngine::setFramePacing(FramePacing pacing)
+{
+    m_FramePacing = pacing;
+}
+
+DisplayEngine::FramePacing DisplayEngine::getFramePacing() const
+{
+    return m_FramePacing;
+}
+
+void DisplayEngine::setFrameTimeWindow(int numFrames)
+{
+    for (int i = 0; i < NUM_FRAME_TIME_TYPES; ++i) {
+        m_pFrameTimeHistograms[i]->setWindowSize(numFrames);
+    }
+}
+
+int DisplayEngine::getFrameTimeWindow() const
+{
+    return m_pFrameTimeHistograms[0]->getWindowSize();
+}
+
+FrameTimeStats DisplayEngine::getFrameTimeStats(FrameTimeType type) const
+{
+    const RollingHistogram& hist = *m_pFrameTimeHistograms[type];
+    FrameTimeStats stats;
+    stats.m_NumFrames = hist.getNumSamples();
+    stats.m_Average = hist.getAverage()/1000;
+    stats.m_P50 = hist.getPercentile(50)/1000.f;
+    stats.m_P95 = hist.getPercentile(95)/1000.f;
+    stats.m_P99 = hist.getPercentile(99)/1000.f;
+    stats.m_Max = hist.getMax()/1000.f;
+    return stats;
+}
+
 void DisplayEngine::setGamma(float red, float green, float blue)
 {
     if (m_pWindows.empty()) {
@@ -264,6 +350,7 @@ const WindowPtr DisplayEngine::getWindow(unsigned i) const
 void DisplayEngine::endFrame()
 {
     frameWait();
+    m_SwapStartTime = TimeSource::get()->getCurrentMicrosecs();
     swapBuffers();
 #ifdef __APPLE__
     // Hack/Workaround for bug #661: When the window is completely occluded, mac
@@ -279,6 +366,26 @@ void DisplayEngine::endFrame()
     checkJitter();
 }
 
+static ProfilingZoneID FrameStartWaitProfilingZone("Wait for frame start");
+
+void DisplayEngine::waitForFrameStart()
+{
+    if (m_FramePacing == LOW_LATENCY_PACING && 
+            m_pFrameTimeHistograms[RENDER_TIME]->getNumSamples() >= 
+                    MIN_FRAMES_FOR_PREDICTION)
+    {
+        ScopeTimer Timer(FrameStartWaitProfilingZone);
+        long long predictedRenderTime = 
+                m_pFrameTimeHistograms[RENDER_TIME]->getPercentile(95);
+        long long startTime = m_LastFrameTime + getFrameDuration() - predictedRenderTime
+                - FRAME_START_MARGIN;
+        if (TimeSource::get()->getCurrentMicrosecs() < startTime) {
+            sleepUntil(startTime);
+        }
+    }
+    m_FrameStartTime = TimeSource::get()->getCurrentMicrosecs();
+}
+
 static ProfilingZoneID WaitProfilingZone("Render - wait");
 
 void DisplayEngine::frameWait()
@@ -288,7 +395,7 @@ void DisplayEngine::frameWait()
     m_NumFrames++;
 
     m_FrameWaitStartTime = TimeSource::get()->getCurrentMicrosecs();
-    m_TargetTime = m_LastFrameTime+(long long)(1000000/m_Framerate);
+    m_TargetTime = m_LastFrameTime+getFrameDuration();
     m_bFrameLate = false;
     if (m_VBRate == 0) {
         if (m_FrameWaitStartTime <= m_TargetTime) {
@@ -296,11 +403,36 @@ void DisplayEngine::frameWait()
             if (WaitTime > 5000) {
                 AVG_LOG_WARNING("DisplayEngine: waiting " << WaitTime << " ms.");
             }
-            TimeSource::get()->sleepUntil(m_TargetTime/1000);
+            sleepUntil(m_TargetTime);
         }
     }
 }
 
+void DisplayEngine::sleepUntil(long long targetTime)
+{
+    if (m_FramePacing == DEFAULT_PACING) {
+        TimeSource::get()->sleepUntil(targetTime/1000);
+    } else {
+        long long overshoot = TimeSource::get()->sleepUntilMicrosecs(targetTime, 
+                m_SpinTime);
+        if (overshoot != -1) {
+            // Grow quickly if the OS overslept, shrink slowly otherwise.
+            long long neededSpinTime = overshoot+SPIN_MARGIN;
+            if (neededSpinTime > m_SpinTime) {
+                m_SpinTime = neededSpinTime;
+            } else {
+                m_SpinTime -= (m_SpinTime-neededSpinTime)/16;
+            }
+            m_SpinTime = std::max(MIN_SPIN_TIME, std::min(m_SpinTime, MAX_SPIN_TIME));
+        }
+    }
+}
+
+long long DisplayEngine::getFrameDuration() const
+{
+    return (long long)(1000000/m_Framerate);
+}
+
 void DisplayEngine::swapBuffers()
 {
     for (unsigned i=0; i<m_pWindows.size(); ++i) {
@@ -319,19 +451,37 @@ void DisplayEngine::checkJitter()
     }
 
     long long frameTime = TimeSource::get()->getCurrentMicrosecs();
-    int maxDelay;
+    // With vblank, a frame that misses a refresh is a whole refresh interval late.
+    long long maxDelay;
     if (m_VBRate == 0) {
-        maxDelay = 2;
+        maxDelay = std::min(2000LL, getFrameDuration()/4);
     } else {
-        maxDelay = 6;
+        maxDelay = getFrameDuration()/(2*m_VBRate);
     }
-    if ((frameTime - m_TargetTime)/1000 > maxDelay || m_bFrameLate) {
+    if (frameTime - m_TargetTime > maxDelay || m_bFrameLate) {
         m_bFrameLate = true;
         m_FramesTooLate++;
+        m_NumConsecutiveLateFrames++;
+        if (m_NumConsecutiveLateFrames > m_MaxConsecutiveLateFrames) {
+            m_MaxConsecutiveLateFrames = int(m_NumConsecutiveLateFrames);
+        }
+    } else {
+        m_NumConsecutiveLateFrames = 0;
     }
 
+    m_pFrameTimeHistograms[TOTAL_TIME]->addSample(int(frameTime-m_LastFrameTime));
+    m_pFrameTimeHistograms[RENDER_TIME]->addSample(
+            int(m_FrameWaitStartTime-m_FrameStartTime));
+    m_pFrameTimeHistograms[WAIT_TIME]->addSample(
+            int(m_FrameStartTime-m_LastFrameTime + m_SwapStartTime-m_FrameWaitStartTime));
+    m_pFrameTimeHistograms[SWAP_TIME]->addSample(int(frameTime-m_SwapStartTime));
+    m_pFrameTimeHistograms[PACING_ERROR]->addSample(
+            int(std::abs(frameTime-m_TargetTime)));
+
+    m_TimeSpentWaiting += frameTime-m_FrameWaitStartTime 
+            + m_FrameStartTime-m_LastFrameTime;
     m_LastFrameTime = frameTime;
-    m_TimeSpentWaiting += m_LastFrameTime-m_FrameWaitStartTime;
+    m_FrameStartTime = frameTime;
 //    cerr << m_LastFrameTime << ", m_FrameWaitStartTime=" << m_FrameWaitStartTime << endl;
 //    cerr << m_TimeSpentWaiting << endl;
 }
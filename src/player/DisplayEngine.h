@@ -27,11 +27,13 @@
 
 #include "../graphics/GLConfig.h"
 
+#include "../base/RollingHistogram.h"
 
 #include <boost/shared_ptr.hpp>
 
 #include <string>
 #include <vector>
+#include <atomic>
 
 namespace avg {
 
@@ -44,9 +46,32 @@ typedef boost::shared_ptr<class Bitmap> BitmapPtr;
 class GLContext;
 class DisplayParams;
 
+// Frame time statistics over the last n frames, in milliseconds.
+struct AVG_API FrameTimeStats
+{
+    int m_NumFrames;
+    float m_Average;
+    float m_P50;
+    float m_P95;
+    float m_P99;
+    float m_Max;
+};
+
 class AVG_API DisplayEngine: public InputDevice
 {   
     public:
+        // Total time is the time between two frame ends. It is split into render time
+        // (everything until the frame is finished), wait time and buffer swap time.
+        // Pacing error is the difference between planned and actual frame end.
+        enum FrameTimeType {TOTAL_TIME, RENDER_TIME, WAIT_TIME, SWAP_TIME, 
+                PACING_ERROR, NUM_FRAME_TIME_TYPES};
+
+        // DEFAULT_PACING sleeps with millisecond resolution. PRECISE_PACING sleeps
+        // coarsely and busy-waits for the last part of the wait. LOW_LATENCY_PACING
+        // additionally delays the start of each frame so it finishes just in time, 
+        // based on the render times of the last frames.
+        enum FramePacing {DEFAULT_PACING, PRECISE_PACING, LOW_LATENCY_PACING};
+
         static void initSDL();
         static void quitSDL();
 
@@ -61,6 +86,16 @@ class AVG_API DisplayEngine: public InputDevice
         float getEffectiveFramerate();
         void setVBlankRate(int rate);
         bool wasFrameLate();
+        int getNumFramesTooLate() const;
+        int getNumConsecutiveLateFrames() const;
+        int getMaxConsecutiveLateFrames() const;
+        void setFramePacing(FramePacing pacing);
+        FramePacing getFramePacing() const;
+        // Not thread-safe: resets the statistics and must not be called during
+        // endFrame() or getFrameTimeStats().
+        void setFrameTimeWindow(int numFrames);
+        int getFrameTimeWindow() const;
+        FrameTimeStats getFrameTimeStats(FrameTimeType type) const;
         void setGamma(float Red, float Green, float Blue);
         void setMousePos(const IntPoint& pos);
         int getKeyModifierState() const;
@@ -68,6 +103,8 @@ class AVG_API DisplayEngine: public InputDevice
         unsigned getNumWindows() const;
         const WindowPtr getWindow(unsigned i) const;
 
+        // Called before anything else is done in a frame.
+        void waitForFrameStart();
         void endFrame();
         void frameWait();
         void swapBuffers();
@@ -92,13 +129,17 @@ class AVG_API DisplayEngine: public InputDevice
 
         float m_Gamma[3];
         int m_NumFrames;
-        int m_FramesTooLate;
+        std::atomic<int> m_FramesTooLate;
+        std::atomic<int> m_NumConsecutiveLateFrames;
+        std::atomic<int> m_MaxConsecutiveLateFrames;
         long long m_StartTime;
         long long m_TimeSpentWaiting;
 
         // Per-Frame timings.
         long long m_LastFrameTime;
+        long long m_FrameStartTime;
         long long m_FrameWaitStartTime;
+        long long m_SwapStartTime;
         long long m_TargetTime;
         int m_VBRate;
         float m_Framerate;
@@ -106,6 +147,15 @@ class AVG_API DisplayEngine: public InputDevice
         bool m_bFrameLate;
 
         float m_EffFramerate;
+
+        void sleepUntil(long long targetTime);
+        long long getFrameDuration() const;
+        FramePacing m_FramePacing;
+        // Busy-wait time for precise pacing. Adapts to how exactly the OS sleeps.
+        long long m_SpinTime;
+
+        // Histograms of frame times in microseconds, indexed by FrameTimeType.
+        std::vector<RollingHistogramPtr> m_pFrameTimeHistograms;
 };
 
 typedef boost::shared_ptr<DisplayEngine> DisplayEnginePtr;
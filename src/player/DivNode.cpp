@@ -25,6 +25,7 @@
 #include "TypeRegistry.h"
 #include "Canvas.h"
 #include "NodeChain.h"
+#include "RasterNode.h"
 
 #include "../graphics/GLContext.h"
 
@@ -34,6 +35,7 @@
 #include "../base/FileHelper.h"
 #include "../base/MathHelper.h"
 #include "../base/ObjectCounter.h"
+#include "../base/ScopeTimer.h"
 
 #include <iostream>
 #include <sstream>
@@ -61,7 +63,8 @@ void DivNode::registerType()
 }
 
 DivNode::DivNode(const ArgList& args, const string& sPublisherName)
-    : AreaNode(sPublisherName)
+    : AreaNode(sPublisherName),
+      m_BatchPassNumber(-1)
 {
     args.setMembers(this);
     ObjectCounter::get()->incRef(&typeid(*this));
@@ -86,6 +89,9 @@ void DivNode::connectDisplay()
 void DivNode::connect(CanvasPtr pCanvas)
 {
     AreaNode::connect(pCanvas);
+    // The batches may refer to the vertex array of a different canvas.
+    m_DrawBatches.clear();
+    m_BatchPassNumber = -1;
     for (unsigned i = 0; i < getNumChildren(); ++i) {
         getChild(i)->connect(pCanvas);
     }
@@ -171,6 +177,7 @@ void DivNode::insertChild(NodePtr pChild, unsigned i)
     }
     std::vector<NodePtr>::iterator pos = m_Children.begin()+i;
     m_Children.insert(pos, pChild);
+    invalidateHitTestIndex();
     try {
         pChild->setParent(this, getState(), getCanvas());
     } catch (Exception&) {
@@ -192,6 +199,8 @@ void DivNode::reorderChild(NodePtr pChild, unsigned j)
     m_Children.erase(m_Children.begin()+i);
     std::vector<NodePtr>::iterator pos = m_Children.begin()+j;
     m_Children.insert(pos, pChild);
+    invalidateHitTestIndex();
+    setCanvasDirty();
 }
 
 void DivNode::reorderChild(unsigned i, unsigned j)
@@ -204,6 +213,8 @@ void DivNode::reorderChild(unsigned i, unsigned j)
     m_Children.erase(m_Children.begin()+i);
     std::vector<NodePtr>::iterator pos = m_Children.begin()+j;
     m_Children.insert(pos, pChild);
+    invalidateHitTestIndex();
+    setCanvasDirty();
 }
 
 unsigned DivNode::indexOf(NodePtr pChild)
@@ -248,6 +259,7 @@ void DivNode::removeChild(NodePtr pChild, bool bKill)
                 getID()+"::removeChild: index "+toString(i)+" out of bounds."));
     }
     m_Children.erase(m_Children.begin()+i);
+    invalidateHitTestIndex();
 }
 
 void DivNode::removeChild(unsigned i, bool bKill)
@@ -264,6 +276,7 @@ bool DivNode::getCrop() const
 void DivNode::setCrop(bool bCrop)
 {
     m_bCrop = bCrop;
+    setCanvasDirty();
 }
 
 const UTF8String& DivNode::getMediaDir() const
@@ -278,19 +291,28 @@ void DivNode::setMediaDir(const UTF8String& sMediaDir)
     checkReload();
 }
 
+static ProfilingZoneID HitTestIndexProfilingZone("DivNode::getElementsByPos indexed");
+
 void DivNode::getElementsByPos(const glm::vec2& pos, NodeChainPtr& pElements)
 {
     if (reactsToMouseEvents() &&
             ((getSize() == glm::vec2(0,0) ||
              (pos.x >= 0 && pos.y >= 0 && pos.x < getSize().x && pos.y < getSize().y))))
     {
-        for (int i = getNumChildren()-1; i >= 0; i--) {
-            NodePtr pCurChild = getChild(i);
-            glm::vec2 relPos = pCurChild->toLocal(pos);
-            pCurChild->getElementsByPos(relPos, pElements);
-            if (!pElements->empty()) {
-                pElements->append(getSharedThis());
-                return;
+        if (useHitTestIndex()) {
+            ScopeTimer timer(HitTestIndexProfilingZone);
+            vector<unsigned> candidates;
+            m_pHitTestIndex->getCandidates(m_Children, pos, candidates);
+            for (unsigned i = 0; i < candidates.size(); ++i) {
+                if (getChildElementsByPos(candidates[i], pos, pElements)) {
+                    return;
+                }
+            }
+        } else {
+            for (int i = getNumChildren()-1; i >= 0; i--) {
+                if (getChildElementsByPos(i, pos, pElements)) {
+                    return;
+                }
             }
         }
         // pos isn't in any of the children.
@@ -301,6 +323,23 @@ void DivNode::getElementsByPos(const glm::vec2& pos, NodeChainPtr& pElements)
     }
 }
 
+bool DivNode::getHitTestBounds(FRect& bounds) const
+{
+    if (getSize() == glm::vec2(0,0)) {
+        // Children can react to the mouse anywhere.
+        return false;
+    } else {
+        return AreaNode::getHitTestBounds(bounds);
+    }
+}
+
+void DivNode::onChildHitTestBoundsChange(const Node* pChild)
+{
+    if (m_pHitTestIndex) {
+        m_pHitTestIndex->setChildDirty(pChild);
+    }
+}
+
 void DivNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
         float parentEffectiveOpacity)
 {
@@ -315,9 +354,14 @@ void DivNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
             m_ClipVA.appendPos(viewport, glm::vec2(0,0), Pixel32(0,0,0,0));
             m_ClipVA.appendQuadIndexes(0, 1, 2, 3);
         }
+        vector<bool> updatedChildren(getNumChildren());
         for (unsigned i = 0; i < getNumChildren(); i++) {
-            m_Children[i]->preRender(pVA, bIsParentActive, getEffectiveOpacity());
+            updatedChildren[i] = m_Children[i]->maybePreRender(pVA, bIsParentActive,
+                    getEffectiveOpacity(), getChildValidPassNumber());
         }
+        calcDrawBatches(pVA, updatedChildren);
+    } else {
+        m_DrawBatches.clear();
     }
 }
 
@@ -326,14 +370,141 @@ void DivNode::render(GLContext* pContext, const glm::mat4& transform)
     if (getCrop() && getSize() != glm::vec2(0,0)) {
         getCanvas()->pushClipRect(pContext, transform, m_ClipVA);
     }
+    vector<DrawBatch>::iterator batchIt = m_DrawBatches.begin();
     for (unsigned i = 0; i < getNumChildren(); i++) {
-        getChild(i)->maybeRender(pContext, transform);
+        if (batchIt != m_DrawBatches.end() && batchIt->m_FirstChild == i) {
+            RasterNode* pNode = static_cast<RasterNode*>(getChild(i).get());
+            pNode->bltBatch(pContext, transform, batchIt->m_SubVA);
+            getCanvas()->addDrawCalls(1, int(batchIt->m_Nodes.size()));
+            i += batchIt->m_NumChildren-1;
+            ++batchIt;
+        } else {
+            getChild(i)->maybeRender(pContext, transform);
+        }
     }
     if (getCrop() && getSize() != glm::vec2(0,0)) {
         getCanvas()->popClipRect(pContext, transform, m_ClipVA);
     }
 }
 
+static ProfilingZoneID CalcDrawBatchesProfilingZone("DivNode::calcDrawBatches");
+
+void DivNode::calcDrawBatches(const VertexArrayPtr& pVA, 
+        const vector<bool>& updatedChildren)
+{
+    ScopeTimer timer(CalcDrawBatchesProfilingZone);
+    vector<DrawBatch> oldBatches;
+    oldBatches.swap(m_DrawBatches);
+    // The batches are part of this node's range, so they are intact under the same
+    // conditions as the children.
+    int validPassNumber = getChildValidPassNumber();
+    if (validPassNumber == -1 || m_BatchPassNumber != validPassNumber) {
+        oldBatches.clear();
+    }
+    m_BatchPassNumber = pVA->getPassNumber();
+    vector<DrawBatch>::const_iterator oldBatchIt = oldBatches.begin();
+    unsigned i = 0;
+    while (i < m_Children.size()) {
+        RasterNode* pFirstNode = getBatchableChild(i);
+        if (!pFirstNode) {
+            i++;
+            continue;
+        }
+        unsigned lastChild = i;
+        int numDrawnNodes = 1;
+        for (unsigned j = i+1; j < m_Children.size(); ++j) {
+            if (!m_Children[j]->isVisible()) {
+                continue;
+            }
+            RasterNode* pNode = getBatchableChild(j);
+            if (!pNode || !pNode->canBatchWith(*pFirstNode)) {
+                break;
+            }
+            lastChild = j;
+            numDrawnNodes++;
+        }
+        if (numDrawnNodes > 1) {
+            m_DrawBatches.push_back(DrawBatch());
+            DrawBatch& batch = m_DrawBatches.back();
+            batch.m_FirstChild = i;
+            batch.m_NumChildren = lastChild-i+1;
+            int numVerts = 0;
+            for (unsigned j = i; j <= lastChild; ++j) {
+                if (m_Children[j]->isVisible()) {
+                    BatchedNode node;
+                    node.m_ChildIndex = j;
+                    node.m_pNode = static_cast<RasterNode*>(m_Children[j].get());
+                    node.m_StartVertex = numVerts;
+                    node.m_NumVerts = node.m_pNode->getNumBatchVertices();
+                    numVerts += node.m_NumVerts;
+                    batch.m_Nodes.push_back(node);
+                }
+            }
+            while (oldBatchIt != oldBatches.end() && oldBatchIt->m_FirstChild < i) {
+                ++oldBatchIt;
+            }
+            if (oldBatchIt != oldBatches.end() && canReuseBatch(*oldBatchIt, batch, pVA))
+            {
+                // The vertexes from the last frame are still in place. Only the 
+                // nodes that changed need to be written again.
+                batch.m_SubVA = oldBatchIt->m_SubVA;
+                pVA->skip(batch.m_SubVA.getNumVerts(), batch.m_SubVA.getNumIndexes());
+                for (unsigned j = 0; j < batch.m_Nodes.size(); ++j) {
+                    const BatchedNode& node = batch.m_Nodes[j];
+                    if (updatedChildren[node.m_ChildIndex]) {
+                        node.m_pNode->updateBatchVertices(batch.m_SubVA, 
+                                node.m_StartVertex);
+                    }
+                }
+            } else {
+                pVA->startSubVA(batch.m_SubVA);
+                for (unsigned j = 0; j < batch.m_Nodes.size(); ++j) {
+                    batch.m_Nodes[j].m_pNode->appendBatchVertices(batch.m_SubVA);
+                }
+            }
+        }
+        i = lastChild+1;
+    }
+}
+
+bool DivNode::canReuseBatch(const DrawBatch& oldBatch, const DrawBatch& batch,
+        const VertexArrayPtr& pVA) const
+{
+    if (oldBatch.m_FirstChild != batch.m_FirstChild || 
+            oldBatch.m_NumChildren != batch.m_NumChildren ||
+            oldBatch.m_Nodes.size() != batch.m_Nodes.size() ||
+            oldBatch.m_SubVA.getStartVertex() != unsigned(pVA->getNumVerts()) ||
+            oldBatch.m_SubVA.getStartIndex() != unsigned(pVA->getNumIndexes()))
+    {
+        return false;
+    }
+    for (unsigned i = 0; i < batch.m_Nodes.size(); ++i) {
+        const BatchedNode& oldNode = oldBatch.m_Nodes[i];
+        const BatchedNode& node = batch.m_Nodes[i];
+        if (oldNode.m_ChildIndex != node.m_ChildIndex || 
+                oldNode.m_pNode != node.m_pNode || 
+                oldNode.m_NumVerts != node.m_NumVerts)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+RasterNode* DivNode::getBatchableChild(unsigned i)
+{
+    const NodePtr& pChild = m_Children[i];
+    if (!pChild->isVisible()) {
+        return 0;
+    }
+    RasterNode* pNode = dynamic_cast<RasterNode*>(pChild.get());
+    if (pNode && pNode->isBatchable()) {
+        return pNode;
+    } else {
+        return 0;
+    }
+}
+
 void DivNode::renderOutlines(const VertexArrayPtr& pVA, Pixel32 parentColor)
 {
     Pixel32 effColor = getEffectiveOutlineColor(parentColor);
@@ -372,6 +543,39 @@ string DivNode::getEffectiveMediaDir()
     return sMediaDir;
 }
 
+bool DivNode::useHitTestIndex()
+{
+    int threshold = Player::get()->getHitTestIndexThreshold();
+    if (threshold == 0 || int(m_Children.size()) < threshold) {
+        return false;
+    }
+    if (!m_pHitTestIndex) {
+        m_pHitTestIndex = HitTestIndexPtr(new HitTestIndex());
+    }
+    return true;
+}
+
+void DivNode::invalidateHitTestIndex()
+{
+    if (m_pHitTestIndex) {
+        m_pHitTestIndex->invalidate();
+    }
+}
+
+bool DivNode::getChildElementsByPos(unsigned i, const glm::vec2& pos, 
+        NodeChainPtr& pElements)
+{
+    NodePtr pChild = m_Children[i];
+    glm::vec2 relPos = pChild->toLocal(pos);
+    pChild->getElementsByPos(relPos, pElements);
+    if (!pElements->empty()) {
+        pElements->append(getSharedThis());
+        return true;
+    } else {
+        return false;
+    }
+}
+
 void DivNode::checkReload()
 {
     for(unsigned i = 0; i < getNumChildren(); ++i) {
@@ -27,6 +27,8 @@
 
 #include "../graphics/SubVertexArray.h"
 
+#include "HitTestIndex.h"
+
 #include "../base/UTF8String.h"
 
 #include <string>
@@ -34,6 +36,7 @@
 namespace avg {
 
 class GLContext;
+class RasterNode;
 
 class AVG_API DivNode : public AreaNode
 {
@@ -69,6 +72,8 @@ class AVG_API DivNode : public AreaNode
         void setMediaDir(const UTF8String& mediaDir);
 
         void getElementsByPos(const glm::vec2& pos, NodeChainPtr& pElements);
+        virtual bool getHitTestBounds(FRect& bounds) const;
+        void onChildHitTestBoundsChange(const Node* pChild);
         virtual void preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
                 float parentEffectiveOpacity);
         virtual void render(GLContext* pContext, const glm::mat4& transform);
@@ -82,12 +87,43 @@ class AVG_API DivNode : public AreaNode
    
     private:
         bool isChildTypeAllowed(const std::string& sType);
+        void calcDrawBatches(const VertexArrayPtr& pVA, 
+                const std::vector<bool>& updatedChildren);
+        RasterNode* getBatchableChild(unsigned i);
+        bool useHitTestIndex();
+        void invalidateHitTestIndex();
+        bool getChildElementsByPos(unsigned i, const glm::vec2& pos, 
+                NodeChainPtr& pElements);
 
         UTF8String m_sMediaDir;
         bool m_bCrop;
 
         SubVertexArray m_ClipVA;
 
+        // A visible child in a DrawBatch and the range of m_SubVA it wrote.
+        struct BatchedNode {
+            unsigned m_ChildIndex;
+            RasterNode* m_pNode;
+            int m_StartVertex;
+            int m_NumVerts;
+        };
+        // A run of children that is rendered using a single draw call. The run may
+        // contain invisible children; these aren't rendered at all.
+        struct DrawBatch {
+            unsigned m_FirstChild;
+            unsigned m_NumChildren;
+            std::vector<BatchedNode> m_Nodes;
+            SubVertexArray m_SubVA;
+        };
+        bool canReuseBatch(const DrawBatch& oldBatch, const DrawBatch& batch,
+                const VertexArrayPtr& pVA) const;
+        std::vector<DrawBatch> m_DrawBatches;
+        // Vertex array pass m_DrawBatches were written in.
+        int m_BatchPassNumber;
+
+        // Created on the first hit test with enough children.
+        HitTestIndexPtr m_pHitTestIndex;
+
         std::vector<NodePtr> m_Children;
 };
 
@@ -21,6 +21,7 @@
 
 #include "FXNode.h"
 #include "Player.h"
+#include "Canvas.h"
 
 #include "../base/ObjectCounter.h"
 #include "../graphics/GLContext.h"
@@ -55,6 +56,7 @@ void FXNode::connect()
 void FXNode::disconnect()
 {
     m_pFilter = GPUFilterPtr();
+    m_pCanvas = CanvasWeakPtr();
 }
 
 void FXNode::setSize(const IntPoint& newSize)
@@ -67,6 +69,11 @@ void FXNode::setSize(const IntPoint& newSize)
     }
 }
 
+void FXNode::setCanvas(CanvasPtr pCanvas)
+{
+    m_pCanvas = pCanvas;
+}
+
 void FXNode::apply(GLContext* pContext, GLTexturePtr pSrcTex)
 {
     // blt overwrites everything, so no glClear necessary before.
@@ -107,6 +114,10 @@ FBOPtr FXNode::getFBO(GLContext* pContext)
 void FXNode::setDirty()
 {
     m_bDirty = true;
+    CanvasPtr pCanvas = m_pCanvas.lock();
+    if (pCanvas) {
+        pCanvas->setDirty();
+    }
 }
 
 void FXNode::checkGLES() const
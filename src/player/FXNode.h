@@ -28,6 +28,7 @@
 #include "../base/Rect.h"
 
 #include <boost/shared_ptr.hpp>
+#include <boost/weak_ptr.hpp>
 
 namespace avg {
 
@@ -40,6 +41,9 @@ typedef boost::shared_ptr<GPUFilter> GPUFilterPtr;
 class GLTexture;
 typedef boost::shared_ptr<GLTexture> GLTexturePtr;
 class GLContext;
+class Canvas;
+typedef boost::shared_ptr<Canvas> CanvasPtr;
+typedef boost::weak_ptr<Canvas> CanvasWeakPtr;
 
 class AVG_API FXNode {
 public:
@@ -49,6 +53,7 @@ public:
     virtual void connect();
     virtual void disconnect();
     virtual void setSize(const IntPoint& newSize);
+    void setCanvas(CanvasPtr pCanvas);
 
     virtual void apply(GLContext* pContext, GLTexturePtr pSrcTex);
 
@@ -72,6 +77,8 @@ private:
     
     bool m_bSupportsGLES;
     bool m_bDirty;
+    // Canvas of the node the effect is attached to. Parameter changes dirty it.
+    CanvasWeakPtr m_pCanvas;
 };
 
 typedef boost::shared_ptr<FXNode> FXNodePtr;
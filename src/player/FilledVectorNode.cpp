@@ -25,6 +25,7 @@
 #include "TypeRegistry.h"
 #include "DivNode.h"
 #include "Shape.h"
+#include "Canvas.h"
 
 #include "../base/ScopeTimer.h"
 #include "../base/Logger.h"
@@ -170,6 +171,7 @@ void FilledVectorNode::render(GLContext* pContext, const glm::mat4& transform)
     ScopeTimer Timer(RenderProfilingZone);
     if (m_EffectiveOpacity > 0.01) {
         m_pFillShape->draw(pContext, transform, m_EffectiveOpacity);
+        getCanvas()->addDrawCalls(1, 1);
     }
     VectorNode::render(pContext, transform);
 }
@@ -41,12 +41,13 @@ using namespace std;
 
 namespace avg {
 
-GPUImage::GPUImage(OGLSurface * pSurface, bool bUseMipmaps)
+GPUImage::GPUImage(OGLSurface * pSurface, bool bUseMipmaps, bool bUseAtlas)
     : m_sFilename(""),
       m_pSurface(pSurface),
       m_State(CPU),
       m_Source(NONE),
-      m_bUseMipmaps(bUseMipmaps)
+      m_bUseMipmaps(bUseMipmaps),
+      m_bUseAtlas(bUseAtlas)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
     assertValid();
@@ -239,9 +240,13 @@ GPUImage::Source GPUImage::getSource()
 void GPUImage::setupImageSurface()
 {
     PixelFormat pf = m_pImage->getBmp()->getPixelFormat();
-    m_pImage->incTexRef(m_bUseMipmaps);
+    m_pImage->incTexRef(m_bUseMipmaps, m_bUseAtlas);
     MCTexturePtr pTex = m_pImage->getTex();
     m_pSurface->create(pf, pTex);
+    TextureAtlasRegionPtr pRegion = m_pImage->getAtlasRegion();
+    if (pRegion) {
+        m_pSurface->setAtlasRegion(pRegion);
+    }
 }
 
 void GPUImage::setupBitmapSurface()
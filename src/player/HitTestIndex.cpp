@@ -0,0 +1,223 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "HitTestIndex.h"
+
+#include "Node.h"
+
+#include "../base/Exception.h"
+#include "../base/ObjectCounter.h"
+
+#include <algorithm>
+#include <functional>
+#include <limits>
+#include <math.h>
+
+using namespace std;
+
+namespace avg {
+
+static const int MAX_CELLS_PER_DIM = 64;
+
+static bool isFinite(const glm::vec2& pt)
+{
+    // Also false for NaN.
+    return fabs(pt.x) <= numeric_limits<float>::max() && 
+            fabs(pt.y) <= numeric_limits<float>::max();
+}
+
+HitTestIndex::ChildEntry::ChildEntry()
+    : m_bBounded(false)
+{
+}
+
+HitTestIndex::HitTestIndex()
+    : m_bValid(false)
+{
+    ObjectCounter::get()->incRef(&typeid(*this));
+}
+
+HitTestIndex::~HitTestIndex()
+{
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+void HitTestIndex::invalidate()
+{
+    m_bValid = false;
+    m_DirtyChildren.clear();
+}
+
+void HitTestIndex::setChildDirty(const Node* pChild)
+{
+    if (!m_bValid) {
+        return;
+    }
+    map<const Node*, unsigned>::iterator it = m_ChildIndexes.find(pChild);
+    if (it == m_ChildIndexes.end()) {
+        invalidate();
+    } else {
+        m_DirtyChildren.push_back(it->second);
+        if (m_DirtyChildren.size() > m_ChildEntries.size()) {
+            // Many changes without a query in between: Rebuilding is cheaper.
+            invalidate();
+        }
+    }
+}
+
+void HitTestIndex::getCandidates(const vector<NodePtr>& children, const glm::vec2& pos,
+        vector<unsigned>& candidates)
+{
+    candidates.clear();
+    if (!isFinite(pos)) {
+        for (int i = int(children.size())-1; i >= 0; --i) {
+            candidates.push_back(i);
+        }
+        return;
+    }
+    if (m_bValid) {
+        AVG_ASSERT(children.size() == m_ChildEntries.size());
+        updateDirtyChildren(children);
+    } else {
+        build(children);
+    }
+    IntPoint cell = getCell(pos);
+    const vector<unsigned>& cellChildren = m_Cells[cell.y*m_GridSize.x+cell.x];
+    candidates.reserve(cellChildren.size()+m_UnboundedChildren.size());
+    candidates.insert(candidates.end(), cellChildren.begin(), cellChildren.end());
+    candidates.insert(candidates.end(), m_UnboundedChildren.begin(), 
+            m_UnboundedChildren.end());
+    sort(candidates.begin(), candidates.end(), greater<unsigned>());
+}
+
+void HitTestIndex::build(const vector<NodePtr>& children)
+{
+    unsigned numChildren = children.size();
+    FRect extent;
+    unsigned numBounded = 0;
+    for (unsigned i = 0; i < numChildren; ++i) {
+        FRect bounds;
+        if (children[i]->getHitTestBounds(bounds) && isFinite(bounds.tl) &&
+                isFinite(bounds.br))
+        {
+            if (numBounded == 0) {
+                extent = bounds;
+            } else {
+                extent.expand(bounds);
+            }
+            numBounded++;
+        }
+    }
+
+    // About one child per cell.
+    int cellsPerDim = int(ceil(sqrt(float(numBounded))));
+    cellsPerDim = max(1, min(cellsPerDim, MAX_CELLS_PER_DIM));
+    m_GridSize = IntPoint(cellsPerDim, cellsPerDim);
+    m_Origin = extent.tl;
+    m_CellSize = glm::vec2(max(extent.width()/cellsPerDim, 1.f), 
+            max(extent.height()/cellsPerDim, 1.f));
+    m_Cells.assign(cellsPerDim*cellsPerDim, vector<unsigned>());
+
+    m_ChildEntries.assign(numChildren, ChildEntry());
+    m_UnboundedChildren.clear();
+    m_ChildIndexes.clear();
+    for (unsigned i = 0; i < numChildren; ++i) {
+        m_ChildIndexes[children[i].get()] = i;
+        addChild(i, children[i].get());
+    }
+    m_DirtyChildren.clear();
+    m_bValid = true;
+}
+
+void HitTestIndex::updateDirtyChildren(const vector<NodePtr>& children)
+{
+    for (unsigned i = 0; i < m_DirtyChildren.size(); ++i) {
+        unsigned childIndex = m_DirtyChildren[i];
+        removeChild(childIndex);
+        addChild(childIndex, children[childIndex].get());
+    }
+    m_DirtyChildren.clear();
+}
+
+void HitTestIndex::addChild(unsigned i, const Node* pChild)
+{
+    ChildEntry& entry = m_ChildEntries[i];
+    FRect bounds;
+    entry.m_bBounded = pChild->getHitTestBounds(bounds) && isFinite(bounds.tl) &&
+            isFinite(bounds.br);
+    if (entry.m_bBounded) {
+        entry.m_Cells = IntRect(getCell(bounds.tl), getCell(bounds.br));
+        int numCells = (entry.m_Cells.width()+1)*(entry.m_Cells.height()+1);
+        // Large children would end up in most cells anyway.
+        if (numCells > 4 && numCells > int(m_Cells.size()/4)) {
+            entry.m_bBounded = false;
+        }
+    }
+    if (entry.m_bBounded) {
+        for (int y = entry.m_Cells.tl.y; y <= entry.m_Cells.br.y; ++y) {
+            for (int x = entry.m_Cells.tl.x; x <= entry.m_Cells.br.x; ++x) {
+                m_Cells[y*m_GridSize.x+x].push_back(i);
+            }
+        }
+    } else {
+        vector<unsigned>::iterator it = lower_bound(m_UnboundedChildren.begin(), 
+                m_UnboundedChildren.end(), i);
+        if (it == m_UnboundedChildren.end() || *it != i) {
+            m_UnboundedChildren.insert(it, i);
+        }
+    }
+}
+
+void HitTestIndex::removeChild(unsigned i)
+{
+    ChildEntry& entry = m_ChildEntries[i];
+    if (entry.m_bBounded) {
+        for (int y = entry.m_Cells.tl.y; y <= entry.m_Cells.br.y; ++y) {
+            for (int x = entry.m_Cells.tl.x; x <= entry.m_Cells.br.x; ++x) {
+                vector<unsigned>& cell = m_Cells[y*m_GridSize.x+x];
+                vector<unsigned>::iterator it = find(cell.begin(), cell.end(), i);
+                if (it != cell.end()) {
+                    cell.erase(it);
+                }
+            }
+        }
+    } else {
+        vector<unsigned>::iterator it = lower_bound(m_UnboundedChildren.begin(), 
+                m_UnboundedChildren.end(), i);
+        if (it != m_UnboundedChildren.end() && *it == i) {
+            m_UnboundedChildren.erase(it);
+        }
+    }
+    entry.m_bBounded = false;
+}
+
+IntPoint HitTestIndex::getCell(const glm::vec2& pos) const
+{
+    // Positions outside of the grid map to the border cells. Clamp before 
+    // converting to int to avoid overflows.
+    glm::vec2 cell = (pos-m_Origin)/m_CellSize;
+    cell.x = max(0.f, min(floorf(cell.x), float(m_GridSize.x-1)));
+    cell.y = max(0.f, min(floorf(cell.y), float(m_GridSize.y-1)));
+    return IntPoint(int(cell.x), int(cell.y));
+}
+
+}
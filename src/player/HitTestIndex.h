@@ -0,0 +1,91 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _HitTestIndex_H_
+#define _HitTestIndex_H_
+
+#include "../api.h"
+
+#include "../base/GLMHelper.h"
+#include "../base/Rect.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <vector>
+#include <map>
+
+namespace avg {
+
+class Node;
+typedef boost::shared_ptr<Node> NodePtr;
+
+// Uniform grid of the bounding boxes of a DivNode's children. Finds the children
+// that might contain a point without asking every child. Children that don't have a
+// bounding box are always candidates.
+//
+// Changes to the set or order of children invalidate the complete index. Changes
+// to the bounding box of a single child are applied before the next query.
+class AVG_API HitTestIndex
+{
+public:
+    HitTestIndex();
+    virtual ~HitTestIndex();
+
+    void invalidate();
+    void setChildDirty(const Node* pChild);
+
+    // Returns the indexes of the children that might contain pos, last child first.
+    void getCandidates(const std::vector<NodePtr>& children, const glm::vec2& pos,
+            std::vector<unsigned>& candidates);
+
+private:
+    struct ChildEntry {
+        ChildEntry();
+
+        bool m_bBounded;
+        // Inclusive range of cells covered by the child.
+        IntRect m_Cells;
+    };
+
+    void build(const std::vector<NodePtr>& children);
+    void updateDirtyChildren(const std::vector<NodePtr>& children);
+    void addChild(unsigned i, const Node* pChild);
+    void removeChild(unsigned i);
+    IntPoint getCell(const glm::vec2& pos) const;
+
+    bool m_bValid;
+    glm::vec2 m_Origin;
+    glm::vec2 m_CellSize;
+    IntPoint m_GridSize;
+    std::vector<std::vector<unsigned> > m_Cells;
+    std::vector<ChildEntry> m_ChildEntries;
+    // Sorted.
+    std::vector<unsigned> m_UnboundedChildren;
+    std::map<const Node*, unsigned> m_ChildIndexes;
+    std::vector<unsigned> m_DirtyChildren;
+};
+
+typedef boost::shared_ptr<HitTestIndex> HitTestIndexPtr;
+
+}
+
+#endif
@@ -61,7 +61,7 @@ ImageNode::ImageNode(const ArgList& args, const string& sPublisherName)
       m_Compression(TEXCOMPRESSION_NONE)
 {
     args.setMembers(this);
-    m_pGPUImage = GPUImagePtr(new GPUImage(getSurface(), getMipmap()));
+    m_pGPUImage = GPUImagePtr(new GPUImage(getSurface(), getMipmap(), true));
     m_Compression = string2TexCompression(args.getArgVal<string>("compression"));
     setHRef(m_href);
     ObjectCounter::get()->incRef(&typeid(*this));
@@ -102,7 +102,7 @@ void ImageNode::disconnect(bool bKill)
     }
     if (bKill) {
         RasterNode::disconnect(bKill);
-        m_pGPUImage = GPUImagePtr(new GPUImage(getSurface(), getMipmap()));
+        m_pGPUImage = GPUImagePtr(new GPUImage(getSurface(), getMipmap(), true));
         m_href = "";
     } else {
         m_pGPUImage->moveToCPU();
@@ -118,6 +118,7 @@ const UTF8String& ImageNode::getHRef() const
 void ImageNode::setHRef(const UTF8String& href)
 {
     m_href = href;
+    setCanvasDirty();
     if (m_pGPUImage->getSource() == GPUImage::SCENE && getState() == Node::NS_CANRENDER)
     {
         m_pGPUImage->getCanvas()->removeDependentCanvas(getCanvas());
@@ -180,6 +181,11 @@ void ImageNode::render(GLContext* pContext, const glm::mat4& transform)
     }
 }
 
+bool ImageNode::isBatchable() const
+{
+    return m_pGPUImage->getSource() != GPUImage::NONE && hasStdRenderState();
+}
+
 IntPoint ImageNode::getMediaSize()
 {
     return m_pGPUImage->getSize();
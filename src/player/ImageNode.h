@@ -56,6 +56,7 @@ class AVG_API ImageNode : public RasterNode
         virtual void preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
                 float parentEffectiveOpacity);
         virtual void render(GLContext* pContext, const glm::mat4& transform);
+        virtual bool isBatchable() const;
         
         void getElementsByPos(const glm::vec2& pos, NodeChainPtr& pElements);
         glm::vec2 toCanvasPos(const glm::vec2& pos);
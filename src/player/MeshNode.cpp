@@ -137,6 +137,7 @@ bool MeshNode::getBackfaceCull() const
 void MeshNode::setBackfaceCull(const bool bBackfaceCull)
 {
     m_bBackfaceCull = bBackfaceCull;
+    setCanvasDirty();
 }
 
 void MeshNode::calcVertexes(const VertexDataPtr& pVertexData, Pixel32 color)
@@ -35,7 +35,9 @@ using namespace std;
 namespace avg {
 
 MultitouchInputDevice::MultitouchInputDevice(const DivNodePtr& pEventReceiverNode)
-    : InputDevice("MultitouchInputDevice", pEventReceiverNode)
+    : InputDevice("MultitouchInputDevice", pEventReceiverNode),
+      m_NumEventsDispatched(0),
+      m_NumFinishedTouchEvents(0)
 {
     if (pEventReceiverNode) {
         m_TouchOffset = IntPoint(0,0);
@@ -67,6 +69,7 @@ vector<EventPtr> MultitouchInputDevice::pollEvents()
         if (pEvent) {
             events.push_back(pEvent);
             if (pEvent->getType() == Event::CURSOR_UP) {
+                m_NumFinishedTouchEvents += (*it)->getNumEventsReceived();
                 it = m_Touches.erase(it);
             } else {
                 ++it;
@@ -76,9 +79,27 @@ vector<EventPtr> MultitouchInputDevice::pollEvents()
         }
     }
 //    cerr << endl;
+    m_NumEventsDispatched += events.size();
     return events;
 }
 
+int MultitouchInputDevice::getNumEventsReceived()
+{
+    lock_guard lock(*m_pMutex);
+    int numEvents = m_NumFinishedTouchEvents;
+    vector<TouchStatusPtr>::iterator it;
+    for (it = m_Touches.begin(); it != m_Touches.end(); ++it) {
+        numEvents += (*it)->getNumEventsReceived();
+    }
+    return numEvents;
+}
+
+int MultitouchInputDevice::getNumEventsDispatched()
+{
+    lock_guard lock(*m_pMutex);
+    return m_NumEventsDispatched;
+}
+
 int MultitouchInputDevice::getNumTouches() const
 {
     return m_TouchIDMap.size();
@@ -49,6 +49,11 @@ public:
 
     std::vector<EventPtr> pollEvents();
 
+    // Event counters since construction. Motion events that arrive faster than
+    // they are polled are coalesced, so more events are received than dispatched.
+    int getNumEventsReceived();
+    int getNumEventsDispatched();
+
 protected:
     int getNumTouches() const;
     // Note that the id used here is not the libavg cursor id but a touch-driver-specific
@@ -72,6 +77,10 @@ private:
     MutexPtr m_pMutex;
     glm::vec2 m_TouchArea;
     glm::vec2 m_TouchOffset;
+
+    int m_NumEventsDispatched;
+    // Events received by touches that have already been removed from m_Touches.
+    int m_NumFinishedTouchEvents;
 };
 
 typedef boost::shared_ptr<MultitouchInputDevice> MultitouchInputDevicePtr;
@@ -32,6 +32,8 @@
 #include "GPUImage.h"
 #include "NodeChain.h"
 
+#include "../graphics/VertexArray.h"
+
 #include "../base/Exception.h"
 #include "../base/Logger.h"
 #include "../base/ObjectCounter.h"
@@ -81,11 +83,24 @@ void Node::registerType()
     TypeRegistry::get()->registerType(def);
 }
 
+int Node::s_NumPreRenderVisits = 0;
+int Node::s_NumPreRenderUpdates = 0;
+
 Node::Node(const string& sPublisherName)
     : Publisher(sPublisherName),
       m_pParent(0),
       m_pCanvas(),
-      m_State(NS_UNCONNECTED)
+      m_State(NS_UNCONNECTED),
+      m_bPreRenderDirty(true),
+      m_bLastParentActive(false),
+      m_LastParentOpacity(0),
+      m_VAPassNumber(-1),
+      m_VAStartVertex(0),
+      m_VAStartIndex(0),
+      m_VANumVerts(0),
+      m_VANumIndexes(0),
+      m_PreRenderPassNumber(-1),
+      m_ChildValidPassNumber(-1)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
 }
@@ -162,11 +177,13 @@ void Node::connect(CanvasPtr pCanvas)
 {
     m_pCanvas = pCanvas;
     setState(NS_CONNECTED);
+    setCanvasDirty();
 }
 
 void Node::disconnect(bool bKill)
 {
     AVG_ASSERT(getState() != NS_UNCONNECTED);
+    setCanvasDirty();
     m_pCanvas.lock()->removeNodeID(getID());
     setState(NS_UNCONNECTED);
     if (bKill) {
@@ -210,6 +227,7 @@ void Node::setOpacity(float opacity)
     } else if (m_Opacity > 1.0) {
         m_Opacity = 1.0;
     }
+    setCanvasDirty();
 }
 
 bool Node::getActive() const 
@@ -221,6 +239,7 @@ void Node::setActive(bool bActive)
 {
     if (bActive != m_bActive) {
         m_bActive = bActive;
+        setCanvasDirty();
     }
 }
 
@@ -324,6 +343,35 @@ bool Node::reactsToMouseEvents()
     return m_bActive && m_bSensitive;
 }
 
+void Node::hitTestBoundsChanged()
+{
+    if (m_pParent) {
+        m_pParent->onChildHitTestBoundsChange(this);
+    }
+}
+
+void Node::setCanvasDirty()
+{
+    if (getState() != NS_UNCONNECTED) {
+        CanvasPtr pCanvas = m_pCanvas.lock();
+        if (pCanvas) {
+            pCanvas->setDirty();
+        }
+    }
+    setPreRenderDirty();
+}
+
+void Node::setPreRenderDirty()
+{
+    // Ancestors of an inactive node don't visit it, so an ancestor can be clean
+    // even if the node is dirty. Always walk up to the root.
+    Node* pNode = this;
+    while (pNode) {
+        pNode->m_bPreRenderDirty = true;
+        pNode = pNode->m_pParent;
+    }
+}
+
 glm::vec2 Node::getRelPos(const glm::vec2& absPos) const 
 {
     glm::vec2 parentPos;
@@ -368,6 +416,57 @@ void Node::getElementsByPos(const glm::vec2& pos, NodeChainPtr& pElements)
 {
 }
 
+bool Node::getHitTestBounds(FRect& bounds) const
+{
+    return false;
+}
+
+bool Node::maybePreRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
+        float parentEffectiveOpacity, int validPassNumber)
+{
+    s_NumPreRenderVisits++;
+    // The parent's range was kept since validPassNumber, so whatever the subtree wrote
+    // or kept in that pass is still there.
+    bool bVAIntact = (validPassNumber != -1 && m_VAPassNumber == validPassNumber);
+    if (!m_bPreRenderDirty && bIsParentActive == m_bLastParentActive &&
+            parentEffectiveOpacity == m_LastParentOpacity && bVAIntact &&
+            pVA->getNumVerts() == m_VAStartVertex &&
+            pVA->getNumIndexes() == m_VAStartIndex)
+    {
+        // Nothing in the subtree changed and nothing before it changed size, so the
+        // vertexes from the last frame are still valid.
+        pVA->skip(m_VANumVerts, m_VANumIndexes);
+        m_VAPassNumber = pVA->getPassNumber();
+        return false;
+    } else {
+        s_NumPreRenderUpdates++;
+        // Nodes that need to be updated every frame set this again in preRender().
+        m_bPreRenderDirty = false;
+        m_bLastParentActive = bIsParentActive;
+        m_LastParentOpacity = parentEffectiveOpacity;
+        // Children that were visited in the last preRender() have been kept along
+        // with this node since then. Those that moved are caught by their offsets.
+        if (bVAIntact) {
+            m_ChildValidPassNumber = m_PreRenderPassNumber;
+        } else {
+            m_ChildValidPassNumber = -1;
+        }
+        m_VAStartVertex = pVA->getNumVerts();
+        m_VAStartIndex = pVA->getNumIndexes();
+        preRender(pVA, bIsParentActive, parentEffectiveOpacity);
+        m_VANumVerts = pVA->getNumVerts()-m_VAStartVertex;
+        m_VANumIndexes = pVA->getNumIndexes()-m_VAStartIndex;
+        m_VAPassNumber = pVA->getPassNumber();
+        m_PreRenderPassNumber = pVA->getPassNumber();
+        return true;
+    }
+}
+
+int Node::getChildValidPassNumber() const
+{
+    return m_ChildValidPassNumber;
+}
+
 void Node::preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
         float parentEffectiveOpacity)
 {
@@ -385,6 +484,22 @@ CanvasPtr Node::getCanvas() const
     return m_pCanvas.lock();
 }
 
+void Node::resetPreRenderCounts()
+{
+    s_NumPreRenderVisits = 0;
+    s_NumPreRenderUpdates = 0;
+}
+
+int Node::getNumPreRenderVisits()
+{
+    return s_NumPreRenderVisits;
+}
+
+int Node::getNumPreRenderUpdates()
+{
+    return s_NumPreRenderUpdates;
+}
+
 bool Node::handleEvent(EventPtr pEvent)
 {
     if (pEvent->getSource() != Event::NONE && pEvent->getSource() != Event::CUSTOM) {
@@ -31,6 +31,7 @@
 #include "../graphics/TexInfo.h"
 
 #include "../base/GLMHelper.h"
+#include "../base/Rect.h"
 
 #include <boost/shared_ptr.hpp>
 #include <boost/weak_ptr.hpp>
@@ -116,7 +117,17 @@ class AVG_API Node: public Publisher
         virtual glm::vec2 toGlobal(const glm::vec2& pos) const;
         NodePtr getElementByPos(const glm::vec2& pos);
         virtual void getElementsByPos(const glm::vec2& pos, NodeChainPtr& pElements);
-
+        // Conservative bounding box of the area that can react to the mouse, in parent
+        // coordinates. Returns false if there is no such bounding box.
+        virtual bool getHitTestBounds(FRect& bounds) const;
+
+        // Calls preRender() unless nothing in the subtree changed since the last frame.
+        // In that case, the vertexes of the subtree are still in pVA and are kept.
+        // validPassNumber is the pass whose vertexes the parent knows to be intact:
+        // Vertexes the subtree wrote or kept in that pass can be kept again. -1 if
+        // there is no such pass. Returns true if preRender() was called.
+        bool maybePreRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
+                float parentEffectiveOpacity, int validPassNumber);
         virtual void preRender(const VertexArrayPtr& pVA, bool bIsParentActive, 
                 float parentEffectiveOpacity);
         virtual void maybeRender(GLContext* pContext, const glm::mat4& parentTransform)
@@ -125,6 +136,7 @@ class AVG_API Node: public Publisher
         virtual void renderOutlines(const VertexArrayPtr& pVA, Pixel32 color) {};
 
         float getEffectiveOpacity() const;
+        virtual bool isVisible() const;
         virtual std::string dump(int indent = 0);
         
         NodeState getState() const;
@@ -133,17 +145,27 @@ class AVG_API Node: public Publisher
         virtual bool handleEvent(EventPtr pEvent); 
 
         virtual const std::string& getID() const;
+
+        // Number of maybePreRender() calls and of preRender() calls these resulted in
+        // since the last resetPreRenderCounts().
+        static void resetPreRenderCounts();
+        static int getNumPreRenderVisits();
+        static int getNumPreRenderUpdates();
     
     protected:
         Node(const std::string& sPublisherName);
 
         bool reactsToMouseEvents();
+        void hitTestBoundsChanged();
+        void setCanvasDirty();
+        void setPreRenderDirty();
+        // Pass that the children's vertexes are intact from. Valid during preRender().
+        int getChildValidPassNumber() const;
             
         void setState(NodeState state);
         void initFilename(std::string& sFilename);
         bool checkReload(const std::string& sHRef, const GPUImagePtr& pGPUImage,
                 TexCompression comp=TEXCOMPRESSION_NONE);
-        virtual bool isVisible() const;
         bool getEffectiveActive() const;
         NodePtr getSharedThis();
 
@@ -192,6 +214,25 @@ class AVG_API Node: public Publisher
         bool m_bSensitive;
         float m_EffectiveOpacity;
         bool m_bEffectiveActive;
+
+        // Set if the node or one of its descendants changed since the last preRender.
+        bool m_bPreRenderDirty;
+        bool m_bLastParentActive;
+        float m_LastParentOpacity;
+        // Range of the vertex array written by the subtree in the last preRender and
+        // the last pass that wrote or kept it.
+        int m_VAPassNumber;
+        int m_VAStartVertex;
+        int m_VAStartIndex;
+        int m_VANumVerts;
+        int m_VANumIndexes;
+        // Pass of the last preRender(). Descendants that weren't visited since then
+        // have been kept as part of this node's range.
+        int m_PreRenderPassNumber;
+        int m_ChildValidPassNumber;
+
+        static int s_NumPreRenderVisits;
+        static int s_NumPreRenderUpdates;
 };
 
 }
@@ -31,6 +31,7 @@
 #include "../graphics/MCTexture.h"
 #include "../graphics/GLTexture.h"
 #include "../graphics/StandardShader.h"
+#include "../graphics/TextureAtlas.h"
 
 #include <iostream>
 #include <sstream>
@@ -48,9 +49,11 @@ static glm::mat4 yuvCoeff(
 namespace avg {
 
 OGLSurface::OGLSurface(const WrapMode& wrapMode)
-    : m_Size(-1,-1),
+    : m_AtlasRegionVersion(0),
+      m_Size(-1,-1),
       m_WrapMode(wrapMode),
       m_Gamma(1,1,1,1),
+      m_bColorIsModified(false),
       m_Brightness(1,1,1),
       m_Contrast(1,1,1),
       m_bIsDirty(true)
@@ -72,6 +75,7 @@ void OGLSurface::create(PixelFormat pf, MCTexturePtr pTex0, MCTexturePtr pTex1,
     m_pMCTextures[1] = pTex1;
     m_pMCTextures[2] = pTex2;
     m_pMCTextures[3] = pTex3;
+    m_pAtlasRegion = TextureAtlasRegionPtr();
     m_bIsDirty = true;
     m_bPremultipliedAlpha = bPremultipliedAlpha;
 
@@ -88,6 +92,18 @@ void OGLSurface::create(PixelFormat pf, MCTexturePtr pTex0, MCTexturePtr pTex1,
     }
 }
 
+void OGLSurface::setAtlasRegion(TextureAtlasRegionPtr pRegion)
+{
+    AVG_ASSERT(isCreated());
+    m_pAtlasRegion = pRegion;
+    if (pRegion) {
+        AVG_ASSERT(pRegion->getTex() == m_pMCTextures[0]);
+        m_Size = pRegion->getRect().size();
+        m_AtlasRegionVersion = pRegion->getVersion();
+    }
+    m_bIsDirty = true;
+}
+
 void OGLSurface::setMask(MCTexturePtr pTex)
 {
     m_pMaskMCTexture = pTex;
@@ -100,6 +116,7 @@ void OGLSurface::destroy()
     m_pMCTextures[1] = MCTexturePtr();
     m_pMCTextures[2] = MCTexturePtr();
     m_pMCTextures[3] = MCTexturePtr();
+    m_pAtlasRegion = TextureAtlasRegionPtr();
 }
 
 void OGLSurface::activate(GLContext* pContext, const IntPoint& logicalSize) const
@@ -152,7 +169,7 @@ void OGLSurface::activate(GLContext* pContext, const IntPoint& logicalSize) cons
         //   need to a) undo this and b) adjust for pot mask textures. In the npot case,
         //   everything evaluates to (1,1);
         glm::vec2 texSize = m_pMCTextures[0]->getGLSize();
-        glm::vec2 imgSize = m_pMCTextures[0]->getSize();
+        glm::vec2 imgSize = m_Size;
         glm::vec2 imgScale = glm::vec2(texSize.x/imgSize.x, texSize.y/imgSize.y);
         maskPos = maskPos/imgScale;
         maskSize = maskSize/imgScale;
@@ -163,6 +180,10 @@ void OGLSurface::activate(GLContext* pContext, const IntPoint& logicalSize) cons
                 maskTexSize.y/maskImgSize.y);
         maskPos = maskPos*maskScale;
         maskSize = maskSize*maskScale;
+        if (m_pAtlasRegion) {
+            // The shader compares the mask position to the atlas texture coordinates.
+            maskPos += m_pAtlasRegion->getTexCoordRect().tl;
+        }
 
         pShader->setMask(true, maskPos, maskSize);
     } else {
@@ -194,11 +215,63 @@ IntPoint OGLSurface::getTextureSize()
     return m_pMCTextures[0]->getGLSize();
 }
 
+FRect OGLSurface::getTexCoordRect() const
+{
+    if (m_pAtlasRegion) {
+        return m_pAtlasRegion->getTexCoordRect();
+    } else {
+        glm::vec2 texSize = m_pMCTextures[0]->getGLSize();
+        return FRect(0, 0, m_Size.x/texSize.x, m_Size.y/texSize.y);
+    }
+}
+
 bool OGLSurface::isCreated() const
 {
     return (m_pMCTextures[0] != MCTexturePtr());
 }
 
+bool OGLSurface::isInAtlas() const
+{
+    return m_pAtlasRegion != TextureAtlasRegionPtr();
+}
+
+bool OGLSurface::isAtlasRegionMoved() const
+{
+    return m_pAtlasRegion && m_pAtlasRegion->getVersion() != m_AtlasRegionVersion;
+}
+
+void OGLSurface::resetAtlasRegionMoved()
+{
+    if (m_pAtlasRegion) {
+        m_AtlasRegionVersion = m_pAtlasRegion->getVersion();
+    }
+}
+
+bool OGLSurface::isBatchCompatible(const OGLSurface& other) const
+{
+    // True if activate() sets identical GL state for both surfaces.
+    for (int i = 0; i < 4; ++i) {
+        if (m_pMCTextures[i] != other.m_pMCTextures[i]) {
+            return false;
+        }
+    }
+    if (m_pMaskMCTexture || other.m_pMaskMCTexture) {
+        return false;
+    }
+    if (m_bColorIsModified != other.m_bColorIsModified) {
+        return false;
+    }
+    if (m_bColorIsModified && (m_Brightness != other.m_Brightness || 
+            m_Contrast != other.m_Contrast))
+    {
+        return false;
+    }
+    return m_pf == other.m_pf && m_bPremultipliedAlpha == other.m_bPremultipliedAlpha &&
+            m_WrapMode.getS() == other.m_WrapMode.getS() &&
+            m_WrapMode.getT() == other.m_WrapMode.getT() &&
+            m_Gamma == other.m_Gamma;
+}
+
 bool OGLSurface::isPremultipliedAlpha() const
 {
     return m_bPremultipliedAlpha;
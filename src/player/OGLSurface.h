@@ -25,6 +25,7 @@
 #include "../api.h"
 
 #include "../base/GLMHelper.h"
+#include "../base/Rect.h"
 #include "../graphics/PixelFormat.h"
 #include "../graphics/WrapMode.h"
 
@@ -34,6 +35,8 @@ namespace avg {
 
 class MCTexture;
 typedef boost::shared_ptr<MCTexture> MCTexturePtr;
+class TextureAtlasRegion;
+typedef boost::shared_ptr<TextureAtlasRegion> TextureAtlasRegionPtr;
 class GLContext;
 
 class AVG_API OGLSurface {
@@ -44,6 +47,8 @@ public:
     virtual void create(PixelFormat pf, MCTexturePtr pTex0, 
             MCTexturePtr pTex1 = MCTexturePtr(), MCTexturePtr pTex2 = MCTexturePtr(), 
             MCTexturePtr pTex3 = MCTexturePtr(), bool bPremultipliedAlpha = false);
+    // The image occupies only part of the texture. Must be called after create().
+    void setAtlasRegion(TextureAtlasRegionPtr pRegion);
     void setMask(MCTexturePtr pTex);
     virtual void destroy();
     void activate(GLContext* pContext, const IntPoint& logicalSize = IntPoint(1,1)) const;
@@ -53,8 +58,13 @@ public:
     PixelFormat getPixelFormat();
     IntPoint getSize();
     IntPoint getTextureSize();
+    FRect getTexCoordRect() const;
     bool isCreated() const;
+    bool isInAtlas() const;
+    bool isAtlasRegionMoved() const;
+    void resetAtlasRegionMoved();
     bool isPremultipliedAlpha() const;
+    bool isBatchCompatible(const OGLSurface& other) const;
 
     void setColorParams(const glm::vec3& gamma, const glm::vec3& brightness,
             const glm::vec3& contrast);
@@ -68,6 +78,8 @@ private:
     glm::mat4 calcColorspaceMatrix() const;
 
     MCTexturePtr m_pMCTextures[4];
+    TextureAtlasRegionPtr m_pAtlasRegion;
+    int m_AtlasRegionVersion;
     IntPoint m_Size;
     PixelFormat m_pf;
     MCTexturePtr m_pMaskMCTexture;
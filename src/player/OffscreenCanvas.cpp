@@ -262,6 +262,11 @@ void OffscreenCanvas::dump() const
     }
 }
 
+bool OffscreenCanvas::isRenderNeeded() const
+{
+    return isDirty() || !m_bIsRendered;
+}
+
 static ProfilingZoneID OffscreenRenderProfilingZone("Render OffscreenCanvas");
 
 void OffscreenCanvas::renderTree()
@@ -284,6 +289,10 @@ void OffscreenCanvas::renderTree()
     }
     GLContextManager::get()->reset();
     m_bIsRendered = true;
+    // Canvases that display this one need to pick up the new image.
+    for (unsigned i = 0; i < m_pDependentCanvases.size(); ++i) {
+        m_pDependentCanvases[i]->setDirty();
+    }
 }
 
 }
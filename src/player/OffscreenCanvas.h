@@ -76,6 +76,7 @@ class AVG_API OffscreenCanvas: public Canvas
         void dump() const;
  
     protected:
+        virtual bool isRenderNeeded() const;
         virtual void renderTree();
 
     private:
@@ -121,12 +121,15 @@ Player::Player()
       m_bFakeFPS(false),
       m_FakeFPS(0),
       m_FrameTime(0),
+      m_FrameTimeWindow(600),
+      m_FramePacing(DisplayEngine::DEFAULT_PACING),
       m_Volume(1),
       m_bPythonAvailable(true),
       m_pLastMouseEvent(new MouseEvent(Event::CURSOR_MOTION, false, false, false,
             IntPoint(-1, -1), MouseEvent::NO_BUTTON, glm::vec2(-1, -1), 0)),
       m_EventHookPyFunc(Py_None),
-      m_bMouseEnabled(true)
+      m_bMouseEnabled(true),
+      m_HitTestIndexThreshold(32)
 {
     string sDummy;
 #ifdef _WIN32
@@ -559,6 +562,8 @@ void Player::initPlayback()
 #endif
     }
 
+    m_pDisplayEngine->setFrameTimeWindow(m_FrameTimeWindow);
+    m_pDisplayEngine->setFramePacing(m_FramePacing);
     m_pDisplayEngine->initRender();
     Display::get()->rereadScreenResolution();
     m_bStopping = false;
@@ -653,6 +658,87 @@ float Player::getFrameDuration()
     }
 }
 
+void Player::startTracing(int numFrames)
+{
+    ThreadProfiler::startTracing(numFrames);
+}
+
+void Player::stopTracing()
+{
+    ThreadProfiler::stopTracing();
+}
+
+bool Player::isTracing() const
+{
+    return ThreadProfiler::isTracing();
+}
+
+void Player::saveTrace(const string& sFilename) const
+{
+    long long numDropped = ThreadProfiler::getNumDroppedTraceEvents();
+    if (numDropped > 0) {
+        AVG_LOG_WARNING("Trace buffer overflow, " << numDropped 
+                << " events not recorded.");
+    }
+    ThreadProfiler::writeTrace(sFilename);
+}
+
+void Player::setFramePacing(DisplayEngine::FramePacing pacing)
+{
+    if (m_bIsPlaying) {
+        m_pDisplayEngine->setFramePacing(pacing);
+    }
+    m_FramePacing = pacing;
+}
+
+DisplayEngine::FramePacing Player::getFramePacing() const
+{
+    return m_FramePacing;
+}
+
+void Player::setFrameTimeWindow(int numFrames)
+{
+    if (numFrames < 1) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE, 
+                "Player.setFrameTimeWindow: numFrames must be at least 1.");
+    }
+    // Applied in doFrame().
+    m_FrameTimeWindow = numFrames;
+}
+
+FrameTimeStats Player::getFrameTimeStats(DisplayEngine::FrameTimeType type) const
+{
+    if (!m_bIsPlaying) {
+        throw Exception(AVG_ERR_UNSUPPORTED,
+                "Must call Player.play() before getFrameTimeStats().");
+    }
+    return m_pDisplayEngine->getFrameTimeStats(type);
+}
+
+int Player::getNumFramesTooLate() const
+{
+    if (!m_bIsPlaying) {
+        return 0;
+    }
+    return m_pDisplayEngine->getNumFramesTooLate();
+}
+
+int Player::getNumConsecutiveLateFrames() const
+{
+    if (!m_bIsPlaying) {
+        return 0;
+    }
+    return m_pDisplayEngine->getNumConsecutiveLateFrames();
+}
+
+int Player::getMaxConsecutiveLateFrames() const
+{
+    if (!m_bIsPlaying) {
+        return 0;
+    }
+    return m_pDisplayEngine->getMaxConsecutiveLateFrames();
+}
+
 BitmapPtr Player::getTouchUserBmp() const
 {
     TUIOInputDevicePtr pTUIODev = dynamic_pointer_cast<TUIOInputDevice>(
@@ -663,6 +749,39 @@ BitmapPtr Player::getTouchUserBmp() const
     return pTUIODev->getUserBmp();
 }
 
+int Player::getNumTouchPacketsReceived() const
+{
+    TUIOInputDevicePtr pTUIODev = dynamic_pointer_cast<TUIOInputDevice>(
+            m_pMultitouchInputDevice);
+    if (pTUIODev) {
+        return pTUIODev->getNumPacketsReceived();
+    } else {
+        return 0;
+    }
+}
+
+int Player::getNumTouchEventsReceived() const
+{
+    MultitouchInputDevicePtr pTouchDev = dynamic_pointer_cast<MultitouchInputDevice>(
+            m_pMultitouchInputDevice);
+    if (pTouchDev) {
+        return pTouchDev->getNumEventsReceived();
+    } else {
+        return 0;
+    }
+}
+
+int Player::getNumTouchEventsDispatched() const
+{
+    MultitouchInputDevicePtr pTouchDev = dynamic_pointer_cast<MultitouchInputDevice>(
+            m_pMultitouchInputDevice);
+    if (pTouchDev) {
+        return pTouchDev->getNumEventsDispatched();
+    } else {
+        return 0;
+    }
+}
+
 void Player::enableMouse(bool enabled)
 {
     m_bMouseEnabled = enabled;
@@ -672,6 +791,20 @@ void Player::enableMouse(bool enabled)
     }
 }
 
+void Player::setHitTestIndexThreshold(int numChildren)
+{
+    if (numChildren < 0) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE, 
+                "setHitTestIndexThreshold: numChildren must not be negative.");
+    }
+    m_HitTestIndexThreshold = numChildren;
+}
+
+int Player::getHitTestIndexThreshold() const
+{
+    return m_HitTestIndexThreshold;
+}
+
 void Player::setEventCapture(NodePtr pNode, int cursorID=MOUSECURSORID)
 {
     std::map<int, EventCaptureInfoPtr>::iterator it =
@@ -987,7 +1120,19 @@ void Player::doFrame(bool bFirstFrame)
 {
     {
         ScopeTimer Timer(MainProfilingZone);
+        if (m_pDisplayEngine->getFrameTimeWindow() != m_FrameTimeWindow) {
+            // Resizing the histograms can't happen concurrently with endFrame() or
+            // getFrameTimeStats(). Here, we hold the GIL and aren't rendering.
+            m_pDisplayEngine->setFrameTimeWindow(m_FrameTimeWindow);
+        }
         if (!bFirstFrame) {
+            if (m_bPythonAvailable) {
+                Py_BEGIN_ALLOW_THREADS;
+                m_pDisplayEngine->waitForFrameStart();
+                Py_END_ALLOW_THREADS;
+            } else {
+                m_pDisplayEngine->waitForFrameStart();
+            }
             m_NumFrames++;
             if (m_bFakeFPS) {
                 m_FrameTime = (long long)((m_NumFrames*1000.0)/m_FakeFPS);
@@ -1005,6 +1150,10 @@ void Player::doFrame(bool bFirstFrame)
                 removeDeadEventCaptures();
             }
         }
+        if (ImageCache::exists()) {
+            // Regions freed during event handling are reclaimed before rendering.
+            ImageCache::get()->defragmentAtlas();
+        }
         for (unsigned i = 0; i < m_pCanvases.size(); ++i) {
             ScopeTimer Timer(OffscreenProfilingZone);
             dispatchOffscreenRendering(m_pCanvases[i].get());
@@ -1028,6 +1177,7 @@ void Player::doFrame(bool bFirstFrame)
         }
     }
     ThreadProfiler::get()->reset();
+    ThreadProfiler::endTraceFrame();
     if (m_NumFrames == 5) {
         ThreadProfiler::get()->restart();
     }
@@ -1593,6 +1743,24 @@ float Player::getVolume() const
     return m_Volume;
 }
 
+int Player::getNumAudioUnderruns() const
+{
+    if (AudioEngine::get()) {
+        return AudioEngine::get()->getNumUnderruns();
+    } else {
+        return 0;
+    }
+}
+
+int Player::getNumLateAudioCallbacks() const
+{
+    if (AudioEngine::get()) {
+        return AudioEngine::get()->getNumLateCallbacks();
+    } else {
+        return 0;
+    }
+}
+
 string Player::getConfigOption(const string& sSubsys, const string& sName) const
 {
     const string* psValue = ConfigMgr::get()->getOption(sSubsys, sName);
@@ -27,6 +27,7 @@
 #include "DisplayParams.h"
 #include "BoostPython.h"
 #include "Event.h"
+#include "DisplayEngine.h"
 
 #include "../audio/AudioParams.h"
 #include "../graphics/GLConfig.h"
@@ -53,7 +54,6 @@ class Contact;
 class EventDispatcher;
 class MouseEvent;
 class CursorEvent;
-class DisplayEngine;
 class Display;
 class GLContextManager;
 class Timeout;
@@ -138,6 +138,17 @@ class AVG_API Player: public Publisher
         void setFakeFPS(float fps);
         long long getFrameTime();
         float getFrameDuration();
+        void startTracing(int numFrames);
+        void stopTracing();
+        bool isTracing() const;
+        void saveTrace(const std::string& sFilename) const;
+        void setFramePacing(DisplayEngine::FramePacing pacing);
+        DisplayEngine::FramePacing getFramePacing() const;
+        void setFrameTimeWindow(int numFrames);
+        FrameTimeStats getFrameTimeStats(DisplayEngine::FrameTimeType type) const;
+        int getNumFramesTooLate() const;
+        int getNumConsecutiveLateFrames() const;
+        int getMaxConsecutiveLateFrames() const;
 
         NodePtr createNode(const std::string& sType, const py::dict& PyDict,
                 const py::object& self=py::object());
@@ -153,7 +164,12 @@ class AVG_API Player: public Publisher
         MouseEventPtr getMouseState() const;
         EventPtr getCurrentEvent() const;
         BitmapPtr getTouchUserBmp() const;
+        int getNumTouchPacketsReceived() const;
+        int getNumTouchEventsReceived() const;
+        int getNumTouchEventsDispatched() const;
         void enableMouse(bool enabled);
+        void setHitTestIndexThreshold(int numChildren);
+        int getHitTestIndexThreshold() const;
         void setEventCapture(NodePtr pNode, int cursorID);
         void releaseEventCapture(int cursorID);
         bool isCaptured(int cursorID);
@@ -180,6 +196,8 @@ class AVG_API Player: public Publisher
         bool getStopOnEscape() const;
         void setVolume(float volume);
         float getVolume() const;
+        int getNumAudioUnderruns() const;
+        int getNumLateAudioCallbacks() const;
         std::string getConfigOption(const std::string& sSubsys, const std::string& sName)
                 const;
         bool isUsingGLES() const;
@@ -279,6 +297,8 @@ class AVG_API Player: public Publisher
         long long m_FrameTime;
         long long m_PlayStartTime;
         long long m_NumFrames;
+        int m_FrameTimeWindow;
+        DisplayEngine::FramePacing m_FramePacing;
 
         float m_Volume;
 
@@ -308,6 +328,7 @@ class AVG_API Player: public Publisher
 
         PyObject * m_EventHookPyFunc;
         bool m_bMouseEnabled;
+        int m_HitTestIndexThreshold;
 };
 
 }
@@ -140,6 +140,7 @@ void RasterNode::disconnect(bool bKill)
 
 void RasterNode::checkReload()
 {
+    setCanvasDirty();
     string sLastMaskFilename = m_sMaskFilename;
     string sMaskFilename = m_sMaskHref;
     initFilename(sMaskFilename);
@@ -207,6 +208,7 @@ void RasterNode::setWarpedVertexCoords(const VertexGrid& grid)
         m_pSubVA = new SubVertexArray();
     }
     m_TileVertices = grid;
+    setCanvasDirty();
 }
 
 void RasterNode::setMirror(MirrorType mirrorType)
@@ -257,6 +259,7 @@ void RasterNode::setBlendModeStr(const string& sBlendMode)
     }
     m_sBlendMode = sBlendMode;
     m_BlendMode = blendMode;
+    setCanvasDirty();
 }
 
 const UTF8String& RasterNode::getMaskHRef() const
@@ -285,6 +288,7 @@ void RasterNode::setMaskBitmap(BitmapPtr pBmp)
     if (getState() == Node::NS_CANRENDER && m_pMaskBmp) {
         downloadMask();
     }
+    setCanvasDirty();
 }
 
 const glm::vec2& RasterNode::getMaskPos() const
@@ -296,6 +300,7 @@ void RasterNode::setMaskPos(const glm::vec2& pos)
 {
     m_MaskPos = pos;
     setMaskCoords();
+    setCanvasDirty();
 }
 
 const glm::vec2& RasterNode::getMaskSize() const
@@ -307,6 +312,7 @@ void RasterNode::setMaskSize(const glm::vec2& size)
 {
     m_MaskSize = size;
     setMaskCoords();
+    setCanvasDirty();
 }
 
 void RasterNode::getElementsByPos(const glm::vec2& pos, NodeChainPtr& pElements)
@@ -328,6 +334,7 @@ void RasterNode::setGamma(const glm::vec3& gamma)
     if (getState() == Node::NS_CANRENDER) {
         m_pSurface->setColorParams(m_Gamma, m_Intensity, m_Contrast);
     }
+    setCanvasDirty();
 }
 
 glm::vec3 RasterNode::getIntensity() const
@@ -341,6 +348,7 @@ void RasterNode::setIntensity(const glm::vec3& intensity)
     if (getState() == Node::NS_CANRENDER) {
         m_pSurface->setColorParams(m_Gamma, m_Intensity, m_Contrast);
     }
+    setCanvasDirty();
 }
 
 glm::vec3 RasterNode::getContrast() const
@@ -354,6 +362,7 @@ void RasterNode::setContrast(const glm::vec3& contrast)
     if (getState() == Node::NS_CANRENDER) {
         m_pSurface->setColorParams(m_Gamma, m_Intensity, m_Contrast);
     }
+    setCanvasDirty();
 }
 
 void RasterNode::setEffect(FXNodePtr pFXNode)
@@ -368,6 +377,7 @@ void RasterNode::setEffect(FXNodePtr pFXNode)
     if (getState() == NS_CANRENDER) {
         setupFX();
     }
+    setCanvasDirty();
 }
 
 static ProfilingZoneID FXProfilingZone("RasterNode::renderFX");
@@ -421,13 +431,32 @@ void RasterNode::resetFXDirty()
 void RasterNode::scheduleFXRender()
 {
     if (m_pFXNode) {
+        // Effects are scheduled in every frame, so the node can't be skipped.
+        setPreRenderDirty();
         getCanvas()->scheduleFXRender(
                 dynamic_pointer_cast<RasterNode>(shared_from_this()));
     }
 }
 
+glm::mat4 RasterNode::getBatchTransform() const
+{
+    // Same geometry as calcVertexArray(), but transformed to parent coordinates so
+    // all nodes in a batch can share one transform.
+    glm::vec2 size = getSize();
+    return glm::scale(getLocalTransform(), glm::vec3(size.x, size.y, 1));
+}
+
 void RasterNode::calcVertexArray(const VertexArrayPtr& pVA)
 {
+    if (m_pSurface->isAtlasRegionMoved()) {
+        // Atlas defragmentation moved the image to a different part of the texture.
+        calcTexCoords();
+        if (m_pImagingProjection) {
+            m_pImagingProjection->setTexCoordRect(m_pSurface->getTexCoordRect());
+        }
+        m_bFXDirty = true;
+        m_pSurface->resetAtlasRegionMoved();
+    }
     if (m_pSurface->isCreated() && !m_bHasStdVertices && isVisible()) {
         pVA->startSubVA(*m_pSubVA);
         for (unsigned y = 0; y < m_TileVertices.size()-1; y++) {
@@ -490,6 +519,82 @@ void RasterNode::blt(GLContext* pContext, const glm::mat4& transform,
     pShader->setTransform(localTransform);
     pShader->activate();
     m_pSubVA->draw();
+    getCanvas()->addDrawCalls(1, 1);
+}
+
+bool RasterNode::isBatchable() const
+{
+    return false;
+}
+
+bool RasterNode::canBatchWith(const RasterNode& other) const
+{
+    return m_BlendMode == other.m_BlendMode && 
+            getEffectiveOpacity() == other.getEffectiveOpacity() &&
+            m_pSurface->isBatchCompatible(*other.m_pSurface);
+}
+
+static glm::vec2 transformPoint(const glm::mat4& transform, const glm::vec2& pt)
+{
+    glm::vec4 transformed = transform*glm::vec4(pt.x, pt.y, 0, 1);
+    return glm::vec2(transformed.x, transformed.y);
+}
+
+int RasterNode::getNumBatchVertices() const
+{
+    return int((m_TileVertices.size()-1)*(m_TileVertices[0].size()-1)*4);
+}
+
+// Corners of a tile in the order the vertexes are written.
+static const unsigned TILE_CORNERS[4][2] = {{0,0}, {1,0}, {1,1}, {0,1}};
+
+void RasterNode::appendBatchVertices(SubVertexArray& subVA)
+{
+    glm::mat4 transform = getBatchTransform();
+    for (unsigned y = 0; y < m_TileVertices.size()-1; y++) {
+        for (unsigned x = 0; x < m_TileVertices[0].size()-1; x++) {
+            int curVertex = subVA.getNumVerts();
+            for (unsigned i = 0; i < 4; ++i) {
+                unsigned tx = x+TILE_CORNERS[i][0];
+                unsigned ty = y+TILE_CORNERS[i][1];
+                subVA.appendPos(transformPoint(transform, m_TileVertices[ty][tx]), 
+                        m_TexCoords[ty][tx], m_Color);
+            }
+            subVA.appendQuadIndexes(curVertex+1, curVertex, curVertex+2, curVertex+3);
+        }
+    }
+}
+
+void RasterNode::updateBatchVertices(SubVertexArray& subVA, int startVertex)
+{
+    glm::mat4 transform = getBatchTransform();
+    int curVertex = startVertex;
+    for (unsigned y = 0; y < m_TileVertices.size()-1; y++) {
+        for (unsigned x = 0; x < m_TileVertices[0].size()-1; x++) {
+            for (unsigned i = 0; i < 4; ++i) {
+                unsigned tx = x+TILE_CORNERS[i][0];
+                unsigned ty = y+TILE_CORNERS[i][1];
+                subVA.setPos(curVertex, 
+                        transformPoint(transform, m_TileVertices[ty][tx]), 
+                        m_TexCoords[ty][tx], m_Color);
+                curVertex++;
+            }
+        }
+    }
+}
+
+void RasterNode::bltBatch(GLContext* pContext, const glm::mat4& transform,
+        SubVertexArray& subVA)
+{
+    StandardShader* pShader = pContext->getStandardShader();
+    float opacity = getEffectiveOpacity();
+    pContext->setBlendColor(glm::vec4(1.0f, 1.0f, 1.0f, opacity));
+    pShader->setAlpha(opacity);
+    m_pSurface->activate(pContext, getMediaSize());
+    pContext->setBlendMode(m_BlendMode, m_pSurface->isPremultipliedAlpha());
+    pShader->setTransform(transform);
+    pShader->activate();
+    subVA.draw();
 }
 
 GLContext::BlendMode RasterNode::getBlendMode() const
@@ -507,6 +612,11 @@ bool RasterNode::hasMask() const
     return m_pMaskBmp != BitmapPtr();
 }
 
+bool RasterNode::hasStdRenderState() const
+{
+    return m_pSurface->isCreated() && !m_pFXNode && !hasMask();
+}
+
 const BitmapPtr RasterNode::getMaskBmp() const
 {
     return m_pMaskBmp;
@@ -560,7 +670,8 @@ void RasterNode::newSurface()
 {
     if (m_pSurface->isCreated()) {
         m_bHasStdVertices = !(m_pSurface->getPixelFormat() == A8) &&
-                !GLContext::getCurrent()->usePOTTextures();
+                !GLContext::getCurrent()->usePOTTextures() && 
+                !m_pSurface->isInAtlas();
         if (m_bHasStdVertices) {
             m_pSubVA = &(getCanvas()->getStdSubVA());
         } else {
@@ -570,6 +681,7 @@ void RasterNode::newSurface()
         calcVertexGrid(m_TileVertices);
         calcTexCoords();
         setupFX();
+        setPreRenderDirty();
     }
 }
 
@@ -577,6 +689,7 @@ void RasterNode::setupFX()
 {
     if (m_pSurface && m_pSurface->getSize() != IntPoint(-1,-1) && m_pFXNode) {
         m_pFXNode->setSize(m_pSurface->getSize());
+        m_pFXNode->setCanvas(getCanvas());
         m_pFXNode->connect();
         m_bFXDirty = true;
         if (!m_pFBO || m_pFBO->getSize() != m_pSurface->getSize()) {
@@ -587,6 +700,11 @@ void RasterNode::setupFX()
             m_pImagingProjection = ImagingProjectionPtr(new ImagingProjection(
                     m_pSurface->getSize()));
         }
+        if (m_pSurface->isInAtlas()) {
+            m_pImagingProjection->setTexCoordRect(m_pSurface->getTexCoordRect());
+        } else {
+            m_pImagingProjection->setTexCoordRect(FRect(0, 0, 1, 1));
+        }
     }
 }
 
@@ -630,10 +748,10 @@ void RasterNode::calcTileVertex(int x, int y, glm::vec2& Vertex)
 
 void RasterNode::calcTexCoords()
 {
-    glm::vec2 textureSize = glm::vec2(m_pSurface->getTextureSize());
+    // For images in a texture atlas, the rect covers only part of the texture.
+    FRect texCoordRect = m_pSurface->getTexCoordRect();
     glm::vec2 imageSize = glm::vec2(m_pSurface->getSize());
-    glm::vec2 texCoordExtents = glm::vec2(imageSize.x/textureSize.x,
-            imageSize.y/textureSize.y);
+    glm::vec2 texCoordExtents = texCoordRect.size();
 
     glm::vec2 texSizePerTile;
     if (m_TileSize.x == -1) {
@@ -659,6 +777,7 @@ void RasterNode::calcTexCoords()
             } else {
                 m_TexCoords[y][x].x = texSizePerTile.x*x;
             }
+            m_TexCoords[y][x] += texCoordRect.tl;
         }
     }
 }
@@ -101,10 +101,22 @@ class AVG_API RasterNode: public AreaNode
         virtual void renderFX(GLContext* pContext);
         void resetFXDirty();
 
+        // Draw call batching: Consecutive batchable siblings that can be batched with
+        // each other are rendered by the parent using a single draw call.
+        virtual bool isBatchable() const;
+        bool canBatchWith(const RasterNode& other) const;
+        int getNumBatchVertices() const;
+        void appendBatchVertices(SubVertexArray& subVA);
+        // Rewrites vertexes appended by appendBatchVertices() in an earlier frame.
+        void updateBatchVertices(SubVertexArray& subVA, int startVertex);
+        void bltBatch(GLContext* pContext, const glm::mat4& transform, 
+                SubVertexArray& subVA);
+
     protected:
         RasterNode(const std::string& sPublisherName);
         
         void scheduleFXRender();
+        glm::mat4 getBatchTransform() const;
         void calcVertexArray(const VertexArrayPtr& pVA);
         void blt32(GLContext* pContext, const glm::mat4& transform);
         void blt(GLContext* pContext, const glm::mat4& transform,
@@ -112,6 +124,7 @@ class AVG_API RasterNode: public AreaNode
 
         virtual OGLSurface * getSurface();
         bool hasMask() const;
+        bool hasStdRenderState() const;
         const BitmapPtr getMaskBmp() const;
         void setMaskCoords();
         void setRenderColor(const Pixel32& color);
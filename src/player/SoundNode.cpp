@@ -310,8 +310,8 @@ void SoundNode::startDecoding()
 {
     AudioEngine* pEngine = AudioEngine::get();
     m_pDecoder->startDecoding(false, pEngine->getParams());
-    m_AudioID = pEngine->addSource(*m_pDecoder->getAudioMsgQ(), 
-            *m_pDecoder->getAudioStatusQ());
+    m_AudioID = pEngine->addSource(m_pDecoder->getAudioMsgQ(), 
+            m_pDecoder->getAudioStatusQ(), m_pDecoder->getAudioTimeStatus());
     pEngine->setSourceVolume(m_AudioID, m_Volume);
     if (m_SeekBeforeCanRenderTime != 0) {
         seek(m_SeekBeforeCanRenderTime);
@@ -64,7 +64,8 @@ TUIOInputDevice::TUIOInputDevice(const DivNodePtr& pEventReceiverNode, int port)
     : MultitouchInputDevice(pEventReceiverNode),
       m_pSocket(0),
       m_RemoteIP(0),
-      m_bConnected(false)
+      m_bConnected(false),
+      m_NumPacketsReceived(0)
 {
     if (port != 0) {
         m_Port = port;
@@ -124,11 +125,18 @@ BitmapPtr TUIOInputDevice::getUserBmp() const
     return m_pUserBmp;
 }
 
+int TUIOInputDevice::getNumPacketsReceived()
+{
+    lock_guard lock(getMutex());
+    return m_NumPacketsReceived;
+}
+
 void TUIOInputDevice::ProcessPacket(const char* pData, int size, 
         const IpEndpointName& remoteEndpoint)
 {
     lock_guard lock(getMutex());
     m_RemoteIP = remoteEndpoint.address;
+    m_NumPacketsReceived++;
     try {
         ReceivedPacket packet(pData, size);
         if (packet.IsBundle()) {
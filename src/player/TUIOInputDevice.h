@@ -49,6 +49,7 @@ public:
    
     virtual unsigned getRemoteIP() const;
     virtual BitmapPtr getUserBmp() const;
+    int getNumPacketsReceived();
 
     virtual void ProcessPacket(const char* pData, int size, 
             const IpEndpointName& remoteEndpoint);
@@ -76,6 +77,7 @@ private:
     unsigned m_RemoteIP;
     int m_Port;
     bool m_bConnected;
+    int m_NumPacketsReceived;
     BitmapPtr m_pUserBmp;
 #ifndef WIN32
     pthread_t m_Thread;
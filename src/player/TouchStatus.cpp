@@ -35,7 +35,8 @@ namespace avg {
 
 TouchStatus::TouchStatus(CursorEventPtr pEvent)
     : m_bFirstFrame(true),
-      m_CursorID(pEvent->getCursorID())
+      m_CursorID(pEvent->getCursorID()),
+      m_NumEventsReceived(1)
 {
     m_pNewEvents.push_back(pEvent);
     m_pLastEvent = pEvent;
@@ -49,7 +50,15 @@ void TouchStatus::pushEvent(CursorEventPtr pEvent, bool bCheckMotion)
 {
     AVG_ASSERT(pEvent);
     pEvent->setCursorID(m_CursorID);
+    m_NumEventsReceived++;
 
+    if (!m_pNewEvents.empty() && 
+            m_pNewEvents.back()->getType() == Event::CURSOR_UP)
+    {
+        // The touch has ended; anything after the up event would be delivered out
+        // of order.
+        return;
+    }
     if (m_bFirstFrame) {
         // Ignore unless cursorup.
         if (pEvent->getType() == Event::CURSOR_UP) {
@@ -69,7 +78,10 @@ void TouchStatus::pushEvent(CursorEventPtr pEvent, bool bCheckMotion)
                 // No pending events: schedule for delivery.
                 m_pNewEvents.push_back(pEvent);
             } else {
-                // More than one event per poll: Deliver only the last one.
+                // More than one event per poll: The pending event is a motion event
+                // and the new event supersedes it. A motion event carries the newest
+                // position and speed, an up event is cloned from the last event.
+                AVG_ASSERT(m_pNewEvents[0]->getType() == Event::CURSOR_MOTION);
                 m_pNewEvents[0] = pEvent;
             }
         }
@@ -104,5 +116,10 @@ int TouchStatus::getID() const
     return m_CursorID;
 }
 
+int TouchStatus::getNumEventsReceived() const
+{
+    return m_NumEventsReceived;
+}
+
 }
 
@@ -43,6 +43,7 @@ public:
     CursorEventPtr getLastEvent();
 
     int getID() const;
+    int getNumEventsReceived() const;
 
 private:
     CursorEventPtr m_pLastEvent;
@@ -50,6 +51,7 @@ private:
 
     bool m_bFirstFrame;
     int m_CursorID;
+    int m_NumEventsReceived;
 };
 
 typedef boost::shared_ptr<class TouchStatus> TouchStatusPtr;
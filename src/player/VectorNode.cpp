@@ -26,6 +26,7 @@
 #include "OGLSurface.h"
 #include "Shape.h"
 #include "NodeChain.h"
+#include "Canvas.h"
 
 #include "../base/Exception.h"
 #include "../base/Logger.h"
@@ -140,6 +141,7 @@ void VectorNode::setBlendModeStr(const string& sBlendMode)
 {
     m_sBlendMode = sBlendMode;
     m_BlendMode = GLContext::stringToBlendMode(sBlendMode);
+    setCanvasDirty();
 }
 
 static ProfilingZoneID PrerenderProfilingZone("VectorNode::prerender");
@@ -176,6 +178,7 @@ void VectorNode::render(GLContext* pContext, const glm::mat4& transform)
     float curOpacity = getEffectiveOpacity();
     if (curOpacity > 0.01) {
         m_pShape->draw(pContext, transform, curOpacity);
+        getCanvas()->addDrawCalls(1, 1);
     }
 }
 
@@ -192,7 +195,7 @@ void VectorNode::setColor(const Color& color)
 {
     if (m_Color != color) {
         m_Color = color;
-        m_bDrawNeeded = true;
+        setDrawNeeded();
     }
 }
 
@@ -204,7 +207,7 @@ const Color& VectorNode::getColor() const
 void VectorNode::setStrokeWidth(float width)
 {
     if (width != m_StrokeWidth) {
-        m_bDrawNeeded = true;
+        setDrawNeeded();
         m_StrokeWidth = width;
     }
 }
@@ -253,6 +256,7 @@ string VectorNode::dump(int indent)
 void VectorNode::setDrawNeeded()
 {
     m_bDrawNeeded = true;
+    setCanvasDirty();
 }
         
 bool VectorNode::isDrawNeeded()
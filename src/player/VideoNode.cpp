@@ -62,6 +62,12 @@ void VideoNode::registerType()
         .addArg(Arg<float>("fps", 0.0, false, offsetof(VideoNode, m_FPS)))
         .addArg(Arg<int>("queuelength", 8, false, 
                 offsetof(VideoNode, m_QueueLength)))
+        .addArg(Arg<int>("framepoolsize", 0, false, 
+                offsetof(VideoNode, m_FramePoolSize)))
+        .addArg(Arg<int>("decodingthreads", -1, false, 
+                offsetof(VideoNode, m_DecodingThreads)))
+        .addArg(Arg<bool>("scrubmode", false, false, 
+                offsetof(VideoNode, m_bScrubMode)))
         .addArg(Arg<float>("volume", 1.0, false, offsetof(VideoNode, m_Volume)))
         .addArg(Arg<bool>("enablesound", true, false,
                 offsetof(VideoNode, m_bEnableSound)))
@@ -92,11 +98,27 @@ VideoNode::VideoNode(const ArgList& args,const string& sPublisherName)
         throw Exception(AVG_ERR_INVALID_ARGS, 
                 "Can't set queue length for unthreaded videos because there is no decoder queue in this case.");
     }
+    if (!m_bThreaded && m_FramePoolSize != 0) {
+        throw Exception(AVG_ERR_INVALID_ARGS, 
+                "Can't set frame pool size for unthreaded videos.");
+    }
+    if (m_DecodingThreads < -1) {
+        throw Exception(AVG_ERR_OUT_OF_RANGE, 
+                "Number of decoding threads must be -1 (use avgrc), 0 (auto) or more.");
+    }
+    if (!m_bThreaded && m_bScrubMode) {
+        throw Exception(AVG_ERR_INVALID_ARGS, 
+                "Scrub mode is only available for threaded videos.");
+    }
     if (m_bThreaded) {
-        m_pDecoder = new AsyncVideoDecoder(m_QueueLength);
+        AsyncVideoDecoder* pAsyncDecoder = 
+                new AsyncVideoDecoder(m_QueueLength, m_FramePoolSize);
+        pAsyncDecoder->setScrubMode(m_bScrubMode);
+        m_pDecoder = pAsyncDecoder;
     } else {
         m_pDecoder = new SyncVideoDecoder();
     }
+    m_pDecoder->setNumDecodingThreads(m_DecodingThreads);
 
     ObjectCounter::get()->incRef(&typeid(*this));
 }
@@ -426,6 +448,7 @@ void VideoNode::changeVideoState(VideoState newVideoState)
         }
     }
     m_VideoState = newVideoState;
+    setCanvasDirty();
 }
 
 void VideoNode::seek(long long destTime) 
@@ -446,6 +469,7 @@ void VideoNode::seek(long long destTime)
         // the actual seek until the decoder is ready.
         m_SeekBeforeCanRenderTime = destTime;
     }
+    setCanvasDirty();
 }
 
 void VideoNode::open() 
@@ -490,8 +514,8 @@ void VideoNode::startDecoding()
     if (videoInfo.m_bHasAudio && pAudioEngine) {
         AsyncVideoDecoder* pAsyncDecoder = 
                 dynamic_cast<AsyncVideoDecoder*>(m_pDecoder);
-        m_AudioID = pAudioEngine->addSource(*pAsyncDecoder->getAudioMsgQ(), 
-                *pAsyncDecoder->getAudioStatusQ());
+        m_AudioID = pAudioEngine->addSource(pAsyncDecoder->getAudioMsgQ(), 
+                pAsyncDecoder->getAudioStatusQ(), pAsyncDecoder->getAudioTimeStatus());
         pAudioEngine->setSourceVolume(m_AudioID, m_Volume);
     }
     m_bSeekPending = true;
@@ -584,6 +608,78 @@ int VideoNode::getQueueLength() const
     return m_QueueLength;
 }
 
+int VideoNode::getNumDecodingThreads() const
+{
+    exceptionIfUnloaded("getNumDecodingThreads");
+    return m_pDecoder->getVideoInfo().m_NumDecodingThreads;
+}
+
+int VideoNode::getFramePoolSize() const
+{
+    exceptionIfUnloaded("getFramePoolSize");
+    return m_pDecoder->getFramePoolSize();
+}
+
+long long VideoNode::getFramePoolHits() const
+{
+    exceptionIfUnloaded("getFramePoolHits");
+    return m_pDecoder->getFramePoolHits();
+}
+
+long long VideoNode::getFramePoolMisses() const
+{
+    exceptionIfUnloaded("getFramePoolMisses");
+    return m_pDecoder->getFramePoolMisses();
+}
+
+bool VideoNode::isScrubMode() const
+{
+    return m_bScrubMode;
+}
+
+void VideoNode::setScrubMode(bool bScrubMode)
+{
+    if (!m_bThreaded && bScrubMode) {
+        throw Exception(AVG_ERR_INVALID_ARGS, 
+                "Scrub mode is only available for threaded videos.");
+    }
+    m_bScrubMode = bScrubMode;
+    AsyncVideoDecoder* pAsyncDecoder = dynamic_cast<AsyncVideoDecoder*>(m_pDecoder);
+    if (pAsyncDecoder) {
+        pAsyncDecoder->setScrubMode(bScrubMode);
+    }
+}
+
+int VideoNode::getNumSeeksDone() const
+{
+    exceptionIfUnloaded("getNumSeeksDone");
+    return m_pDecoder->getNumSeeksDone();
+}
+
+int VideoNode::getNumSeeksCancelled() const
+{
+    exceptionIfUnloaded("getNumSeeksCancelled");
+    return m_pDecoder->getNumSeeksCancelled();
+}
+
+float VideoNode::getAvgSeekLatency() const
+{
+    exceptionIfUnloaded("getAvgSeekLatency");
+    return m_pDecoder->getAvgSeekLatency();
+}
+
+float VideoNode::getMaxSeekLatency() const
+{
+    exceptionIfUnloaded("getMaxSeekLatency");
+    return m_pDecoder->getMaxSeekLatency();
+}
+
+float VideoNode::getAvgExactSeekLatency() const
+{
+    exceptionIfUnloaded("getAvgExactSeekLatency");
+    return m_pDecoder->getAvgExactSeekLatency();
+}
+
 long long VideoNode::getNextFrameTime() const
 {
     switch (m_VideoState) {
@@ -615,6 +711,13 @@ long long VideoNode::getNextFrameTime() const
     }
 }
 
+bool VideoNode::isRefiningSeek() const
+{
+    // Scrub mode implies an AsyncVideoDecoder.
+    return m_bScrubMode && 
+            dynamic_cast<AsyncVideoDecoder*>(m_pDecoder)->isRefiningSeek();
+}
+
 void VideoNode::exceptionIfNoAudio(const std::string& sFuncName) const
 {
     exceptionIfUnloaded(sFuncName);
@@ -645,8 +748,9 @@ void VideoNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
                 bool bNewFrame = renderFrame();
                 m_bFrameAvailable |= bNewFrame;
             } else { // Paused
-                if (!m_bFrameAvailable) {
-                    m_bFrameAvailable = renderFrame();
+                if (!m_bFrameAvailable || isRefiningSeek()) {
+                    bool bNewFrame = renderFrame();
+                    m_bFrameAvailable |= bNewFrame;
                 }
             }
             m_bFirstFrameDecoded |= m_bFrameAvailable;
@@ -668,6 +772,12 @@ void VideoNode::preRender(const VertexArrayPtr& pVA, bool bIsParentActive,
             }
         }
     }
+    if (m_VideoState == Playing || (m_VideoState == Paused && 
+            (!m_bFrameAvailable || m_bSeekPending || isRefiningSeek())))
+    {
+        // New frames arrive without any attribute changes, so keep rendering.
+        setCanvasDirty();
+    }
     calcVertexArray(pVA);
 }
 
@@ -65,6 +65,17 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener
         void setVolume(float volume);
         float getFPS() const;
         int getQueueLength() const;
+        int getNumDecodingThreads() const;
+        int getFramePoolSize() const;
+        long long getFramePoolHits() const;
+        long long getFramePoolMisses() const;
+        bool isScrubMode() const;
+        void setScrubMode(bool bScrubMode);
+        int getNumSeeksDone() const;
+        int getNumSeeksCancelled() const;
+        float getAvgSeekLatency() const;
+        float getMaxSeekLatency() const;
+        float getAvgExactSeekLatency() const;
         void checkReload();
 
         int getNumFrames() const;
@@ -114,6 +125,7 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener
         void changeVideoState(VideoState NewVideoState);
         PixelFormat getPixelFormat() const;
         long long getNextFrameTime() const;
+        bool isRefiningSeek() const;
         void exceptionIfNoAudio(const std::string& sFuncName) const;
         void exceptionIfUnloaded(const std::string& sFuncName) const;
 
@@ -128,6 +140,9 @@ class AVG_API VideoNode: public RasterNode, IFrameEndListener
         bool m_bThreaded;
         float m_FPS;
         int m_QueueLength;
+        int m_FramePoolSize;
+        int m_DecodingThreads;
+        bool m_bScrubMode;
         bool m_bEOFPending;
         PyObject * m_pEOFCallback;
         int m_FramesTooLate;
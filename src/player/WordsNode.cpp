@@ -530,6 +530,7 @@ static ProfilingZoneID UpdateLayoutProfilingZone("WordsNode: Update layout");
 void WordsNode::updateLayout()
 {
     ScopeTimer timer(UpdateLayoutProfilingZone);
+    setCanvasDirty();
 
     if (m_sText.length() == 0) {
         m_LogicalSize = IntPoint(0,0);
@@ -657,6 +658,7 @@ void WordsNode::renderText()
             PangoRectangle ink_rect;
             pango_layout_get_pixel_extents(m_pLayout, &ink_rect, &logical_rect);
             pango_ft2_render_layout(&bitmap, m_pLayout, -ink_rect.x, -ink_rect.y);
+            int oldAlignOffset = m_AlignOffset;
             switch (m_FontStyle.getAlignmentVal()) {
                 case PANGO_ALIGN_LEFT:
                     m_AlignOffset = 0;
@@ -670,6 +672,9 @@ void WordsNode::renderText()
                 default:
                     AVG_ASSERT(false);
             }
+            if (m_AlignOffset != oldAlignOffset) {
+                hitTestBoundsChanged();
+            }
             setRenderColor(m_FontStyle.getColor());
 
             GLContextManager* pCM = GLContextManager::get();
@@ -0,0 +1,161 @@
+//
+//  libavg - Media Playback Engine.
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+#include "Player.h"
+#include "AVGNode.h"
+#include "TUIOInputDevice.h"
+
+#include "../base/TimeSource.h"
+
+#include "../oscpack/OscOutboundPacketStream.h"
+#include "../oscpack/UdpSocket.h"
+
+#include <boost/thread/thread.hpp>
+#include <boost/bind.hpp>
+
+#include <iostream>
+#include <vector>
+#include <math.h>
+
+using namespace avg;
+using namespace std;
+
+const int BENCHMARK_PORT = 3340;
+const int MAX_PACKET_SIZE = 65536;
+
+struct RecordedPacket {
+    long long m_Time;  // Microseconds since start of recording.
+    string m_Data;
+};
+
+typedef vector<RecordedPacket> Recording;
+
+// Records the packets a camera-based tracker sends: one bundle with alive, set and
+// fseq messages per tracker frame. The blobs move in circles and a third of them are
+// replaced every second so the recording contains down and up events as well.
+Recording recordTracker(int trackerFPS, int numBlobs, float duration)
+{
+    Recording recording;
+    vector<char> buffer(MAX_PACKET_SIZE);
+    int numFrames = int(duration*trackerFPS);
+    for (int frame = 0; frame < numFrames; ++frame) {
+        float t = float(frame)/trackerFPS;
+        int generation = frame/trackerFPS;
+        vector<osc::int32> ids;
+        for (int i = 0; i < numBlobs; ++i) {
+            if (i%3 == 0) {
+                ids.push_back(i + numBlobs*generation);
+            } else {
+                ids.push_back(i);
+            }
+        }
+
+        osc::OutboundPacketStream packet(&(buffer[0]), MAX_PACKET_SIZE);
+        packet << osc::BeginBundleImmediate;
+        packet << osc::BeginMessage("/tuio/2Dcur") << "alive";
+        for (int i = 0; i < numBlobs; ++i) {
+            packet << ids[i];
+        }
+        packet << osc::EndMessage;
+        for (int i = 0; i < numBlobs; ++i) {
+            float phase = t + i*0.1f;
+            float x = 0.5f + 0.4f*cosf(phase);
+            float y = 0.5f + 0.4f*sinf(phase);
+            packet << osc::BeginMessage("/tuio/2Dcur") << "set" << ids[i] << x << y
+                    << -0.4f*sinf(phase) << 0.4f*cosf(phase) << 0.f << osc::EndMessage;
+        }
+        packet << osc::BeginMessage("/tuio/2Dcur") << "fseq" << osc::int32(frame)
+                << osc::EndMessage;
+        packet << osc::EndBundle;
+
+        RecordedPacket recordedPacket;
+        recordedPacket.m_Time = (long long)(frame)*1000000/trackerFPS;
+        recordedPacket.m_Data = string(packet.Data(), packet.Size());
+        recording.push_back(recordedPacket);
+    }
+    return recording;
+}
+
+static void replayThread(const Recording* pRecording, int port)
+{
+    UdpTransmitSocket socket(IpEndpointName("127.0.0.1", port));
+    TimeSource* pTimeSource = TimeSource::get();
+    long long startTime = pTimeSource->getCurrentMillisecs();
+    for (unsigned i = 0; i < pRecording->size(); ++i) {
+        const RecordedPacket& packet = (*pRecording)[i];
+        pTimeSource->sleepUntil(startTime + packet.m_Time/1000);
+        socket.Send(packet.m_Data.c_str(), int(packet.m_Data.size()));
+    }
+}
+
+// Replays the recording over a loopback UDP socket in real time and polls the
+// device at the display frame rate, like the main loop does.
+void runReplayBenchmark(const string& sName, const DivNodePtr& pReceiverNode,
+        const Recording& recording, int port, int displayFPS=60)
+{
+    TUIOInputDevice device(pReceiverNode, port);
+    TimeSource* pTimeSource = TimeSource::get();
+    long long duration = recording.back().m_Time/1000 + 100;
+    long long startTime = pTimeSource->getCurrentMillisecs();
+    boost::thread sender(boost::bind(&replayThread, &recording, port));
+
+    int numFrames = 0;
+    long long pollTime = 0;
+    long long frameTime = startTime;
+    while (frameTime - startTime < duration) {
+        frameTime += 1000/displayFPS;
+        pTimeSource->sleepUntil(frameTime);
+        long long pollStartTime = pTimeSource->getCurrentMicrosecs();
+        device.pollEvents();
+        pollTime += pTimeSource->getCurrentMicrosecs() - pollStartTime;
+        numFrames++;
+    }
+    sender.join();
+
+    int numEventsReceived = device.getNumEventsReceived();
+    int numEventsDispatched = device.getNumEventsDispatched();
+    cerr << sName << ": " << device.getNumPacketsReceived() << "/" << recording.size()
+            << " packets, " << numEventsReceived << " events received, "
+            << numEventsDispatched << " dispatched ("
+            << (100.f*numEventsDispatched)/numEventsReceived << "%), "
+            << float(pollTime)/numFrames << " us/poll" << endl;
+}
+
+int main(int nargs, char** args)
+{
+    Player player;
+    player.loadString(
+            "<?xml version=\"1.0\"?>"
+            "<avg width=\"1920\" height=\"1080\"/>");
+    player.disablePython();
+    DivNodePtr pRootNode = player.getRootNode();
+
+    Recording recording = recordTracker(60, 10, 2);
+    runReplayBenchmark("60 Hz tracker, 10 blobs", pRootNode, recording,
+            BENCHMARK_PORT);
+    recording = recordTracker(200, 32, 2);
+    runReplayBenchmark("200 Hz tracker, 32 blobs", pRootNode, recording,
+            BENCHMARK_PORT+1);
+    recording = recordTracker(200, 64, 2);
+    runReplayBenchmark("200 Hz tracker, 64 blobs", pRootNode, recording,
+            BENCHMARK_PORT+2);
+}
+
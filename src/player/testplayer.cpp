@@ -20,6 +20,8 @@
 //
 
 #include "Player.h"
+#include "TouchStatus.h"
+#include "TouchEvent.h"
 
 #include "../base/TestSuite.h"
 #include "../base/Exception.h"
@@ -83,6 +85,69 @@ public:
     }
 };
 
+class TouchStatusTest: public Test {
+public:
+    TouchStatusTest()
+        : Test("TouchStatusTest", 2)
+    {
+    }
+
+    void runTests()
+    {
+        Player player;
+        {
+            // Motion in the first frame is ignored.
+            TouchStatus touch(createEvent(Event::CURSOR_DOWN, IntPoint(10, 10)));
+            touch.pushEvent(createEvent(Event::CURSOR_MOTION, IntPoint(11, 10)));
+            TEST(touch.pollEvent()->getType() == Event::CURSOR_DOWN);
+            TEST(!touch.pollEvent());
+
+            // Motion events between polls are merged, keeping the newest speed.
+            touch.pushEvent(createEvent(Event::CURSOR_MOTION, IntPoint(12, 10),
+                    glm::vec2(1, 0)));
+            touch.pushEvent(createEvent(Event::CURSOR_MOTION, IntPoint(14, 10),
+                    glm::vec2(2, 0)));
+            CursorEventPtr pEvent = touch.pollEvent();
+            TEST(pEvent->getType() == Event::CURSOR_MOTION);
+            TEST(pEvent->getPos() == glm::vec2(14, 10));
+            TEST(pEvent->getSpeed() == glm::vec2(2, 0));
+            TEST(!touch.pollEvent());
+
+            // Motion without movement is dropped.
+            touch.pushEvent(createEvent(Event::CURSOR_MOTION, IntPoint(14, 10)));
+            TEST(!touch.pollEvent());
+
+            // Up supersedes pending motion and nothing gets past it.
+            touch.pushEvent(createEvent(Event::CURSOR_MOTION, IntPoint(16, 10),
+                    glm::vec2(3, 0)));
+            touch.pushEvent(touch.getLastEvent()->cloneAs(Event::CURSOR_UP));
+            touch.pushEvent(createEvent(Event::CURSOR_MOTION, IntPoint(18, 10)));
+            pEvent = touch.pollEvent();
+            TEST(pEvent->getType() == Event::CURSOR_UP);
+            TEST(pEvent->getPos() == glm::vec2(16, 10));
+            TEST(pEvent->getSpeed() == glm::vec2(3, 0));
+            TEST(!touch.pollEvent());
+            TEST(touch.getNumEventsReceived() == 8);
+        }
+        {
+            // Down and up in the first frame are both delivered, in order.
+            TouchStatus touch(createEvent(Event::CURSOR_DOWN, IntPoint(10, 10)));
+            touch.pushEvent(createEvent(Event::CURSOR_UP, IntPoint(10, 10)));
+            touch.pushEvent(createEvent(Event::CURSOR_MOTION, IntPoint(12, 10)));
+            TEST(touch.pollEvent()->getType() == Event::CURSOR_DOWN);
+            TEST(touch.pollEvent()->getType() == Event::CURSOR_UP);
+            TEST(!touch.pollEvent());
+        }
+    }
+
+private:
+    CursorEventPtr createEvent(Event::Type type, const IntPoint& pos, 
+            const glm::vec2& speed=glm::vec2(0,0))
+    {
+        return TouchEventPtr(new TouchEvent(1, type, pos, Event::TOUCH, speed));
+    }
+};
+
 class PlayerTestSuite: public TestSuite {
 public:
     PlayerTestSuite()
@@ -90,6 +155,7 @@ public:
     {
         Test::setRelSrcDir(".");
         addTest(TestPtr(new PlayerTest));
+        addTest(TestPtr(new TouchStatusTest));
     }
 };
 
@@ -109,6 +109,112 @@ class AVTestCase(AVGTestCase):
         node = avg.VideoNode(href="mpeg1-48x48-sound.avi", queuelength=23, parent=root)
         self.assertEqual(node.queuelength, 23)
 
+    def testVideoFramePool(self):
+        def checkPoolStats():
+            # mpeg1 supports direct rendering, so frames are decoded into the pool.
+            # The pool can grow to four times its initial size.
+            poolSize = node.getFramePoolSize()
+            self.assert_(poolSize >= 4 and poolSize <= 16)
+            # More hits than slots: Slots have been reused.
+            self.assert_(node.getFramePoolHits() > poolSize)
+
+        player.setFakeFPS(25)
+        root = self.loadEmptyScene()
+        node = avg.VideoNode(href="mpeg1-48x48.mov", framepoolsize=4, parent=root)
+        self.assertException(node.getFramePoolSize)
+        node.play()
+        self.start(False,
+                [None]*20
+                + [checkPoolStats,
+                   lambda: node.seekToFrame(0)]
+                + [None]*20
+                + [checkPoolStats])
+        self.assertException(lambda: avg.VideoNode(href="mpeg1-48x48.mov",
+                threaded=False, framepoolsize=12))
+
+    def testVideoDecodingThreads(self):
+        def checkThreads(node, numThreads):
+            self.assertEqual(node.getNumDecodingThreads(), numThreads)
+
+        def checkSameFrame():
+            # Frame threading delays the decoded pictures. This mustn't change the 
+            # frame times.
+            self.assertEqual(multiNode.getCurFrame(), singleNode.getCurFrame())
+
+        def seek():
+            for node in (singleNode, multiNode):
+                node.pause()
+                node.seekToFrame(20)
+
+        player.setFakeFPS(25)
+        root = self.loadEmptyScene()
+        # h264 supports frame threading, unlike mpeg1.
+        singleNode = avg.VideoNode(href="h264-48x48.h264", decodingthreads=1, 
+                parent=root)
+        self.assertException(singleNode.getNumDecodingThreads)
+        multiNode = avg.VideoNode(href="h264-48x48.h264", decodingthreads=2, 
+                parent=root)
+        unthreadedNode = avg.VideoNode(href="h264-48x48.h264", threaded=False,
+                decodingthreads=2, parent=root)
+        self.assertException(lambda: avg.VideoNode(href="h264-48x48.h264",
+                decodingthreads=-2))
+        for node in (singleNode, multiNode, unthreadedNode):
+            node.play()
+        self.start(False,
+                [lambda: checkThreads(singleNode, 1),
+                 lambda: checkThreads(multiNode, 2),
+                 lambda: checkThreads(unthreadedNode, 2)]
+                + [checkSameFrame]*10
+                + [seek,
+                   None,
+                   checkSameFrame,
+                   lambda: self.assertEqual(multiNode.getCurFrame(), 20),
+                  ])
+
+    def testVideoScrub(self):
+        def onFrame():
+            self.numFrames += 1
+            if self.numFrames == 2:
+                # The first seek is cancelled by the second one.
+                node.seekToFrame(10)
+                node.seekToFrame(20)
+                self.assert_(node.isSeeking())
+            elif self.numFrames > 2 and self.firstSeekFrame is None:
+                if node.getCurFrame() != 0:
+                    # The keyframes of the video are 0, 12 and 24. The keyframe 
+                    # before the destination is shown before the destination frame.
+                    self.firstSeekFrame = node.getCurFrame()
+                    self.assertEqual(self.firstSeekFrame, 12)
+            elif self.numFrames > 2 and node.getCurFrame() == 20:
+                # Refining to the destination frame takes an unknown number of frames.
+                self.assert_(not(node.isSeeking()))
+                self.assertEqual(node.getNumSeeksDone(), 1)
+                self.assertEqual(node.getNumSeeksCancelled(), 1)
+                self.assert_(node.getMaxSeekLatency() >= node.getAvgSeekLatency())
+                self.assert_(node.getAvgExactSeekLatency() >= 
+                        node.getAvgSeekLatency())
+                player.stop()
+
+        def onTimeout():
+            self.fail("Scrubbing didn't reach the destination frame.")
+
+        player.setFakeFPS(25)
+        root = self.loadEmptyScene()
+        node = avg.VideoNode(href="mpeg1-48x48.mov", scrubmode=True, parent=root)
+        self.assert_(node.scrubmode)
+        self.assertException(node.getNumSeeksDone)
+        self.assertException(lambda: avg.VideoNode(href="mpeg1-48x48.mov", 
+                threaded=False, scrubmode=True))
+        node.play()
+        node.pause()
+        self.numFrames = 0
+        self.firstSeekFrame = None
+        player.subscribe(avg.Player.ON_FRAME, onFrame)
+        player.setTimeout(100000, onTimeout)
+        player.play()
+        node.scrubmode = False
+        self.assert_(not(node.scrubmode))
+
     def testVideoFiles(self):
         def testVideoFile(filename, isThreaded):
             def setVolume(volume):
@@ -531,6 +637,63 @@ class AVTestCase(AVGTestCase):
                  lambda: soundNode.seekToTime(200),
                 ))
 
+    def testAudioStats(self):
+        def onEOF():
+            self.numEOFs += 1
+
+        def seekRepeatedly():
+            # Seeks don't wait for the audio thread, so queueing several is fine.
+            for time in (100, 800, 300, 1200):
+                soundNode.seekToTime(time)
+
+        def seekToEnd():
+            self.numEOFs = 0
+            soundNode.seekToTime(soundNode.getDuration()-100)
+
+        def checkLooped():
+            # The end of the file was reached and the seek back to the start has
+            # completed, so playback continues.
+            self.assertEqual(self.numEOFs, 1)
+            self.assert_(soundNode.getCurTime() < soundNode.getDuration()-100)
+
+        def seekBeyondEnd():
+            self.numEOFs = 0
+            soundNode.seekToTime(soundNode.getDuration()+1000)
+
+        def checkSeekBeyondEnd():
+            # Seeking past the end counts as an EOF and doesn't leave a seek pending.
+            self.assert_(self.numEOFs >= 1)
+
+        def stopSound():
+            soundNode.stop()
+            self.numUnderruns = player.getNumAudioUnderruns()
+
+        def checkStopped():
+            # Sources that aren't playing can't underrun.
+            self.assertEqual(player.getNumAudioUnderruns(), self.numUnderruns)
+
+        player.setFakeFPS(-1)
+        player.volume = 0
+        root = self.loadEmptyScene()
+        soundNode = avg.SoundNode(parent=root, loop=True,
+                href="44.1kHz_16bit_stereo.wav")
+        soundNode.subscribe(avg.Node.END_OF_FILE, onEOF)
+        self.numEOFs = 0
+        soundNode.play()
+        self.start(False,
+                (seekRepeatedly,
+                 lambda: self.delay(100),
+                 seekToEnd,
+                 lambda: self.delay(500),
+                 checkLooped,
+                 seekBeyondEnd,
+                 lambda: self.delay(300),
+                 checkSeekBeyondEnd,
+                 stopSound,
+                 lambda: self.delay(200),
+                 checkStopped,
+                ))
+
 
     def testBrokenSound(self):
         def openSound():
@@ -660,9 +823,13 @@ def AVTestSuite(tests):
             "testSound",
             "testSoundInfo",
             "testSoundSeek",
+            "testAudioStats",
             "testBrokenSound",
             "testSoundEOF",
             "testVideoInfo",
+            "testVideoFramePool",
+            "testVideoDecodingThreads",
+            "testVideoScrub",
             "testVideoFiles",
             "testPlayBeforeConnect",
             "testVideoState",
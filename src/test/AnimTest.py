@@ -509,6 +509,59 @@ class AnimTestCase(AVGTestCase):
         genericObject2 = None
         genericObject3 = None
 
+    def testNodeAttrAnims(self):
+        class ClampedImageNode(avg.ImageNode):
+            # Overrides a node attribute, so animations must go through Python.
+            def __init__(self, parent=None, **kwargs):
+                avg.ImageNode.__init__(self, **kwargs)
+                self.registerInstance(self, parent)
+
+            def getX(self):
+                return avg.ImageNode.x.__get__(self)
+
+            def setX(self, x):
+                avg.ImageNode.x.__set__(self, min(x, 50))
+
+            x = property(getX, setX)
+
+        def startAnims():
+            for anim in anims:
+                anim.start()
+
+        def checkEndValues():
+            self.assertEqual(avg.Anim.getNumRunningAnims(), 0)
+            self.assertEqual(image.pos, (100, 40))
+            self.assertAlmostEqual(image.opacity, 0.5)
+            self.assertEqual(clampedImage.x, 50)
+            self.assertEqual(rect.size, (20, 30))
+            self.assertEqual(rect.fillcolor, avg.Color("0000FF"))
+            self.assertEqual(circle.r, 20)
+            self.assertEqual(circle.pos, (50, 60))
+
+        root = self.loadEmptyScene()
+        image = avg.ImageNode(href="rgb24-65x65.png", parent=root)
+        clampedImage = ClampedImageNode(href="rgb24-65x65.png", parent=root)
+        rect = avg.RectNode(size=(10,10), fillcolor="FF0000", fillopacity=1, 
+                parent=root)
+        circle = avg.CircleNode(r=10, parent=root)
+        anims = [avg.LinearAnim(image, "pos", 300, (0,0), (100,40)),
+                avg.EaseInOutAnim(image, "opacity", 300, 1, 0.5, 100, 100),
+                avg.LinearAnim(clampedImage, "x", 300, 0, 100, True),
+                avg.LinearAnim(rect, "size", 300, (10,10), (20,30)),
+                avg.LinearAnim(rect, "fillcolor", 300, "FF0000", "0000FF"),
+                avg.LinearAnim(circle, "r", 300, 10, 20),
+                avg.LinearAnim(circle, "pos", 300, (0,0), (50,60)),
+               ]
+        player.setFakeFPS(10)
+        self.start(False,
+                (startAnims,
+                 lambda: self.assert_(0 < image.x < 100),
+                 lambda: self.assert_(clampedImage.x <= 50),
+                 lambda: self.delay(400),
+                 checkEndValues,
+                ))
+        anims = None
+
 
     def _testPointAnim(self, startPos, endPos, keepAttrPos, startPosImgSrc, endPosImgSrc,
             keepAttrPosImgSrc):
@@ -554,7 +607,8 @@ def animTestSuite(tests):
         "testParallelAnimRegistry",
         "testStateAnim",
         "testStateAnimRegistry",
-        "testNonNodeAttrAnim"
+        "testNonNodeAttrAnim",
+        "testNodeAttrAnims",
         )
     return createAVGTestSuite(availableTests, AnimTestCase, tests)
 
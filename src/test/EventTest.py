@@ -19,6 +19,8 @@
 # Current versions can be found at www.libavg.de
 #
 
+import struct
+
 from libavg import avg, player
 from libavg.testcase import *
 
@@ -937,6 +939,51 @@ class EventTestCase(AVGTestCase):
                 ))
         self.assertEqual(self.numContactCallbacks, 2)
 
+    def testContactHistory(self):
+
+        def onDown(event):
+            contact = event.contact
+            self.assertEqual(len(contact.history), 20)
+            contact.subscribe(avg.Contact.CURSOR_UP, onUp)
+
+        def onUp(event):
+            # Only the last two events are kept, but the statistics cover the 
+            # complete contact.
+            contact = event.contact
+            self.assertEqual(contact.age, 120)
+            self.assertEqual(contact.motionvec, (0,0))
+            self.assertEqual(contact.distancetravelled, 40)
+            self.assertEqual(len(contact.events), 2)
+            self.assertEqual(contact.events[0].pos, (30,10))
+            self.assertEqual(contact.events[-1].pos, event.pos)
+            history = contact.history
+            samples = struct.unpack("%df" % (len(history)//4), bytes(history))
+            self.assertEqual(len(samples), 10)
+            self.assertEqual(samples[0:2], (30,10))
+            self.assertEqual(samples[4], 80)
+            self.assertEqual(samples[5:7], (10,10))
+            self.assertAlmostEqual(samples[7], -0.5)
+            self.assertEqual(samples[9], 120)
+            self.upCalled = True
+
+        self.assertRaises(avg.Exception, lambda: avg.Contact.setHistoryLength(0))
+        oldLength = avg.Contact.getHistoryLength()
+        avg.Contact.setHistoryLength(2)
+        try:
+            root = self.loadEmptyScene()
+            root.subscribe(avg.Node.CURSOR_DOWN, onDown)
+            player.setFakeFPS(25)
+            self.upCalled = False
+            self.start(False,
+                    (lambda: self._sendTouchEvent(1, avg.Event.CURSOR_DOWN, 10, 10),
+                     lambda: self._sendTouchEvent(1, avg.Event.CURSOR_MOTION, 20, 10),
+                     lambda: self._sendTouchEvent(1, avg.Event.CURSOR_MOTION, 30, 10),
+                     lambda: self._sendTouchEvent(1, avg.Event.CURSOR_UP, 10, 10),
+                    ))
+        finally:
+            avg.Contact.setHistoryLength(oldLength)
+        self.assert_(self.upCalled)
+
     def testContactRegistration(self):
 
         def onDown(event):
@@ -1146,6 +1193,7 @@ def eventTestSuite(tests):
             "testEventHook",
             "testException",
             "testContacts",
+            "testContactHistory",
             "testContactRegistration",
             "testMultiContactRegistration",
             "testPlaybackMessages",
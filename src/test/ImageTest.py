@@ -165,6 +165,97 @@ class ImageTestCase(AVGTestCase):
         self.assert_(cache.getMemUsed() == (0,0))
         cache.capacity = oldCapacity
 
+    def testImageDiskCache(self):
+        def loadImage():
+            node = avg.ImageNode(href="rgb24-65x65.png", parent=root)
+            self.compareBitmapToFile(node.getBitmap(), "rgb24-65x65")
+            node.unlink(True)
+
+        def flushCPUCache():
+            oldCapacity = cache.capacity
+            cache.capacity = (0, 0)
+            cache.capacity = oldCapacity
+
+        import tempfile
+        cacheDir = tempfile.mkdtemp()
+        cache = player.imageCache
+        flushCPUCache()
+        cache.setDiskCache(cacheDir, 1024*1024)
+        try:
+            root = self.loadEmptyScene()
+            loadImage()
+            numEntries, memUsed, hits, misses, evictions = cache.getDiskCacheStats()
+            self.assertEqual((numEntries, hits, misses, evictions), (1, 0, 1, 0))
+            self.assert_(memUsed > 65*65*4)
+            flushCPUCache()
+            # Second load is served from the disk cache.
+            loadImage()
+            self.assertEqual(cache.getDiskCacheStats()[2:], (1, 1, 0))
+            # Too small for the image: evicts it.
+            cache.setDiskCache(cacheDir, 1000)
+            self.assertEqual(cache.getDiskCacheStats(), (0, 0, 1, 1, 1))
+        finally:
+            cache.setDiskCache("", 0)
+            self.assertEqual(cache.getDiskCacheStats(), None)
+            flushCPUCache()
+            shutil.rmtree(cacheDir)
+
+    def testImageAtlas(self):
+        def flushGPUCache():
+            oldCapacity = cache.capacity
+            cache.capacity = (oldCapacity[0], 0)
+            cache.capacity = oldCapacity
+
+        def createNodes():
+            root = self.loadEmptyScene()
+            for i, href in enumerate(("rgb24-64x64.png", "rgb24-32x32.png",
+                    "rgb24-65x65.png")):
+                avg.ImageNode(pos=(i*70, i*10), href=href, parent=root)
+
+        def checkDrawCalls(numDrawCalls, numUnbatchedDrawCalls):
+            canvas = player.getMainCanvas()
+            self.assertEqual(canvas.getNumDrawCalls(), numDrawCalls)
+            self.assertEqual(canvas.getNumUnbatchedDrawCalls(), numUnbatchedDrawCalls)
+
+        def getScreenshot():
+            self.bmp = player.screenshot()
+
+        def enableAtlas():
+            cache.setAtlas(512, 128)
+            flushGPUCache()
+            createNodes()
+
+        def checkAtlas():
+            numPages, occupancy, numDefragmentations = cache.getAtlasStats()
+            self.assertEqual(numPages, 1)
+            self.assert_(0 < occupancy < 1)
+            checkDrawCalls(1, 3)
+            bmp = player.screenshot()
+            self.assert_(self.areSimilarBmps(bmp, self.bmp, 0.01, 0.01))
+
+        def unloadImages():
+            root = player.getRootNode()
+            while root.getNumChildren() > 0:
+                root.getChild(0).unlink(True)
+            flushGPUCache()
+
+        cache = player.imageCache
+        flushGPUCache()
+        try:
+            createNodes()
+            self.start(False,
+                    (lambda: checkDrawCalls(3, 3),
+                     getScreenshot,
+                     enableAtlas,
+                     checkAtlas,
+                     unloadImages,
+                     # Empty pages are freed once per frame.
+                     lambda: self.assertEqual(cache.getAtlasStats()[0], 0),
+                    ))
+        finally:
+            cache.setAtlas(0, 128)
+            self.assertEqual(cache.getAtlasStats(), None)
+
     def testBitmap(self):
         def getBitmap(node):
             bmp = node.getBitmap()
@@ -312,6 +403,8 @@ class ImageTestCase(AVGTestCase):
 
             bitmapManager.loadBitmap("media/rgb24alpha-64x64.png",
                     validBitmapCb, avg.B5G6R5)
+            bitmapManager.loadBitmap(fileName="media/rgb24alpha-64x64.png",
+                    callback=lambda bmp: None, pixelformat=avg.B5G6R5, priority=1)
 
         def loadUnexistentBitmap():
             bitmapManager.loadBitmap("nonexistent.png",
@@ -348,6 +441,50 @@ class ImageTestCase(AVGTestCase):
             player.play()
         avg.BitmapManager.get().setNumThreads(1)
         
+    def testBitmapManagerRequests(self):
+        def onLoaded(name, bmp):
+            self.assert_(not isinstance(bmp, Exception))
+            self.loaded.append(name)
+
+        def issueRequests():
+            # The first request keeps the loader thread busy while the others are 
+            # queued.
+            bitmapManager.loadBitmap("media/freidrehen.jpg",
+                    lambda bmp: onLoaded("first", bmp))
+            for i, fileName in enumerate(lowPriorityFiles):
+                bitmapManager.loadBitmap("media/"+fileName,
+                        lambda bmp, i=i: onLoaded(i, bmp), priority=-1)
+            bitmapManager.loadBitmap("media/rgb24-65x65.png",
+                    lambda bmp: onLoaded("high", bmp), priority=10)
+            # Duplicate request: Served by the same load.
+            bitmapManager.loadBitmap("media/rgb24-65x65.png",
+                    lambda bmp: onLoaded("high2", bmp), priority=10)
+            cancelledID = bitmapManager.loadBitmap("media/rgb24-32x32.png",
+                    lambda bmp: onLoaded("cancelled", bmp))
+            self.assert_(bitmapManager.cancelRequest(cancelledID))
+            self.assert_(not bitmapManager.cancelRequest(cancelledID))
+            self.assert_(bitmapManager.getNumPendingRequests() > 0)
+
+        def checkResults():
+            self.assert_(len(self.loaded) == len(lowPriorityFiles)+3)
+            self.assert_("cancelled" not in self.loaded)
+            # High-priority requests overtake the low-priority ones.
+            self.assert_(self.loaded.index("high") <= 1)
+            self.assert_(self.loaded.index("high2") <= 2)
+            self.assertEqual(bitmapManager.getNumPendingRequests(), 0)
+
+        lowPriorityFiles = ["mask2.png", "mask3.png", "mask4.png", "checker.png",
+                "colorramp.png", "greyscale.png", "hsl.png", "i8-64x64.png"]
+        player.setFakeFPS(-1)
+        self.loaded = []
+        bitmapManager = avg.BitmapManager.get()
+        self.loadEmptyScene()
+        self.start(False,
+                (issueRequests,
+                 lambda: self.delay(500),
+                 checkResults,
+                ))
+
     def testBitmapManagerException(self):
         def bitmapCb(bitmap):
             raise RuntimeError
@@ -393,6 +530,52 @@ class ImageTestCase(AVGTestCase):
                  lambda: self.compareImage("testBlend2")
                 ))
 
+    def testImageBatching(self):
+        def createNodes(bWrapInDivs):
+            # Each entry: (href, opacity, active)
+            nodeParams = (
+                    ("rgb24-64x64.png", 1, True),
+                    ("rgb24-64x64.png", 1, True),
+                    ("rgb24-64x64.png", 1, True),
+                    ("rgb24-64x64.png", 1, True),
+                    ("rgb24alpha-64x64.png", 1, True),
+                    ("rgb24-64x64.png", 0.5, True),
+                    ("rgb24-64x64.png", 0.5, False),
+                    ("rgb24-64x64.png", 0.5, True),
+                    ("rgb24-64x64.png", 1, True),
+                )
+            root = self.loadEmptyScene()
+            for i, (href, opacity, active) in enumerate(nodeParams):
+                if bWrapInDivs:
+                    parent = avg.DivNode(parent=root)
+                else:
+                    parent = root
+                avg.ImageNode(pos=(i*12, i*8), size=(32+i*2, 32), angle=i*0.2, 
+                        href=href, opacity=opacity, active=active, parent=parent)
+
+        def getScreenshot():
+            self.bmp = player.screenshot()
+
+        def checkDrawCalls(numDrawCalls, numUnbatchedDrawCalls):
+            canvas = player.getMainCanvas()
+            self.assertEqual(canvas.getNumDrawCalls(), numDrawCalls)
+            self.assertEqual(canvas.getNumUnbatchedDrawCalls(), numUnbatchedDrawCalls)
+
+        def compareToUnbatched():
+            bmp = player.screenshot()
+            self.assert_(self.areSimilarBmps(bmp, self.bmp, 0.01, 0.01))
+
+        createNodes(True)
+        self.start(False,
+                (lambda: checkDrawCalls(8, 8),
+                 getScreenshot,
+                ))
+        createNodes(False)
+        self.start(False,
+                (lambda: checkDrawCalls(4, 8),
+                 compareToUnbatched,
+                ))
+
     def testImageMask(self):
         def createNode(p):
             node = avg.ImageNode(href="rgb24-65x65.png", maskhref="mask4.png",
@@ -578,10 +761,14 @@ def imageTestSuite(tests):
             "testImagePos",
             "testImageSize",
             "testImageCache",
+            "testImageDiskCache",
+            "testImageAtlas",
             "testBitmap",
             "testBitmapManager",
+            "testBitmapManagerRequests",
             "testBitmapManagerException",
             "testBlendMode",
+            "testImageBatching",
             "testImageMask",
             "testImageMaskCanvas",
             "testImageMaskPos",
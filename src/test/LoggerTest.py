@@ -85,6 +85,18 @@ class LoggerTestCase(AVGTestCase):
     def testUnknownCategoryWarning(self):
         self.assertRaises(RuntimeError, lambda: logger.error("Foo", "Bar"))
 
+    def testAsync(self):
+        logger.configureCategory(logger.Category.APP, logger.Severity.INFO)
+        logger.setAsync(True)
+        self.assert_(logger.isAsync())
+        self.assertEqual(logger.getOverflowPolicy(), logger.OverflowPolicy.DROP_MESSAGES)
+        logger.info(self.testMsg)
+        logger.flush()
+        logger.setAsync(False)
+        self.assert_(not(logger.isAsync()))
+        self.assertEqual(logger.getNumDroppedMessages(), 0)
+        self._assertMsg()
+
 
 def loggerTestSuite(tests):
     availableTests = (
@@ -94,5 +106,6 @@ def loggerTestSuite(tests):
             "testOmitCategory",
             "testLogCategory",
             "testUnknownCategoryWarning",
+            "testAsync",
             )
     return createAVGTestSuite(availableTests, LoggerTestCase, tests)
@@ -309,6 +309,34 @@ class OffscreenTestCase(AVGTestCase):
                  lambda: self.compareImage("testOffscreenAutoRender2")
                 ))
 
+    def testCanvasSkipUnchanged(self):
+        def storeNumSkipped():
+            self.__numSkipped = self.__offscreenCanvas.getNumSkippedFrames()
+
+        def assertSkipped():
+            self.assert_(self.__offscreenCanvas.getNumSkippedFrames() >
+                    self.__numSkipped)
+
+        def changeContent():
+            self.__offscreenCanvas.getElementByID("test1").x = 42
+
+        root = self.loadEmptyScene()
+        self.__offscreenCanvas = self.__createOffscreenCanvas("testcanvas", False)
+        avg.ImageNode(href="canvas:testcanvas", parent=root)
+        self.start(False,
+                (lambda: self.compareImage("testOffscreenAutoRender1"),
+                 storeNumSkipped,
+                 None,
+                 assertSkipped,
+                 lambda: self.compareImage("testOffscreenAutoRender1"),
+                 changeContent,
+                 lambda: self.compareImage("testOffscreenAutoRender2"),
+                 storeNumSkipped,
+                 None,
+                 assertSkipped,
+                 lambda: self.compareImage("testOffscreenAutoRender2")
+                ))
+
     def testCanvasCrop(self):
         root = self.loadEmptyScene()
         canvas = player.createCanvas(id="testcanvas", size=(160,120), 
@@ -506,6 +534,7 @@ def offscreenTestSuite(tests):
                 "testCanvasEventCapture",
                 "testCanvasRender",
                 "testCanvasAutoRender",
+                "testCanvasSkipUnchanged",
                 "testCanvasCrop",
                 "testCanvasAlpha",
                 "testCanvasBackface",
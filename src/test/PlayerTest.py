@@ -21,6 +21,9 @@
 
 import math
 import threading
+import time
+import os
+import json
 
 from libavg import avg, player
 from libavg.testcase import *
@@ -292,6 +295,335 @@ class PlayerTestCase(AVGTestCase):
                  lambda: self.compareImage("testRotatePivot3"),
                 ))
 
+    def testHitTestIndex(self):
+        def createScene():
+            root = self.loadEmptyScene()
+            for i in range(60):
+                pos = (rand.randint(-20, 160), rand.randint(-20, 120))
+                kind = i % 6
+                if kind == 0:
+                    avg.WordsNode(pos=pos, text="foo", alignment="center", parent=root)
+                elif kind == 1:
+                    avg.CircleNode(pos=pos, r=10, parent=root)
+                elif kind == 2:
+                    # No size: the children can be anywhere.
+                    div = avg.DivNode(pos=pos, parent=root)
+                    avg.ImageNode(pos=(-40, 30), href="rgb24-32x32.png", parent=div)
+                elif kind == 3:
+                    div = avg.DivNode(pos=pos, size=(20, 30), angle=0.3, parent=root)
+                    avg.ImageNode(pos=(5, 5), href="rgb24-32x32.png", parent=div)
+                else:
+                    avg.ImageNode(pos=pos, size=(rand.randint(1, 40), 20), 
+                            angle=rand.uniform(0, 3), href="rgb24-32x32.png", 
+                            parent=root)
+
+        def moveNodes():
+            root = player.getRootNode()
+            for i in range(20):
+                node = root.getChild(rand.randint(0, root.getNumChildren()-1))
+                if isinstance(node, avg.AreaNode):
+                    node.pos = (rand.randint(-20, 160), rand.randint(-20, 120))
+                    node.angle += 0.5
+                    if isinstance(node, avg.WordsNode):
+                        node.alignment = "right"
+                    else:
+                        node.pivot = (3, 4)
+                        node.size = (rand.randint(0, 40), 10)
+
+        def changeChildren():
+            root = player.getRootNode()
+            root.reorderChild(0, 10)
+            root.removeChild(5)
+            avg.ImageNode(pos=(50, 50), href="rgb24-32x32.png", parent=root)
+
+        def getNodesUnderGrid():
+            root = player.getRootNode()
+            return [root.getElementByPos((x, y)) 
+                    for x in range(-30, 170, 3) for y in range(-30, 130, 3)]
+
+        def compareToUnindexed():
+            # The index persists between calls, so it's updated incrementally. 
+            player.setHitTestIndexThreshold(32)
+            indexedNodes = getNodesUnderGrid()
+            player.setHitTestIndexThreshold(0)
+            unindexedNodes = getNodesUnderGrid()
+            self.assertEqual(indexedNodes, unindexedNodes)
+        
+        import random
+        rand = random.Random(17)
+        createScene()
+        try:
+            self.start(False,
+                    (compareToUnindexed,
+                     moveNodes,
+                     compareToUnindexed,
+                     moveNodes,
+                     # Alignment is applied when the text is rendered.
+                     None,
+                     compareToUnindexed,
+                     changeChildren,
+                     compareToUnindexed,
+                    ))
+        finally:
+            player.setHitTestIndexThreshold(32)
+
+    def testIncrementalPreRender(self):
+        def createScene():
+            root = self.loadEmptyScene()
+            for i in range(5):
+                div = avg.DivNode(pos=(i*30, 0), parent=root)
+                avg.ImageNode(href="rgb24-32x32.png", parent=div)
+                avg.ImageNode(pos=(0, 40), href="rgb24alpha-32x32.png", parent=div)
+                avg.PolyLineNode(pos=[(0,80), (20,80)], color="FF0000", parent=div)
+
+        def changeNodes():
+            root = player.getRootNode()
+            root.getChild(1).getChild(0).x = 5
+            # Adds vertexes, so everything after the line moves in the vertex array.
+            root.getChild(2).getChild(2).pos = [(0,80), (20,80), (20,100)]
+            root.getChild(3).active = False
+            root.getChild(4).opacity = 0.5
+
+        def changeMoreNodes():
+            root = player.getRootNode()
+            root.getChild(2).getChild(2).pos = [(0,80), (20,100)]
+            root.getChild(3).active = True
+            root.getChild(0).getChild(1).unlink(True)
+
+        def getScreenshot():
+            self.bmp = player.screenshot()
+
+        def reconnectNodes():
+            # Reconnected nodes are rendered from scratch.
+            root = player.getRootNode()
+            divs = [root.getChild(i) for i in range(root.getNumChildren())]
+            for div in divs:
+                div.unlink()
+            for div in divs:
+                root.appendChild(div)
+
+        def compareScreenshots():
+            bmp = player.screenshot()
+            self.assert_(self.areSimilarBmps(bmp, self.bmp, 0.01, 0.01))
+
+        createScene()
+        self.start(False,
+                (None,
+                 changeNodes,
+                 changeMoreNodes,
+                 getScreenshot,
+                 reconnectNodes,
+                 compareScreenshots,
+                ))
+
+    def testPreRenderAfterSkip(self):
+        def createScene():
+            root = self.loadEmptyScene()
+            for i in range(5):
+                div = avg.DivNode(pos=(i*30, 0), parent=root)
+                for j in range(10):
+                    avg.ImageNode(pos=(0, j*10), href="rgb24-32x32.png", parent=div)
+
+        def moveImage(divIndex):
+            player.getRootNode().getChild(divIndex).getChild(0).x += 1
+
+        def checkNumUpdates():
+            # The image, its div and the root node. The other images in the div were 
+            # kept in the last frame as part of the div and are still valid.
+            self.assertEqual(canvas.getNumPreRenderUpdates(), 3)
+
+        createScene()
+        canvas = player.getMainCanvas()
+        self.start(False,
+                (lambda: moveImage(0),
+                 checkNumUpdates,
+                 lambda: moveImage(1),
+                 checkNumUpdates,
+                 lambda: moveImage(0),
+                 checkNumUpdates,
+                ))
+
+    def testIncrementalBatch(self):
+        def createScene():
+            root = self.loadEmptyScene()
+            for i in range(10):
+                avg.ImageNode(pos=(i*12, 0), href="rgb24-32x32.png", parent=root)
+
+        def checkDrawCalls(numDrawCalls):
+            self.assertEqual(player.getMainCanvas().getNumDrawCalls(), numDrawCalls)
+
+        def changeNodes():
+            # The nodes stay in the batch, so only their vertexes are rewritten.
+            root = player.getRootNode()
+            root.getChild(3).pos = (36, 40)
+            root.getChild(7).angle = 0.5
+
+        def splitBatch():
+            player.getRootNode().getChild(5).opacity = 0.5
+
+        def joinBatch():
+            root = player.getRootNode()
+            root.getChild(5).opacity = 1
+            root.getChild(2).size = (16, 16)
+
+        def getScreenshot():
+            self.bmp = player.screenshot()
+
+        def reconnectNodes():
+            root = player.getRootNode()
+            nodes = [root.getChild(i) for i in range(root.getNumChildren())]
+            for node in nodes:
+                node.unlink()
+            for node in nodes:
+                root.appendChild(node)
+
+        def compareScreenshots():
+            bmp = player.screenshot()
+            self.assert_(self.areSimilarBmps(bmp, self.bmp, 0.01, 0.01))
+
+        createScene()
+        self.start(False,
+                (lambda: checkDrawCalls(1),
+                 changeNodes,
+                 lambda: checkDrawCalls(1),
+                 splitBatch,
+                 lambda: checkDrawCalls(3),
+                 joinBatch,
+                 lambda: checkDrawCalls(1),
+                 getScreenshot,
+                 reconnectNodes,
+                 compareScreenshots,
+                ))
+
+    def testVertexUpload(self):
+        def getInitialUpload():
+            # The images are rendered in one batch.
+            self.assertEqual(canvas.getNumDrawCalls(), 1)
+            self.numInitialBytes = canvas.getNumVertexBytesUploaded()
+            self.assert_(self.numInitialBytes > 0)
+
+        def checkNoUpload():
+            self.assertEqual(canvas.getNumVertexBytesUploaded(), 0)
+
+        def moveImage():
+            root.getChild(10).x = 5
+
+        def checkPartialUpload():
+            # Only the vertexes of the image that moved are transferred: Its own and 
+            # its part of the batch.
+            self.assertEqual(canvas.getNumDrawCalls(), 1)
+            numBytes = canvas.getNumVertexBytesUploaded()
+            self.assert_(0 < numBytes < self.numInitialBytes/10)
+
+        root = self.loadEmptyScene()
+        for i in range(20):
+            avg.ImageNode(pos=(i*5, i*5), href="rgb24-32x32.png", parent=root)
+        canvas = player.getMainCanvas()
+        self.start(False,
+                (getInitialUpload,
+                 checkNoUpload,
+                 moveImage,
+                 checkPartialUpload,
+                 checkNoUpload,
+                ))
+
+    def testTracing(self):
+        def startTracing():
+            player.startTracing(2)
+            self.assert_(player.isTracing())
+
+        def checkTrace():
+            self.assert_(not(player.isTracing()))
+            player.saveTrace("trace.json")
+            with open("trace.json") as f:
+                trace = json.load(f)
+            os.remove("trace.json")
+            events = trace["traceEvents"]
+            threadNames = [event["args"]["name"] for event in events 
+                    if event["ph"] == "M"]
+            self.assert_("main" in threadNames)
+            zoneNames = [event["name"] for event in events if event["ph"] == "X"]
+            self.assert_("Render" in zoneNames)
+            numFrames = len([event for event in events if event["ph"] == "i"])
+            self.assertEqual(numFrames, 2)
+
+        self.loadEmptyScene()
+        self.start(False,
+                (startTracing,
+                 None,
+                 None,
+                 None,
+                 checkTrace,
+                ))
+
+    def testFrameTimeStats(self):
+        def checkStats():
+            stats = player.getFrameTimeStats()
+            self.assertEqual(stats.numframes, 10)
+            self.assert_(0 < stats.p50 <= stats.p95 <= stats.p99 <= stats.max)
+            renderStats = player.getFrameTimeStats(avg.RENDER_TIME)
+            self.assert_(renderStats.average <= stats.average)
+            self.assert_(player.getNumConsecutiveLateFrames() <= 
+                    player.getMaxConsecutiveLateFrames() <= 
+                    player.getNumFramesTooLate())
+
+        self.assertRaises(avg.Exception, player.getFrameTimeStats)
+        player.setFrameTimeWindow(10)
+        self.loadEmptyScene()
+        self.start(False, [None]*20 + [checkStats])
+        player.setFrameTimeWindow(600)
+
+    def testFramePacing(self):
+        def setPacing(pacing):
+            player.setFramePacing(pacing)
+            self.assertEqual(player.getFramePacing(), pacing)
+            self.handlerDelays = []
+
+        def recordHandlerDelay():
+            # Time between the previous frame and the frame handler, plus a constant
+            # offset between the clocks.
+            self.handlerDelays.append(time.time()*1000 - player.getFrameTime())
+
+        def getMedianHandlerDelay():
+            # Skip the frames right after the pacing change.
+            delays = sorted(self.handlerDelays[-30:])
+            return delays[len(delays)/2]
+
+        def checkDefaultPacing():
+            self.defaultHandlerDelay = getMedianHandlerDelay()
+
+        def checkPacingError():
+            # Generous bounds: The test machine may be loaded.
+            stats = player.getFrameTimeStats(avg.PACING_ERROR)
+            self.assertEqual(stats.numframes, 40)
+            self.assert_(stats.p50 < 4)
+
+        def checkLowLatencyPacing():
+            checkPacingError()
+            # The wait moved in front of the frame, so frame handlers run shortly
+            # before the deadline instead of right after the previous frame. With
+            # 20 ms frames, the difference should be well above this.
+            self.assert_(getMedianHandlerDelay() - self.defaultHandlerDelay > 5)
+
+        player.setFakeFPS(-1)
+        player.setFrameTimeWindow(40)
+        self.loadEmptyScene()
+        onFrameID = player.subscribe(player.ON_FRAME, recordHandlerDelay)
+        self.start(False, 
+                [lambda: player.setFramerate(50),
+                 lambda: setPacing(avg.DEFAULT_PACING)]
+                + [None]*40
+                + [checkDefaultPacing,
+                   lambda: setPacing(avg.PRECISE_PACING)]
+                + [None]*40
+                + [checkPacingError,
+                   lambda: setPacing(avg.LOW_LATENCY_PACING)]
+                + [None]*40
+                + [checkLowLatencyPacing,
+                   lambda: setPacing(avg.DEFAULT_PACING),
+                   lambda: player.unsubscribe(player.ON_FRAME, onFrameID)])
+        player.setFrameTimeWindow(600)
+
     def testOpacity(self):
         root = self.loadEmptyScene()
         avg.ImageNode(pos=(0,0), href="rgb24-65x65.png", opacity=0.5, parent=root)
@@ -912,6 +1244,14 @@ def playerTestSuite(tests):
             "testRotate",
             "testRotate2",
             "testRotatePivot",
+            "testHitTestIndex",
+            "testIncrementalPreRender",
+            "testPreRenderAfterSkip",
+            "testIncrementalBatch",
+            "testVertexUpload",
+            "testTracing",
+            "testFrameTimeStats",
+            "testFramePacing",
             "testOpacity",
             "testOutlines",
             "testWordsOutlines",
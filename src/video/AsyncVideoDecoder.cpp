@@ -20,10 +20,12 @@
 //
 
 #include "AsyncVideoDecoder.h"
+#include "DecoderExecutor.h"
 
 #include "../base/ObjectCounter.h"
 #include "../base/Exception.h"
 #include "../base/ScopeTimer.h"
+#include "../base/TimeSource.h"
 
 #include "../audio/AudioParams.h"
 
@@ -36,26 +38,32 @@
 using namespace std;
 using boost::dynamic_pointer_cast;
 
+// The bounded data queues use lock-free rings. They need the multi-producer variant
+// because the producing threads also pop from them when clearing on seek.
 #define AUDIO_MSG_QUEUE_LENGTH  50
 #define AUDIO_STATUS_QUEUE_LENGTH -1
 #define PACKET_QUEUE_LENGTH 50
+// Frames the codec keeps as references plus the frame waiting for upload.
+#define FRAME_POOL_EXTRA_FRAMES 6
 
 namespace avg {
 
-AsyncVideoDecoder::AsyncVideoDecoder(int queueLength)
+AsyncVideoDecoder::AsyncVideoDecoder(int queueLength, int framePoolSize)
     : m_QueueLength(queueLength),
-      m_pDemuxThread(0),
-      m_pVDecoderThread(0),
-      m_pADecoderThread(0),
+      m_FramePoolSize(framePoolSize),
+      m_DemuxTaskID(-1),
+      m_VDecoderTaskID(-1),
+      m_ADecoderTaskID(-1),
       m_bUseStreamFPS(true),
-      m_FPS(0)
+      m_FPS(0),
+      m_bScrubMode(false)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
 }
 
 AsyncVideoDecoder::~AsyncVideoDecoder()
 {
-    if (m_pVDecoderThread || m_pADecoderThread) {
+    if (m_VDecoderTaskID != -1 || m_ADecoderTaskID != -1) {
         close();
     }
     ObjectCounter::get()->decRef(&typeid(*this));
@@ -71,8 +79,20 @@ void AsyncVideoDecoder::open(const std::string& sFilename,
     m_bVideoEOF = false;
     m_bWasVSeeking = false;
     m_bWasSeeking = false;
+    m_bScrubFramePending = false;
     m_CurVideoFrameTime = -1;
     m_LastAudioFrameTime = 0;
+    m_LastReportedAudioTime = -1;
+
+    m_SeekStartTime = -1;
+    m_SeekDestTime = 0;
+    m_bSeekFrameDelivered = false;
+    m_NumSeeksDelivered = 0;
+    m_SeekLatencySum = 0;
+    m_MaxSeekLatency = 0;
+    m_NumSeeksDone = 0;
+    m_NumSeeksCancelled = 0;
+    m_ExactSeekLatencySum = 0;
     
     VideoDecoder::open(sFilename, bEnableSound);
 
@@ -85,7 +105,7 @@ void AsyncVideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP
 {
     VideoDecoder::startDecoding(bDeliverYCbCr, pAP);
 
-    AVG_ASSERT(!m_pDemuxThread);
+    AVG_ASSERT(m_DemuxTaskID == -1);
     vector<int> streamIndexes;
     if (getVStreamIndex() >= 0) {
         streamIndexes.push_back(getVStreamIndex());
@@ -102,22 +122,38 @@ void AsyncVideoDecoder::startDecoding(bool bDeliverYCbCr, const AudioParams* pAP
             m_FPS = getStreamFPS();
         }
         m_pVCmdQ = VideoDecoderThread::CQueuePtr(new VideoDecoderThread::CQueue);
-        m_pVMsgQ = VideoMsgQueuePtr(new VideoMsgQueue(m_QueueLength));
+        m_pVMsgQ = VideoMsgQueuePtr(new VideoMsgQueue(m_QueueLength, QT_LOCKFREE_MP));
         VideoMsgQueue& packetQ = *m_PacketQs[getVStreamIndex()];
 
-        m_pVDecoderThread = new boost::thread(VideoDecoderThread(
-                *m_pVCmdQ, *m_pVMsgQ, packetQ, getVideoStream(), 
-                getSize(), getPixelFormat()));
+        if (pixelFormatIsPlanar(getPixelFormat())) {
+            int poolSize = m_FramePoolSize;
+            if (poolSize == 0) {
+                // Frame threading keeps one additional frame per thread in flight.
+                poolSize = m_QueueLength + FRAME_POOL_EXTRA_FRAMES + 
+                        getVideoInfo().m_NumDecodingThreads - 1;
+            }
+            m_pFramePool = VideoFramePoolPtr(new VideoFramePool(getSize(),
+                    getPixelFormat(), poolSize));
+            if (!m_pFramePool->attach(getCodecContext())) {
+                m_pFramePool = VideoFramePoolPtr();
+            }
+        }
+        m_VDecoderTaskID = DecoderExecutor::get()->addTask(
+                new DecoderTask<VideoDecoderThread>(new VideoDecoderThread(
+                        *m_pVCmdQ, *m_pVMsgQ, packetQ, getVideoStream(), 
+                        getSize(), getPixelFormat(), m_pFramePool)));
     }
     
     if (getVideoInfo().m_bHasAudio) {
         m_pACmdQ = AudioDecoderThread::CQueuePtr(new AudioDecoderThread::CQueue);
-        m_pAMsgQ = AudioMsgQueuePtr(new AudioMsgQueue(AUDIO_MSG_QUEUE_LENGTH));
+        m_pAMsgQ = AudioMsgQueuePtr(new AudioMsgQueue(AUDIO_MSG_QUEUE_LENGTH,
+                QT_LOCKFREE_MP));
         m_pAStatusQ = AudioMsgQueuePtr(new AudioMsgQueue(AUDIO_STATUS_QUEUE_LENGTH));
+        m_pATimeStatus = AudioTimeStatusPtr(new AudioTimeStatus(-1));
         VideoMsgQueue& packetQ = *m_PacketQs[getAStreamIndex()];
-        m_pADecoderThread = new boost::thread(
-                AudioDecoderThread(*m_pACmdQ, *m_pAMsgQ, packetQ, getAudioStream(),
-                        *pAP));
+        m_ADecoderTaskID = DecoderExecutor::get()->addTask(
+                new DecoderTask<AudioDecoderThread>(new AudioDecoderThread(
+                        *m_pACmdQ, *m_pAMsgQ, packetQ, getAudioStream(), *pAP)));
     }
 }
 
@@ -125,29 +161,33 @@ void AsyncVideoDecoder::close()
 {
     AVG_ASSERT(getState() != CLOSED);
 
-    if (m_pDemuxThread) {
-        m_pDemuxCmdQ->pushCmd(boost::bind(&VideoDemuxerThread::close, _1));
-        m_pDemuxThread->join();
+    DecoderExecutor* pExecutor = DecoderExecutor::get();
+    if (m_DemuxTaskID != -1) {
+        pushDemuxCmd(boost::bind(&VideoDemuxerThread::close, _1));
+        pExecutor->waitForTask(m_DemuxTaskID);
     }
 
-    if (m_pVDecoderThread) {
+    if (m_VDecoderTaskID != -1) {
         m_pVMsgQ->clear();
-        m_pVDecoderThread->join();
-        delete m_pVDecoderThread;
-        m_pVDecoderThread = 0;
+        pExecutor->wakeUp();
+        pExecutor->waitForTask(m_VDecoderTaskID);
+        m_VDecoderTaskID = -1;
         m_pVMsgQ = VideoMsgQueuePtr();
     }
-    if (m_pADecoderThread) {
+    if (m_ADecoderTaskID != -1) {
         m_pAMsgQ->clear();
         m_pAStatusQ->clear();
-        m_pADecoderThread->join();
-        delete m_pADecoderThread;
-        m_pADecoderThread = 0;
+        pExecutor->wakeUp();
+        pExecutor->waitForTask(m_ADecoderTaskID);
+        m_ADecoderTaskID = -1;
         m_pAStatusQ = AudioMsgQueuePtr();
+        m_pATimeStatus = AudioTimeStatusPtr();
         m_pAMsgQ = AudioMsgQueuePtr();
     }
     VideoDecoder::close();
-    if (m_pDemuxThread) {
+    // The codec releases its buffers on close, so the pool must outlive it.
+    m_pFramePool = VideoFramePoolPtr();
+    if (m_DemuxTaskID != -1) {
         deleteDemuxer();
     }
 }
@@ -158,8 +198,14 @@ void AsyncVideoDecoder::seek(float destTime)
     m_bAudioEOF = false;
     m_bVideoEOF = false;
     m_NumSeeksSent++;
-    m_pDemuxCmdQ->pushCmd(boost::bind(&VideoDemuxerThread::seek, _1, m_NumSeeksSent,
-            destTime));
+    if (m_SeekStartTime != -1) {
+        m_NumSeeksCancelled++;
+    }
+    m_SeekStartTime = TimeSource::get()->getCurrentMicrosecs();
+    m_SeekDestTime = destTime;
+    m_bSeekFrameDelivered = false;
+    m_bScrubFramePending = m_bScrubMode;
+    pushDemuxCmd(boost::bind(&VideoDemuxerThread::seek, _1, m_NumSeeksSent, destTime));
 }
 
 void AsyncVideoDecoder::loop()
@@ -200,8 +246,8 @@ float AsyncVideoDecoder::getFPS() const
 
 void AsyncVideoDecoder::setFPS(float fps)
 {
-    AVG_ASSERT(!m_pADecoderThread);
-    m_pVCmdQ->pushCmd(boost::bind(&VideoDecoderThread::setFPS, _1, fps));
+    AVG_ASSERT(m_ADecoderTaskID == -1);
+    pushVDecoderCmd(boost::bind(&VideoDecoderThread::setFPS, _1, fps));
     m_bUseStreamFPS = (fps == 0);
     if (m_bUseStreamFPS) {
         m_FPS = getVideoInfo().m_StreamFPS;
@@ -220,6 +266,7 @@ FrameAvailableCode AsyncVideoDecoder::getRenderedBmps(vector<BitmapPtr>& pBmps,
         waitForSeekDone();
         pFrameMsg = getNextBmps(true);
         frameAvailable = FA_NEW_FRAME;
+        m_bScrubFramePending = false;
     } else {
         pFrameMsg = getBmpsForTime(timeWanted, frameAvailable);
     }
@@ -230,6 +277,7 @@ FrameAvailableCode AsyncVideoDecoder::getRenderedBmps(vector<BitmapPtr>& pBmps,
         for (unsigned i = 0; i < pBmps.size(); ++i) {
             pBmps[i] = pFrameMsg->getFrameBitmap(i);
         }
+        updateSeekStats(m_LastVideoFrameTime);
     }
     return frameAvailable;
 }
@@ -238,10 +286,25 @@ void AsyncVideoDecoder::updateAudioStatus()
 {
     if (m_pAStatusQ) {
         AudioMsgPtr pMsg = m_pAStatusQ->pop(false);
+        bool bAudioConsumed = bool(pMsg);
         while (pMsg) {
             handleAudioMsg(pMsg);
             pMsg = m_pAStatusQ->pop(false);
         }
+        // Read after the messages: The audio thread updates the time before it sends
+        // a SEEK_DONE, so this is never a time from before the seek.
+        float audioTime = *m_pATimeStatus;
+        if (audioTime != m_LastReportedAudioTime) {
+            m_LastReportedAudioTime = audioTime;
+            m_LastAudioFrameTime = audioTime;
+            bAudioConsumed = true;
+        }
+        if (bAudioConsumed) {
+            // The audio thread has consumed data, so the audio decoder may have work
+            // again. The audio thread can't wake the executor itself without 
+            // blocking.
+            DecoderExecutor::get()->wakeUp();
+        }
     }
 }
 
@@ -265,6 +328,85 @@ void AsyncVideoDecoder::throwAwayFrame(float timeWanted)
     VideoMsgPtr pFrameMsg = getBmpsForTime(timeWanted, frameAvailable);
 }
 
+int AsyncVideoDecoder::getFramePoolSize() const
+{
+    if (m_pFramePool) {
+        return m_pFramePool->getSize();
+    } else {
+        return 0;
+    }
+}
+
+long long AsyncVideoDecoder::getFramePoolHits() const
+{
+    if (m_pFramePool) {
+        return m_pFramePool->getNumHits();
+    } else {
+        return 0;
+    }
+}
+
+long long AsyncVideoDecoder::getFramePoolMisses() const
+{
+    if (m_pFramePool) {
+        return m_pFramePool->getNumMisses();
+    } else {
+        return 0;
+    }
+}
+
+void AsyncVideoDecoder::setScrubMode(bool bScrubMode)
+{
+    m_bScrubMode = bScrubMode;
+    if (!m_bScrubMode) {
+        m_bScrubFramePending = false;
+    }
+}
+
+bool AsyncVideoDecoder::isScrubMode() const
+{
+    return m_bScrubMode;
+}
+
+bool AsyncVideoDecoder::isRefiningSeek() const
+{
+    return m_bScrubMode && m_bSeekFrameDelivered && m_SeekStartTime != -1 && 
+            !m_bVideoEOF;
+}
+
+int AsyncVideoDecoder::getNumSeeksDone() const
+{
+    return m_NumSeeksDone;
+}
+
+int AsyncVideoDecoder::getNumSeeksCancelled() const
+{
+    return m_NumSeeksCancelled;
+}
+
+float AsyncVideoDecoder::getAvgSeekLatency() const
+{
+    if (m_NumSeeksDelivered == 0) {
+        return 0;
+    } else {
+        return float(m_SeekLatencySum)/m_NumSeeksDelivered/1000;
+    }
+}
+
+float AsyncVideoDecoder::getMaxSeekLatency() const
+{
+    return float(m_MaxSeekLatency)/1000;
+}
+
+float AsyncVideoDecoder::getAvgExactSeekLatency() const
+{
+    if (m_NumSeeksDone == 0) {
+        return 0;
+    } else {
+        return float(m_ExactSeekLatencySum)/m_NumSeeksDone/1000;
+    }
+}
+
 AudioMsgQueuePtr AsyncVideoDecoder::getAudioMsgQ()
 {
     return m_pAMsgQ;
@@ -275,21 +417,27 @@ AudioMsgQueuePtr AsyncVideoDecoder::getAudioStatusQ() const
     return m_pAStatusQ;
 }
 
+AudioTimeStatusPtr AsyncVideoDecoder::getAudioTimeStatus() const
+{
+    return m_pATimeStatus;
+}
+
 void AsyncVideoDecoder::setupDemuxer(vector<int> streamIndexes)
 {
     m_pDemuxCmdQ = VideoDemuxerThread::CQueuePtr(new VideoDemuxerThread::CQueue());    
     for (unsigned i = 0; i < streamIndexes.size(); ++i) {
-        VideoMsgQueuePtr pPacketQ(new VideoMsgQueue(PACKET_QUEUE_LENGTH));
+        VideoMsgQueuePtr pPacketQ(new VideoMsgQueue(PACKET_QUEUE_LENGTH,
+                QT_LOCKFREE_MP));
         m_PacketQs[streamIndexes[i]] = pPacketQ;
     }
-    m_pDemuxThread = new boost::thread(VideoDemuxerThread(*m_pDemuxCmdQ,
-            getFormatContext(), m_PacketQs));
+    m_DemuxTaskID = DecoderExecutor::get()->addTask(
+            new DecoderTask<VideoDemuxerThread>(new VideoDemuxerThread(*m_pDemuxCmdQ,
+                    getFormatContext(), m_PacketQs)));
 }
 
 void AsyncVideoDecoder::deleteDemuxer()
 {
-    delete m_pDemuxThread;
-    m_pDemuxThread = 0;
+    m_DemuxTaskID = -1;
     map<int, VideoMsgQueuePtr>::iterator it;
     for (it = m_PacketQs.begin(); it != m_PacketQs.end(); it++) {
         VideoMsgQueuePtr pPacketQ = it->second;
@@ -330,6 +478,15 @@ VideoMsgPtr AsyncVideoDecoder::getBmpsForTime(float timeWanted,
         // The last frame is still current. Display it again.
         frameAvailable = FA_USE_LAST_FRAME;
         return VideoMsgPtr();
+    } else if (m_bScrubFramePending) {
+        // Decoding restarts at a keyframe after a seek, so this is the keyframe.
+        pFrameMsg = getNextBmps(false);
+        if (pFrameMsg) {
+            m_bScrubFramePending = false;
+            frameAvailable = FA_NEW_FRAME;
+        } else {
+            frameAvailable = FA_STILL_DECODING;
+        }
     } else {
         float frameTime = -1;
         while (frameTime-timeWanted < -0.5*timePerFrame && !m_bVideoEOF) {
@@ -357,14 +514,13 @@ VideoMsgPtr AsyncVideoDecoder::getBmpsForTime(float timeWanted,
 
 VideoMsgPtr AsyncVideoDecoder::getNextBmps(bool bWait)
 {
-    VideoMsgPtr pMsg = m_pVMsgQ->pop(bWait);
+    VideoMsgPtr pMsg = popVideoMsg(bWait);
     if (pMsg) {
         switch (pMsg->getType()) {
             case VideoMsg::FRAME:
                 return pMsg;
             case VideoMsg::END_OF_FILE:
-                m_NumVSeeksDone = m_NumSeeksSent;
-                m_bVideoEOF = true;
+                handleVideoEOF();
                 return VideoMsgPtr();
             case VideoMsg::ERROR:
                 m_bVideoEOF = true;
@@ -381,10 +537,20 @@ VideoMsgPtr AsyncVideoDecoder::getNextBmps(bool bWait)
         return pMsg;
     }
 }
+VideoMsgPtr AsyncVideoDecoder::popVideoMsg(bool bWait)
+{
+    VideoMsgPtr pMsg = m_pVMsgQ->pop(bWait);
+    if (pMsg) {
+        // The video decoder may have been waiting for space in the queue.
+        DecoderExecutor::get()->wakeUp();
+    }
+    return pMsg;
+}
+
 void AsyncVideoDecoder::waitForSeekDone()
 {
     while (isVSeeking()) {
-        VideoMsgPtr pMsg = m_pVMsgQ->pop(true);
+        VideoMsgPtr pMsg = popVideoMsg(true);
         handleVSeekMsg(pMsg);
     }
 }
@@ -394,7 +560,7 @@ void AsyncVideoDecoder::checkForSeekDone()
     if (isVSeeking()) {
         VideoMsgPtr pMsg;
         do {
-            pMsg = m_pVMsgQ->pop(false);
+            pMsg = popVideoMsg(false);
             if (pMsg) {
                 handleVSeekMsg(pMsg);
             }
@@ -412,8 +578,7 @@ void AsyncVideoDecoder::handleVSeekMsg(VideoMsgPtr pMsg)
             returnFrame(dynamic_pointer_cast<VideoMsg>(pMsg));
             break;
         case VideoMsg::END_OF_FILE:
-            m_NumVSeeksDone = m_NumSeeksSent;
-            m_bVideoEOF = true;
+            handleVideoEOF();
             break;
         default:
             // TODO: Handle ERROR messages here.
@@ -429,6 +594,16 @@ void AsyncVideoDecoder::handleVSeekDone(AudioMsgPtr pMsg)
     }
 }
 
+void AsyncVideoDecoder::handleVideoEOF()
+{
+    m_NumVSeeksDone = m_NumSeeksSent;
+    m_bVideoEOF = true;
+    // A seek beyond the end of the video never delivers a frame. It mustn't be 
+    // counted as cancelled by the next seek.
+    m_SeekStartTime = -1;
+    m_bScrubFramePending = false;
+}
+
 void AsyncVideoDecoder::handleAudioMsg(AudioMsgPtr pMsg)
 {
     switch (pMsg->getType()) {
@@ -444,9 +619,6 @@ void AsyncVideoDecoder::handleAudioMsg(AudioMsgPtr pMsg)
                 m_NumASeeksDone = pMsg->getSeekSeqNum();
             }
             break;
-        case AudioMsg::AUDIO_TIME:
-            m_LastAudioFrameTime = pMsg->getAudioTime();
-            break;
         default:
             // Unhandled message type.
             pMsg->dump();
@@ -458,7 +630,7 @@ void AsyncVideoDecoder::returnFrame(VideoMsgPtr pFrameMsg)
 {
     if (pFrameMsg) {
         AVG_ASSERT(pFrameMsg->getType() == VideoMsg::FRAME);
-        m_pVCmdQ->pushCmd(boost::bind(&VideoDecoderThread::returnFrame, _1, pFrameMsg));
+        pushVDecoderCmd(boost::bind(&VideoDecoderThread::returnFrame, _1, pFrameMsg));
     }
 }
 
@@ -472,4 +644,35 @@ bool AsyncVideoDecoder::isVSeeking() const
     return m_NumSeeksSent > m_NumVSeeksDone;
 }
 
+void AsyncVideoDecoder::updateSeekStats(float frameTime)
+{
+    if (m_SeekStartTime == -1) {
+        return;
+    }
+    long long latency = TimeSource::get()->getCurrentMicrosecs()-m_SeekStartTime;
+    if (!m_bSeekFrameDelivered) {
+        m_bSeekFrameDelivered = true;
+        m_NumSeeksDelivered++;
+        m_SeekLatencySum += latency;
+        m_MaxSeekLatency = max(m_MaxSeekLatency, latency);
+    }
+    if (frameTime >= m_SeekDestTime-0.5f/getFPS()) {
+        m_NumSeeksDone++;
+        m_ExactSeekLatencySum += latency;
+        m_SeekStartTime = -1;
+    }
+}
+
+void AsyncVideoDecoder::pushDemuxCmd(VideoDemuxerThread::Cmd::CmdFunc func)
+{
+    m_pDemuxCmdQ->pushCmd(func);
+    DecoderExecutor::get()->wakeUp();
+}
+
+void AsyncVideoDecoder::pushVDecoderCmd(VideoDecoderThread::Cmd::CmdFunc func)
+{
+    m_pVCmdQ->pushCmd(func);
+    DecoderExecutor::get()->wakeUp();
+}
+
 }
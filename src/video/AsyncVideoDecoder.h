@@ -28,6 +28,7 @@
 #include "VideoDecoderThread.h"
 #include "AudioDecoderThread.h"
 #include "VideoMsg.h"
+#include "VideoFramePool.h"
 
 #include "../graphics/Bitmap.h"
 #include "../audio/AudioParams.h"
@@ -41,7 +42,7 @@ namespace avg {
 class AVG_API AsyncVideoDecoder: public VideoDecoder
 {
 public:
-    AsyncVideoDecoder(int queueLength);
+    AsyncVideoDecoder(int queueLength, int framePoolSize=0);
     virtual ~AsyncVideoDecoder();
     virtual void open(const std::string& sFilename, bool bEnableSound);
     virtual void startDecoding(bool bDeliverYCbCr, const AudioParams* pAP);
@@ -59,38 +60,65 @@ public:
     void updateAudioStatus();
     virtual bool isEOF() const;
     virtual void throwAwayFrame(float timeWanted);
+
+    virtual int getFramePoolSize() const;
+    virtual long long getFramePoolHits() const;
+    virtual long long getFramePoolMisses() const;
+
+    // In scrub mode, the frame at the keyframe that precedes a seek target is 
+    // delivered as soon as it is decoded. The frames up to the target follow in 
+    // later calls to getRenderedBmps(). A newer seek cancels this refinement.
+    void setScrubMode(bool bScrubMode);
+    bool isScrubMode() const;
+    bool isRefiningSeek() const;
+
+    virtual int getNumSeeksDone() const;
+    virtual int getNumSeeksCancelled() const;
+    virtual float getAvgSeekLatency() const;
+    virtual float getMaxSeekLatency() const;
+    virtual float getAvgExactSeekLatency() const;
    
     AudioMsgQueuePtr getAudioMsgQ();
     AudioMsgQueuePtr getAudioStatusQ() const;
+    AudioTimeStatusPtr getAudioTimeStatus() const;
 
 private:
     void setupDemuxer(std::vector<int> streamIndexes);
     void deleteDemuxer();
+    void pushDemuxCmd(VideoDemuxerThread::Cmd::CmdFunc func);
+    void pushVDecoderCmd(VideoDecoderThread::Cmd::CmdFunc func);
     VideoMsgPtr getBmpsForTime(float timeWanted, FrameAvailableCode& frameAvailable);
     VideoMsgPtr getNextBmps(bool bWait);
+    VideoMsgPtr popVideoMsg(bool bWait);
     void waitForSeekDone();
     void checkForSeekDone();
     void handleVSeekMsg(VideoMsgPtr pMsg);
     void handleVSeekDone(AudioMsgPtr pMsg);
+    void handleVideoEOF();
     void handleAudioMsg(AudioMsgPtr pMsg);
     void returnFrame(VideoMsgPtr pFrameMsg);
     bool isSeeking() const;
     bool isVSeeking() const;
+    void updateSeekStats(float frameTime);
 
     int m_QueueLength;
+    int m_FramePoolSize;
+    VideoFramePoolPtr m_pFramePool;
 
-    boost::thread* m_pDemuxThread;
+    // Ids of the demuxer and decoder tasks in the DecoderExecutor, -1 if not running.
+    int m_DemuxTaskID;
     std::map<int, VideoMsgQueuePtr> m_PacketQs;
     VideoDemuxerThread::CQueuePtr m_pDemuxCmdQ;
 
-    boost::thread* m_pVDecoderThread;
+    int m_VDecoderTaskID;
     VideoDecoderThread::CQueuePtr m_pVCmdQ;
     VideoMsgQueuePtr m_pVMsgQ;
 
-    boost::thread* m_pADecoderThread;
+    int m_ADecoderTaskID;
     AudioDecoderThread::CQueuePtr m_pACmdQ;
     AudioMsgQueuePtr m_pAMsgQ;
     AudioMsgQueuePtr m_pAStatusQ;
+    AudioTimeStatusPtr m_pATimeStatus;
 
     bool m_bUseStreamFPS;
     float m_FPS;
@@ -100,6 +128,19 @@ private:
     int m_NumASeeksDone;
     bool m_bWasVSeeking;
     bool m_bWasSeeking;
+    bool m_bScrubMode;
+    bool m_bScrubFramePending;
+
+    // Time the current seek was sent in microseconds, -1 once it reached its target.
+    long long m_SeekStartTime;
+    float m_SeekDestTime;
+    bool m_bSeekFrameDelivered;
+    int m_NumSeeksDelivered;
+    long long m_SeekLatencySum;
+    long long m_MaxSeekLatency;
+    int m_NumSeeksDone;
+    int m_NumSeeksCancelled;
+    long long m_ExactSeekLatencySum;
 
     bool m_bAudioEOF;
     bool m_bVideoEOF;
@@ -107,6 +148,7 @@ private:
     float m_LastVideoFrameTime;
     float m_CurVideoFrameTime;
     float m_LastAudioFrameTime;
+    float m_LastReportedAudioTime;
 };
 
 typedef boost::shared_ptr<AsyncVideoDecoder> AsyncVideoDecoderPtr;
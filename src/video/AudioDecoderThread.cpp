@@ -67,6 +67,10 @@ AudioDecoderThread::~AudioDecoderThread()
     }
 }
 
+// A packet can decode to several audio messages. Leave room for them so work() 
+// doesn't block.
+static const int MSG_QUEUE_HEADROOM = 8;
+
 static ProfilingZoneID DecoderProfilingZone("Audio Decoder Thread", true);
 static ProfilingZoneID PacketWaitProfilingZone("Audio Wait for packet", true);
 
@@ -104,6 +108,12 @@ bool AudioDecoderThread::work()
             m_SeekTime = pMsg->getSeekTime();
             break;
         case VideoMsg::END_OF_FILE:
+            if (m_State != DECODING) {
+                // The seek target is beyond the end of the stream. The seek must still
+                // be reported as done.
+                pushSeekDone(m_SeekTime, m_SeekSeqNum);
+                m_State = DECODING;
+            }
             pushEOF();
             break;
         case VideoMsg::CLOSED:
@@ -118,6 +128,17 @@ bool AudioDecoderThread::work()
     return true;
 }
 
+bool AudioDecoderThread::isWorkAvailable() const
+{
+    return !m_PacketQ.empty() && 
+            m_MsgQ.size() < m_MsgQ.getMaxSize()-MSG_QUEUE_HEADROOM;
+}
+
+float AudioDecoderThread::getQueueFill() const
+{
+    return float(m_MsgQ.size())/m_MsgQ.getMaxSize();
+}
+
 void AudioDecoderThread::decodePacket(AVPacket* pPacket)
 {
     char* pDecodedData = 0;
@@ -45,6 +45,8 @@ class AVG_API AudioDecoderThread : public WorkerThread<AudioDecoderThread> {
         virtual ~AudioDecoderThread();
 
         bool work();
+        bool isWorkAvailable() const;
+        float getQueueFill() const;
 
     private:
         void decodePacket(AVPacket* pPacket);
@@ -0,0 +1,211 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "DecoderExecutor.h"
+
+#include "../base/ConfigMgr.h"
+#include "../base/Exception.h"
+#include "../base/Logger.h"
+#include "../base/StringHelper.h"
+#include "../base/ThreadHelper.h"
+#include "../base/ThreadProfiler.h"
+
+#include <algorithm>
+#include <stdlib.h>
+
+using namespace std;
+
+namespace avg {
+
+// Number of steps a worker runs on a task before it looks for a more urgent one.
+static const int MAX_STEPS_PER_TURN = 4;
+
+DecoderExecutor* DecoderExecutor::s_pInstance = 0;
+
+void deleteDecoderExecutor()
+{
+    delete DecoderExecutor::s_pInstance;
+}
+
+DecoderExecutor* DecoderExecutor::get()
+{
+    if (!s_pInstance) {
+        int numWorkers = ConfigMgr::get()->getIntOption("scr", "videoworkerthreads", 0);
+        s_pInstance = new DecoderExecutor(numWorkers);
+        atexit(deleteDecoderExecutor);
+    }
+    return s_pInstance;
+}
+
+DecoderExecutor::DecoderExecutor(int numWorkers)
+    : m_NextTaskID(0),
+      m_bStop(false)
+{
+    if (numWorkers <= 0) {
+        numWorkers = max(int(boost::thread::hardware_concurrency()), 1);
+    }
+    for (int i = 0; i < numWorkers; ++i) {
+        m_pWorkers.push_back(new boost::thread(&DecoderExecutor::workerLoop, this, i));
+    }
+}
+
+DecoderExecutor::~DecoderExecutor()
+{
+    {
+        boost::mutex::scoped_lock lock(m_Mutex);
+        m_bStop = true;
+        m_Cond.notify_all();
+    }
+    for (unsigned i = 0; i < m_pWorkers.size(); ++i) {
+        m_pWorkers[i]->join();
+        delete m_pWorkers[i];
+    }
+    for (unsigned i = 0; i < m_pTasks.size(); ++i) {
+        delete m_pTasks[i]->m_pTask;
+        delete m_pTasks[i];
+    }
+    s_pInstance = 0;
+}
+
+int DecoderExecutor::addTask(IDecoderTask* pTask)
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    TaskSlot* pSlot = new TaskSlot;
+    pSlot->m_pTask = pTask;
+    pSlot->m_ID = m_NextTaskID++;
+    pSlot->m_HomeWorker = pSlot->m_ID % m_pWorkers.size();
+    pSlot->m_bRunning = false;
+    m_pTasks.push_back(pSlot);
+    m_Cond.notify_one();
+    return pSlot->m_ID;
+}
+
+void DecoderExecutor::waitForTask(int taskID)
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    while (hasTask(taskID)) {
+        m_FinishedCond.wait(lock);
+    }
+}
+
+void DecoderExecutor::wakeUp()
+{
+    // Idle workers don't poll, so the notification must not get lost between 
+    // findNextTask() and the wait.
+    boost::mutex::scoped_lock lock(m_Mutex);
+    m_Cond.notify_one();
+}
+
+int DecoderExecutor::getNumWorkers() const
+{
+    return int(m_pWorkers.size());
+}
+
+int DecoderExecutor::getNumTasks() const
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    return int(m_pTasks.size());
+}
+
+void DecoderExecutor::workerLoop(int workerIndex)
+{
+    setAffinityMask(false);
+    ThreadProfiler* pProfiler = ThreadProfiler::get();
+    pProfiler->setName("Video Worker " + toString(workerIndex));
+    pProfiler->setLogCategory(Logger::category::PROFILE_VIDEO);
+    pProfiler->start();
+
+    boost::mutex::scoped_lock lock(m_Mutex);
+    while (!m_bStop) {
+        TaskSlot* pSlot = findNextTask(workerIndex);
+        if (!pSlot) {
+            m_Cond.wait(lock);
+            continue;
+        }
+        pSlot->m_bRunning = true;
+        lock.unlock();
+
+        bool bContinue = true;
+        for (int i = 0; i < MAX_STEPS_PER_TURN; ++i) {
+            bContinue = pSlot->m_pTask->step();
+            if (!bContinue || !pSlot->m_pTask->isReady()) {
+                break;
+            }
+        }
+
+        lock.lock();
+        pSlot->m_bRunning = false;
+        if (bContinue) {
+            // The task's output is the input of other tasks.
+            m_Cond.notify_one();
+        } else {
+            removeTask(pSlot);
+        }
+    }
+    lock.unlock();
+
+    pProfiler->dumpStatistics();
+    pProfiler->kill();
+}
+
+DecoderExecutor::TaskSlot* DecoderExecutor::findNextTask(int workerIndex)
+{
+    TaskSlot* pBestSlot = 0;
+    float bestFill = 0;
+    for (unsigned i = 0; i < m_pTasks.size(); ++i) {
+        TaskSlot* pSlot = m_pTasks[i];
+        if (!pSlot->m_bRunning && pSlot->m_pTask->isReady()) {
+            float fill = pSlot->m_pTask->getQueueFill();
+            bool bIsHome = (pSlot->m_HomeWorker == workerIndex);
+            if (!pBestSlot || fill < bestFill || 
+                    (fill == bestFill && bIsHome && 
+                     pBestSlot->m_HomeWorker != workerIndex))
+            {
+                pBestSlot = pSlot;
+                bestFill = fill;
+            }
+        }
+    }
+    return pBestSlot;
+}
+
+bool DecoderExecutor::hasTask(int taskID) const
+{
+    for (unsigned i = 0; i < m_pTasks.size(); ++i) {
+        if (m_pTasks[i]->m_ID == taskID) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void DecoderExecutor::removeTask(TaskSlot* pSlot)
+{
+    vector<TaskSlot*>::iterator it = find(m_pTasks.begin(), m_pTasks.end(), pSlot);
+    AVG_ASSERT(it != m_pTasks.end());
+    m_pTasks.erase(it);
+    delete pSlot->m_pTask;
+    delete pSlot;
+    m_FinishedCond.notify_all();
+}
+
+}
@@ -0,0 +1,145 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _DecoderExecutor_H_
+#define _DecoderExecutor_H_
+
+#include "../api.h"
+
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/condition.hpp>
+#include <boost/thread.hpp>
+
+#include <vector>
+
+namespace avg {
+
+// One demuxer or decoder of an AsyncVideoDecoder, seen from the executor.
+class AVG_API IDecoderTask
+{
+public:
+    virtual ~IDecoderTask() {};
+    // True if step() has something to do and won't block.
+    virtual bool isReady() const = 0;
+    // Fill level of the queue the task writes to, between 0 (empty) and 1 (full).
+    virtual float getQueueFill() const = 0;
+    // Returns false once the task has finished.
+    virtual bool step() = 0;
+};
+
+// Adapts a WorkerThread-derived class that implements isWorkAvailable() and 
+// getQueueFill() to IDecoderTask.
+template<class WORKER>
+class AVG_TEMPLATE_API DecoderTask: public IDecoderTask
+{
+public:
+    DecoderTask(WORKER* pWorker)
+        : m_pWorker(pWorker)
+    {
+    }
+
+    virtual ~DecoderTask()
+    {
+        delete m_pWorker;
+    }
+
+    virtual bool isReady() const
+    {
+        return m_pWorker->hasPendingCmds() || m_pWorker->isWorkAvailable();
+    }
+
+    virtual float getQueueFill() const
+    {
+        if (m_pWorker->hasPendingCmds()) {
+            // Seeks and close requests are always urgent.
+            return 0;
+        } else {
+            return m_pWorker->getQueueFill();
+        }
+    }
+
+    virtual bool step()
+    {
+        return m_pWorker->step(m_pWorker->isWorkAvailable());
+    }
+
+private:
+    WORKER* m_pWorker;
+};
+
+// Runs the demuxers and decoders of all AsyncVideoDecoders on a fixed number of
+// worker threads instead of three threads per video. A task is never run by two 
+// workers at once, so the messages of each decoder stay in order. Among the tasks 
+// that can make progress, workers pick the one whose output queue is emptiest, i.e.
+// closest to an underrun. Every task has a home worker that prefers it among tasks 
+// of equal urgency; idle workers take over tasks of busy ones.
+class AVG_API DecoderExecutor
+{
+public:
+    static DecoderExecutor* get();
+    // numWorkers == 0 uses one worker per core.
+    DecoderExecutor(int numWorkers);
+    virtual ~DecoderExecutor();
+
+    // Takes ownership of pTask. Returns an id for waitForTask().
+    int addTask(IDecoderTask* pTask);
+    // Blocks until the task has finished and has been deleted.
+    void waitForTask(int taskID);
+    // Must be called after making a task ready from outside the executor, e.g. after
+    // pushing a command or consuming its output. Idle workers sleep until a task is
+    // added, a task is woken up or the executor shuts down.
+    void wakeUp();
+
+    int getNumWorkers() const;
+    int getNumTasks() const;
+
+private:
+    struct TaskSlot {
+        IDecoderTask* m_pTask;
+        int m_ID;
+        int m_HomeWorker;
+        bool m_bRunning;
+    };
+
+    void workerLoop(int workerIndex);
+    TaskSlot* findNextTask(int workerIndex);
+    bool hasTask(int taskID) const;
+    void removeTask(TaskSlot* pSlot);
+
+    std::vector<boost::thread*> m_pWorkers;
+    std::vector<TaskSlot*> m_pTasks;
+    int m_NextTaskID;
+    bool m_bStop;
+
+    mutable boost::mutex m_Mutex;
+    // Signalled when a task may have become ready.
+    boost::condition m_Cond;
+    // Signalled when a task has finished.
+    boost::condition m_FinishedCond;
+
+    static DecoderExecutor* s_pInstance;
+    friend void deleteDecoderExecutor();
+};
+
+}
+
+#endif
@@ -20,11 +20,15 @@
 //
 
 #include "FFMpegDemuxer.h"
+#include "VideoDecoder.h"
 
 #include "../base/ScopeTimer.h"
 #include "../base/ObjectCounter.h"
 #include "../base/Exception.h"
 #include "../base/Logger.h"
+#include "../base/ConfigMgr.h"
+#include "../base/TimeSource.h"
+#include "../base/ThreadHelper.h"
 
 #include <cstring>
 #include <iostream>
@@ -33,17 +37,33 @@ using namespace std;
 
 namespace avg {
 
+// An index that ends more than this many seconds before the end of the stream is
+// considered incomplete.
+static const float MAX_KEYFRAME_DISTANCE = 10;
+
 FFMpegDemuxer::FFMpegDemuxer(AVFormatContext * pFormatContext, vector<int> streamIndexes)
-    : m_pFormatContext(pFormatContext)
+    : m_pFormatContext(pFormatContext),
+      m_VStreamIndex(-1),
+      m_pScanThread(0),
+      m_bStopScan(false)
 {
     ObjectCounter::get()->incRef(&typeid(*this));
     for (unsigned i = 0; i < streamIndexes.size(); ++i) {
         m_PacketLists[streamIndexes[i]] = PacketList();
+        AVStream* pStream = m_pFormatContext->streams[streamIndexes[i]];
+        if (pStream->codec->codec_type == AVMEDIA_TYPE_VIDEO) {
+            m_VStreamIndex = streamIndexes[i];
+        }
     }
 }
 
 FFMpegDemuxer::~FFMpegDemuxer()
 {
+    if (m_pScanThread) {
+        m_bStopScan = true;
+        m_pScanThread->join();
+        delete m_pScanThread;
+    }
     clearPacketCache();
     ObjectCounter::get()->decRef(&typeid(*this));
 }
@@ -111,8 +131,22 @@ AVPacket * FFMpegDemuxer::getPacket(int streamIndex)
         
 void FFMpegDemuxer::seek(float destTime)
 {
-    av_seek_frame(m_pFormatContext, -1, (long long)(destTime*AV_TIME_BASE),
-            AVSEEK_FLAG_BACKWARD);
+    if (m_VStreamIndex != -1 && !m_pScanThread && !getKeyframeIndex()) {
+        buildKeyframeIndex();
+    }
+    KeyframeIndexPtr pKeyframeIndex = getKeyframeIndex();
+    if (pKeyframeIndex && pKeyframeIndex->getNumKeyframes() > 0) {
+        // Seeking to the exact keyframe timestamp avoids landing on a non-keyframe
+        // in containers that ffmpeg seeks by bisection.
+        AVStream* pStream = m_pFormatContext->streams[m_VStreamIndex];
+        long long destTimestamp = (long long)(destTime/av_q2d(pStream->time_base));
+        long long keyframeTimestamp = pKeyframeIndex->getKeyframeBefore(destTimestamp);
+        av_seek_frame(m_pFormatContext, m_VStreamIndex, keyframeTimestamp, 
+                AVSEEK_FLAG_BACKWARD);
+    } else {
+        av_seek_frame(m_pFormatContext, -1, (long long)(destTime*AV_TIME_BASE),
+                AVSEEK_FLAG_BACKWARD);
+    }
     clearPacketCache();
 }
 
@@ -130,6 +164,122 @@ void FFMpegDemuxer::clearPacketCache()
     }
 }
 
+void FFMpegDemuxer::buildKeyframeIndex()
+{
+    KeyframeIndexPtr pIndex(new KeyframeIndex());
+    string sFilename(m_pFormatContext->filename);
+    string sCacheDir;
+    ConfigMgr::get()->getStringOption("scr", "keyframeindexdir", "", sCacheDir);
+    if (sCacheDir != "" && pIndex->load(sCacheDir, sFilename)) {
+        m_pKeyframeIndex = pIndex;
+        return;
+    }
+
+    // Most containers have an index that ffmpeg has already read.
+    AVStream* pStream = m_pFormatContext->streams[m_VStreamIndex];
+    for (int i = 0; i < pStream->nb_index_entries; ++i) {
+        const AVIndexEntry& entry = pStream->index_entries[i];
+        if (entry.flags & AVINDEX_KEYFRAME) {
+            pIndex->addKeyframe(entry.timestamp);
+        }
+    }
+    if (isIndexComplete(*pIndex)) {
+        m_pKeyframeIndex = pIndex;
+    } else {
+        // Reading all packets is expensive for large files, so it happens in the 
+        // background and the result is cached if possible. Until it's done, seeks 
+        // use av_seek_frame() without an index.
+        m_bStopScan = false;
+        m_pScanThread = new boost::thread(&FFMpegDemuxer::scanKeyframes, this, 
+                sFilename, sCacheDir);
+    }
+}
+
+bool FFMpegDemuxer::isIndexComplete(const KeyframeIndex& index) const
+{
+    if (index.getNumKeyframes() == 0) {
+        return false;
+    }
+    AVStream* pStream = m_pFormatContext->streams[m_VStreamIndex];
+    if (pStream->duration == (long long)AV_NOPTS_VALUE) {
+        return !(m_pFormatContext->iformat->flags & AVFMT_GENERIC_INDEX);
+    }
+    // For formats without an index of their own (AVFMT_GENERIC_INDEX) and for files 
+    // that lack one (e.g. mkv without cues), ffmpeg only indexes the keyframes it 
+    // read while probing. A complete index reaches the end of the stream.
+    long long startTime = pStream->start_time;
+    if (startTime == (long long)AV_NOPTS_VALUE) {
+        startTime = 0;
+    }
+    long long maxDistance = (long long)(MAX_KEYFRAME_DISTANCE/av_q2d(pStream->time_base));
+    long long lastKeyframe = index.getKeyframe(index.getNumKeyframes()-1);
+    return lastKeyframe >= startTime+pStream->duration-maxDistance;
+}
+
+void FFMpegDemuxer::scanKeyframes(string sFilename, string sCacheDir)
+{
+    // Runs in m_pScanThread and uses a format context of its own, so it doesn't
+    // interfere with the demuxer.
+    long long startTime = TimeSource::get()->getCurrentMillisecs();
+    KeyframeIndexPtr pIndex(new KeyframeIndex());
+    AVFormatContext* pFormatContext = 0;
+    {
+        lock_guard lock(VideoDecoder::s_OpenMutex);
+        int err = avformat_open_input(&pFormatContext, sFilename.c_str(), 0, 0);
+        if (err >= 0) {
+            err = avformat_find_stream_info(pFormatContext, 0);
+            if (err < 0) {
+                avformat_close_input(&pFormatContext);
+            }
+        }
+        if (err < 0) {
+            AVG_TRACE(Logger::category::PLAYER, Logger::severity::WARNING,
+                    "Can't index keyframes of " << sFilename << ".");
+            lock_guard indexLock(m_IndexMutex);
+            m_pKeyframeIndex = pIndex;
+            return;
+        }
+    }
+
+    AVPacket packet;
+    av_init_packet(&packet);
+    packet.data = 0;
+    packet.size = 0;
+    while (!m_bStopScan && av_read_frame(pFormatContext, &packet) >= 0) {
+        if (packet.stream_index == m_VStreamIndex && (packet.flags & AV_PKT_FLAG_KEY)) {
+            if (packet.dts != (long long)AV_NOPTS_VALUE) {
+                pIndex->addKeyframe(packet.dts);
+            } else if (packet.pts != (long long)AV_NOPTS_VALUE) {
+                pIndex->addKeyframe(packet.pts);
+            }
+        }
+        av_free_packet(&packet);
+    }
+    {
+        lock_guard lock(VideoDecoder::s_OpenMutex);
+        avformat_close_input(&pFormatContext);
+    }
+    if (m_bStopScan) {
+        return;
+    }
+
+    AVG_TRACE(Logger::category::PLAYER, Logger::severity::INFO,
+            "Indexed " << pIndex->getNumKeyframes() << " keyframes of " 
+            << sFilename << " in " 
+            << TimeSource::get()->getCurrentMillisecs()-startTime << " ms.");
+    if (sCacheDir != "" && pIndex->getNumKeyframes() > 0) {
+        pIndex->save(sCacheDir, sFilename);
+    }
+    lock_guard lock(m_IndexMutex);
+    m_pKeyframeIndex = pIndex;
+}
+
+KeyframeIndexPtr FFMpegDemuxer::getKeyframeIndex()
+{
+    lock_guard lock(m_IndexMutex);
+    return m_pKeyframeIndex;
+}
+
 void FFMpegDemuxer::dump()
 {
     map<int, PacketList>::iterator it;
@@ -25,12 +25,18 @@
 #include "../avgconfigwrapper.h"
 
 #include "WrapFFMpeg.h"
+#include "KeyframeIndex.h"
 
 #include <list>
 #include <vector>
 #include <map>
+#include <string>
 
 #include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+#include <boost/thread/thread.hpp>
+
+#include <atomic>
 
 namespace avg {
 
@@ -40,17 +46,32 @@ class AVG_API FFMpegDemuxer {
         virtual ~FFMpegDemuxer();
        
         AVPacket * getPacket(int streamIndex);
+        // Seeks to the last keyframe at or before destTime.
         void seek(float destTime);
         void dump();
         
     private:
         void clearPacketCache();
+        void buildKeyframeIndex();
+        bool isIndexComplete(const KeyframeIndex& index) const;
+        void scanKeyframes(std::string sFilename, std::string sCacheDir);
+        KeyframeIndexPtr getKeyframeIndex();
 
         // Packets that haven't been delivered yet.
         typedef std::list<AVPacket *> PacketList;
         std::map<int, PacketList> m_PacketLists;
        
         AVFormatContext * m_pFormatContext;
+
+        // Built on the first seek. Empty if there is no video stream.
+        int m_VStreamIndex;
+        KeyframeIndexPtr m_pKeyframeIndex;
+        boost::mutex m_IndexMutex;
+
+        // Files without a complete index are read once by a thread of their own, so
+        // the decoder threads aren't blocked while it runs.
+        boost::thread* m_pScanThread;
+        std::atomic<bool> m_bStopScan;
 };
 
 typedef boost::shared_ptr<FFMpegDemuxer> FFMpegDemuxerPtr;
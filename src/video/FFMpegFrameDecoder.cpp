@@ -47,10 +47,15 @@ FFMpegFrameDecoder::FFMpegFrameDecoder(AVStream* pStream)
       m_bEOF(false),
       m_StartTimestamp(-1),
       m_LastFrameTime(-1),
+      m_FrameDelay(0),
       m_bUseStreamFPS(true)
 {
     m_TimeUnitsPerSecond = float(1.0/av_q2d(pStream->time_base));
     m_FPS = getStreamFPS(pStream);
+    AVCodecContext const* pContext = pStream->codec;
+    if (pContext->active_thread_type & FF_THREAD_FRAME) {
+        m_FrameDelay = pContext->thread_count-1;
+    }
     
     ObjectCounter::get()->incRef(&typeid(*this));
 }
@@ -74,8 +79,9 @@ bool FFMpegFrameDecoder::decodePacket(AVPacket* pPacket, AVFrame* pFrame,
     AVCodecContext* pContext = m_pStream->codec;
     AVG_ASSERT(pPacket);
     avcodec_decode_video2(pContext, pFrame, &bGotPicture, pPacket);
+    long long dts = getDelayedDTS(pPacket->dts);
     if (bGotPicture) {
-        m_LastFrameTime = getFrameTime(pPacket->dts, bFrameAfterSeek);
+        m_LastFrameTime = getFrameTime(dts, bFrameAfterSeek);
     }
     av_free_packet(pPacket);
     delete pPacket;
@@ -94,9 +100,18 @@ bool FFMpegFrameDecoder::decodeLastFrame(AVFrame* pFrame)
     avcodec_decode_video2(pContext, pFrame, &bGotPicture, &packet);
     m_bEOF = true;
 
-    // We don't have a timestamp for the last frame, so we'll
-    // calculate it based on the frame before.
-    m_LastFrameTime += 1.0f/m_FPS;
+    if (!m_PendingDTSs.empty()) {
+        // Frame threading: The remaining frames belong to packets we've already sent.
+        long long dts = m_PendingDTSs.front();
+        m_PendingDTSs.pop_front();
+        if (bGotPicture) {
+            m_LastFrameTime = getFrameTime(dts, false);
+        }
+    } else {
+        // We don't have a timestamp for the last frame, so we'll
+        // calculate it based on the frame before.
+        m_LastFrameTime += 1.0f/m_FPS;
+    }
     return (bGotPicture != 0);
 }
 
@@ -198,6 +213,7 @@ void FFMpegFrameDecoder::handleSeek()
 {
     m_LastFrameTime = -1.0f;
     avcodec_flush_buffers(m_pStream->codec);
+    m_PendingDTSs.clear();
     m_bEOF = false;
     if (m_StartTimestamp == -1) {
         m_StartTimestamp = 0;
@@ -229,6 +245,22 @@ bool FFMpegFrameDecoder::isEOF() const
     return m_bEOF;
 }
 
+long long FFMpegFrameDecoder::getDelayedDTS(long long dts)
+{
+    if (m_FrameDelay == 0) {
+        return dts;
+    }
+    m_PendingDTSs.push_back(dts);
+    if (int(m_PendingDTSs.size()) > m_FrameDelay) {
+        long long delayedDTS = m_PendingDTSs.front();
+        m_PendingDTSs.pop_front();
+        return delayedDTS;
+    } else {
+        // Still filling the pipeline; the codec doesn't return a picture yet.
+        return (long long)AV_NOPTS_VALUE;
+    }
+}
+
 float FFMpegFrameDecoder::getFrameTime(long long dts, bool bFrameAfterSeek)
 {
     bool bUseStreamFPS = m_bUseStreamFPS;
@@ -28,6 +28,8 @@
 
 #include <boost/shared_ptr.hpp>
 
+#include <deque>
+
 namespace avg {
 
 class Bitmap;
@@ -54,6 +56,7 @@ class AVG_API FFMpegFrameDecoder
         
     private:
         float getFrameTime(long long dts, bool bFrameAfterSeek);
+        long long getDelayedDTS(long long dts);
 
         SwsContext * m_pSwsContext;
         AVStream* m_pStream;
@@ -64,6 +67,12 @@ class AVG_API FFMpegFrameDecoder
         long long m_StartTimestamp;
         float m_LastFrameTime;
 
+        // With frame threading, the codec returns the picture for a packet 
+        // m_FrameDelay packets later. These are the timestamps of the packets in 
+        // flight.
+        int m_FrameDelay;
+        std::deque<long long> m_PendingDTSs;
+
         bool m_bUseStreamFPS;
         float m_FPS;
 };
@@ -0,0 +1,155 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "KeyframeIndex.h"
+
+#include "../base/Exception.h"
+#include "../base/FileHelper.h"
+#include "../base/Logger.h"
+
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+
+#define INDEX_MAGIC "avgkeyframeindex"
+#define INDEX_VERSION 1
+#define INDEX_SUFFIX ".avgkfi"
+
+using namespace std;
+
+namespace avg {
+
+KeyframeIndex::KeyframeIndex()
+{
+}
+
+KeyframeIndex::~KeyframeIndex()
+{
+}
+
+void KeyframeIndex::addKeyframe(long long timestamp)
+{
+    // Keyframes usually arrive in order, so this is almost always a push_back.
+    if (m_Timestamps.empty() || m_Timestamps.back() < timestamp) {
+        m_Timestamps.push_back(timestamp);
+    } else {
+        vector<long long>::iterator it = 
+                lower_bound(m_Timestamps.begin(), m_Timestamps.end(), timestamp);
+        if (*it != timestamp) {
+            m_Timestamps.insert(it, timestamp);
+        }
+    }
+}
+
+int KeyframeIndex::getNumKeyframes() const
+{
+    return int(m_Timestamps.size());
+}
+
+long long KeyframeIndex::getKeyframe(int i) const
+{
+    return m_Timestamps[i];
+}
+
+long long KeyframeIndex::getKeyframeBefore(long long timestamp) const
+{
+    AVG_ASSERT(!m_Timestamps.empty());
+    vector<long long>::const_iterator it = 
+            upper_bound(m_Timestamps.begin(), m_Timestamps.end(), timestamp);
+    if (it == m_Timestamps.begin()) {
+        return *it;
+    } else {
+        return *(it-1);
+    }
+}
+
+bool KeyframeIndex::load(const string& sCacheDir, const string& sVideoFilename)
+{
+    long long size;
+    long long modTime;
+    if (!statFile(sVideoFilename, size, modTime)) {
+        return false;
+    }
+    ifstream file(getCacheFilename(sCacheDir, sVideoFilename).c_str());
+    if (!file) {
+        return false;
+    }
+    string sMagic;
+    int version;
+    string sFilename;
+    long long cachedSize;
+    long long cachedModTime;
+    int numKeyframes;
+    file >> sMagic >> version >> ws;
+    getline(file, sFilename);
+    file >> cachedSize >> cachedModTime >> numKeyframes;
+    if (!file || sMagic != INDEX_MAGIC || version != INDEX_VERSION || 
+            sFilename != sVideoFilename || cachedSize != size || 
+            cachedModTime != modTime || numKeyframes < 0)
+    {
+        // Stale entry, hash collision or incompatible version.
+        return false;
+    }
+    vector<long long> timestamps(numKeyframes);
+    for (int i = 0; i < numKeyframes; ++i) {
+        file >> timestamps[i];
+    }
+    if (!file) {
+        return false;
+    }
+    m_Timestamps.swap(timestamps);
+    return true;
+}
+
+void KeyframeIndex::save(const string& sCacheDir, const string& sVideoFilename) const
+{
+    long long size;
+    long long modTime;
+    if (!statFile(sVideoFilename, size, modTime)) {
+        return;
+    }
+    makeDir(sCacheDir);
+    string sCacheFilename = getCacheFilename(sCacheDir, sVideoFilename);
+    ofstream file(sCacheFilename.c_str());
+    if (!file) {
+        AVG_LOG_WARNING("Can't write keyframe index " << sCacheFilename << ".");
+        return;
+    }
+    file << INDEX_MAGIC << " " << INDEX_VERSION << endl;
+    file << sVideoFilename << endl;
+    file << size << " " << modTime << " " << m_Timestamps.size() << endl;
+    for (unsigned i = 0; i < m_Timestamps.size(); ++i) {
+        file << m_Timestamps[i] << endl;
+    }
+}
+
+string KeyframeIndex::getCacheFilename(const string& sCacheDir, 
+        const string& sVideoFilename) const
+{
+    stringstream ss;
+    ss << sCacheDir << "/" << hex << setw(16) << setfill('0') 
+            << hashString(sVideoFilename) << INDEX_SUFFIX;
+    return ss.str();
+}
+
+}
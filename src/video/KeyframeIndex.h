@@ -0,0 +1,68 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _KeyframeIndex_H_
+#define _KeyframeIndex_H_
+
+#include "../api.h"
+
+#include <boost/shared_ptr.hpp>
+
+#include <string>
+#include <vector>
+
+namespace avg {
+
+// Sorted decoding timestamps of the keyframes of a video stream, in stream time base
+// units. Lets the demuxer seek directly to the keyframe that precedes a seek target.
+// Indexes can be stored in a cache directory; a cache entry becomes stale
+// automatically when the video file changes.
+class AVG_API KeyframeIndex
+{
+public:
+    KeyframeIndex();
+    virtual ~KeyframeIndex();
+
+    void addKeyframe(long long timestamp);
+    int getNumKeyframes() const;
+    long long getKeyframe(int i) const;
+
+    // Returns the last keyframe at or before timestamp, or the first keyframe if 
+    // timestamp precedes all keyframes. The index must not be empty.
+    long long getKeyframeBefore(long long timestamp) const;
+
+    // Returns false if there is no valid cache entry for the video file.
+    bool load(const std::string& sCacheDir, const std::string& sVideoFilename);
+    void save(const std::string& sCacheDir, const std::string& sVideoFilename) const;
+
+private:
+    std::string getCacheFilename(const std::string& sCacheDir, 
+            const std::string& sVideoFilename) const;
+
+    std::vector<long long> m_Timestamps;
+};
+
+typedef boost::shared_ptr<KeyframeIndex> KeyframeIndexPtr;
+
+}
+
+#endif
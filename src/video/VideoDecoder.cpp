@@ -21,6 +21,7 @@
 
 #include "VideoDecoder.h"
 
+#include "../base/ConfigMgr.h"
 #include "../base/Exception.h"
 #include "../base/Logger.h"
 #include "../base/ObjectCounter.h"
@@ -47,6 +48,7 @@ boost::mutex VideoDecoder::s_OpenMutex;
 VideoDecoder::VideoDecoder()
     : m_State(CLOSED),
       m_pFormatContext(0),
+      m_NumDecodingThreadsWanted(-1),
       m_VStreamIndex(-1),
       m_pVStream(0),
       m_PF(NO_PIXELFORMAT),
@@ -66,6 +68,12 @@ VideoDecoder::~VideoDecoder()
     ObjectCounter::get()->decRef(&typeid(*this));
 }
 
+void VideoDecoder::setNumDecodingThreads(int numThreads)
+{
+    AVG_ASSERT(m_State == CLOSED);
+    m_NumDecodingThreadsWanted = numThreads;
+}
+
 void VideoDecoder::open(const string& sFilename, bool bEnableSound)
 {
     lock_guard lock(s_OpenMutex);
@@ -125,7 +133,12 @@ void VideoDecoder::open(const string& sFilename, bool bEnableSound)
 
         char szCodec[256];
         avcodec_string(szCodec, sizeof(szCodec), m_pVStream->codec, 0);
-        int rc = openCodec(m_VStreamIndex);
+        int numThreads = m_NumDecodingThreadsWanted;
+        if (numThreads < 0) {
+            numThreads = ConfigMgr::get()->getIntOption("scr", "videodecodingthreads", 
+                    0);
+        }
+        int rc = openCodec(m_VStreamIndex, numThreads);
         if (rc == -1) {
             m_VStreamIndex = -1;
             m_pVStream = 0;
@@ -139,7 +152,7 @@ void VideoDecoder::open(const string& sFilename, bool bEnableSound)
         m_pAStream = m_pFormatContext->streams[m_AStreamIndex];
         char szCodec[256];
         avcodec_string(szCodec, sizeof(szCodec), m_pAStream->codec, 0);
-        int rc = openCodec(m_AStreamIndex);
+        int rc = openCodec(m_AStreamIndex, 1);
         if (rc == -1) {
             m_AStreamIndex = -1;
             m_pAStream = 0; 
@@ -228,7 +241,8 @@ VideoInfo VideoDecoder::getVideoInfo() const
             m_pVStream != 0, m_pAStream != 0);
     if (m_pVStream) {
         info.setVideoData(m_Size, getStreamPF(), getNumFrames(), getStreamFPS(),
-                m_pVStream->codec->codec->name, getDuration(SS_VIDEO));
+                m_pVStream->codec->codec->name, getDuration(SS_VIDEO),
+                getNumDecodingThreads());
     }
     if (m_pAStream) {
         AVCodecContext * pACodec = m_pAStream->codec;
@@ -265,6 +279,46 @@ FrameAvailableCode VideoDecoder::getRenderedBmp(BitmapPtr& pBmp, float timeWante
     return fa;
 }
 
+int VideoDecoder::getFramePoolSize() const
+{
+    return 0;
+}
+
+long long VideoDecoder::getFramePoolHits() const
+{
+    return 0;
+}
+
+long long VideoDecoder::getFramePoolMisses() const
+{
+    return 0;
+}
+
+int VideoDecoder::getNumSeeksDone() const
+{
+    return 0;
+}
+
+int VideoDecoder::getNumSeeksCancelled() const
+{
+    return 0;
+}
+
+float VideoDecoder::getAvgSeekLatency() const
+{
+    return 0;
+}
+
+float VideoDecoder::getMaxSeekLatency() const
+{
+    return 0;
+}
+
+float VideoDecoder::getAvgExactSeekLatency() const
+{
+    return 0;
+}
+
 int VideoDecoder::getNumFrames() const
 {
     AVG_ASSERT(m_State != CLOSED);
@@ -339,7 +393,7 @@ void VideoDecoder::initVideoSupport()
     }
 }
 
-int VideoDecoder::openCodec(int streamIndex)
+int VideoDecoder::openCodec(int streamIndex, int numThreads)
 {
     AVCodecContext* pContext;
     pContext = m_pFormatContext->streams[streamIndex]->codec;
@@ -350,6 +404,11 @@ int VideoDecoder::openCodec(int streamIndex)
     if (!pCodec) {
         return -1;
     }
+    // thread_count == 0 lets ffmpeg choose based on the number of cores. Frame 
+    // threading delays output by one frame per additional thread. FFMpegFrameDecoder
+    // compensates for this when calculating frame times.
+    pContext->thread_count = numThreads;
+    pContext->thread_type = FF_THREAD_FRAME | FF_THREAD_SLICE;
     int rc = avcodec_open2(pContext, pCodec, 0);
     if (rc < 0) {
         return -1;
@@ -357,6 +416,17 @@ int VideoDecoder::openCodec(int streamIndex)
     return 0;
 }
 
+int VideoDecoder::getNumDecodingThreads() const
+{
+    AVCodecContext const* pContext = m_pVStream->codec;
+    if (pContext->active_thread_type == 0) {
+        // The codec doesn't support threading.
+        return 1;
+    } else {
+        return pContext->thread_count;
+    }
+}
+
 float VideoDecoder::getDuration(StreamSelect streamSelect) const
 {
     AVG_ASSERT(m_State != CLOSED);
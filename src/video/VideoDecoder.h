@@ -56,6 +56,8 @@ class AVG_API VideoDecoder
         enum DecoderState {CLOSED, OPENED, DECODING};
         VideoDecoder();
         virtual ~VideoDecoder();
+        // -1 uses the videodecodingthreads config option. Must be called before open().
+        void setNumDecodingThreads(int numThreads);
         virtual void open(const std::string& sFilename, bool bEnableSound);
         virtual void startDecoding(bool bDeliverYCbCr, const AudioParams* pAP);
         virtual void close();
@@ -79,6 +81,19 @@ class AVG_API VideoDecoder
         virtual bool isEOF() const = 0;
         virtual void throwAwayFrame(float timeWanted) = 0;
 
+        // Statistics of the zero-copy frame pool. 0 if the decoder doesn't use one.
+        virtual int getFramePoolSize() const;
+        virtual long long getFramePoolHits() const;
+        virtual long long getFramePoolMisses() const;
+
+        // Seek statistics. Latencies are in milliseconds. 0 if the decoder doesn't 
+        // track seeks.
+        virtual int getNumSeeksDone() const;
+        virtual int getNumSeeksCancelled() const;
+        virtual float getAvgSeekLatency() const;
+        virtual float getMaxSeekLatency() const;
+        virtual float getAvgExactSeekLatency() const;
+
         // Prevents different decoder instances from executing open/close simultaneously
         static boost::mutex s_OpenMutex;
 
@@ -96,7 +111,8 @@ class AVG_API VideoDecoder
 
     private:
         void initVideoSupport();
-        int openCodec(int streamIndex);
+        int openCodec(int streamIndex, int numThreads);
+        int getNumDecodingThreads() const;
         float getDuration(StreamSelect streamSelect) const;
         PixelFormat calcPixelFormat(bool bUseYCbCr);
         std::string getStreamPF() const;
@@ -104,6 +120,7 @@ class AVG_API VideoDecoder
         DecoderState m_State;
         AVFormatContext * m_pFormatContext;
         std::string m_sFilename;
+        int m_NumDecodingThreadsWanted;
 
         // Video
         int m_VStreamIndex;
@@ -33,16 +33,21 @@ struct vdpau_render_state;
 
 using namespace std;
 
+// Upper bound for the number of recycled frame messages.
+#define MAX_FRAME_MSGS 64
+
 namespace avg {
 
 VideoDecoderThread::VideoDecoderThread(CQueue& cmdQ, VideoMsgQueue& msgQ, 
-        VideoMsgQueue& packetQ, AVStream* pStream, const IntPoint& size, PixelFormat pf)
+        VideoMsgQueue& packetQ, AVStream* pStream, const IntPoint& size, PixelFormat pf,
+        VideoFramePoolPtr pFramePool)
     : WorkerThread<VideoDecoderThread>(string("Video Decoder"), cmdQ, 
             Logger::category::PROFILE_VIDEO),
       m_MsgQ(msgQ),
       m_PacketQ(packetQ),
       m_pBmpQ(new BitmapQueue()),
       m_pHalfBmpQ(new BitmapQueue()),
+      m_pFramePool(pFramePool),
       m_Size(size),
       m_PF(pf),
       m_bSeekDone(false),
@@ -105,6 +110,20 @@ bool VideoDecoderThread::work()
     return true;
 }
 
+bool VideoDecoderThread::isWorkAvailable() const
+{
+    // Each call to work() produces at most one message.
+    if (m_MsgQ.size() >= m_MsgQ.getMaxSize()) {
+        return false;
+    }
+    return m_bProcessingLastFrames || !m_PacketQ.empty();
+}
+
+float VideoDecoderThread::getQueueFill() const
+{
+    return float(m_MsgQ.size())/m_MsgQ.getMaxSize();
+}
+
 void VideoDecoderThread::setFPS(float fps)
 {
     m_pFrameDecoder->setFPS(fps);
@@ -112,6 +131,10 @@ void VideoDecoderThread::setFPS(float fps)
 
 void VideoDecoderThread::returnFrame(VideoMsgPtr pMsg)
 {
+    if (m_pFramePool && m_pFramePool->isPoolBmp(pMsg->getFrameBitmap(0))) {
+        // Pool slots are reused automatically as soon as nobody references them.
+        return;
+    }
     m_pBmpQ->push(pMsg->getFrameBitmap(0));
     if (pixelFormatIsPlanar(m_PF)) {
         m_pHalfBmpQ->push(pMsg->getFrameBitmap(1));
@@ -124,6 +147,7 @@ void VideoDecoderThread::returnFrame(VideoMsgPtr pMsg)
 
 void VideoDecoderThread::decodePacket(AVPacket* pPacket)
 {
+    recycleFrameMsgs();
     bool bGotPicture = m_pFrameDecoder->decodePacket(pPacket, m_pFrame, m_bSeekDone);
     if (bGotPicture) {
         m_bSeekDone = false;
@@ -133,6 +157,7 @@ void VideoDecoderThread::decodePacket(AVPacket* pPacket)
 
 void VideoDecoderThread::handleEOF()
 {
+    recycleFrameMsgs();
     bool bGotPicture = m_pFrameDecoder->decodeLastFrame(m_pFrame);
     if (bGotPicture) {
         sendFrame(m_pFrame);
@@ -156,26 +181,30 @@ static ProfilingZoneID CopyImageProfilingZone("Copy image", true);
 
 void VideoDecoderThread::sendFrame(AVFrame* pFrame)
 {
-    VideoMsgPtr pMsg(new VideoMsg());
-    vector<BitmapPtr> pBmps;
+    VideoMsgPtr pMsg = getFrameMsg();
+    vector<BitmapPtr>& pBmps = m_pFrameBmps;
+    pBmps.clear();
     if (pixelFormatIsPlanar(m_PF)) {
-        ScopeTimer timer(CopyImageProfilingZone);
-        IntPoint halfSize(m_Size.x/2, m_Size.y/2);
-        pBmps.push_back(getBmp(m_pBmpQ, m_Size, I8));
-        pBmps.push_back(getBmp(m_pHalfBmpQ, halfSize, I8));
-        pBmps.push_back(getBmp(m_pHalfBmpQ, halfSize, I8));
-        if (m_PF == YCbCrA420p) {
+        if (!m_pFramePool || !m_pFramePool->getFrameBmps(pFrame, pBmps)) {
+            ScopeTimer timer(CopyImageProfilingZone);
+            IntPoint halfSize(m_Size.x/2, m_Size.y/2);
             pBmps.push_back(getBmp(m_pBmpQ, m_Size, I8));
-        }
-        for (unsigned i = 0; i < pBmps.size(); ++i) {
-            m_pFrameDecoder->copyPlaneToBmp(pBmps[i], pFrame->data[i], 
-                    pFrame->linesize[i]);
+            pBmps.push_back(getBmp(m_pHalfBmpQ, halfSize, I8));
+            pBmps.push_back(getBmp(m_pHalfBmpQ, halfSize, I8));
+            if (m_PF == YCbCrA420p) {
+                pBmps.push_back(getBmp(m_pBmpQ, m_Size, I8));
+            }
+            for (unsigned i = 0; i < pBmps.size(); ++i) {
+                m_pFrameDecoder->copyPlaneToBmp(pBmps[i], pFrame->data[i], 
+                        pFrame->linesize[i]);
+            }
         }
     } else {
         pBmps.push_back(getBmp(m_pBmpQ, m_Size, m_PF));
         m_pFrameDecoder->convertFrameToBmp(pFrame, pBmps[0]);
     }
     pMsg->setFrame(pBmps, m_pFrameDecoder->getCurTime());
+    pBmps.clear();
     pushMsg(pMsg);
 }
 
@@ -197,6 +226,36 @@ BitmapPtr VideoDecoderThread::getBmp(BitmapQueuePtr pBmpQ, const IntPoint& size,
     }
 }
 
+VideoMsgPtr VideoDecoderThread::getFrameMsg()
+{
+    for (unsigned i = 0; i < m_pFrameMsgs.size(); ++i) {
+        if (m_pFrameMsgs[i].use_count() == 1) {
+            // Only referenced here, so the main thread is done with it.
+            if (m_pFrameMsgs[i]->getType() == VideoMsg::FRAME) {
+                m_pFrameMsgs[i]->resetFrame();
+            }
+            return m_pFrameMsgs[i];
+        }
+    }
+    VideoMsgPtr pMsg(new VideoMsg());
+    if (m_pFrameMsgs.size() < MAX_FRAME_MSGS) {
+        m_pFrameMsgs.push_back(pMsg);
+    }
+    return pMsg;
+}
+
+void VideoDecoderThread::recycleFrameMsgs()
+{
+    // Idle messages still reference the bitmaps of the last frame they carried. 
+    // Release them so the frame pool can reuse the planes.
+    for (unsigned i = 0; i < m_pFrameMsgs.size(); ++i) {
+        VideoMsgPtr& pMsg = m_pFrameMsgs[i];
+        if (pMsg.use_count() == 1 && pMsg->getType() == VideoMsg::FRAME) {
+            pMsg->resetFrame();
+        }
+    }
+}
+
 static ProfilingZoneID PushMsgProfilingZone("Push message", true);
 
 void VideoDecoderThread::pushMsg(VideoMsgPtr pMsg)
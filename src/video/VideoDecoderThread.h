@@ -24,6 +24,7 @@
 
 #include "../api.h"
 #include "VideoMsg.h"
+#include "VideoFramePool.h"
 
 #include "../base/WorkerThread.h"
 #include "../base/Command.h"
@@ -47,12 +48,15 @@ typedef boost::shared_ptr<FFMpegFrameDecoder> FFMpegFrameDecoderPtr;
 class AVG_API VideoDecoderThread: public WorkerThread<VideoDecoderThread> {
     public:
         VideoDecoderThread(CQueue& cmdQ, VideoMsgQueue& msgQ, VideoMsgQueue& packetQ, 
-                AVStream* pStream, const IntPoint& size, PixelFormat pf);
+                AVStream* pStream, const IntPoint& size, PixelFormat pf,
+                VideoFramePoolPtr pFramePool=VideoFramePoolPtr());
         virtual ~VideoDecoderThread();
         virtual bool init();
         virtual void deinit();
         
         bool work();
+        bool isWorkAvailable() const;
+        float getQueueFill() const;
         void setFPS(float fps);
         void returnFrame(VideoMsgPtr pMsg);
 
@@ -63,6 +67,8 @@ class AVG_API VideoDecoderThread: public WorkerThread<VideoDecoderThread> {
         void sendFrame(AVFrame* pFrame);
         void close();
         BitmapPtr getBmp(BitmapQueuePtr pBmpQ, const IntPoint& size, PixelFormat pf);
+        VideoMsgPtr getFrameMsg();
+        void recycleFrameMsgs();
         void pushMsg(VideoMsgPtr pMsg);
 
         VideoMsgQueue& m_MsgQ;
@@ -71,6 +77,9 @@ class AVG_API VideoDecoderThread: public WorkerThread<VideoDecoderThread> {
 
         BitmapQueuePtr m_pBmpQ;
         BitmapQueuePtr m_pHalfBmpQ;
+        VideoFramePoolPtr m_pFramePool;
+        std::vector<VideoMsgPtr> m_pFrameMsgs;
+        std::vector<BitmapPtr> m_pFrameBmps;
         
         IntPoint m_Size;
         PixelFormat m_PF;
@@ -63,19 +63,7 @@ bool VideoDemuxerThread::work()
     if (m_bEOF) {
         waitForCommand();
     } else {
-        map<int, VideoMsgQueuePtr>::iterator it;
-        int shortestQ = -1;
-        int shortestLength = INT_MAX;
-        for (it = m_PacketQs.begin(); it != m_PacketQs.end(); it++) {
-            if (it->second->size() < shortestLength && 
-                    it->second->size() < it->second->getMaxSize() &&
-                    !m_PacketQEOFMap[it->first])
-            {
-                shortestLength = it->second->size();
-                shortestQ = it->first;
-            }
-        }
-        
+        int shortestQ = findShortestQueue();
         if (shortestQ < 0) {
             // All queues are at their max capacity. Take a nap and try again later.
             // Note that we can't wait on the queue. If decoding is paused, the queues can
@@ -94,11 +82,26 @@ bool VideoDemuxerThread::work()
             pMsg->setPacket(pPacket);
         }
         m_PacketQs[shortestQ]->push(pMsg);
-        msleep(0);
     }
     return true;
 }
 
+bool VideoDemuxerThread::isWorkAvailable() const
+{
+    return !m_bEOF && findShortestQueue() >= 0;
+}
+
+float VideoDemuxerThread::getQueueFill() const
+{
+    int shortestQ = findShortestQueue();
+    if (shortestQ < 0) {
+        return 1;
+    } else {
+        VideoMsgQueuePtr pPacketQ = m_PacketQs.at(shortestQ);
+        return float(pPacketQ->size())/pPacketQ->getMaxSize();
+    }
+}
+
 void VideoDemuxerThread::seek(int seqNum, float destTime)
 {
     map<int, VideoMsgQueuePtr>::iterator it;
@@ -131,6 +134,23 @@ void VideoDemuxerThread::close()
     stop();
 }
         
+int VideoDemuxerThread::findShortestQueue() const
+{
+    map<int, VideoMsgQueuePtr>::const_iterator it;
+    int shortestQ = -1;
+    int shortestLength = INT_MAX;
+    for (it = m_PacketQs.begin(); it != m_PacketQs.end(); it++) {
+        if (it->second->size() < shortestLength && 
+                it->second->size() < it->second->getMaxSize() &&
+                !m_PacketQEOFMap.at(it->first))
+        {
+            shortestLength = it->second->size();
+            shortestQ = it->first;
+        }
+    }
+    return shortestQ;
+}
+
 void VideoDemuxerThread::onStreamEOF(int streamIndex)
 {
     m_PacketQEOFMap[streamIndex] = true;
@@ -43,11 +43,14 @@ class AVG_API VideoDemuxerThread: public WorkerThread<VideoDemuxerThread> {
         virtual ~VideoDemuxerThread();
         bool init();
         bool work();
+        bool isWorkAvailable() const;
+        float getQueueFill() const;
 
         void seek(int seqNum, float DestTime);
         void close();
 
     private:
+        int findShortestQueue() const;
         void onStreamEOF(int streamIndex);
         void clearQueue(VideoMsgQueuePtr pPacketQ);
 
@@ -0,0 +1,330 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#include "VideoFramePool.h"
+
+#include "../base/Exception.h"
+#include "../base/ObjectCounter.h"
+#include "../graphics/Bitmap.h"
+
+using namespace std;
+
+// Stride and plane alignment. Large enough for all SIMD code in ffmpeg.
+#define STRIDE_ALIGN 64
+// ffmpeg's optimized code may read and write a few bytes after the end of a plane.
+#define PLANE_PADDING 64
+
+namespace avg {
+
+namespace {
+
+int alignUp(int i, int align)
+{
+    return (i+align-1)/align*align;
+}
+
+AVPixelFormat getAVPixelFormat(PixelFormat pf)
+{
+    switch (pf) {
+        case YCbCr420p:
+            return AV_PIX_FMT_YUV420P;
+        case YCbCrJ420p:
+            return AV_PIX_FMT_YUVJ420P;
+        case YCbCrA420p:
+            return AV_PIX_FMT_YUVA420P;
+        default:
+            return AV_PIX_FMT_NONE;
+    }
+}
+
+// Keeps the slot memory alive as long as any plane Bitmap is referenced, even if
+// the pool itself is already gone.
+class PlaneDeleter
+{
+public:
+    PlaneDeleter(const boost::shared_ptr<unsigned char>& pMem)
+        : m_pMem(pMem)
+    {
+    }
+
+    void operator()(Bitmap* pBmp)
+    {
+        delete pBmp;
+    }
+
+private:
+    boost::shared_ptr<unsigned char> m_pMem;
+};
+
+}
+
+VideoFramePool::VideoFramePool(const IntPoint& size, PixelFormat pf, int initialSize)
+    : m_Size(size),
+      m_PF(pf),
+      m_InitialSize(initialSize),
+      m_MaxSize(initialSize*4),
+      m_FrameWidth(-1),
+      m_FrameHeight(-1),
+      m_FrameFormat(AV_PIX_FMT_NONE),
+      m_NumSlots(0),
+      m_NumHits(0),
+      m_NumMisses(0)
+{
+    AVG_ASSERT(pixelFormatIsPlanar(pf));
+    AVG_ASSERT(initialSize > 0);
+    ObjectCounter::get()->incRef(&typeid(*this));
+}
+
+VideoFramePool::~VideoFramePool()
+{
+    for (unsigned i = 0; i < m_pSlots.size(); ++i) {
+        AVG_ASSERT(!m_pSlots[i]->m_bUsedByCodec);
+        delete m_pSlots[i];
+    }
+    ObjectCounter::get()->decRef(&typeid(*this));
+}
+
+bool VideoFramePool::attach(AVCodecContext* pContext)
+{
+    if (!(pContext->codec->capabilities & AV_CODEC_CAP_DR1) || 
+            pContext->pix_fmt != getAVPixelFormat(m_PF))
+    {
+        return false;
+    }
+    pContext->opaque = this;
+    pContext->get_buffer2 = &VideoFramePool::getBuffer;
+    return true;
+}
+
+bool VideoFramePool::getFrameBmps(AVFrame* pFrame, vector<BitmapPtr>& pBmps)
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    for (unsigned i = 0; i < m_pSlots.size(); ++i) {
+        Slot* pSlot = m_pSlots[i];
+        if (pSlot->m_bUsedByCodec && pSlot->m_pPlaneData[0] == pFrame->data[0]) {
+            for (int j = 0; j < getNumPlanes(); ++j) {
+                if (pSlot->m_pPlaneData[j] != pFrame->data[j] || 
+                        m_Strides[j] != pFrame->linesize[j])
+                {
+                    // Cropped frame: Plane start doesn't match the Bitmap.
+                    return false;
+                }
+            }
+            pBmps.clear();
+            for (int j = 0; j < getNumPlanes(); ++j) {
+                pBmps.push_back(pSlot->m_pPlanes[j]);
+            }
+            return true;
+        }
+    }
+    return false;
+}
+
+bool VideoFramePool::isPoolBmp(const BitmapPtr& pBmp) const
+{
+    boost::mutex::scoped_lock lock(m_Mutex);
+    for (unsigned i = 0; i < m_pSlots.size(); ++i) {
+        const vector<BitmapPtr>& pPlanes = m_pSlots[i]->m_pPlanes;
+        for (unsigned j = 0; j < pPlanes.size(); ++j) {
+            if (pPlanes[j] == pBmp) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+int VideoFramePool::getSize() const
+{
+    return m_NumSlots;
+}
+
+long long VideoFramePool::getNumHits() const
+{
+    return m_NumHits;
+}
+
+long long VideoFramePool::getNumMisses() const
+{
+    return m_NumMisses;
+}
+
+int VideoFramePool::getBuffer(AVCodecContext* pContext, AVFrame* pFrame, int flags)
+{
+    VideoFramePool* pThis = (VideoFramePool*)(pContext->opaque);
+    Slot* pSlot;
+    {
+        boost::mutex::scoped_lock lock(pThis->m_Mutex);
+        pSlot = pThis->findFreeSlot(pContext, pFrame);
+        if (pSlot) {
+            pSlot->m_bUsedByCodec = true;
+        }
+    }
+    if (!pSlot) {
+        return avcodec_default_get_buffer2(pContext, pFrame, flags);
+    }
+
+    int bufferSize = 0;
+    for (int i = 0; i < pThis->getNumPlanes(); ++i) {
+        bufferSize += alignUp(pThis->m_Strides[i]*pThis->m_PlaneHeights[i]+PLANE_PADDING,
+                STRIDE_ALIGN);
+    }
+    pFrame->buf[0] = av_buffer_create(pSlot->m_pPlaneData[0], bufferSize, 
+            &VideoFramePool::releaseBuffer, pSlot, 0);
+    if (!pFrame->buf[0]) {
+        boost::mutex::scoped_lock lock(pThis->m_Mutex);
+        pSlot->m_bUsedByCodec = false;
+        return AVERROR(ENOMEM);
+    }
+    for (int i = 0; i < pThis->getNumPlanes(); ++i) {
+        pFrame->data[i] = pSlot->m_pPlaneData[i];
+        pFrame->linesize[i] = pThis->m_Strides[i];
+    }
+    pFrame->extended_data = pFrame->data;
+    return 0;
+}
+
+void VideoFramePool::releaseBuffer(void* pOpaque, uint8_t* pData)
+{
+    // Called by ffmpeg when the codec doesn't need the buffer anymore.
+    Slot* pSlot = (Slot*)pOpaque;
+    boost::mutex::scoped_lock lock(pSlot->m_pPool->m_Mutex);
+    pSlot->m_bUsedByCodec = false;
+}
+
+bool VideoFramePool::isFree(const Slot* pSlot) const
+{
+    if (pSlot->m_bUsedByCodec) {
+        return false;
+    }
+    // The pool holds one reference to each plane. More references mean that the 
+    // frame is still queued or waiting for upload.
+    for (unsigned i = 0; i < pSlot->m_pPlanes.size(); ++i) {
+        if (pSlot->m_pPlanes[i].use_count() > 1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+VideoFramePool::Slot* VideoFramePool::findFreeSlot(AVCodecContext* pContext, 
+        AVFrame* pFrame)
+{
+    if (m_FrameFormat == AV_PIX_FMT_NONE) {
+        if (!initLayout(pContext, pFrame)) {
+            m_NumMisses++;
+            return 0;
+        }
+    }
+    if (pFrame->width != m_FrameWidth || pFrame->height != m_FrameHeight ||
+            pFrame->format != m_FrameFormat)
+    {
+        // Stream parameters changed midstream. Let ffmpeg handle it.
+        m_NumMisses++;
+        return 0;
+    }
+    for (unsigned i = 0; i < m_pSlots.size(); ++i) {
+        if (isFree(m_pSlots[i])) {
+            m_NumHits++;
+            return m_pSlots[i];
+        }
+    }
+    m_NumMisses++;
+    if (int(m_pSlots.size()) < m_MaxSize) {
+        return allocSlot(pContext, pFrame);
+    } else {
+        return 0;
+    }
+}
+
+VideoFramePool::Slot* VideoFramePool::allocSlot(AVCodecContext* pContext, 
+        AVFrame* pFrame)
+{
+    int planeOffsets[4];
+    int bufferSize = 0;
+    for (int i = 0; i < getNumPlanes(); ++i) {
+        planeOffsets[i] = bufferSize;
+        bufferSize += alignUp(m_Strides[i]*m_PlaneHeights[i]+PLANE_PADDING, STRIDE_ALIGN);
+    }
+    unsigned char* pData = (unsigned char*)av_malloc(bufferSize);
+    if (!pData) {
+        return 0;
+    }
+    boost::shared_ptr<unsigned char> pMem(pData, av_free);
+
+    Slot* pSlot = new Slot;
+    pSlot->m_pPool = this;
+    pSlot->m_bUsedByCodec = false;
+    IntPoint halfSize(m_Size.x/2, m_Size.y/2);
+    for (int i = 0; i < getNumPlanes(); ++i) {
+        pSlot->m_pPlaneData[i] = pData + planeOffsets[i];
+        IntPoint planeSize = (i == 1 || i == 2) ? halfSize : m_Size;
+        pSlot->m_pPlanes.push_back(BitmapPtr(new Bitmap(planeSize, I8, 
+                pSlot->m_pPlaneData[i], m_Strides[i], false), PlaneDeleter(pMem)));
+    }
+    m_pSlots.push_back(pSlot);
+    m_NumSlots = int(m_pSlots.size());
+    return pSlot;
+}
+
+bool VideoFramePool::initLayout(AVCodecContext* pContext, AVFrame* pFrame)
+{
+    if (pFrame->format != getAVPixelFormat(m_PF) || pFrame->width < m_Size.x ||
+            pFrame->height < m_Size.y)
+    {
+        return false;
+    }
+    int width = pFrame->width;
+    int height = pFrame->height;
+    int linesizeAlign[AV_NUM_DATA_POINTERS];
+    avcodec_align_dimensions2(pContext, &width, &height, linesizeAlign);
+    const AVPixFmtDescriptor* pDesc = av_pix_fmt_desc_get(AVPixelFormat(pFrame->format));
+    for (int i = 0; i < getNumPlanes(); ++i) {
+        int shiftX = 0;
+        int shiftY = 0;
+        if (i == 1 || i == 2) {
+            shiftX = pDesc->log2_chroma_w;
+            shiftY = pDesc->log2_chroma_h;
+        }
+        int planeWidth = -((-width) >> shiftX);
+        m_Strides[i] = alignUp(planeWidth, STRIDE_ALIGN);
+        if (linesizeAlign[i] > 0) {
+            m_Strides[i] = alignUp(m_Strides[i], linesizeAlign[i]);
+        }
+        m_PlaneHeights[i] = -((-height) >> shiftY);
+    }
+    m_FrameWidth = pFrame->width;
+    m_FrameHeight = pFrame->height;
+    m_FrameFormat = pFrame->format;
+
+    for (int i = 0; i < m_InitialSize; ++i) {
+        allocSlot(pContext, pFrame);
+    }
+    return true;
+}
+
+int VideoFramePool::getNumPlanes() const
+{
+    return getNumPixelFormatPlanes(m_PF);
+}
+
+}
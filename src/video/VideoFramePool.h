@@ -0,0 +1,110 @@
+//
+//  libavg - Media Playback Engine. 
+//  Copyright (C) 2003-2020 Ulrich von Zadow
+//
+//  This library is free software; you can redistribute it and/or
+//  modify it under the terms of the GNU Lesser General Public
+//  License as published by the Free Software Foundation; either
+//  version 2 of the License, or (at your option) any later version.
+//
+//  This library is distributed in the hope that it will be useful,
+//  but WITHOUT ANY WARRANTY; without even the implied warranty of
+//  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+//  Lesser General Public License for more details.
+//
+//  You should have received a copy of the GNU Lesser General Public
+//  License along with this library; if not, write to the Free Software
+//  Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+//  Current versions can be found at www.libavg.de
+//
+
+
+#ifndef _VideoFramePool_H_
+#define _VideoFramePool_H_
+
+#include "../api.h"
+#include "../avgconfigwrapper.h"
+
+#include "WrapFFMpeg.h"
+
+#include "../base/GLMHelper.h"
+#include "../graphics/PixelFormat.h"
+
+#include <boost/shared_ptr.hpp>
+#include <boost/thread/mutex.hpp>
+
+#include <atomic>
+#include <vector>
+
+namespace avg {
+
+class Bitmap;
+typedef boost::shared_ptr<Bitmap> BitmapPtr;
+
+// Preallocated, aligned planes that ffmpeg decodes into directly (via get_buffer2).
+// The planes are handed to the application as Bitmaps without copying. A slot is
+// reused as soon as ffmpeg has released it and no Bitmap of the slot is referenced
+// outside the pool anymore, so frames don't need to be returned explicitly.
+class AVG_API VideoFramePool
+{
+public:
+    VideoFramePool(const IntPoint& size, PixelFormat pf, int initialSize);
+    virtual ~VideoFramePool();
+
+    // Installs the pool as buffer allocator for the codec. Returns false if the codec
+    // or pixel format doesn't support direct rendering.
+    bool attach(AVCodecContext* pContext);
+
+    // Fills pBmps with the pool Bitmaps that correspond to the decoded frame. Returns
+    // false if the frame wasn't decoded into the pool.
+    bool getFrameBmps(AVFrame* pFrame, std::vector<BitmapPtr>& pBmps);
+    bool isPoolBmp(const BitmapPtr& pBmp) const;
+
+    // Can be called from any thread.
+    int getSize() const;
+    long long getNumHits() const;
+    long long getNumMisses() const;
+
+private:
+    struct Slot {
+        VideoFramePool* m_pPool;
+        std::vector<BitmapPtr> m_pPlanes;
+        unsigned char* m_pPlaneData[4];
+        bool m_bUsedByCodec;
+    };
+
+    static int getBuffer(AVCodecContext* pContext, AVFrame* pFrame, int flags);
+    static void releaseBuffer(void* pOpaque, uint8_t* pData);
+
+    bool isFree(const Slot* pSlot) const;
+    Slot* findFreeSlot(AVCodecContext* pContext, AVFrame* pFrame);
+    Slot* allocSlot(AVCodecContext* pContext, AVFrame* pFrame);
+    bool initLayout(AVCodecContext* pContext, AVFrame* pFrame);
+    int getNumPlanes() const;
+
+    IntPoint m_Size;
+    PixelFormat m_PF;
+    int m_InitialSize;
+    int m_MaxSize;
+
+    // Layout of the planes in a slot. Determined by the first get_buffer2 call.
+    int m_FrameWidth;
+    int m_FrameHeight;
+    int m_FrameFormat;
+    int m_Strides[4];
+    int m_PlaneHeights[4];
+
+    std::vector<Slot*> m_pSlots;
+    mutable boost::mutex m_Mutex;
+
+    std::atomic<int> m_NumSlots;
+    std::atomic<long long> m_NumHits;
+    std::atomic<long long> m_NumMisses;
+};
+
+typedef boost::shared_ptr<VideoFramePool> VideoFramePoolPtr;
+
+}
+#endif
+
@@ -42,7 +42,8 @@ VideoInfo::VideoInfo(string sContainerFormat, float duration, int bitrate, bool
 }
 
 void VideoInfo::setVideoData(const IntPoint& size, const string& sPixelFormat,
-        int numFrames, float streamFPS, const string& sVCodec, float duration)
+        int numFrames, float streamFPS, const string& sVCodec, float duration,
+        int numDecodingThreads)
 {
     AVG_ASSERT(m_bHasVideo);
     m_Size = size;
@@ -51,6 +52,7 @@ void VideoInfo::setVideoData(const IntPoint& size, const string& sPixelFormat,
     m_StreamFPS = streamFPS;
     m_sVCodec = sVCodec;
     m_VideoDuration = duration;
+    m_NumDecodingThreads = numDecodingThreads;
 }
 
 void VideoInfo::setAudioData(const string& sACodec, int sampleRate, int numAudioChannels,
@@ -38,7 +38,8 @@ struct AVG_API VideoInfo
     VideoInfo(std::string sContainerFormat, float duration, int bitrate, bool bHasVideo,
             bool bHasAudio);
     void setVideoData(const IntPoint& size, const std::string& sPixelFormat,
-            int numFrames, float streamFPS, const std::string& sVCodec, float duration);
+            int numFrames, float streamFPS, const std::string& sVCodec, float duration,
+            int numDecodingThreads);
 
     void setAudioData(const std::string& sACodec, int sampleRate, int numAudioChannels,
             float duration);
@@ -54,6 +55,8 @@ struct AVG_API VideoInfo
     float m_StreamFPS;
     std::string m_sVCodec;
     float m_VideoDuration;
+    // Number of threads ffmpeg actually uses to decode the video stream.
+    int m_NumDecodingThreads;
 
     bool m_bHasAudio;
     std::string m_sACodec;
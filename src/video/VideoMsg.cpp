@@ -43,6 +43,14 @@ void VideoMsg::setFrame(const std::vector<BitmapPtr>& pBmps, float frameTime)
     m_FrameTime = frameTime;
 }
 
+void VideoMsg::resetFrame()
+{
+    AVG_ASSERT(getType() == FRAME);
+    // clear() keeps the vector's memory, so reusing the message doesn't allocate.
+    m_pBmps.clear();
+    resetType();
+}
+
 void VideoMsg::setPacket(AVPacket* pPacket)
 {
     setType(PACKET);
@@ -42,6 +42,8 @@ public:
     VideoMsg();
     void setFrame(const std::vector<BitmapPtr>& pBmps, float frameTime);
     void setPacket(AVPacket* pPacket);
+    // Makes the message reusable for another frame.
+    void resetFrame();
 
     virtual ~VideoMsg();
 
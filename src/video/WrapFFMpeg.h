@@ -60,6 +60,10 @@ extern "C" {
 #include <libswresample/version.h>
 }
 
+#ifndef AV_CODEC_CAP_DR1
+    #define AV_CODEC_CAP_DR1 CODEC_CAP_DR1
+#endif
+
 // Old ffmpeg has PixelFormat, new ffmpeg uses AVPixelFormat.
 // Intermediate versions define PixelFormat in terms of AVPixelFormat for compatibility.
 // libavg also defines avg::PixelFormat.
@@ -21,6 +21,8 @@
 
 #include "AsyncVideoDecoder.h"
 #include "SyncVideoDecoder.h"
+#include "DecoderExecutor.h"
+#include "KeyframeIndex.h"
 
 #include "../graphics/Filterfliprgba.h"
 #include "../graphics/Filterfliprgb.h"
@@ -34,10 +36,12 @@
 #include "../base/ThreadProfiler.h"
 #include "../base/Directory.h"
 #include "../base/DirEntry.h"
+#include "../base/FileHelper.h"
 
 #include <string>
 #include <sstream>
 #include <cmath>
+#include <atomic>
 
 #include <glib-object.h>
 
@@ -76,19 +80,19 @@ class DecoderTest: public GraphicsTest {
             return &AP;
         }
 
-        int processAudioMsg(AudioMsgQueuePtr pMsgQ, AudioMsgQueuePtr pStatusQ)
+        int processAudioMsg(AudioMsgQueuePtr pMsgQ, AudioMsgQueuePtr pStatusQ,
+                AudioTimeStatusPtr pTimeStatus)
         {
             AudioMsgPtr pMsg = pMsgQ->pop(false);
             if (pMsg) {
                 switch (pMsg->getType()) {
                     case AudioMsg::AUDIO: {
                         AudioBufferPtr pBuffer = pMsg->getAudioBuffer();
-                        AudioMsgPtr pStatusMsg(new AudioMsg);
-                        pStatusMsg->setAudioTime(pMsg->getAudioTime());
-                        pStatusQ->push(AudioMsgPtr(pStatusMsg));
+                        *pTimeStatus = pMsg->getAudioTime();
                         return pBuffer->getNumFrames();
                     }
                     case AudioMsg::SEEK_DONE: {
+                        *pTimeStatus = pMsg->getSeekTime();
                         AudioMsgPtr pStatusMsg(new AudioMsg);
                         pStatusMsg->setSeekDone(pMsg->getSeekSeqNum(),
                                 pMsg->getSeekTime());
@@ -104,13 +108,14 @@ class DecoderTest: public GraphicsTest {
             }
         }
 
-        void processAudioSeek(AudioMsgQueuePtr pMsgQ, AudioMsgQueuePtr pStatusQ)
+        void processAudioSeek(AudioMsgQueuePtr pMsgQ, AudioMsgQueuePtr pStatusQ,
+                AudioTimeStatusPtr pTimeStatus)
         {
             int framesDecoded = 0;
             while (framesDecoded != -1) {
                 // The real AudioSource blocks on pMsgQ->pop()
                 msleep(10);
-                framesDecoded = processAudioMsg(pMsgQ, pStatusQ);
+                framesDecoded = processAudioMsg(pMsgQ, pStatusQ, pTimeStatus);
             }
         }
 
@@ -314,8 +319,10 @@ class AudioDecoderTest: public DecoderTest {
                     pDecoder->startDecoding(false, getAudioParams());
                     AudioMsgQueuePtr pMsgQ = pDecoder->getAudioMsgQ();
                     AudioMsgQueuePtr pStatusQ = pDecoder->getAudioStatusQ();
+                    AudioTimeStatusPtr pTimeStatus = pDecoder->getAudioTimeStatus();
                     int totalFramesDecoded = 0;
-                    readAudioToEOF(pDecoder, pMsgQ, pStatusQ, totalFramesDecoded, true);
+                    readAudioToEOF(pDecoder, pMsgQ, pStatusQ, pTimeStatus, 
+                            totalFramesDecoded, true);
 
                     // Check if we've decoded the whole file.
                     int framesInDuration = int(pDecoder->getVideoInfo().m_Duration*44100);
@@ -332,11 +339,13 @@ class AudioDecoderTest: public DecoderTest {
                     pDecoder->startDecoding(false, getAudioParams());
                     AudioMsgQueuePtr pMsgQ = pDecoder->getAudioMsgQ();
                     AudioMsgQueuePtr pStatusQ = pDecoder->getAudioStatusQ();
+                    AudioTimeStatusPtr pTimeStatus = pDecoder->getAudioTimeStatus();
                     pDecoder->seek(duration/2);
-                    processAudioSeek(pMsgQ, pStatusQ);
+                    processAudioSeek(pMsgQ, pStatusQ, pTimeStatus);
                     int totalFramesDecoded = 0;
 
-                    readAudioToEOF(pDecoder, pMsgQ, pStatusQ, totalFramesDecoded, false);
+                    readAudioToEOF(pDecoder, pMsgQ, pStatusQ, pTimeStatus, 
+                            totalFramesDecoded, false);
                     if (sFilename.find(".mp3") == string::npos) {
                         // Check if we've decoded half the file.
                         // TODO: Find out why there are problems with this
@@ -356,14 +365,15 @@ class AudioDecoderTest: public DecoderTest {
         }
 
         void readAudioToEOF(AsyncVideoDecoderPtr pDecoder, AudioMsgQueuePtr pMsgQ, 
-                AudioMsgQueuePtr pStatusQ, int& totalFramesDecoded,
+                AudioMsgQueuePtr pStatusQ, AudioTimeStatusPtr pTimeStatus, 
+                int& totalFramesDecoded,
                 bool bCheckTimestamps) 
         {
             int numWrongTimestamps = 0;
             while (!pDecoder->isEOF()) {
                 int framesDecoded = 0;
                 while (framesDecoded == 0 && !pDecoder->isEOF()) {
-                    framesDecoded = processAudioMsg(pMsgQ, pStatusQ);
+                    framesDecoded = processAudioMsg(pMsgQ, pStatusQ, pTimeStatus);
                     AVG_ASSERT(framesDecoded != -1);
                     pDecoder->updateAudioStatus();
                     msleep(0);
@@ -408,6 +418,9 @@ class AVDecoderTest: public DecoderTest {
             pMsgQ = dynamic_pointer_cast<AsyncVideoDecoder>(pDecoder) ->getAudioMsgQ();
             pStatusQ = dynamic_pointer_cast<AsyncVideoDecoder>(pDecoder)
                 ->getAudioStatusQ();
+            AudioTimeStatusPtr pTimeStatus = 
+                    dynamic_pointer_cast<AsyncVideoDecoder>(pDecoder)
+                    ->getAudioTimeStatus();
             TEST(pDecoder->getVideoInfo().m_bHasAudio);
             
             BitmapPtr pBmp;
@@ -429,7 +442,7 @@ class AVDecoderTest: public DecoderTest {
                 }
                 int framesDecoded = 0;
                 while (framesDecoded == 0 && !pDecoder->isEOF()) {
-                    framesDecoded = processAudioMsg(pMsgQ, pStatusQ);
+                    framesDecoded = processAudioMsg(pMsgQ, pStatusQ, pTimeStatus);
                     dynamic_pointer_cast<AsyncVideoDecoder>(pDecoder)
                         ->updateAudioStatus();
                     msleep(0);
@@ -444,7 +457,7 @@ class AVDecoderTest: public DecoderTest {
 
             // Test loop.
             pDecoder->seek(0);
-            processAudioSeek(pMsgQ, pStatusQ);
+            processAudioSeek(pMsgQ, pStatusQ, pTimeStatus);
             pDecoder->getRenderedBmp(pBmp, -1);
             testEqual(*pBmp, sFilename+"_loop", B8G8R8X8);
 
@@ -453,6 +466,165 @@ class AVDecoderTest: public DecoderTest {
 };
 
 
+// Runs a fixed number of steps once m_bGo is set and logs them.
+class LoggingTask: public IDecoderTask {
+    public:
+        LoggingTask(int id, int numSteps, float queueFill, std::atomic<bool>& bGo,
+                std::vector<int>& log, boost::mutex& logMutex, bool& bDeleted)
+            : m_ID(id),
+              m_NumStepsLeft(numSteps),
+              m_QueueFill(queueFill),
+              m_bGo(bGo),
+              m_Log(log),
+              m_LogMutex(logMutex),
+              m_bDeleted(bDeleted),
+              m_bInStep(false),
+              m_bConcurrent(false)
+        {
+        }
+
+        virtual ~LoggingTask()
+        {
+            m_bDeleted = !m_bConcurrent;
+        }
+
+        virtual bool isReady() const
+        {
+            return m_bGo && m_NumStepsLeft > 0;
+        }
+
+        virtual float getQueueFill() const
+        {
+            return m_QueueFill;
+        }
+
+        virtual bool step()
+        {
+            if (m_bInStep.exchange(true)) {
+                m_bConcurrent = true;
+            }
+            {
+                boost::mutex::scoped_lock lock(m_LogMutex);
+                m_Log.push_back(m_ID);
+            }
+            m_NumStepsLeft--;
+            m_bInStep = false;
+            return m_NumStepsLeft > 0;
+        }
+
+    private:
+        int m_ID;
+        int m_NumStepsLeft;
+        float m_QueueFill;
+        std::atomic<bool>& m_bGo;
+        std::vector<int>& m_Log;
+        boost::mutex& m_LogMutex;
+        bool& m_bDeleted;
+        std::atomic<bool> m_bInStep;
+        bool m_bConcurrent;
+};
+
+class DecoderExecutorTest: public Test {
+    public:
+        DecoderExecutorTest()
+            : Test("DecoderExecutorTest", 2)
+        {
+        }
+
+        void runTests()
+        {
+            // With one worker, the task with the emptier output queue runs first.
+            {
+                DecoderExecutor executor(1);
+                TEST(executor.getNumWorkers() == 1);
+                std::atomic<bool> bGo(false);
+                vector<int> log;
+                boost::mutex logMutex;
+                bool bDeleted[2] = {false, false};
+                int id0 = executor.addTask(new LoggingTask(0, 5, 0.9f, bGo, log, 
+                        logMutex, bDeleted[0]));
+                int id1 = executor.addTask(new LoggingTask(1, 5, 0.1f, bGo, log, 
+                        logMutex, bDeleted[1]));
+                bGo = true;
+                executor.wakeUp();
+                executor.waitForTask(id0);
+                executor.waitForTask(id1);
+                TEST(bDeleted[0] && bDeleted[1]);
+                TEST(executor.getNumTasks() == 0);
+                TEST(log.size() == 10);
+                for (unsigned i = 0; i < log.size(); ++i) {
+                    TEST(log[i] == (i < 5 ? 1 : 0));
+                }
+            }
+            // With several workers, all tasks complete and none runs concurrently 
+            // with itself.
+            {
+                DecoderExecutor executor(4);
+                std::atomic<bool> bGo(true);
+                vector<int> log;
+                boost::mutex logMutex;
+                bool bDeleted[16];
+                vector<int> ids;
+                for (int i = 0; i < 16; ++i) {
+                    bDeleted[i] = false;
+                    ids.push_back(executor.addTask(new LoggingTask(i, 100, 
+                            (i%4)/4.f, bGo, log, logMutex, bDeleted[i])));
+                }
+                for (int i = 0; i < 16; ++i) {
+                    executor.waitForTask(ids[i]);
+                    TEST(bDeleted[i]);
+                }
+                TEST(log.size() == 1600);
+            }
+        }
+};
+
+class KeyframeIndexTest: public Test {
+    public:
+        KeyframeIndexTest()
+            : Test("KeyframeIndexTest", 2)
+        {
+        }
+
+        void runTests()
+        {
+            KeyframeIndex index;
+            index.addKeyframe(0);
+            index.addKeyframe(300);
+            index.addKeyframe(600);
+            // Out-of-order and duplicate keyframes.
+            index.addKeyframe(150);
+            index.addKeyframe(300);
+            TEST(index.getNumKeyframes() == 4);
+            TEST(index.getKeyframe(1) == 150);
+            TEST(index.getKeyframeBefore(-10) == 0);
+            TEST(index.getKeyframeBefore(150) == 150);
+            TEST(index.getKeyframeBefore(299) == 150);
+            TEST(index.getKeyframeBefore(1000) == 600);
+
+            // Cache entries are only valid for the file they were saved for.
+            string sCacheDir = "keyframeindextest";
+            string sVideoFilename = getMediaDir()+"/mpeg1-48x48.mov";
+            index.save(sCacheDir, sVideoFilename);
+            KeyframeIndex loadedIndex;
+            TEST(loadedIndex.load(sCacheDir, sVideoFilename));
+            TEST(loadedIndex.getNumKeyframes() == 4);
+            TEST(loadedIndex.getKeyframeBefore(500) == 300);
+            KeyframeIndex otherIndex;
+            TEST(!otherIndex.load(sCacheDir, getMediaDir()+"/mjpeg-48x48.avi"));
+            TEST(otherIndex.getNumKeyframes() == 0);
+
+            {
+                Directory dir(sCacheDir);
+                dir.open();
+                dir.empty();
+            }
+            removeDir(sCacheDir);
+            TEST(!fileExists(sCacheDir));
+        }
+};
+
+
 class VideoTestSuite: public TestSuite {
 public:
     VideoTestSuite() 
@@ -471,6 +643,8 @@ private:
 
     void addVideoTests()
     {
+        addTest(TestPtr(new DecoderExecutorTest()));
+        addTest(TestPtr(new KeyframeIndexTest()));
         addTest(TestPtr(new VideoDecoderTest(false)));
         addTest(TestPtr(new VideoDecoderTest(true)));
 
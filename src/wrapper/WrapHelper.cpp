@@ -512,7 +512,11 @@ void addPythonLogger(PyObject * self, PyObject * pyLogger)
 {
     Logger * logger = Logger::get();
     LogSinkPtr logSink(new PythonLogSink(pyLogger));
+    // In async mode, the logging thread can hold the sink lock while it waits for 
+    // the GIL.
+    Py_BEGIN_ALLOW_THREADS;
     logger->addLogSink(logSink);
+    Py_END_ALLOW_THREADS;
     m_pyObjectMap[pyLogger] = logSink;
 }
 
@@ -522,11 +526,27 @@ void removePythonLogger(PyObject * self, PyObject * pyLogger)
     std::map<PyObject *, LogSinkPtr>::iterator it;
     it = m_pyObjectMap.find(pyLogger);
     if( it !=m_pyObjectMap.end() ){
+        Py_BEGIN_ALLOW_THREADS;
         logger->removeLogSink(it->second);
+        Py_END_ALLOW_THREADS;
         m_pyObjectMap.erase(it);
     }
 }
 
+void setLoggerAsync(PyObject * self, bool bAsync, Logger::OverflowPolicy policy)
+{
+    Py_BEGIN_ALLOW_THREADS;
+    Logger::get()->setAsync(bAsync, policy);
+    Py_END_ALLOW_THREADS;
+}
+
+void flushLogger(PyObject * self)
+{
+    Py_BEGIN_ALLOW_THREADS;
+    Logger::get()->flush();
+    Py_END_ALLOW_THREADS;
+}
+
 void pytrace(PyObject * self, const avg::category_t& category, const UTF8String& sMsg,
         avg::severity_t severity)
 {
@@ -29,6 +29,7 @@
 #include "../base/GLMHelper.h"
 #include "../base/Exception.h"
 #include "../base/ILogSink.h"
+#include "../base/Logger.h"
 
 #include "../player/Player.h"
 #include "../player/TypeRegistry.h"
@@ -268,6 +269,8 @@ void exportMessages(boost::python::object& nodeClass, const std::string& sClassN
 
 void addPythonLogger(PyObject * self, PyObject * pyLogger);
 void removePythonLogger(PyObject * self, PyObject * pyLogger);
+void setLoggerAsync(PyObject * self, bool bAsync, avg::Logger::OverflowPolicy policy);
+void flushLogger(PyObject * self);
 
 void pytrace(PyObject * self, const avg::category_t& category, const avg::UTF8String& sMsg,
         avg::severity_t severity);
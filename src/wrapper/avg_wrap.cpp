@@ -130,6 +130,31 @@ BOOST_PYTHON_MODULE(avg)
             .export_values()
         ;
 
+        enum_<DisplayEngine::FrameTimeType>("FrameTimeType")
+            .value("TOTAL_TIME", DisplayEngine::TOTAL_TIME)
+            .value("RENDER_TIME", DisplayEngine::RENDER_TIME)
+            .value("WAIT_TIME", DisplayEngine::WAIT_TIME)
+            .value("SWAP_TIME", DisplayEngine::SWAP_TIME)
+            .value("PACING_ERROR", DisplayEngine::PACING_ERROR)
+            .export_values()
+        ;
+
+        enum_<DisplayEngine::FramePacing>("FramePacing")
+            .value("DEFAULT_PACING", DisplayEngine::DEFAULT_PACING)
+            .value("PRECISE_PACING", DisplayEngine::PRECISE_PACING)
+            .value("LOW_LATENCY_PACING", DisplayEngine::LOW_LATENCY_PACING)
+            .export_values()
+        ;
+
+        class_<FrameTimeStats>("FrameTimeStats", no_init)
+            .def_readonly("numframes", &FrameTimeStats::m_NumFrames)
+            .def_readonly("average", &FrameTimeStats::m_Average)
+            .def_readonly("p50", &FrameTimeStats::m_P50)
+            .def_readonly("p95", &FrameTimeStats::m_P95)
+            .def_readonly("p99", &FrameTimeStats::m_P99)
+            .def_readonly("max", &FrameTimeStats::m_Max)
+        ;
+
         object playerClass = class_<Player, bases<Publisher>, boost::noncopyable>
                 ("Player") 
             .def("get", &Player::get, 
@@ -170,10 +195,28 @@ BOOST_PYTHON_MODULE(avg)
             .def("setFakeFPS", &Player::setFakeFPS)
             .def("getFrameTime", &Player::getFrameTime)
             .def("getFrameDuration", &Player::getFrameDuration)
+            .def("startTracing", &Player::startTracing, (bp::arg("numframes")=0))
+            .def("stopTracing", &Player::stopTracing)
+            .def("isTracing", &Player::isTracing)
+            .def("saveTrace", &Player::saveTrace)
+            .def("setFramePacing", &Player::setFramePacing)
+            .def("getFramePacing", &Player::getFramePacing)
+            .def("setFrameTimeWindow", &Player::setFrameTimeWindow)
+            .def("getFrameTimeStats", &Player::getFrameTimeStats,
+                    (bp::arg("type")=DisplayEngine::TOTAL_TIME))
+            .def("getNumFramesTooLate", &Player::getNumFramesTooLate)
+            .def("getNumConsecutiveLateFrames", &Player::getNumConsecutiveLateFrames)
+            .def("getMaxConsecutiveLateFrames", &Player::getMaxConsecutiveLateFrames)
+            .def("getNumAudioUnderruns", &Player::getNumAudioUnderruns)
+            .def("getNumLateAudioCallbacks", &Player::getNumLateAudioCallbacks)
             .def("createNode", &Player::createNodeFromXmlString)
             .def("createNode", &Player::createNode, Player_createNode_overloads())
             .def("getTouchUserBmp", &Player::getTouchUserBmp)
+            .def("getNumTouchPacketsReceived", &Player::getNumTouchPacketsReceived)
+            .def("getNumTouchEventsReceived", &Player::getNumTouchEventsReceived)
+            .def("getNumTouchEventsDispatched", &Player::getNumTouchEventsDispatched)
             .def("enableMouse", &Player::enableMouse)
+            .def("setHitTestIndexThreshold", &Player::setHitTestIndexThreshold)
             .def("setInterval", &Player::setInterval)
             .def("setTimeout", &Player::setTimeout)
             .def("callFromThread", &Player::callFromThread)
@@ -213,6 +256,10 @@ BOOST_PYTHON_MODULE(avg)
             .def("getRootNode", &Canvas::getRootNode)
             .def("getElementByID", &Canvas::getElementByID)
             .def("screenshot", &Canvas::screenshot)
+            .def("getNumDrawCalls", &Canvas::getNumDrawCalls)
+            .def("getNumUnbatchedDrawCalls", &Canvas::getNumUnbatchedDrawCalls)
+            .def("getNumVertexBytesUploaded", &Canvas::getNumVertexBytesUploaded)
+            .def("getNumPreRenderUpdates", &Canvas::getNumPreRenderUpdates)
         ;
 
         class_<OffscreenCanvas, bases<Canvas>, boost::noncopyable>
@@ -227,6 +274,7 @@ BOOST_PYTHON_MODULE(avg)
             .add_property("autorender", &OffscreenCanvas::getAutoRender,
                     &OffscreenCanvas::setAutoRender)
             .def("getNumDependentCanvases", &OffscreenCanvas::getNumDependentCanvases)
+            .def("getNumSkippedFrames", &OffscreenCanvas::getNumSkippedFrames)
             .def("isSupported", &OffscreenCanvas::isSupported)
             .staticmethod("isSupported")
             .def("isMultisampleSupported", &OffscreenCanvas::isMultisampleSupported)
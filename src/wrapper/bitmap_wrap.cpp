@@ -183,7 +183,7 @@ BitmapPtr createBitmapWithRect(BitmapPtr pBmp,
 }
 
 BOOST_PYTHON_MEMBER_FUNCTION_OVERLOADS(loadBitmap_overloads, BitmapManager::loadBitmapPy, 
-        2, 3);
+        2, 4);
 
 static bp::object ImageCache_GetCapacity(ImageCache* pCache)
 {
@@ -209,6 +209,27 @@ static bp::object ImageCache_GetMemUsed(ImageCache* pCache)
             pCache->getMemUsed(CachedImage::STORAGE_GPU));
 }
 
+static bp::object ImageCache_GetDiskCacheStats(ImageCache* pCache)
+{
+    ImageDiskCache* pDiskCache = pCache->getDiskCache();
+    if (!pDiskCache) {
+        return bp::object();
+    }
+    return bp::make_tuple(pDiskCache->getNumEntries(), pDiskCache->getMemUsed(),
+            pDiskCache->getNumHits(), pDiskCache->getNumMisses(), 
+            pDiskCache->getNumEvictions());
+}
+
+static bp::object ImageCache_GetAtlasStats(ImageCache* pCache)
+{
+    TextureAtlas* pAtlas = pCache->getAtlas();
+    if (!pAtlas) {
+        return bp::object();
+    }
+    return bp::make_tuple(pAtlas->getNumPages(), pAtlas->getOccupancy(), 
+            pAtlas->getNumDefragmentations());
+}
+
 vector<string> getSupportedPixelFormatsDeprecated()
 {
     avgDeprecationWarning("1.9.0", "avg.getSupportedPixelFormats",
@@ -317,13 +338,22 @@ void export_bitmap()
         .add_property("capacity", ImageCache_GetCapacity, ImageCache_SetCapacity)
         .def("getNumImages", ImageCache_GetNumImages)
         .def("getMemUsed", ImageCache_GetMemUsed)
+        .def("setDiskCache", &ImageCache::setDiskCache)
+        .def("getDiskCacheStats", ImageCache_GetDiskCacheStats)
+        .def("setAtlas", &ImageCache::setAtlas)
+        .def("getAtlasStats", ImageCache_GetAtlasStats)
     ;
 
-    class_<BitmapManager>("BitmapManager", no_init)
+    class_<BitmapManager, boost::noncopyable>("BitmapManager", no_init)
         .def("get", &BitmapManager::get,
                 return_value_policy<reference_existing_object>())
         .staticmethod("get")
-        .def("loadBitmap", &BitmapManager::loadBitmapPy, loadBitmap_overloads())
+        .def("loadBitmap", &BitmapManager::loadBitmapPy,
+                loadBitmap_overloads((bp::arg("fileName"), bp::arg("callback"),
+                        bp::arg("pixelformat")=NO_PIXELFORMAT, bp::arg("priority")=0)))
+        .def("cancelRequest", &BitmapManager::cancelRequest)
+        .def("setPriority", &BitmapManager::setPriority)
+        .def("getNumPendingRequests", &BitmapManager::getNumPendingRequests)
         .def("setNumThreads", &BitmapManager::setNumThreads)
     ;
 
@@ -38,6 +38,15 @@ using namespace boost::python;
 using namespace avg;
 using namespace std;
 
+// Returns the history as a bytearray of ContactSample structs so python code can 
+// wrap it in an array or numpy array without creating an object per sample.
+static object Contact_getHistory(const Contact& contact)
+{
+    int numBytes = contact.getNumHistorySamples()*sizeof(ContactSample);
+    object pyBuffer(handle<>(PyByteArray_FromStringAndSize(0, numBytes)));
+    contact.copyHistory((ContactSample*)PyByteArray_AsString(pyBuffer.ptr()));
+    return pyBuffer;
+}
 
 void export_event()
 {
@@ -171,6 +180,11 @@ void export_event()
         .add_property("motionvec", &Contact::getMotionVec)
         .add_property("distancetravelled", &Contact::getDistanceTravelled)
         .add_property("events", &Contact::getEvents)
+        .add_property("history", &Contact_getHistory)
+        .def("setHistoryLength", &Contact::setHistoryLength)
+        .staticmethod("setHistoryLength")
+        .def("getHistoryLength", &Contact::getHistoryLength)
+        .staticmethod("getHistoryLength")
         .def("connectListener", &Contact::connectListener)
         .def("disconnectListener", &Contact::disconnectListener)
         .def("getRelPos", &Contact::getRelPos)
@@ -92,7 +92,18 @@ void export_misc()
             .def("log", &Logger::log,
                     (bp::arg("category")=Logger::category::APP,
                      bp::arg("severity")=Logger::severity::INFO))
+            .def("setAsync", setLoggerAsync,
+                    (bp::arg("async"), bp::arg("policy")=Logger::DROP_MESSAGES))
+            .def("isAsync", &Logger::isAsync)
+            .def("getOverflowPolicy", &Logger::getOverflowPolicy)
+            .def("flush", flushLogger)
+            .def("getNumDroppedMessages", &Logger::getNumDroppedMessages)
        ;
+        enum_<Logger::OverflowPolicy>("OverflowPolicy")
+            .value("DROP_MESSAGES", Logger::DROP_MESSAGES)
+            .value("BLOCK_PRODUCER", Logger::BLOCK_PRODUCER)
+            .export_values()
+        ;
         {
             scope severityScope = class_<SeverityScopeHelper>("Severity");
             severityScope.attr("CRIT") = Logger::severity::CRITICAL;
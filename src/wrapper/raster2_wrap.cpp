@@ -111,6 +111,10 @@ void export_raster2()
         .def("pause", &VideoNode::pause)
         .def("getNumFrames", &VideoNode::getNumFrames)
         .def("getNumFramesQueued", &VideoNode::getNumFramesQueued)
+        .def("getNumDecodingThreads", &VideoNode::getNumDecodingThreads)
+        .def("getFramePoolSize", &VideoNode::getFramePoolSize)
+        .def("getFramePoolHits", &VideoNode::getFramePoolHits)
+        .def("getFramePoolMisses", &VideoNode::getFramePoolMisses)
         .def("getCurFrame", &VideoNode::getCurFrame)
         .def("seekToFrame", &VideoNode::seekToFrame)
         .def("getStreamPixelFormat", &VideoNode::getStreamPixelFormat)
@@ -126,6 +130,11 @@ void export_raster2()
         .def("getCurTime", &VideoNode::getCurTime)
         .def("seekToTime", &VideoNode::seekToTime)
         .def("isSeeking", &VideoNode::isSeeking)
+        .def("getNumSeeksDone", &VideoNode::getNumSeeksDone)
+        .def("getNumSeeksCancelled", &VideoNode::getNumSeeksCancelled)
+        .def("getAvgSeekLatency", &VideoNode::getAvgSeekLatency)
+        .def("getMaxSeekLatency", &VideoNode::getMaxSeekLatency)
+        .def("getAvgExactSeekLatency", &VideoNode::getAvgExactSeekLatency)
         .def("hasAudio", &VideoNode::hasAudio)
         .def("hasAlpha", &VideoNode::hasAlpha)
         .def("setEOFCallback", &VideoNode::setEOFCallback)
@@ -138,6 +147,7 @@ void export_raster2()
         .add_property("loop", &VideoNode::getLoop)
         .add_property("volume", &VideoNode::getVolume, &VideoNode::setVolume)
         .add_property("threaded", &VideoNode::isThreaded)
+        .add_property("scrubmode", &VideoNode::isScrubMode, &VideoNode::setScrubMode)
         .add_property("duration", &VideoNode::getDuration)
     ;
 }